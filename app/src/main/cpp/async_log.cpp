@@ -0,0 +1,556 @@
+// async_log.cpp
+// The log ring, argument capture, the drain thread and the core log interface (see async_log.h).
+
+#include "async_log.h"
+#include "platform.h"
+#include "trace.h"
+
+#include <sys/types.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+static const size_t kSlots = 512;              // power of two
+static const size_t kRecordBytes = 512;
+static const size_t kMaxMessage = 1024;
+static const auto kDrainInterval = std::chrono::milliseconds(20);
+
+static const size_t kRateSlots = 256;
+
+// Arguments are packed back to back: integers, doubles and pointers as 8 bytes, strings as a
+// 16-bit length followed by the bytes and a NUL. A copied core format string comes first.
+struct log_record {
+    const char* tag;
+    const char* fmt;       // nullptr: the format is the first string in args
+    uint8_t prio;
+    uint8_t truncated;     // arguments did not fit; the message ends early
+    uint16_t nargs;
+    uint8_t args[kRecordBytes - 32];
+};
+
+// Bounded multi-producer queue (Vyukov): seq == position when the slot is free for that
+// position's producer, position + 1 once its record is published.
+struct alignas(64) log_cell {
+    std::atomic<uint64_t> seq;
+    log_record rec;
+};
+
+static_assert(sizeof(log_cell) == kRecordBytes, "log records are one slot");
+
+static log_cell gRing[kSlots];
+alignas(64) static std::atomic<uint64_t> gEnqueue(0);
+alignas(64) static std::atomic<uint64_t> gDequeue(0);   // records delivered to the sink
+static std::atomic<uint64_t> gDropped(0);
+static std::atomic<uint64_t> gRateLimited(0);
+
+static std::atomic<int> gMinLevel(LOG_LEVEL_INFO);
+static std::atomic<int> gCoreMinLevel(LOG_LEVEL_INFO);
+static std::atomic<log_sink_fn> gSink(nullptr);
+static std::atomic<int64_t> gRateIntervalNs(100000000);
+static std::atomic<int64_t> gRateBurst(32);
+
+static std::once_flag gStartOnce;
+static std::atomic<bool> gStarted(false);
+static std::atomic<bool> gStop(false);
+static std::atomic<bool> gWakeup(false);
+static std::mutex gWakeLock;
+static std::condition_variable gWake;
+static std::thread gDrain;
+
+struct rate_slot {
+    std::atomic<const char*> site{nullptr};
+    std::atomic<int64_t> tat{0};   // GCRA theoretical arrival time
+};
+
+static rate_slot gRate[kRateSlots];
+
+static int64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void init_ring() {
+    for (size_t i = 0; i < kSlots; ++i) gRing[i].seq.store(i, std::memory_order_relaxed);
+}
+
+// ---------------------------
+// Format parsing
+// ---------------------------
+
+struct fmt_spec {
+    const char* begin;   // the '%'
+    const char* end;     // past the conversion character
+    int precision;       // -1: none, -2: '*'
+    int stars;           // '*' for the width and/or the precision, each taking an int argument
+    char length;         // 'H' for hh, 'L' for ll, L and q, else h l j z t or 0
+    char conv;           // 0 when what follows the '%' is not a conversion
+};
+
+// The next conversion at or after p. False when there is none.
+static bool next_spec(const char* p, fmt_spec* s) {
+    p = strchr(p, '%');
+    if (!p) return false;
+    s->begin = p++;
+    s->precision = -1;
+    s->stars = 0;
+    s->length = 0;
+    while (*p && strchr("-+ #0'", *p)) ++p;
+    if (*p == '*') {
+        ++s->stars;
+        ++p;
+    } else {
+        while (*p >= '0' && *p <= '9') ++p;
+    }
+    if (*p == '.') {
+        ++p;
+        if (*p == '*') {
+            ++s->stars;
+            s->precision = -2;
+            ++p;
+        } else {
+            s->precision = 0;
+            for (; *p >= '0' && *p <= '9'; ++p) s->precision = std::min(s->precision * 10 + (*p - '0'), 1 << 20);
+        }
+    }
+    switch (*p) {
+        case 'h': s->length = p[1] == 'h' ? 'H' : 'h'; p += s->length == 'H' ? 2 : 1; break;
+        case 'l': s->length = p[1] == 'l' ? 'L' : 'l'; p += s->length == 'L' ? 2 : 1; break;
+        case 'L': case 'q': s->length = 'L'; ++p; break;
+        case 'j': case 'z': case 't': s->length = *p++; break;
+        default: break;
+    }
+    s->conv = *p && strchr("diouxXeEfFgGaAcspn%", *p) ? *p : 0;
+    s->end = s->conv ? p + 1 : p;
+    return true;
+}
+
+// ---------------------------
+// Producer
+// ---------------------------
+
+struct arg_writer {
+    uint8_t* p;
+    uint8_t* end;
+    uint16_t n = 0;
+    bool full = false;
+
+    void u64(uint64_t v) {
+        if (full || end - p < 8) {
+            full = true;
+            return;
+        }
+        memcpy(p, &v, 8);
+        p += 8;
+        ++n;
+    }
+
+    // At most max bytes of s, like a printf precision.
+    void str(const char* s, size_t max) {
+        if (!s) s = "(null)";
+        if (full || end - p < 3) {
+            full = true;
+            return;
+        }
+        const size_t room = std::min<size_t>((size_t)(end - p) - 3, 0xFFFF);
+        const size_t limit = std::min(max, room);
+        const uint16_t len = (uint16_t)strnlen(s, limit);
+        memcpy(p, &len, 2);
+        memcpy(p + 2, s, len);
+        p[2 + len] = 0;
+        p += 3 + len;
+        ++n;
+        if (len == room && room < max && s[len]) full = true;
+    }
+};
+
+static bool rate_allow(const char* site) {
+    const int64_t interval = gRateIntervalNs.load(std::memory_order_relaxed);
+    if (!interval) return true;
+    const int64_t tolerance = gRateBurst.load(std::memory_order_relaxed) * interval;
+    rate_slot& r = gRate[((uint64_t)(uintptr_t)site * 0x9E3779B97F4A7C15ull) >> 56];
+    const int64_t now = monotonic_ns();
+    // two sites sharing a slot take turns owning it; good enough to stop a flood
+    if (r.site.load(std::memory_order_relaxed) != site) {
+        r.site.store(site, std::memory_order_relaxed);
+        r.tat.store(now, std::memory_order_relaxed);
+    }
+    int64_t tat = r.tat.load(std::memory_order_relaxed);
+    for (;;) {
+        const int64_t t = std::max(tat, now);
+        if (t - now >= tolerance) return false;
+        if (r.tat.compare_exchange_weak(tat, t + interval, std::memory_order_relaxed)) return true;
+    }
+}
+
+static void drain_main();
+
+static void stop_drain() {
+    gStop.store(true);
+    gWake.notify_one();
+    if (gDrain.joinable()) gDrain.join();
+}
+
+static void start_drain() {
+    std::call_once(gStartOnce, [] {
+        init_ring();
+        gDrain = std::thread(drain_main);
+        atexit(stop_drain);
+        gStarted.store(true, std::memory_order_release);
+    });
+}
+
+static void wake_drain() {
+    if (!gWakeup.exchange(true)) gWake.notify_one();
+}
+
+static void log_vwrite(int prio, const char* tag, const char* fmt, bool copy_fmt, va_list ap) {
+    if (!fmt) return;
+    if (!rate_allow(fmt)) {
+        gRateLimited.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!gStarted.load(std::memory_order_acquire)) start_drain();
+
+    uint64_t pos = gEnqueue.load(std::memory_order_relaxed);
+    log_cell* cell;
+    for (;;) {
+        cell = &gRing[pos & (kSlots - 1)];
+        const int64_t diff = (int64_t)(cell->seq.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (gEnqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            gDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = gEnqueue.load(std::memory_order_relaxed);
+        }
+    }
+
+    log_record& r = cell->rec;
+    r.tag = tag;
+    r.prio = (uint8_t)prio;
+    arg_writer w{r.args, r.args + sizeof(r.args)};
+    if (copy_fmt) {
+        w.str(fmt, SIZE_MAX);
+        r.fmt = nullptr;
+    } else {
+        r.fmt = fmt;
+    }
+
+    fmt_spec s;
+    for (const char* p = fmt; !w.full && next_spec(p, &s); p = s.end) {
+        int precision = s.precision;
+        for (int i = 0; i < s.stars; ++i) {
+            const int v = va_arg(ap, int);
+            w.u64((uint64_t)(int64_t)v);
+            if (i == s.stars - 1 && s.precision == -2) precision = v;   // the precision's star is last
+        }
+        switch (s.conv) {
+            case 'd': case 'i': {
+                int64_t v;
+                switch (s.length) {
+                    case 'l': v = va_arg(ap, long); break;
+                    case 'L': v = va_arg(ap, long long); break;
+                    case 'j': v = va_arg(ap, intmax_t); break;
+                    case 'z': v = va_arg(ap, ssize_t); break;
+                    case 't': v = va_arg(ap, ptrdiff_t); break;
+                    case 'h': v = (short)va_arg(ap, int); break;
+                    case 'H': v = (signed char)va_arg(ap, int); break;
+                    default: v = va_arg(ap, int); break;
+                }
+                w.u64((uint64_t)v);
+                break;
+            }
+            case 'o': case 'u': case 'x': case 'X': {
+                uint64_t v;
+                switch (s.length) {
+                    case 'l': v = va_arg(ap, unsigned long); break;
+                    case 'L': v = va_arg(ap, unsigned long long); break;
+                    case 'j': v = va_arg(ap, uintmax_t); break;
+                    case 'z': v = va_arg(ap, size_t); break;
+                    case 't': v = (uint64_t)va_arg(ap, ptrdiff_t); break;
+                    case 'h': v = (unsigned short)va_arg(ap, unsigned); break;
+                    case 'H': v = (unsigned char)va_arg(ap, unsigned); break;
+                    default: v = va_arg(ap, unsigned); break;
+                }
+                w.u64(v);
+                break;
+            }
+            case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A': {
+                const double d = s.length == 'L' ? (double)va_arg(ap, long double) : va_arg(ap, double);
+                uint64_t v;
+                memcpy(&v, &d, 8);
+                w.u64(v);
+                break;
+            }
+            case 'c':
+                w.u64((uint64_t)va_arg(ap, int));
+                break;
+            case 's':
+                if (s.length == 'l') {
+                    va_arg(ap, const wchar_t*);
+                    w.str("(wide)", SIZE_MAX);
+                } else {
+                    w.str(va_arg(ap, const char*), precision >= 0 ? (size_t)precision : SIZE_MAX);
+                }
+                break;
+            case 'p':
+                w.u64((uint64_t)(uintptr_t)va_arg(ap, void*));
+                break;
+            case 'n':
+                va_arg(ap, void*);   // never written through
+                break;
+            default:
+                break;
+        }
+    }
+    r.nargs = w.n;
+    r.truncated = w.full;
+    const uint64_t backlog = pos + 1 - gDequeue.load(std::memory_order_relaxed);
+    cell->seq.store(pos + 1, std::memory_order_release);
+    if (prio >= LOG_LEVEL_ERROR || backlog >= kSlots / 2) wake_drain();
+}
+
+void log_write(int prio, const char* tag, const char* fmt, ...) {
+    if (prio < gMinLevel.load(std::memory_order_relaxed)) return;
+    va_list ap;
+    va_start(ap, fmt);
+    log_vwrite(prio, tag, fmt, false, ap);
+    va_end(ap);
+}
+
+static void core_log(enum retro_log_level level, const char* fmt, ...) {
+    const int prio = (unsigned)level <= RETRO_LOG_ERROR ? LOG_LEVEL_DEBUG + (int)level : LOG_LEVEL_ERROR;
+    if (prio < gCoreMinLevel.load(std::memory_order_relaxed)) return;
+    va_list ap;
+    va_start(ap, fmt);
+    log_vwrite(prio, "Core", fmt, true, ap);
+    va_end(ap);
+}
+
+void log_core_interface(retro_log_callback* out) {
+    out->log = core_log;
+}
+
+void log_set_min_level(int prio) {
+    gMinLevel.store(prio, std::memory_order_relaxed);
+}
+
+void log_set_core_min_level(int prio) {
+    gCoreMinLevel.store(prio, std::memory_order_relaxed);
+}
+
+void log_set_rate_limit(unsigned burst, unsigned per_second) {
+    gRateBurst.store(std::max(burst, 1u), std::memory_order_relaxed);
+    gRateIntervalNs.store(per_second ? 1000000000 / per_second : 0, std::memory_order_relaxed);
+}
+
+// ---------------------------
+// Drain
+// ---------------------------
+
+struct arg_reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    unsigned left;
+
+    bool u64(uint64_t* v) {
+        if (!left || end - p < 8) return false;
+        memcpy(v, p, 8);
+        p += 8;
+        --left;
+        return true;
+    }
+
+    bool str(const char** s) {
+        uint16_t len;
+        if (!left || end - p < 3) return false;
+        memcpy(&len, p, 2);
+        if (end - p < 3 + len) return false;
+        *s = (const char*)p + 2;
+        p += 3 + len;
+        --left;
+        return true;
+    }
+};
+
+struct msg_buf {
+    char* out;
+    size_t cap;
+    size_t n = 0;
+
+    void append(const char* s, size_t len) {
+        len = std::min(len, cap - 1 - n);
+        memcpy(out + n, s, len);
+        n += len;
+    }
+
+    template <typename T>
+    void print(const char* spec, T v) {
+        const int k = snprintf(out + n, cap - n, spec, v);
+        if (k > 0) n += std::min((size_t)k, cap - 1 - n);
+    }
+};
+
+// The spec with its length modifier replaced by one matching the captured type and each '*'
+// replaced by the captured value.
+static bool build_spec(const fmt_spec& s, arg_reader* args, char* spec, size_t cap) {
+    size_t k = 0;
+    for (const char* c = s.begin; c < s.end - 1 && k + 16 < cap; ++c) {
+        if (*c == '*') {
+            uint64_t v;
+            if (!args->u64(&v)) return false;
+            const bool precision = c > s.begin && c[-1] == '.';
+            if (precision && (int)v < 0) {
+                --k;   // a negative precision is taken as if it were omitted
+                continue;
+            }
+            k += (size_t)snprintf(spec + k, cap - k, "%d", (int)v);
+        } else if (!strchr("hlLqjzt", *c)) {
+            spec[k++] = *c;
+        }
+    }
+    if (strchr("diouxX", s.conv)) {
+        spec[k++] = 'l';
+        spec[k++] = 'l';
+    }
+    spec[k++] = s.conv;
+    spec[k] = 0;
+    return true;
+}
+
+static size_t format_record(const log_record& r, char* out, size_t cap) {
+    msg_buf m{out, cap};
+    arg_reader args{r.args, r.args + sizeof(r.args), r.nargs};
+    const char* fmt = r.fmt;
+    if (!fmt && !args.str(&fmt)) fmt = "";
+    bool complete = true;
+    fmt_spec s;
+    const char* p = fmt;
+    while (next_spec(p, &s)) {
+        m.append(p, (size_t)(s.begin - p));
+        p = s.end;
+        char spec[64];
+        uint64_t v;
+        const char* str;
+        if (!s.conv) {
+            m.append(s.begin, (size_t)(s.end - s.begin));
+            continue;
+        }
+        if (s.conv == '%') {
+            m.append("%", 1);
+            continue;
+        }
+        if (!build_spec(s, &args, spec, sizeof(spec))) {
+            complete = false;
+            break;
+        }
+        if (s.conv == 'n') continue;
+        if (s.conv == 's') {
+            if (!args.str(&str)) {
+                complete = false;
+                break;
+            }
+            m.print(spec, str);
+            continue;
+        }
+        if (!args.u64(&v)) {
+            complete = false;
+            break;
+        }
+        switch (s.conv) {
+            case 'd': case 'i': m.print(spec, (long long)v); break;
+            case 'o': case 'u': case 'x': case 'X': m.print(spec, (unsigned long long)v); break;
+            case 'c': m.print(spec, (int)v); break;
+            case 'p': m.print(spec, (void*)(uintptr_t)v); break;
+            default: {
+                double d;
+                memcpy(&d, &v, 8);
+                m.print(spec, d);
+                break;
+            }
+        }
+    }
+    if (complete) m.append(p, strlen(p));
+    if (!complete || r.truncated) m.append(" [...]", 6);
+    while (m.n && m.out[m.n - 1] == '\n') --m.n;
+    out[m.n] = 0;
+    return m.n;
+}
+
+static void platform_sink(int prio, const char* tag, const char* msg) {
+#ifdef __ANDROID__
+    __android_log_write(prio, tag, msg);
+#else
+    host_log_print(prio, tag, "%s", msg);
+#endif
+}
+
+static void sink(int prio, const char* tag, const char* msg) {
+    log_sink_fn fn = gSink.load(std::memory_order_acquire);
+    (fn ? fn : platform_sink)(prio, tag, msg);
+}
+
+static void report(uint64_t* seen, const std::atomic<uint64_t>& count, const char* what) {
+    const uint64_t now = count.load(std::memory_order_relaxed);
+    if (now == *seen) return;
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%llu messages %s", (unsigned long long)(now - *seen), what);
+    *seen = now;
+    sink(LOG_LEVEL_WARN, "Log", msg);
+}
+
+static void drain_main() {
+    trace_set_thread_name("saasemu-log");
+    char msg[kMaxMessage];
+    uint64_t dropped = 0, limited = 0;
+    for (;;) {
+        uint64_t pos = gDequeue.load(std::memory_order_relaxed);
+        for (;;) {
+            log_cell& c = gRing[pos & (kSlots - 1)];
+            if (c.seq.load(std::memory_order_acquire) != pos + 1) break;
+            const int prio = c.rec.prio;
+            const char* tag = c.rec.tag;
+            format_record(c.rec, msg, sizeof(msg));
+            c.seq.store(pos + kSlots, std::memory_order_release);
+            sink(prio, tag, msg);
+            gDequeue.store(++pos, std::memory_order_release);
+        }
+        report(&dropped, gDropped, "dropped, the log ring was full");
+        report(&limited, gRateLimited, "suppressed by the rate limit");
+        if (gStop.load() && pos == gEnqueue.load(std::memory_order_acquire)) break;
+        std::unique_lock<std::mutex> lk(gWakeLock);
+        gWake.wait_for(lk, kDrainInterval, [] { return gWakeup.load() || gStop.load(); });
+        gWakeup.store(false);
+    }
+}
+
+void log_flush() {
+    if (!gStarted.load(std::memory_order_acquire)) return;
+    const uint64_t target = gEnqueue.load(std::memory_order_acquire);
+    const int64_t deadline = monotonic_ns() + 1000000000;
+    while (gDequeue.load(std::memory_order_acquire) < target && monotonic_ns() < deadline) {
+        wake_drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void log_get_stats(log_stats* out) {
+    if (!out) return;
+    out->written = gEnqueue.load(std::memory_order_relaxed);
+    out->dropped = gDropped.load(std::memory_order_relaxed);
+    out->rate_limited = gRateLimited.load(std::memory_order_relaxed);
+}
+
+void log_set_sink(log_sink_fn fn) {
+    gSink.store(fn, std::memory_order_release);
+}
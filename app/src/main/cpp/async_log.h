@@ -0,0 +1,57 @@
+// async_log.h
+// Asynchronous logging for the runtime (LOGI/LOGE in platform.h) and for cores
+// (RETRO_ENVIRONMENT_GET_LOG_INTERFACE).
+//
+// log_write() does not format. It walks the printf format, copies the arguments (strings by value)
+// into a fixed-size record and pushes that onto a bounded lock-free multi-producer ring; a drain
+// thread formats the records and hands them to the platform log (logcat, or stderr on the host).
+// A call never blocks and costs a few hundred nanoseconds on any thread: when the ring is full the
+// message is dropped and counted. Messages below the minimum level are rejected before the format
+// is looked at, and every call site (format string) is rate limited to a burst followed by a steady
+// rate; what is dropped or suppressed is reported by the drain thread.
+//
+// Runtime format strings must be literals, since the record keeps the pointer. Core format strings
+// are copied: the core may be unloaded before its messages are drained.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libretro_defs.h"
+
+// android_LogPriority values
+enum {
+    LOG_LEVEL_DEBUG = 3,
+    LOG_LEVEL_INFO = 4,
+    LOG_LEVEL_WARN = 5,
+    LOG_LEVEL_ERROR = 6
+};
+
+void log_write(int prio, const char* tag, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+// Minimum level of runtime messages and of core messages. INFO for both by default.
+void log_set_min_level(int prio);
+void log_set_core_min_level(int prio);
+
+// Per call site: a burst of this many messages, then per_second. 0 per_second: no limit.
+// 32 then 10 per second by default.
+void log_set_rate_limit(unsigned burst, unsigned per_second);
+
+// The interface handed to cores; messages are tagged "Core".
+void log_core_interface(retro_log_callback* out);
+
+// Wait until everything logged before the call has reached the sink (at most a second).
+void log_flush();
+
+struct log_stats {
+    uint64_t written;        // records queued
+    uint64_t dropped;        // ring full
+    uint64_t rate_limited;   // suppressed by the per-call-site limit
+};
+
+void log_get_stats(log_stats* out);
+
+// Where formatted messages go; nullptr restores the platform log. Called on the drain thread.
+typedef void (*log_sink_fn)(int prio, const char* tag, const char* msg);
+void log_set_sink(log_sink_fn sink);
@@ -0,0 +1,171 @@
+// audio_output.cpp
+// Lock-free audio ring drained by a dedicated output thread, resampled and written to an AudioSink.
+
+#include "audio_output.h"
+#include "audio_ring.h"
+#include "platform.h"
+#include "resampler.h"
+#include "thread_placement.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define LOG_TAG "AudioOutput"
+
+// Ring depth in seconds of audio. Deep enough to ride out a slow frame, shallow enough that
+// queued audio does not become audible latency.
+static const double kRingSeconds = 0.1;
+// Fill the rate controller steers towards, and that playback waits for after startup or an
+// underrun: a video frame's worth of audio plus margin for a late frame.
+static const double kTargetSeconds = 0.04;
+// Largest step adjustment; 0.5% is well below an audible pitch change.
+static const double kMaxRateDelta = 0.005;
+
+static AudioRing gRing;
+static AudioSink* gSink = nullptr;
+static std::thread gThread;
+static std::atomic<bool> gRunning(false);
+static std::mutex gControlLock;   // start/stop
+static unsigned gSampleRate = 0;
+
+static std::atomic<uint64_t> gFramesQueued(0);
+static std::atomic<uint64_t> gFramesPlayed(0);
+static std::atomic<uint64_t> gUnderruns(0);
+static std::atomic<uint64_t> gUnderrunFrames(0);
+static std::atomic<uint64_t> gOverruns(0);
+static std::atomic<uint64_t> gOverrunFrames(0);
+static std::atomic<unsigned> gDeviceRate(0);
+static size_t gTargetFrames = 0;
+static std::atomic<int> gQuality(RESAMPLER_SINC16);
+static std::atomic<int> gActiveQuality(RESAMPLER_SINC16);
+static std::atomic<double> gRateFactor(1.0);
+
+static void output_thread_main() {
+    trace_set_thread_name("saasemu-audio");
+    thread_placement_apply(THREAD_ROLE_AUDIO);
+    const unsigned burst = gSink->burst_frames();
+    const unsigned device_rate = gSink->rate();
+    int quality = gQuality.load(std::memory_order_relaxed);
+    Resampler rs;
+    rs.init(quality, gSampleRate, device_rate);
+    RateController drc;
+    drc.init(gTargetFrames, kMaxRateDelta);
+    const double max_step = (double)gSampleRate / device_rate * (1.0 + kMaxRateDelta);
+    std::vector<int16_t> in(((size_t)(burst * max_step) + 64) * 2);
+    std::vector<int16_t> out((size_t)burst * 2);
+    bool primed = false;
+    gActiveQuality.store(quality, std::memory_order_relaxed);
+    LOGI("output thread started: %s, %u -> %u Hz, burst %u, %s", gSink->name(), gSampleRate, device_rate,
+         burst, resampler_quality_name(quality));
+
+    while (gRunning.load(std::memory_order_relaxed)) {
+        thread_placement_sample(THREAD_ROLE_AUDIO);
+        int q = gQuality.load(std::memory_order_relaxed);
+        if (q != quality) {
+            quality = q;
+            rs.init(quality, gSampleRate, device_rate);
+            rs.set_step_factor(drc.factor());
+            gActiveQuality.store(quality, std::memory_order_relaxed);
+        }
+
+        size_t produced = 0;
+        if (!primed && gRing.fill() >= gTargetFrames) primed = true;
+        if (primed) {
+            TRACE_SCOPE("audio_resample");
+            size_t need = std::min(rs.input_needed(burst), in.size() / 2);
+            rs.push(in.data(), gRing.read(in.data(), need));
+            produced = rs.pull(out.data(), burst);
+            if (produced < burst) {
+                gUnderruns.fetch_add(1, std::memory_order_relaxed);
+                gUnderrunFrames.fetch_add(burst - produced, std::memory_order_relaxed);
+                primed = false; // rebuild some headroom instead of crackling on every burst
+            }
+            rs.set_step_factor(drc.update(gRing.fill()));
+            gRateFactor.store(drc.factor(), std::memory_order_relaxed);
+        }
+        if (produced < burst) memset(&out[produced * 2], 0, (burst - produced) * 4);
+
+        if (!gSink->write(out.data(), burst)) {
+            // device lost (route change, disconnect): reopen and carry on
+            LOGE("%s write failed, reopening", gSink->name());
+            gSink->close();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            if (!gSink->open(gSampleRate)) std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            continue;
+        }
+        gFramesPlayed.fetch_add(burst, std::memory_order_relaxed);
+    }
+    LOGI("output thread stopped");
+}
+
+bool audio_output_start(unsigned sample_rate) {
+    std::lock_guard<std::mutex> lk(gControlLock);
+    if (!sample_rate) return false;
+    if (gRunning.load() && sample_rate == gSampleRate) return true;
+    if (gRunning.load()) {
+        gRunning.store(false);
+        gThread.join();
+        gSink->close();
+    }
+    if (!gSink) gSink = audio_sink_create_default();
+    if (!gSink || !gSink->open(sample_rate)) {
+        LOGE("no audio sink for %u Hz", sample_rate);
+        return false;
+    }
+    gSampleRate = sample_rate;
+    gDeviceRate.store(gSink->rate(), std::memory_order_relaxed);
+    gRing.init((size_t)(sample_rate * kRingSeconds));
+    gTargetFrames = (size_t)(sample_rate * kTargetSeconds);
+    gRunning.store(true);
+    gThread = std::thread(output_thread_main);
+    return true;
+}
+
+void audio_output_stop() {
+    std::lock_guard<std::mutex> lk(gControlLock);
+    if (!gRunning.load()) return;
+    gRunning.store(false);
+    gThread.join();
+    gSink->close();
+    delete gSink;
+    gSink = nullptr;
+}
+
+void audio_output_write(const int16_t* frames, size_t count) {
+    if (!gRunning.load(std::memory_order_relaxed) || !count) return;
+    TRACE_SCOPE_ARG("audio_write", count);
+    size_t n = gRing.write(frames, count);
+    gFramesQueued.fetch_add(n, std::memory_order_relaxed);
+    if (n < count) {
+        gOverruns.fetch_add(1, std::memory_order_relaxed);
+        gOverrunFrames.fetch_add(count - n, std::memory_order_relaxed);
+    }
+}
+
+void audio_output_set_quality(int quality) {
+    if (quality < 0 || quality >= RESAMPLER_QUALITY_COUNT) quality = RESAMPLER_SINC16;
+    gQuality.store(quality, std::memory_order_relaxed);
+}
+
+void audio_output_get_stats(audio_stats* out) {
+    if (!out) return;
+    out->sample_rate = gSampleRate;
+    out->device_rate = gDeviceRate.load(std::memory_order_relaxed);
+    out->frames_queued = gFramesQueued.load(std::memory_order_relaxed);
+    out->frames_played = gFramesPlayed.load(std::memory_order_relaxed);
+    out->underruns = gUnderruns.load(std::memory_order_relaxed);
+    out->underrun_frames = gUnderrunFrames.load(std::memory_order_relaxed);
+    out->overruns = gOverruns.load(std::memory_order_relaxed);
+    out->overrun_frames = gOverrunFrames.load(std::memory_order_relaxed);
+    out->fill_frames = gRunning.load() ? gRing.fill() : 0;
+    out->target_frames = gTargetFrames;
+    out->capacity_frames = gRing.capacity();
+    out->quality = gActiveQuality.load(std::memory_order_relaxed);
+    out->rate_factor = gRateFactor.load(std::memory_order_relaxed);
+}
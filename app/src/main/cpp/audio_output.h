@@ -0,0 +1,58 @@
+// audio_output.h
+// Audio path from the core callbacks to the device.
+//
+// audio_output_write (emulation thread) only copies into a lock-free ring. A dedicated output
+// thread drains the ring in bursts, resamples to the device rate with dynamic rate control (see
+// resampler.h) and writes to an AudioSink; the sink's blocking write paces the thread. When the
+// ring runs dry the burst is padded with silence (underrun); when it is full the newest frames are
+// discarded (overrun).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Device side of the audio path. write() blocks until the device has accepted the frames.
+class AudioSink {
+public:
+    virtual ~AudioSink() {}
+    virtual const char* name() const = 0;
+    // Open for interleaved stereo int16. rate is the source rate; a sink may instead open at its
+    // native rate and report that from rate(). Returns false if unavailable.
+    virtual bool open(unsigned rate) = 0;
+    virtual unsigned rate() const = 0;          // rate actually opened
+    virtual unsigned burst_frames() const = 0;  // preferred write size
+    virtual bool write(const int16_t* frames, size_t count) = 0;
+    virtual void close() = 0;
+};
+
+// Platform default sink: AAudio on Android, see host/host_audio.cpp on the host.
+AudioSink* audio_sink_create_default();
+
+struct audio_stats {
+    unsigned sample_rate;        // core rate
+    unsigned device_rate;
+    uint64_t frames_queued;      // accepted from the core
+    uint64_t frames_played;      // handed to the sink, including silence
+    uint64_t underruns;          // bursts that had to be padded with silence
+    uint64_t underrun_frames;
+    uint64_t overruns;           // writes that did not fit in the ring
+    uint64_t overrun_frames;
+    uint64_t fill_frames;        // ring fill now
+    uint64_t target_frames;      // fill the rate controller steers towards
+    uint64_t capacity_frames;
+    int quality;                 // resampler_quality in use
+    double rate_factor;          // dynamic rate control step adjustment (1.0 = nominal)
+};
+
+// Open the default sink and start the output thread; no-op if already running at this rate.
+bool audio_output_start(unsigned sample_rate);
+void audio_output_stop();
+
+// Emulation thread: queue interleaved stereo frames. Never blocks.
+void audio_output_write(const int16_t* frames, size_t count);
+
+// Resampler quality (resampler_quality); the output thread switches on its next burst.
+void audio_output_set_quality(int quality);
+
+void audio_output_get_stats(audio_stats* out);
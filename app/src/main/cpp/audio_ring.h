@@ -0,0 +1,80 @@
+// audio_ring.h
+// Single-producer / single-consumer ring of interleaved stereo int16 frames.
+//
+// The emulation thread writes and the audio output thread reads. Capacity is a power of two and
+// fixed at construction, so neither side allocates, locks or blocks: a write that does not fit is
+// truncated (the caller counts the overrun) and a read returns what is available.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class AudioRing {
+public:
+    // Allocate room for at least min_frames frames. Only call while neither side is active.
+    void init(size_t min_frames) {
+        size_t cap = 64;
+        while (cap < min_frames) cap <<= 1;
+        buf_.assign(cap * 2, 0);
+        mask_ = cap - 1;
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Frames currently queued; exact for either side, approximate for observers.
+    size_t fill() const {
+        return (size_t)(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+    }
+
+    // Producer: copy up to frames frames in. Returns the number written.
+    size_t write(const int16_t* src, size_t frames) {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        size_t space = capacity() - (size_t)(head - tail);
+        if (frames > space) frames = space;
+        copy_in(head, src, frames);
+        head_.store(head + frames, std::memory_order_release);
+        return frames;
+    }
+
+    // Consumer: copy up to frames frames out. Returns the number read.
+    size_t read(int16_t* dst, size_t frames) {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        size_t avail = (size_t)(head - tail);
+        if (frames > avail) frames = avail;
+        copy_out(tail, dst, frames);
+        tail_.store(tail + frames, std::memory_order_release);
+        return frames;
+    }
+
+    // Consumer: drop everything queued.
+    void clear() { tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+    void copy_in(uint64_t pos, const int16_t* src, size_t frames) {
+        size_t at = (size_t)pos & mask_;
+        size_t first = frames < capacity() - at ? frames : capacity() - at;
+        memcpy(&buf_[at * 2], src, first * 4);
+        if (frames > first) memcpy(&buf_[0], src + first * 2, (frames - first) * 4);
+    }
+
+    void copy_out(uint64_t pos, int16_t* dst, size_t frames) const {
+        size_t at = (size_t)pos & mask_;
+        size_t first = frames < capacity() - at ? frames : capacity() - at;
+        memcpy(dst, &buf_[at * 2], first * 4);
+        if (frames > first) memcpy(dst + first * 2, &buf_[0], (frames - first) * 4);
+    }
+
+    std::vector<int16_t> buf_;
+    size_t mask_ = 0;
+    // monotonically increasing frame counters on separate cache lines
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+};
@@ -0,0 +1,92 @@
+// audio_sink_aaudio.cpp
+// AAudio output for Android (API 26+, the app's minSdk is 29): exclusive low-latency stream,
+// interleaved stereo int16, blocking writes. The stream runs at the device's native rate and the
+// output thread resamples, which keeps AAudio off its own (higher latency) conversion path.
+
+#include "audio_output.h"
+#include "platform.h"
+
+#include <aaudio/AAudio.h>
+
+#define LOG_TAG "AAudioSink"
+
+static const int64_t kWriteTimeoutNs = 100 * 1000000LL;
+
+class AAudioSink : public AudioSink {
+public:
+    ~AAudioSink() override { close(); }
+
+    const char* name() const override { return "aaudio"; }
+
+    bool open(unsigned rate) override {
+        (void)rate; // native rate, see above
+        close();
+        AAudioStreamBuilder* b = nullptr;
+        if (AAudio_createStreamBuilder(&b) != AAUDIO_OK) return false;
+        AAudioStreamBuilder_setDirection(b, AAUDIO_DIRECTION_OUTPUT);
+        AAudioStreamBuilder_setSharingMode(b, AAUDIO_SHARING_MODE_EXCLUSIVE);
+        AAudioStreamBuilder_setPerformanceMode(b, AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
+        AAudioStreamBuilder_setFormat(b, AAUDIO_FORMAT_PCM_I16);
+        AAudioStreamBuilder_setChannelCount(b, 2);
+        aaudio_result_t r = AAudioStreamBuilder_openStream(b, &stream_);
+        AAudioStreamBuilder_delete(b);
+        if (r != AAUDIO_OK) {
+            LOGE("openStream failed: %s", AAudio_convertResultToText(r));
+            stream_ = nullptr;
+            return false;
+        }
+        rate_ = (unsigned)AAudioStream_getSampleRate(stream_);
+        burst_ = (unsigned)AAudioStream_getFramesPerBurst(stream_);
+        if (!burst_) burst_ = 192;
+        // double buffering: the lowest latency that still tolerates one late wakeup
+        AAudioStream_setBufferSizeInFrames(stream_, (int32_t)burst_ * 2);
+        r = AAudioStream_requestStart(stream_);
+        if (r != AAUDIO_OK) {
+            LOGE("requestStart failed: %s", AAudio_convertResultToText(r));
+            close();
+            return false;
+        }
+        LOGI("stream open: %u Hz, burst %u, %s", rate_, burst_,
+             AAudioStream_getSharingMode(stream_) == AAUDIO_SHARING_MODE_EXCLUSIVE ? "exclusive" : "shared");
+        return true;
+    }
+
+    unsigned rate() const override { return rate_; }
+    unsigned burst_frames() const override { return burst_; }
+
+    bool write(const int16_t* frames, size_t count) override {
+        if (!stream_) return false;
+        while (count) {
+            aaudio_result_t n = AAudioStream_write(stream_, frames, (int32_t)count, kWriteTimeoutNs);
+            if (n < 0) {
+                LOGE("write failed: %s", AAudio_convertResultToText(n));
+                return false;
+            }
+            if (n == 0) {
+                // timed out: a stream that takes nothing for that long is stalled. Returning lets
+                // the output thread reopen it and notice a stop instead of retrying forever.
+                LOGE("write timed out, %zu frames not written", count);
+                return false;
+            }
+            frames += (size_t)n * 2;
+            count -= (size_t)n;
+        }
+        return true;
+    }
+
+    void close() override {
+        if (!stream_) return;
+        AAudioStream_requestStop(stream_);
+        AAudioStream_close(stream_);
+        stream_ = nullptr;
+    }
+
+private:
+    AAudioStream* stream_ = nullptr;
+    unsigned rate_ = 0;
+    unsigned burst_ = 0;
+};
+
+AudioSink* audio_sink_create_default() {
+    return new AAudioSink();
+}
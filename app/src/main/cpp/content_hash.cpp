@@ -0,0 +1,220 @@
+// content_hash.cpp
+// Scalar reference kernels, the runtime dispatch and the SHA-1 padding around the block kernels.
+
+#include "content_hash.h"
+#include "content_hash_kernels.h"
+#include "cpu_features.h"
+
+#include <zlib.h>
+
+#include <climits>
+#include <cstring>
+
+uint32_t crc32_scalar(uint32_t crc, const uint8_t* data, size_t n) {
+    // zlib's length is a uInt
+    while (n) {
+        size_t chunk = n > UINT_MAX ? UINT_MAX : n;
+        crc = (uint32_t)crc32(crc, data, (uInt)chunk);
+        data += chunk;
+        n -= chunk;
+    }
+    return crc;
+}
+
+static inline uint32_t rol32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static inline uint32_t load_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+void sha1_blocks_scalar(uint32_t state[5], const uint8_t* blocks, size_t count) {
+    for (; count; --count, blocks += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) w[i] = load_be32(blocks + i * 4);
+        for (int i = 16; i < 80; ++i) w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        // One loop per round function keeps the selection out of the round
+        auto round = [&](uint32_t f, uint32_t k, uint32_t wi) {
+            uint32_t t = rol32(a, 5) + f + e + k + wi;
+            e = d;
+            d = c;
+            c = rol32(b, 30);
+            b = a;
+            a = t;
+        };
+        for (int i = 0; i < 20; ++i) round((b & c) | (~b & d), 0x5A827999, w[i]);
+        for (int i = 20; i < 40; ++i) round(b ^ c ^ d, 0x6ED9EBA1, w[i]);
+        for (int i = 40; i < 60; ++i) round((b & c) | (b & d) | (c & d), 0x8F1BBCDC, w[i]);
+        for (int i = 60; i < 80; ++i) round(b ^ c ^ d, 0xCA62C1D6, w[i]);
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+}
+
+static const crc32_fn kCrc32[HASH_ISA_COUNT] = {
+    crc32_scalar,
+#ifdef CONTENT_HASH_HAVE_X86
+    crc32_pclmul,
+#else
+    nullptr,
+#endif
+#ifdef CONTENT_HASH_HAVE_ARMV8
+    crc32_armv8,
+#else
+    nullptr,
+#endif
+};
+
+static const sha1_blocks_fn kSha1[HASH_ISA_COUNT] = {
+    sha1_blocks_scalar,
+#ifdef CONTENT_HASH_HAVE_X86
+    sha1_blocks_shani,
+#else
+    nullptr,
+#endif
+#ifdef CONTENT_HASH_HAVE_ARMV8
+    sha1_blocks_armv8,
+#else
+    nullptr,
+#endif
+};
+
+static bool crc32_supported(hash_isa isa) {
+    uint32_t f = cpu_features_get();
+    switch (isa) {
+        case HASH_ISA_SCALAR: return true;
+        case HASH_ISA_X86: return (f & CPU_FEATURE_PCLMUL) && (f & CPU_FEATURE_SSE4_1);
+        case HASH_ISA_ARMV8: return (f & CPU_FEATURE_ARM_CRC32) != 0;
+        default: return false;
+    }
+}
+
+static bool sha1_supported(hash_isa isa) {
+    uint32_t f = cpu_features_get();
+    switch (isa) {
+        case HASH_ISA_SCALAR: return true;
+        case HASH_ISA_X86: return (f & CPU_FEATURE_SHA_NI) && (f & CPU_FEATURE_SSE4_1);
+        case HASH_ISA_ARMV8: return (f & CPU_FEATURE_ARM_SHA1) != 0;
+        default: return false;
+    }
+}
+
+static const hash_isa kPreference[] = {HASH_ISA_ARMV8, HASH_ISA_X86};
+
+static hash_isa pick_crc32() {
+    for (hash_isa isa : kPreference)
+        if (kCrc32[isa] && crc32_supported(isa)) return isa;
+    return HASH_ISA_SCALAR;
+}
+
+static hash_isa pick_sha1() {
+    for (hash_isa isa : kPreference)
+        if (kSha1[isa] && sha1_supported(isa)) return isa;
+    return HASH_ISA_SCALAR;
+}
+
+// Selected once on first use; scans start long after startup so there is no init call to forget.
+hash_isa content_crc32_selected_isa() {
+    static const hash_isa isa = pick_crc32();
+    return isa;
+}
+
+hash_isa content_sha1_selected_isa() {
+    static const hash_isa isa = pick_sha1();
+    return isa;
+}
+
+crc32_fn content_crc32_kernel(hash_isa isa) {
+    if (isa < 0 || isa >= HASH_ISA_COUNT || !crc32_supported(isa)) return nullptr;
+    return kCrc32[isa];
+}
+
+sha1_blocks_fn content_sha1_kernel(hash_isa isa) {
+    if (isa < 0 || isa >= HASH_ISA_COUNT || !sha1_supported(isa)) return nullptr;
+    return kSha1[isa];
+}
+
+const char* hash_isa_name(hash_isa isa) {
+    switch (isa) {
+        case HASH_ISA_SCALAR: return "scalar";
+        case HASH_ISA_X86: return "x86";
+        case HASH_ISA_ARMV8: return "armv8";
+        default: return "unknown";
+    }
+}
+
+uint32_t content_crc32(uint32_t crc, const void* data, size_t n) {
+    static const crc32_fn fn = kCrc32[content_crc32_selected_isa()];
+    return fn(crc, (const uint8_t*)data, n);
+}
+
+void hash_to_hex(const uint8_t* bytes, size_t n, char* out) {
+    static const char kHex[] = "0123456789abcdef";
+    for (size_t i = 0; i < n; ++i) {
+        out[i * 2] = kHex[bytes[i] >> 4];
+        out[i * 2 + 1] = kHex[bytes[i] & 15];
+    }
+    out[n * 2] = 0;
+}
+
+// ---------------------------
+// Sha1
+// ---------------------------
+
+Sha1::Sha1(sha1_blocks_fn blocks)
+    : blocks_(blocks ? blocks : kSha1[content_sha1_selected_isa()]) {
+    reset();
+}
+
+void Sha1::reset() {
+    state_[0] = 0x67452301;
+    state_[1] = 0xEFCDAB89;
+    state_[2] = 0x98BADCFE;
+    state_[3] = 0x10325476;
+    state_[4] = 0xC3D2E1F0;
+    buffered_ = 0;
+    total_ = 0;
+}
+
+void Sha1::update(const void* data, size_t n) {
+    const uint8_t* p = (const uint8_t*)data;
+    total_ += n;
+    if (buffered_) {
+        size_t take = 64 - buffered_ < n ? 64 - buffered_ : n;
+        memcpy(buf_ + buffered_, p, take);
+        buffered_ += take;
+        p += take;
+        n -= take;
+        if (buffered_ < 64) return;
+        blocks_(state_, buf_, 1);
+        buffered_ = 0;
+    }
+    // Whole blocks straight from the caller's buffer
+    if (n >= 64) {
+        blocks_(state_, p, n / 64);
+        p += n & ~(size_t)63;
+        n &= 63;
+    }
+    memcpy(buf_, p, n);
+    buffered_ = n;
+}
+
+void Sha1::final(uint8_t digest[20]) {
+    const uint64_t bits = total_ * 8;
+    uint8_t pad[72] = {0x80};
+    size_t pad_len = (buffered_ < 56 ? 56 : 120) - buffered_;
+    for (int i = 0; i < 8; ++i) pad[pad_len + i] = (uint8_t)(bits >> (56 - i * 8));
+    update(pad, pad_len + 8);
+    for (int i = 0; i < 5; ++i) {
+        digest[i * 4] = (uint8_t)(state_[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(state_[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(state_[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)state_[i];
+    }
+    reset();
+}
@@ -0,0 +1,53 @@
+// content_hash.h
+// CRC32 (zlib polynomial, same results as zlib's crc32) and SHA-1 for content identification.
+//
+// Both have a scalar reference and SIMD kernels picked at first use from cpu_features: PCLMULQDQ
+// folding and the SHA extensions on x86, the ARMv8 CRC32 and SHA1 instructions on AArch64. The two
+// algorithms are selected independently since CPUs ship one without the other.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum hash_isa {
+    HASH_ISA_SCALAR = 0,
+    HASH_ISA_X86,     // crc32: pclmul + sse4.1, sha1: sha + sse4.1
+    HASH_ISA_ARMV8,   // crc32: crc32 extension, sha1: sha1 extension
+    HASH_ISA_COUNT
+};
+
+// crc is the running value (0 to start), like zlib.
+typedef uint32_t (*crc32_fn)(uint32_t crc, const uint8_t* data, size_t n);
+// Compresses count 64-byte blocks into state[5].
+typedef void (*sha1_blocks_fn)(uint32_t state[5], const uint8_t* blocks, size_t count);
+
+uint32_t content_crc32(uint32_t crc, const void* data, size_t n);
+
+class Sha1 {
+public:
+    // blocks overrides the selected kernel (benchmarks compare them); nullptr uses the selected one.
+    explicit Sha1(sha1_blocks_fn blocks = nullptr);
+
+    void reset();
+    void update(const void* data, size_t n);
+    void final(uint8_t digest[20]);
+
+private:
+    sha1_blocks_fn blocks_;
+    uint32_t state_[5];
+    uint8_t buf_[64];
+    size_t buffered_ = 0;
+    uint64_t total_ = 0;
+};
+
+// Kernel for a specific ISA, or nullptr when it is not built in or not supported by this CPU.
+crc32_fn content_crc32_kernel(hash_isa isa);
+sha1_blocks_fn content_sha1_kernel(hash_isa isa);
+
+hash_isa content_crc32_selected_isa();
+hash_isa content_sha1_selected_isa();
+const char* hash_isa_name(hash_isa isa);
+
+// Lowercase hex of n bytes into out (2n + 1 chars).
+void hash_to_hex(const uint8_t* bytes, size_t n, char* out);
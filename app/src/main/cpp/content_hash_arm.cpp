@@ -0,0 +1,78 @@
+// content_hash_arm.cpp
+// CRC32 and SHA-1 on the ARMv8 CRC32 and SHA1 instructions. Both are optional in ARMv8.0, so this
+// file is built with +crc+crypto (CMakeLists.txt) and the kernels are only selected after AT_HWCAP
+// says the CPU has them.
+
+#include "content_hash_kernels.h"
+
+#ifdef CONTENT_HASH_HAVE_ARMV8
+
+#include <arm_acle.h>
+#include <arm_neon.h>
+
+#include <cstring>
+
+// ---------------------------
+// CRC32
+// ---------------------------
+
+// __crc32* work on the raw (inverted) register, which is the same polynomial and bit order as zlib.
+uint32_t crc32_armv8(uint32_t crc, const uint8_t* data, size_t n) {
+    crc = ~crc;
+    for (; n && ((uintptr_t)data & 7); --n) crc = __crc32b(crc, *data++);
+    // Four independent loads per iteration keep the load unit ahead of the CRC unit
+    for (; n >= 32; n -= 32, data += 32) {
+        uint64_t v[4];
+        memcpy(v, data, 32);
+        crc = __crc32d(crc, v[0]);
+        crc = __crc32d(crc, v[1]);
+        crc = __crc32d(crc, v[2]);
+        crc = __crc32d(crc, v[3]);
+    }
+    for (; n >= 8; n -= 8, data += 8) {
+        uint64_t v;
+        memcpy(&v, data, 8);
+        crc = __crc32d(crc, v);
+    }
+    for (; n; --n) crc = __crc32b(crc, *data++);
+    return ~crc;
+}
+
+// ---------------------------
+// SHA-1
+// ---------------------------
+
+void sha1_blocks_armv8(uint32_t state[5], const uint8_t* blocks, size_t count) {
+    static const uint32_t kK[4] = {0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6};
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32_t e0 = state[4];
+
+    for (; count; --count, blocks += 64) {
+        const uint32x4_t abcd_save = abcd;
+        uint32_t e = e0;
+        uint32x4_t m[4];
+        for (int i = 0; i < 4; ++i) m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + i * 16)));
+
+        // 20 groups of four rounds; the schedule for group g + 4 is computed from group g's words
+        for (int g = 0; g < 20; ++g) {
+            const uint32x4_t wk = vaddq_u32(m[g & 3], vdupq_n_u32(kK[g / 5]));
+            const uint32_t e_next = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+            switch (g / 5) {
+                case 0: abcd = vsha1cq_u32(abcd, e, wk); break;
+                case 2: abcd = vsha1mq_u32(abcd, e, wk); break;
+                default: abcd = vsha1pq_u32(abcd, e, wk); break;
+            }
+            e = e_next;
+            if (g < 16)
+                m[g & 3] = vsha1su1q_u32(vsha1su0q_u32(m[g & 3], m[(g + 1) & 3], m[(g + 2) & 3]), m[(g + 3) & 3]);
+        }
+
+        e0 += e;
+        abcd = vaddq_u32(abcd, abcd_save);
+    }
+
+    vst1q_u32(state, abcd);
+    state[4] = e0;
+}
+
+#endif
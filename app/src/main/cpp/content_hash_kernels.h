@@ -0,0 +1,26 @@
+// content_hash_kernels.h
+// Per-ISA kernels behind content_hash.h. Only content_hash*.cpp include this.
+//
+// Every kernel must give the same results as the scalar one for any length and alignment; the CRC
+// kernels handle the bulk and hand short tails to zlib.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+uint32_t crc32_scalar(uint32_t crc, const uint8_t* data, size_t n);
+void sha1_blocks_scalar(uint32_t state[5], const uint8_t* blocks, size_t count);
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CONTENT_HASH_HAVE_X86 1
+uint32_t crc32_pclmul(uint32_t crc, const uint8_t* data, size_t n);
+void sha1_blocks_shani(uint32_t state[5], const uint8_t* blocks, size_t count);
+#endif
+
+// content_hash_arm.cpp is built with +crc+crypto on AArch64 (see CMakeLists.txt)
+#if defined(__aarch64__)
+#define CONTENT_HASH_HAVE_ARMV8 1
+uint32_t crc32_armv8(uint32_t crc, const uint8_t* data, size_t n);
+void sha1_blocks_armv8(uint32_t state[5], const uint8_t* blocks, size_t count);
+#endif
@@ -0,0 +1,152 @@
+// content_hash_x86.cpp
+// CRC32 by carry-less multiplication folding and SHA-1 on the SHA extensions. Both use
+// function-level target attributes so the rest of the build keeps the baseline ISA; they are only
+// selected after detection.
+//
+// The CRC fold follows Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ"
+// (the same constants zlib's x86 SIMD path uses): four 128-bit lanes folded 64 bytes at a time,
+// reduced to one lane, then Barrett-reduced to 32 bits.
+
+#include "content_hash_kernels.h"
+
+#ifdef CONTENT_HASH_HAVE_X86
+
+#include <immintrin.h>
+
+#define PCLMUL_FN __attribute__((target("pclmul,sse4.1")))
+#define SHA_FN __attribute__((target("sha,sse4.1")))
+
+// ---------------------------
+// CRC32
+// ---------------------------
+
+// Takes and returns the bit-inverted crc (the raw register); n is a multiple of 16 and at least 64.
+PCLMUL_FN static uint32_t crc32_fold(uint32_t crc, const uint8_t* p, size_t n) {
+    alignas(16) static const uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+    alignas(16) static const uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+    alignas(16) static const uint64_t k5k0[] = {0x0163cd6124, 0x0000000000};
+    alignas(16) static const uint64_t poly[] = {0x01db710641, 0x01f7011641};
+
+    __m128i x1 = _mm_loadu_si128((const __m128i*)(p + 0x00));
+    __m128i x2 = _mm_loadu_si128((const __m128i*)(p + 0x10));
+    __m128i x3 = _mm_loadu_si128((const __m128i*)(p + 0x20));
+    __m128i x4 = _mm_loadu_si128((const __m128i*)(p + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    __m128i k = _mm_load_si128((const __m128i*)k1k2);
+    p += 64;
+    n -= 64;
+
+    while (n >= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, k, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, k, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, k, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(p + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(p + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(p + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(p + 0x30)));
+        p += 64;
+        n -= 64;
+    }
+
+    // Four lanes into one, then the remaining 16-byte chunks
+    k = _mm_load_si128((const __m128i*)k3k4);
+    const __m128i rest[3] = {x2, x3, x4};
+    for (const __m128i& x : rest) {
+        __m128i lo = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11), x), lo);
+    }
+    for (; n >= 16; p += 16, n -= 16) {
+        __m128i lo = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k, 0x11),
+                                         _mm_loadu_si128((const __m128i*)p)), lo);
+    }
+
+    // 128 -> 64 bits
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    k = _mm_loadl_epi64((const __m128i*)k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x00), x2);
+
+    // Barrett reduction to 32 bits
+    k = _mm_load_si128((const __m128i*)poly);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask32), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+uint32_t crc32_pclmul(uint32_t crc, const uint8_t* data, size_t n) {
+    if (n >= 64) {
+        size_t bulk = n & ~(size_t)15;
+        crc = ~crc32_fold(~crc, data, bulk);
+        data += bulk;
+        n -= bulk;
+    }
+    return n ? crc32_scalar(crc, data, n) : crc;
+}
+
+// ---------------------------
+// SHA-1
+// ---------------------------
+
+// One group of four rounds. G is the group (0..19); message words rotate through m[0..3] and the
+// E values through e[0..1], with the schedule for later groups interleaved as Intel's reference does.
+template <int G>
+SHA_FN static inline __attribute__((always_inline)) void sha1_group(__m128i& abcd, __m128i* e,
+                                                                   __m128i* m, const uint8_t* p,
+                                                                   __m128i bswap) {
+    if constexpr (G < 4) m[G] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + G * 16)), bswap);
+    if constexpr (G == 0) e[0] = _mm_add_epi32(e[0], m[0]);
+    else e[G & 1] = _mm_sha1nexte_epu32(e[G & 1], m[G & 3]);
+    e[(G + 1) & 1] = abcd;
+    if constexpr (G >= 3 && G <= 18) m[(G + 1) & 3] = _mm_sha1msg2_epu32(m[(G + 1) & 3], m[G & 3]);
+    abcd = _mm_sha1rnds4_epu32(abcd, e[G & 1], G / 5);
+    if constexpr (G >= 1 && G <= 16) m[(G + 3) & 3] = _mm_sha1msg1_epu32(m[(G + 3) & 3], m[G & 3]);
+    if constexpr (G >= 2 && G <= 17) m[(G + 2) & 3] = _mm_xor_si128(m[(G + 2) & 3], m[G & 3]);
+}
+
+SHA_FN void sha1_blocks_shani(uint32_t state[5], const uint8_t* blocks, size_t count) {
+    const __m128i bswap = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1B);
+    __m128i e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+    for (; count; --count, blocks += 64) {
+        const __m128i abcd_save = abcd, e_save = e0;
+        __m128i e[2] = {e0, e0};
+        __m128i m[4];
+        sha1_group<0>(abcd, e, m, blocks, bswap);
+        sha1_group<1>(abcd, e, m, blocks, bswap);
+        sha1_group<2>(abcd, e, m, blocks, bswap);
+        sha1_group<3>(abcd, e, m, blocks, bswap);
+        sha1_group<4>(abcd, e, m, blocks, bswap);
+        sha1_group<5>(abcd, e, m, blocks, bswap);
+        sha1_group<6>(abcd, e, m, blocks, bswap);
+        sha1_group<7>(abcd, e, m, blocks, bswap);
+        sha1_group<8>(abcd, e, m, blocks, bswap);
+        sha1_group<9>(abcd, e, m, blocks, bswap);
+        sha1_group<10>(abcd, e, m, blocks, bswap);
+        sha1_group<11>(abcd, e, m, blocks, bswap);
+        sha1_group<12>(abcd, e, m, blocks, bswap);
+        sha1_group<13>(abcd, e, m, blocks, bswap);
+        sha1_group<14>(abcd, e, m, blocks, bswap);
+        sha1_group<15>(abcd, e, m, blocks, bswap);
+        sha1_group<16>(abcd, e, m, blocks, bswap);
+        sha1_group<17>(abcd, e, m, blocks, bswap);
+        sha1_group<18>(abcd, e, m, blocks, bswap);
+        sha1_group<19>(abcd, e, m, blocks, bswap);
+        e0 = _mm_sha1nexte_epu32(e[0], e_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+    _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+#endif
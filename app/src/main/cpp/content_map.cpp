@@ -0,0 +1,81 @@
+// content_map.cpp
+// mmap-backed content for retro_game_info.data (see content_map.h).
+
+#include "content_map.h"
+#include "platform.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define LOG_TAG "ContentMap"
+
+// Images at least this large may be backed by transparent huge pages (always possible for the
+// anonymous mappings, only where the kernel supports it for file mappings); smaller ones gain
+// nothing from it.
+static const size_t kHugepageMin = 64u << 20;
+
+bool ContentMapping::map(const char* path) {
+    unmap();
+    if (!path) return false;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file referenced
+    if (p == MAP_FAILED) {
+        LOGE("mmap of %s (%lld bytes) failed", path, (long long)st.st_size);
+        return false;
+    }
+    data_ = p;
+    size_ = (size_t)st.st_size;
+
+    madvise(data_, size_, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+    if (size_ >= kHugepageMin) madvise(data_, size_, MADV_HUGEPAGE);
+#endif
+    return true;
+}
+
+void* ContentMapping::allocate(size_t size) {
+    unmap();
+    if (!size) return nullptr;
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        LOGE("cannot allocate %zu bytes for content", size);
+        return nullptr;
+    }
+    data_ = p;
+    size_ = size;
+#ifdef MADV_HUGEPAGE
+    if (size_ >= kHugepageMin) madvise(data_, size_, MADV_HUGEPAGE);
+#endif
+    return data_;
+}
+
+void ContentMapping::seal() {
+    if (data_) mprotect(data_, size_, PROT_READ);
+}
+
+void ContentMapping::unmap() {
+    if (data_) munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+size_t ContentMapping::cached_bytes() const {
+    if (!data_) return 0;
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> vec((size_ + page - 1) / page);
+    if (mincore(data_, size_, vec.data()) != 0) return 0;
+    size_t pages = 0;
+    for (unsigned char v : vec) pages += v & 1;
+    size_t bytes = pages * page;
+    return bytes < size_ ? bytes : size_;
+}
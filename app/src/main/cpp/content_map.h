@@ -0,0 +1,51 @@
+// content_map.h
+// Read-only memory mapping of a content file, handed to cores as retro_game_info.data.
+//
+// Cores that report need_fullpath = false get the ROM image without the frontend (or the core)
+// reading it into a heap buffer: pages are faulted in from the page cache as the core touches
+// them, stay shared with the cache and never count as dirty memory. MADV_WILLNEED starts
+// read-ahead at map time so the first frames do not stall on the disk.
+//
+// Content extracted from an archive lives in an anonymous mapping of the same object instead, so
+// it is released to the system in one piece when the game is unloaded.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+class ContentMapping {
+public:
+    ContentMapping() = default;
+    ~ContentMapping() { unmap(); }
+    ContentMapping(const ContentMapping&) = delete;
+    ContentMapping& operator=(const ContentMapping&) = delete;
+
+    // Map path read-only. False (and nothing mapped) if the file cannot be opened, is empty, or
+    // mmap fails; the caller then falls back to passing the path alone.
+    bool map(const char* path);
+    void unmap();
+
+    // Anonymous, writable mapping of size bytes to extract into; seal() makes it read-only
+    // before it is handed to a core. nullptr if the allocation fails.
+    void* allocate(size_t size);
+    void seal();
+
+    void swap(ContentMapping& other) {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+    const void* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool mapped() const { return data_ != nullptr; }
+
+    // Bytes of the file currently in the page cache (mincore), i.e. what the core can touch
+    // without waiting for storage; 0 when nothing is mapped.
+    size_t cached_bytes() const;
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
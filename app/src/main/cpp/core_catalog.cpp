@@ -0,0 +1,489 @@
+// core_catalog.cpp
+// ELF inspection, the forked system-info probe and the persisted cache (see core_catalog.h).
+
+#include "core_catalog.h"
+#include "content_hash.h"
+#include "content_map.h"
+#include "libretro_defs.h"
+#include "platform.h"
+#include "zip_archive.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define LOG_TAG "CoreCatalog"
+
+static const char kCacheMagic[8] = {'S', 'C', 'O', 'R', 'E', 'I', 'X', '1'};
+static const int kProbeTimeoutMs = 5000;
+
+// What load_core_internal resolves unconditionally
+static const char* const kRequiredExports[] = {
+    "retro_api_version", "retro_set_environment", "retro_set_video_refresh", "retro_set_audio_sample",
+    "retro_set_audio_sample_batch", "retro_set_input_poll", "retro_set_input_state", "retro_init",
+    "retro_deinit", "retro_load_game", "retro_unload_game", "retro_run", "retro_get_system_av_info",
+};
+
+#if defined(__aarch64__)
+static const int kMachine = EM_AARCH64;
+#elif defined(__arm__)
+static const int kMachine = EM_ARM;
+#elif defined(__x86_64__)
+static const int kMachine = EM_X86_64;
+#elif defined(__i386__)
+static const int kMachine = EM_386;
+#else
+static const int kMachine = EM_NONE;
+#endif
+
+static std::mutex gLock;
+static std::string gCachePath;
+static bool gCacheLoaded = false;
+static std::vector<core_info> gEntries;
+
+static int64_t mtime_ns(const struct stat& st) {
+    return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+static std::string lower_extension(const std::string& name) {
+    size_t dot = name.rfind('.');
+    size_t slash = name.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return "";
+    std::string ext = name.substr(dot + 1);
+    for (char& c : ext) c = (char)tolower((unsigned char)c);
+    return ext;
+}
+
+// ---------------------------
+// ELF
+// ---------------------------
+
+// Walks SHT_DYNSYM for defined functions named retro_*. Every offset is checked against the file:
+// the input is whatever the user imported.
+template <typename Ehdr, typename Shdr, typename Sym>
+static bool dynamic_retro_exports(const uint8_t* base, size_t size, std::vector<std::string>* out) {
+    const Ehdr* eh = (const Ehdr*)base;
+    if (eh->e_shentsize != sizeof(Shdr) || eh->e_shoff == 0 ||
+        eh->e_shoff > size || (size - eh->e_shoff) / sizeof(Shdr) < eh->e_shnum)
+        return false;
+    const Shdr* sh = (const Shdr*)(base + eh->e_shoff);
+    for (unsigned i = 0; i < eh->e_shnum; ++i) {
+        if (sh[i].sh_type != SHT_DYNSYM || sh[i].sh_link >= eh->e_shnum) continue;
+        const Shdr& strtab = sh[sh[i].sh_link];
+        if (sh[i].sh_offset > size || sh[i].sh_size > size - sh[i].sh_offset ||
+            strtab.sh_offset > size || strtab.sh_size > size - strtab.sh_offset)
+            return false;
+        const Sym* syms = (const Sym*)(base + sh[i].sh_offset);
+        const char* strs = (const char*)(base + strtab.sh_offset);
+        const size_t count = sh[i].sh_size / sizeof(Sym);
+        for (size_t s = 0; s < count; ++s) {
+            const unsigned bind = syms[s].st_info >> 4, type = syms[s].st_info & 0xF;
+            if (syms[s].st_shndx == SHN_UNDEF || type != STT_FUNC || (bind != STB_GLOBAL && bind != STB_WEAK))
+                continue;
+            if (syms[s].st_name >= strtab.sh_size) continue;
+            const char* name = strs + syms[s].st_name;
+            const size_t max = strtab.sh_size - syms[s].st_name;
+            if (strncmp(name, "retro_", 6) == 0 && strnlen(name, max) < max) out->push_back(name);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool core_inspect_elf(const char* path, core_info* out) {
+    out->flags &= ~(CORE_INFO_ELF_OK | CORE_INFO_SAVESTATES | CORE_INFO_CONTROLLERS);
+    out->error.clear();
+    ContentMapping map;
+    if (!map.map(path)) {
+        out->error = "cannot read file";
+        return false;
+    }
+    const uint8_t* base = (const uint8_t*)map.data();
+    const size_t size = map.size();
+    if (size < sizeof(Elf32_Ehdr) || memcmp(base, ELFMAG, SELFMAG) != 0) {
+        out->error = "not an ELF file";
+        return false;
+    }
+    const bool is64 = base[EI_CLASS] == ELFCLASS64;
+    if (base[EI_DATA] != ELFDATA2LSB || (is64 && size < sizeof(Elf64_Ehdr))) {
+        out->error = "unsupported ELF layout";
+        return false;
+    }
+    const unsigned machine = is64 ? ((const Elf64_Ehdr*)base)->e_machine : ((const Elf32_Ehdr*)base)->e_machine;
+    const unsigned type = is64 ? ((const Elf64_Ehdr*)base)->e_type : ((const Elf32_Ehdr*)base)->e_type;
+    if (machine != (unsigned)kMachine || is64 != (sizeof(void*) == 8)) {
+        out->error = "built for another ABI (ELF machine " + std::to_string(machine) + (is64 ? ", 64-bit)" : ", 32-bit)");
+        return false;
+    }
+    if (type != ET_DYN) {
+        out->error = "not a shared library";
+        return false;
+    }
+
+    std::vector<std::string> exports;
+    bool ok = is64 ? dynamic_retro_exports<Elf64_Ehdr, Elf64_Shdr, Elf64_Sym>(base, size, &exports)
+                   : dynamic_retro_exports<Elf32_Ehdr, Elf32_Shdr, Elf32_Sym>(base, size, &exports);
+    if (!ok) {
+        out->error = "no dynamic symbol table";
+        return false;
+    }
+    auto has = [&](const char* name) { return std::find(exports.begin(), exports.end(), name) != exports.end(); };
+    std::string missing;
+    for (const char* name : kRequiredExports) {
+        if (!has(name)) missing += (missing.empty() ? "" : " ") + std::string(name);
+    }
+    if (!missing.empty()) {
+        out->error = "missing exports: " + missing;
+        return false;
+    }
+    out->flags |= CORE_INFO_ELF_OK;
+    if (has("retro_serialize_size") && has("retro_serialize") && has("retro_unserialize"))
+        out->flags |= CORE_INFO_SAVESTATES;
+    if (has("retro_set_controller_port_device")) out->flags |= CORE_INFO_CONTROLLERS;
+    return true;
+}
+
+// ---------------------------
+// Probe
+// ---------------------------
+
+static void put(std::string& out, const void* p, size_t n) { out.append((const char*)p, n); }
+
+static void put_str(std::string& out, const char* s) {
+    uint16_t n = (uint16_t)(s ? strnlen(s, 0xFFFF) : 0);
+    put(out, &n, 2);
+    if (n) out.append(s, n);
+}
+
+// Reader over a byte range; every get fails once the range is exhausted.
+struct byte_reader {
+    const uint8_t* p;
+    const uint8_t* end;
+
+    bool get(void* dst, size_t n) {
+        if ((size_t)(end - p) < n) return false;
+        memcpy(dst, p, n);
+        p += n;
+        return true;
+    }
+    bool get_str(std::string* s) {
+        uint16_t n;
+        if (!get(&n, 2) || (size_t)(end - p) < n) return false;
+        s->assign((const char*)p, n);
+        p += n;
+        return true;
+    }
+};
+
+// Child side: report "I" + api + flags + name/version/extensions, or "E" + message, then exit
+// without running the app's atexit handlers or the core's destructors.
+[[noreturn]] static void probe_child(const char* path, int fd) {
+    std::string msg;
+    void* h = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    auto api = h ? (unsigned (*)(void))dlsym(h, "retro_api_version") : nullptr;
+    auto info = h ? (void (*)(retro_system_info*))dlsym(h, "retro_get_system_info") : nullptr;
+    if (!h) {
+        msg = "E";
+        const char* err = dlerror();
+        msg += err ? err : "dlopen failed";
+    } else if (!info) {
+        msg = "Eno retro_get_system_info";
+    } else {
+        retro_system_info si = {};
+        info(&si);
+        uint32_t v = api ? api() : 0;
+        uint32_t flags = (si.need_fullpath ? CORE_INFO_NEED_FULLPATH : 0) | (si.block_extract ? CORE_INFO_BLOCK_EXTRACT : 0);
+        msg = "I";
+        put(msg, &v, 4);
+        put(msg, &flags, 4);
+        put_str(msg, si.library_name);
+        put_str(msg, si.library_version);
+        put_str(msg, si.valid_extensions);
+    }
+    for (size_t done = 0; done < msg.size();) {
+        ssize_t w = write(fd, msg.data() + done, msg.size() - done);
+        if (w <= 0) break;
+        done += (size_t)w;
+    }
+    _exit(0);
+}
+
+// transient: set when the probe failed for reasons that say nothing about the core (no pipe or
+// process, timed out, the child died before answering), so the verdict must not be cached.
+static bool probe_system_info(const char* path, core_info* out, bool* transient) {
+    *transient = false;
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        out->error = "probe: pipe failed";
+        *transient = true;
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        probe_child(path, fds[1]);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        out->error = "probe: fork failed";
+        *transient = true;
+        return false;
+    }
+
+    std::string msg;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kProbeTimeoutMs);
+    bool timed_out = false;
+    for (;;) {
+        int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        pollfd pfd = {fds[0], POLLIN, 0};
+        if (left <= 0 || poll(&pfd, 1, left) == 0) {
+            timed_out = true;
+            break;
+        }
+        char buf[4096];
+        ssize_t n = read(fds[0], buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        msg.append(buf, (size_t)n);
+    }
+    close(fds[0]);
+    if (timed_out) kill(pid, SIGKILL);
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+
+    if (timed_out) {
+        out->error = "probe timed out";
+        *transient = true;
+        return false;
+    }
+    if (WIFSIGNALED(status)) {
+        out->error = "crashed while loading (signal " + std::to_string(WTERMSIG(status)) + ")";
+        return false;
+    }
+    if (msg.empty() || (msg[0] != 'I' && msg[0] != 'E')) {
+        out->error = "probe: no answer";
+        *transient = true;
+        return false;
+    }
+    if (msg[0] == 'E') {
+        out->error = msg.substr(1);
+        return false;
+    }
+    byte_reader r = {(const uint8_t*)msg.data() + 1, (const uint8_t*)msg.data() + msg.size()};
+    uint32_t api = 0, flags = 0;
+    if (!r.get(&api, 4) || !r.get(&flags, 4) || !r.get_str(&out->name) || !r.get_str(&out->version) ||
+        !r.get_str(&out->extensions)) {
+        out->error = "probe: truncated answer";
+        *transient = true;
+        return false;
+    }
+    out->api_version = api;
+    out->flags |= CORE_INFO_PROBED | (flags & (CORE_INFO_NEED_FULLPATH | CORE_INFO_BLOCK_EXTRACT));
+    return true;
+}
+
+// ---------------------------
+// Cache
+// ---------------------------
+
+static void load_cache_locked() {
+    if (gCacheLoaded) return;
+    gCacheLoaded = true;
+    gEntries.clear();
+    ContentMapping map;
+    if (gCachePath.empty() || !map.map(gCachePath.c_str())) return;
+    byte_reader r = {(const uint8_t*)map.data(), (const uint8_t*)map.data() + map.size()};
+    char magic[8];
+    uint32_t count;
+    if (!r.get(magic, 8) || memcmp(magic, kCacheMagic, 8) || !r.get(&count, 4)) return;
+    for (uint32_t i = 0; i < count; ++i) {
+        core_info e = {};
+        if (!r.get_str(&e.path) || !r.get(&e.size, 8) || !r.get(&e.mtime_ns, 8) || !r.get(e.sha1, 20) ||
+            !r.get(&e.flags, 4) || !r.get(&e.api_version, 4) || !r.get_str(&e.name) || !r.get_str(&e.version) ||
+            !r.get_str(&e.extensions) || !r.get_str(&e.error)) {
+            LOGE("Core cache %s is truncated, dropping it", gCachePath.c_str());
+            gEntries.clear();
+            return;
+        }
+        gEntries.push_back(std::move(e));
+    }
+}
+
+static void save_cache_locked() {
+    if (gCachePath.empty()) return;
+    std::string out;
+    put(out, kCacheMagic, 8);
+    uint32_t count = (uint32_t)gEntries.size();
+    put(out, &count, 4);
+    for (const core_info& e : gEntries) {
+        put_str(out, e.path.c_str());
+        put(out, &e.size, 8);
+        put(out, &e.mtime_ns, 8);
+        put(out, e.sha1, 20);
+        put(out, &e.flags, 4);
+        put(out, &e.api_version, 4);
+        put_str(out, e.name.c_str());
+        put_str(out, e.version.c_str());
+        put_str(out, e.extensions.c_str());
+        put_str(out, e.error.c_str());
+    }
+    std::string tmp = gCachePath + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return;
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t w = write(fd, out.data() + done, out.size() - done);
+        if (w <= 0) break;
+        done += (size_t)w;
+    }
+    close(fd);
+    if (done != out.size() || rename(tmp.c_str(), gCachePath.c_str()) != 0) {
+        unlink(tmp.c_str());
+        LOGE("Cannot write core cache %s", gCachePath.c_str());
+    }
+}
+
+static void store_locked(const core_info& info) {
+    for (core_info& e : gEntries) {
+        if (e.path == info.path) {
+            e = info;
+            save_cache_locked();
+            return;
+        }
+    }
+    gEntries.push_back(info);
+    save_cache_locked();
+}
+
+static bool hash_file(const char* path, uint8_t sha1[20]) {
+    ContentMapping map;
+    if (!map.map(path)) return false;
+    Sha1 sha;
+    sha.update(map.data(), map.size());
+    sha.final(sha1);
+    return true;
+}
+
+void core_catalog_set_cache_path(const char* path) {
+    std::lock_guard<std::mutex> lk(gLock);
+    std::string p = path ? path : "";
+    if (p == gCachePath) return;
+    gCachePath = p;
+    gCacheLoaded = false;
+}
+
+bool core_catalog_get(const char* path, core_info* out) {
+    struct stat st;
+    if (!path || stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    {
+        std::lock_guard<std::mutex> lk(gLock);
+        load_cache_locked();
+        for (const core_info& e : gEntries) {
+            if (e.path == path && e.size == (uint64_t)st.st_size && e.mtime_ns == mtime_ns(st)) {
+                *out = e;
+                return true;
+            }
+        }
+    }
+
+    core_info info = {};
+    info.path = path;
+    info.size = (uint64_t)st.st_size;
+    info.mtime_ns = mtime_ns(st);
+    if (!hash_file(path, info.sha1)) return false;
+
+    // Same bytes under another path or with a new mtime (re-imported): nothing to probe
+    {
+        std::lock_guard<std::mutex> lk(gLock);
+        for (const core_info& e : gEntries) {
+            if (!memcmp(e.sha1, info.sha1, 20)) {
+                std::string p = info.path;
+                uint64_t size = info.size;
+                int64_t mt = info.mtime_ns;
+                info = e;
+                info.path = p;
+                info.size = size;
+                info.mtime_ns = mt;
+                store_locked(info);
+                *out = info;
+                return true;
+            }
+        }
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    bool transient = false;
+    if (core_inspect_elf(path, &info)) probe_system_info(path, &info, &transient);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if (info.loadable())
+        LOGI("Core %s: %s %s [%s]%s (%.1f ms)", path, info.name.c_str(), info.version.c_str(), info.extensions.c_str(),
+             info.flags & CORE_INFO_NEED_FULLPATH ? " need_fullpath" : "", ms);
+    else
+        LOGE("Core %s is not loadable: %s", path, info.error.c_str());
+    // only ELF verdicts and answers from a probe that ran to completion; a transient failure is
+    // retried on the next lookup
+    if (!transient) {
+        std::lock_guard<std::mutex> lk(gLock);
+        store_locked(info);
+    }
+    *out = info;
+    return true;
+}
+
+size_t core_catalog_list(const char* dir, std::vector<core_info>* out) {
+    out->clear();
+    DIR* d = dir ? opendir(dir) : nullptr;
+    if (!d) return 0;
+    std::vector<std::string> names;
+    while (dirent* de = readdir(d)) {
+        if (de->d_name[0] != '.' && lower_extension(de->d_name) == "so") names.push_back(de->d_name);
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    for (const std::string& name : names) {
+        core_info info;
+        if (core_catalog_get((std::string(dir) + "/" + name).c_str(), &info)) out->push_back(std::move(info));
+    }
+    return out->size();
+}
+
+static bool takes_extension(const core_info& c, const std::string& ext) {
+    if (!c.loadable() || ext.empty()) return false;
+    std::string list = "|" + c.extensions + "|";
+    for (char& ch : list) ch = (char)tolower((unsigned char)ch);
+    return list.find("|" + ext + "|") != std::string::npos;
+}
+
+bool core_catalog_find_for_content(const char* dir, const char* content_path, core_info* out) {
+    std::vector<core_info> cores;
+    if (!content_path || !core_catalog_list(dir, &cores)) return false;
+    std::string ext = lower_extension(content_path);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const core_info& c : cores) {
+            if (takes_extension(c, ext)) {
+                *out = c;
+                return true;
+            }
+        }
+        // No core reads the archive itself: match on the entry the loader would hand over
+        if (pass || ext != "zip") break;
+        ZipArchive zip;
+        int i = zip.open(content_path) ? zip.pick(nullptr) : -1;
+        if (i < 0) break;
+        ext = lower_extension(zip.entries()[(size_t)i].name);
+    }
+    return false;
+}
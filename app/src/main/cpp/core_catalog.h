@@ -0,0 +1,56 @@
+// core_catalog.h
+// What each installed core is, without loading it into the app process.
+//
+// A core file is first inspected as ELF: its machine must match this process and its dynamic
+// symbol table must define every retro_* function the loader resolves. Cores that pass are probed
+// once in a forked child, which dlopens the core and reports retro_get_system_info (name, version,
+// extensions, need_fullpath); a core that crashes or hangs in its constructors only takes the child
+// down. Results are cached by the SHA-1 of the file and persisted; a lookup whose path, size and mtime
+// are unchanged is a stat and a hash table hit.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum {
+    CORE_INFO_ELF_OK     = 1u << 0,   // ELF for this machine with every required export
+    CORE_INFO_PROBED     = 1u << 1,   // retro_get_system_info was read
+    CORE_INFO_SAVESTATES = 1u << 2,   // exports retro_serialize_size / serialize / unserialize
+    CORE_INFO_CONTROLLERS = 1u << 3,  // exports retro_set_controller_port_device
+    CORE_INFO_NEED_FULLPATH = 1u << 4,
+    CORE_INFO_BLOCK_EXTRACT = 1u << 5
+};
+
+struct core_info {
+    std::string path;
+    uint64_t size;
+    int64_t mtime_ns;
+    uint8_t sha1[20];
+    uint32_t flags;              // CORE_INFO_*
+    unsigned api_version;
+    std::string name;            // library_name
+    std::string version;         // library_version
+    std::string extensions;      // valid_extensions, "sfc|smc"
+    std::string error;           // why the core is not loadable, empty when it is
+
+    bool loadable() const { return (flags & CORE_INFO_ELF_OK) && error.empty(); }
+};
+
+// ELF check alone: machine, and the required retro_* exports (missing ones listed in error).
+bool core_inspect_elf(const char* path, core_info* out);
+
+// Persisted cache file; loaded on first use. Empty keeps the cache in memory only.
+void core_catalog_set_cache_path(const char* path);
+
+// Cached inspection + probe of one core. False if the file cannot be read at all.
+bool core_catalog_get(const char* path, core_info* out);
+
+// Every *.so in dir, sorted by file name.
+size_t core_catalog_list(const char* dir, std::vector<core_info>* out);
+
+// First loadable core in dir whose extensions cover content_path; for a .zip that no core takes
+// as is, the extension of the entry the loader would extract. False when none does.
+bool core_catalog_find_for_content(const char* dir, const char* content_path, core_info* out);
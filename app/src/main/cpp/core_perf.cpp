@@ -0,0 +1,198 @@
+// core_perf.cpp
+// The retro_perf_callback implementation and the registry of core-owned counters.
+
+#include "core_perf.h"
+#include "cpu_features.h"
+#include "platform.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define LOG_TAG "CorePerf"
+
+// As many as RetroArch accepts from a core; cores register a handful.
+static const size_t kMaxCounters = 64;
+
+static std::atomic<retro_perf_counter*> gCounters[kMaxCounters];
+static std::atomic<size_t> gCount(0);
+static std::atomic<bool> gFullLogged(false);
+static std::mutex gLock;   // snapshots against unload
+
+static int64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t core_perf_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return (uint64_t)monotonic_ns();
+#endif
+}
+
+// Tick rate. The ARM generic timer reports its frequency; the TSC is measured against
+// CLOCK_MONOTONIC from the last reset, which is seconds of play by the time anyone asks.
+static std::atomic<uint64_t> gBaseTicks(0);
+static std::atomic<int64_t> gBaseNs(0);
+
+static void calibration_start() {
+    gBaseNs.store(monotonic_ns(), std::memory_order_relaxed);
+    gBaseTicks.store(core_perf_ticks(), std::memory_order_relaxed);
+}
+
+double core_perf_ticks_per_ns() {
+#if defined(__aarch64__)
+    uint64_t freq;
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    return freq ? freq / 1e9 : 1.0;
+#elif defined(__x86_64__) || defined(__i386__)
+    static const int64_t kMinSpanNs = 10000000;
+    if (!gBaseNs.load(std::memory_order_relaxed)) calibration_start();
+    int64_t span = monotonic_ns() - gBaseNs.load(std::memory_order_relaxed);
+    if (span < kMinSpanNs) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(kMinSpanNs - span));
+        span = monotonic_ns() - gBaseNs.load(std::memory_order_relaxed);
+    }
+    const uint64_t ticks = core_perf_ticks() - gBaseTicks.load(std::memory_order_relaxed);
+    return span > 0 && ticks ? (double)ticks / span : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+uint64_t core_perf_simd_features() {
+    const uint32_t f = cpu_features_get();
+    uint64_t simd = 0;
+    // MMX, SSE and CMOV predate SSE2 on every x86 that has it
+    if (f & CPU_FEATURE_SSE2) simd |= RETRO_SIMD_MMX | RETRO_SIMD_SSE | RETRO_SIMD_SSE2 | RETRO_SIMD_CMOV;
+    if (f & CPU_FEATURE_SSE3) simd |= RETRO_SIMD_SSE3;
+    if (f & CPU_FEATURE_SSSE3) simd |= RETRO_SIMD_SSSE3;
+    if (f & CPU_FEATURE_SSE4_1) simd |= RETRO_SIMD_SSE4;
+    if (f & CPU_FEATURE_SSE4_2) simd |= RETRO_SIMD_SSE42;
+    if (f & CPU_FEATURE_AVX) simd |= RETRO_SIMD_AVX;
+    if (f & CPU_FEATURE_AVX2) simd |= RETRO_SIMD_AVX2;
+    if (f & CPU_FEATURE_POPCNT) simd |= RETRO_SIMD_POPCNT;
+    if (f & CPU_FEATURE_AES) simd |= RETRO_SIMD_AES;
+    if (f & CPU_FEATURE_NEON) simd |= RETRO_SIMD_NEON;
+#if defined(__aarch64__)
+    // Advanced SIMD and VFPv4 are part of ARMv8-A
+    simd |= RETRO_SIMD_ASIMD | RETRO_SIMD_VFPV3 | RETRO_SIMD_VFPV4;
+#endif
+    return simd;
+}
+
+// ---------------------------
+// retro_perf_callback
+// ---------------------------
+
+static retro_time_t perf_get_time_usec() {
+    return monotonic_ns() / 1000;
+}
+
+static retro_perf_tick_t perf_get_counter() {
+    return core_perf_ticks();
+}
+
+static uint64_t perf_get_cpu_features() {
+    return core_perf_simd_features();
+}
+
+static void perf_register(retro_perf_counter* c) {
+    if (!c || c->registered) return;
+    const size_t n = gCount.load(std::memory_order_relaxed);
+    if (n >= kMaxCounters) {
+        if (!gFullLogged.exchange(true)) LOGE("more than %zu perf counters, %s is not tracked", kMaxCounters,
+                                              c->ident ? c->ident : "?");
+        c->registered = true;
+        return;
+    }
+    gCounters[n].store(c, std::memory_order_relaxed);
+    gCount.store(n + 1, std::memory_order_release);
+    c->registered = true;
+}
+
+static void perf_register_untracked(retro_perf_counter* c) {
+    if (c) c->registered = true;
+}
+
+static void perf_start(retro_perf_counter* c) {
+    c->call_cnt++;
+    c->start = core_perf_ticks();
+}
+
+static void perf_stop(retro_perf_counter* c) {
+    c->total += core_perf_ticks() - c->start;
+}
+
+static void log_counters(const char* who) {
+    std::vector<core_perf_counter> counters;
+    if (!core_perf_snapshot(&counters)) return;
+    for (const core_perf_counter& c : counters) {
+        LOGI("%s: %s: %llu calls, %.3f ms total, %.2f us avg", who, c.ident.c_str(), (unsigned long long)c.calls,
+             c.total_ns / 1e6, c.calls ? c.total_ns / 1e3 / c.calls : 0.0);
+    }
+}
+
+static void perf_log() {
+    log_counters("perf");
+}
+
+void core_perf_interface(retro_perf_callback* out, bool track) {
+    out->get_time_usec = perf_get_time_usec;
+    out->get_cpu_features = perf_get_cpu_features;
+    out->get_perf_counter = perf_get_counter;
+    out->perf_register = track ? perf_register : perf_register_untracked;
+    out->perf_start = perf_start;
+    out->perf_stop = perf_stop;
+    out->perf_log = perf_log;
+}
+
+// ---------------------------
+// Registry
+// ---------------------------
+
+void core_perf_reset() {
+    std::lock_guard<std::mutex> lk(gLock);
+    gCount.store(0, std::memory_order_release);
+    gFullLogged.store(false, std::memory_order_relaxed);
+    calibration_start();
+}
+
+size_t core_perf_snapshot(std::vector<core_perf_counter>* out) {
+    out->clear();
+    const double per_ns = core_perf_ticks_per_ns();
+    std::lock_guard<std::mutex> lk(gLock);
+    const size_t n = gCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) {
+        retro_perf_counter* c = gCounters[i].load(std::memory_order_relaxed);
+        core_perf_counter r;
+        r.ident = c->ident ? c->ident : "?";
+        // written by the core on the emulation thread; whole 64-bit loads, never torn
+        r.calls = __atomic_load_n(&c->call_cnt, __ATOMIC_RELAXED);
+        r.ticks = __atomic_load_n(&c->total, __ATOMIC_RELAXED);
+        r.total_ns = (uint64_t)(r.ticks / per_ns);
+        out->push_back(r);
+    }
+    return out->size();
+}
+
+void core_perf_unload(const char* core_path) {
+    const char* slash = core_path ? strrchr(core_path, '/') : nullptr;
+    log_counters(slash ? slash + 1 : core_path ? core_path : "core");
+    std::lock_guard<std::mutex> lk(gLock);
+    gCount.store(0, std::memory_order_release);
+}
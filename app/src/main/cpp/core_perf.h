@@ -0,0 +1,45 @@
+// core_perf.h
+// RETRO_ENVIRONMENT_GET_PERF_INTERFACE: clocks, CPU features and perf counters for cores.
+//
+// get_perf_counter reads the cheapest monotonic tick source there is (rdtsc on x86, CNTVCT_EL0 on
+// AArch64, clock_gettime elsewhere); get_time_usec is CLOCK_MONOTONIC. get_cpu_features maps
+// cpu_features_get() to RETRO_SIMD_* so cores pick the same SIMD paths the runtime does.
+//
+// Counters a core registers stay owned by the core. The runtime keeps pointers to them while the
+// core is loaded, converts their ticks to nanoseconds for the stats surface and logs them all when
+// the core is unloaded; core_perf_unload() must run before dlclose.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "libretro_defs.h"
+
+struct core_perf_counter {
+    std::string ident;
+    uint64_t calls;
+    uint64_t ticks;
+    uint64_t total_ns;
+};
+
+// The interface handed to cores. Counters are only tracked when track is set: the run-ahead
+// secondary instance is unloaded on its own schedule, so its counters are not kept.
+void core_perf_interface(retro_perf_callback* out, bool track);
+
+// Tick source of get_perf_counter, and its rate as measured (or reported by the CPU).
+uint64_t core_perf_ticks();
+double core_perf_ticks_per_ns();
+
+uint64_t core_perf_simd_features();   // RETRO_SIMD_*
+
+// A core was loaded: forget counters and restart tick calibration.
+void core_perf_reset();
+
+// Registered counters in registration order. Any thread; values may be a frame old.
+size_t core_perf_snapshot(std::vector<core_perf_counter>* out);
+
+// Log every counter of the core being unloaded and drop the pointers. Before dlclose.
+void core_perf_unload(const char* core_path);
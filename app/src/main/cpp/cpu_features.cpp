@@ -0,0 +1,86 @@
+// cpu_features.cpp
+// CPU feature detection: cpuid via the compiler builtins on x86, AT_HWCAP on ARM.
+// NEON is architecturally guaranteed on AArch64; its CRC32 and SHA1 instructions are not.
+
+#include "cpu_features.h"
+
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#if defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_AES
+#define HWCAP_AES (1 << 3)
+#endif
+#ifndef HWCAP_SHA1
+#define HWCAP_SHA1 (1 << 5)
+#endif
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+
+#if defined(__arm__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+
+static uint32_t detect() {
+    uint32_t f = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) f |= CPU_FEATURE_SSE2;
+    if (__builtin_cpu_supports("sse3")) f |= CPU_FEATURE_SSE3;
+    if (__builtin_cpu_supports("ssse3")) f |= CPU_FEATURE_SSSE3;
+    if (__builtin_cpu_supports("sse4.1")) f |= CPU_FEATURE_SSE4_1;
+    if (__builtin_cpu_supports("sse4.2")) f |= CPU_FEATURE_SSE4_2;
+    if (__builtin_cpu_supports("avx")) f |= CPU_FEATURE_AVX;
+    if (__builtin_cpu_supports("avx2")) f |= CPU_FEATURE_AVX2;
+    if (__builtin_cpu_supports("popcnt")) f |= CPU_FEATURE_POPCNT;
+    unsigned a, b, c, d;
+    if (__get_cpuid(1, &a, &b, &c, &d)) {
+        if (c & bit_PCLMUL) f |= CPU_FEATURE_PCLMUL;
+        if (c & bit_AES) f |= CPU_FEATURE_AES;
+    }
+    if (__get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & (1u << 29))) f |= CPU_FEATURE_SHA_NI;
+#elif defined(__aarch64__)
+    f |= CPU_FEATURE_NEON;
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+    if (hwcap & HWCAP_CRC32) f |= CPU_FEATURE_ARM_CRC32;
+    if (hwcap & HWCAP_SHA1) f |= CPU_FEATURE_ARM_SHA1;
+    if (hwcap & HWCAP_AES) f |= CPU_FEATURE_AES;
+#elif defined(__arm__)
+    if (getauxval(AT_HWCAP) & HWCAP_NEON) f |= CPU_FEATURE_NEON;
+#endif
+    return f;
+}
+
+uint32_t cpu_features_get() {
+    static const uint32_t features = detect();
+    return features;
+}
+
+const char* cpu_features_string() {
+    static const std::string names = [] {
+        static const struct { uint32_t bit; const char* name; } kNames[] = {
+            {CPU_FEATURE_SSE2, "sse2"}, {CPU_FEATURE_SSE3, "sse3"}, {CPU_FEATURE_SSSE3, "ssse3"},
+            {CPU_FEATURE_SSE4_1, "sse4.1"}, {CPU_FEATURE_SSE4_2, "sse4.2"}, {CPU_FEATURE_AVX, "avx"},
+            {CPU_FEATURE_AVX2, "avx2"}, {CPU_FEATURE_NEON, "neon"}, {CPU_FEATURE_PCLMUL, "pclmul"},
+            {CPU_FEATURE_SHA_NI, "sha"}, {CPU_FEATURE_ARM_CRC32, "crc32"}, {CPU_FEATURE_ARM_SHA1, "sha1"},
+            {CPU_FEATURE_POPCNT, "popcnt"}, {CPU_FEATURE_AES, "aes"},
+        };
+        std::string s;
+        for (const auto& n : kNames) {
+            if (!(cpu_features_get() & n.bit)) continue;
+            if (!s.empty()) s += ' ';
+            s += n.name;
+        }
+        return s.empty() ? std::string("none") : s;
+    }();
+    return names.c_str();
+}
@@ -0,0 +1,29 @@
+// cpu_features.h
+// Runtime CPU feature detection, done once and cached. Used to pick SIMD kernels.
+
+#pragma once
+
+#include <cstdint>
+
+enum {
+    CPU_FEATURE_SSE2   = 1u << 0,
+    CPU_FEATURE_SSE3   = 1u << 1,
+    CPU_FEATURE_SSSE3  = 1u << 2,
+    CPU_FEATURE_SSE4_1 = 1u << 3,
+    CPU_FEATURE_SSE4_2 = 1u << 4,
+    CPU_FEATURE_AVX    = 1u << 5,
+    CPU_FEATURE_AVX2   = 1u << 6,
+    CPU_FEATURE_NEON   = 1u << 7,
+    CPU_FEATURE_PCLMUL = 1u << 8,   // carry-less multiply (CRC folding)
+    CPU_FEATURE_SHA_NI = 1u << 9,   // x86 SHA extensions
+    CPU_FEATURE_ARM_CRC32 = 1u << 10,
+    CPU_FEATURE_ARM_SHA1  = 1u << 11,
+    CPU_FEATURE_POPCNT = 1u << 12,
+    CPU_FEATURE_AES    = 1u << 13   // AES-NI, or the ARMv8 AES instructions
+};
+
+// Bitmask of CPU_FEATURE_* supported by the CPU we are running on.
+uint32_t cpu_features_get();
+
+// Human readable list, e.g. "sse2 sse3 ssse3 avx avx2".
+const char* cpu_features_string();
@@ -0,0 +1,128 @@
+// frame_pacer.cpp
+// Hybrid sleep-then-spin frame pacing with absolute deadlines (see frame_pacer.h).
+
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CPU_RELAX() _mm_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
+// Sleep until this long before the deadline, then spin. Covers timer slack and wakeup latency.
+static const int64_t kSpinMarginNs = 1000000;
+// Re-anchor the schedule when this many periods behind.
+static const int64_t kMaxLagPeriods = 4;
+// Jitter percentiles are computed over this many recent frames.
+static const size_t kJitterWindow = 1024;
+
+static std::atomic<int64_t> gPeriodNs(16666667);
+static std::atomic<bool> gEnabled(true);
+
+// Emulation thread only
+static int64_t gNextDeadline = 0;
+static int64_t gLastReturn = 0;
+
+static std::atomic<uint64_t> gFrames(0);
+static std::atomic<uint64_t> gLateFrames(0);
+static std::atomic<uint64_t> gResyncs(0);
+static std::atomic<int64_t> gJitter[kJitterWindow];
+static std::atomic<uint64_t> gJitterCount(0);
+
+static int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void sleep_until_ns(int64_t t) {
+    timespec ts;
+    ts.tv_sec = t / 1000000000LL;
+    ts.tv_nsec = t % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) != 0) {
+        // EINTR: go back to sleep until the same absolute time
+    }
+}
+
+static int64_t period_for(double fps) {
+    if (!(fps > 1.0 && fps < 100000.0)) fps = 60.0; // fast-forward multiplies the core rate
+    return (int64_t)(1e9 / fps + 0.5);
+}
+
+void pacer_reset(double fps) {
+    gPeriodNs.store(period_for(fps), std::memory_order_relaxed);
+    gNextDeadline = 0;
+    gLastReturn = 0;
+    gFrames.store(0, std::memory_order_relaxed);
+    gLateFrames.store(0, std::memory_order_relaxed);
+    gResyncs.store(0, std::memory_order_relaxed);
+    gJitterCount.store(0, std::memory_order_relaxed);
+}
+
+void pacer_set_fps(double fps) {
+    gPeriodNs.store(period_for(fps), std::memory_order_relaxed);
+}
+
+void pacer_set_enabled(bool enabled) {
+    gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool pacer_enabled() {
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+int64_t pacer_wait() {
+    const int64_t period = gPeriodNs.load(std::memory_order_relaxed);
+    int64_t now = now_ns();
+
+    if (gEnabled.load(std::memory_order_relaxed)) {
+        if (!gNextDeadline) gNextDeadline = now;
+        if (now > gNextDeadline) {
+            gLateFrames.fetch_add(1, std::memory_order_relaxed);
+            if (now - gNextDeadline > kMaxLagPeriods * period) {
+                gNextDeadline = now;
+                gResyncs.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else {
+            if (gNextDeadline - now > kSpinMarginNs) sleep_until_ns(gNextDeadline - kSpinMarginNs);
+            while ((now = now_ns()) < gNextDeadline) CPU_RELAX();
+        }
+
+        int64_t dev = now - gNextDeadline;
+        uint64_t n = gJitterCount.load(std::memory_order_relaxed);
+        gJitter[n % kJitterWindow].store(dev < 0 ? -dev : dev, std::memory_order_relaxed);
+        gJitterCount.store(n + 1, std::memory_order_relaxed);
+        gNextDeadline += period;
+    } else {
+        gNextDeadline = 0;
+    }
+
+    gFrames.fetch_add(1, std::memory_order_relaxed);
+    int64_t delta = gLastReturn ? now - gLastReturn : 0;
+    gLastReturn = now;
+    return delta;
+}
+
+void pacer_get_stats(pacer_stats* out) {
+    if (!out) return;
+    out->target_fps = 1e9 / (double)gPeriodNs.load(std::memory_order_relaxed);
+    out->frames = gFrames.load(std::memory_order_relaxed);
+    out->late_frames = gLateFrames.load(std::memory_order_relaxed);
+    out->resyncs = gResyncs.load(std::memory_order_relaxed);
+
+    size_t n = (size_t)std::min<uint64_t>(gJitterCount.load(std::memory_order_relaxed), kJitterWindow);
+    std::vector<int64_t> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = gJitter[i].load(std::memory_order_relaxed);
+    std::sort(v.begin(), v.end());
+    out->jitter_p50_ns = n ? v[n / 2] : 0;
+    out->jitter_p99_ns = n ? v[std::min(n - 1, n * 99 / 100)] : 0;
+    out->jitter_max_ns = n ? v[n - 1] : 0;
+}
@@ -0,0 +1,37 @@
+// frame_pacer.h
+// Paces the emulation thread to the core's frame rate (retro_system_timing.fps).
+//
+// Deadlines are absolute (start + n * period), so rounding and oversleep never accumulate into
+// drift. Each wait sleeps with clock_nanosleep(TIMER_ABSTIME) until shortly before the deadline and
+// spins the rest of the way. If the thread falls more than a few frames behind (core too slow,
+// process stopped) the schedule is re-anchored instead of trying to catch up with a burst.
+
+#pragma once
+
+#include <cstdint>
+
+struct pacer_stats {
+    double target_fps;
+    uint64_t frames;         // waits performed
+    uint64_t late_frames;    // deadline already passed when pacer_wait was entered
+    uint64_t resyncs;        // schedule re-anchored after falling behind
+    int64_t jitter_p50_ns;   // |wake time - deadline| over the recent window
+    int64_t jitter_p99_ns;
+    int64_t jitter_max_ns;
+};
+
+// Start a new schedule at the given rate; the first deadline is "now".
+void pacer_reset(double fps);
+
+// Change the rate (RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO); takes effect from the next frame.
+void pacer_set_fps(double fps);
+
+// Disabled pacing makes pacer_wait return immediately (benchmarks, unlimited fast-forward).
+void pacer_set_enabled(bool enabled);
+bool pacer_enabled();
+
+// Block until the next frame deadline. Returns the time since the previous pacer_wait returned,
+// in nanoseconds (0 on the first frame after a reset).
+int64_t pacer_wait();
+
+void pacer_get_stats(pacer_stats* out);
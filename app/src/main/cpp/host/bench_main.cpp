@@ -0,0 +1,1498 @@
+// bench_main.cpp
+// saasemu_bench: micro-benchmarks for runtime components on the Linux host.
+// Every benchmark first checks its optimized paths against the reference implementation and
+// exits non-zero on a mismatch, so numbers are never reported for a broken kernel.
+//
+//   saasemu_bench convert [--width N] [--height N] [--iters N]
+//   saasemu_bench rewind [--state-kb N] [--dirty N] [--frames N] [--budget-mb N]
+//   saasemu_bench resampler [--iters N] [--seconds N] [--ppm N]
+//   saasemu_bench input [--frames N]
+//   saasemu_bench scan [--files N] [--iters N] [--dir PATH]
+//   saasemu_bench cores [--iters N] [--dir PATH] [--core PATH]
+//   saasemu_bench stats [--frames N]
+//   saasemu_bench trace [--frames N]
+//   saasemu_bench coreperf [--iters N]
+//   saasemu_bench log [--frames N]
+//   saasemu_bench placement [--frames N] [--dir PATH]
+
+#include "libretro_defs.h"
+#include "async_log.h"
+#include "pixel_convert.h"
+#include "cpu_features.h"
+#include "audio_ring.h"
+#include "content_hash.h"
+#include "core_catalog.h"
+#include "core_perf.h"
+#include "input_state.h"
+#include "perf_stats.h"
+#include "resampler.h"
+#include "rewind_buffer.h"
+#include "rom_library.h"
+#include "thread_placement.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct bench_args {
+    unsigned width = 1280;
+    unsigned height = 960;
+    unsigned iters = 200;
+    unsigned state_kb = 128;   // rewind: savestate size
+    unsigned dirty = 512;      // rewind: bytes changed per frame
+    unsigned frames = 3600;    // rewind: frames captured
+    unsigned budget_mb = 32;   // rewind: history budget
+    unsigned seconds = 3600;   // resampler: simulated playback time
+    unsigned ppm = 100;        // resampler: device clock error, tried in both directions
+    unsigned files = 10000;    // scan: library size
+    std::string dir = "/tmp/saasemu_scan_bench";   // scan, cores, placement: scratch directory
+    std::string core;          // cores: defaults to the synthetic core next to the executable
+};
+
+static double seconds_since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// ---------------------------
+// convert
+// ---------------------------
+
+static const struct { int format; const char* name; unsigned bpp; } kFormats[] = {
+    {RETRO_PIXEL_FORMAT_RGB565, "rgb565", 2},
+    {RETRO_PIXEL_FORMAT_0RGB1555, "0rgb1555", 2},
+    {RETRO_PIXEL_FORMAT_XRGB8888, "xrgb8888", 4},
+};
+
+// Compares a kernel with the scalar reference on every 16-bit input value (or random 32-bit
+// values), at every start offset and length up to 67 pixels so all tail paths are hit.
+static bool verify_kernel(pixel_row_fn ref, pixel_row_fn fn, unsigned bpp) {
+    const unsigned count = 65536 + 67;
+    std::vector<uint8_t> src(count * bpp + 64);
+    std::mt19937 rng(1234);
+    for (unsigned i = 0; i < count; ++i) {
+        uint32_t v = bpp == 2 ? (i & 0xFFFF) : rng();
+        memcpy(&src[i * bpp], &v, bpp);
+    }
+    std::vector<uint8_t> a(count * 4 + 64), b(count * 4 + 64);
+    ref(a.data(), src.data(), count);
+    fn(b.data(), src.data(), count);
+    if (memcmp(a.data(), b.data(), count * 4) != 0) return false;
+    for (unsigned off = 0; off < 4; ++off) {
+        for (unsigned len = 0; len <= 67; ++len) {
+            memset(a.data(), 0xA5, len * 4 + 16);
+            memset(b.data(), 0xA5, len * 4 + 16);
+            ref(a.data() + off, src.data() + off * bpp + 1000 * bpp, len);
+            fn(b.data() + off, src.data() + off * bpp + 1000 * bpp, len);
+            if (memcmp(a.data(), b.data(), len * 4 + 16) != 0) return false;
+        }
+    }
+    return true;
+}
+
+static int bench_convert(const bench_args& args) {
+    pixel_convert_init();
+    printf("cpu: %s, selected: %s\n", cpu_features_string(),
+           pixel_isa_name(pixel_convert_selected_isa()));
+    const size_t pixels = (size_t)args.width * args.height;
+    std::vector<uint8_t> src(pixels * 4), dst(pixels * 4);
+    std::mt19937 rng(42);
+    for (auto& b : src) b = (uint8_t)rng();
+
+    int failures = 0;
+    for (const auto& f : kFormats) {
+        pixel_row_fn ref = pixel_convert_kernel(PIXEL_ISA_SCALAR, f.format);
+        for (int isa = 0; isa < PIXEL_ISA_COUNT; ++isa) {
+            pixel_row_fn fn = pixel_convert_kernel((pixel_isa)isa, f.format);
+            if (!fn) continue;
+            if (!verify_kernel(ref, fn, f.bpp)) {
+                printf("%-9s %-7s MISMATCH against scalar\n", f.name, pixel_isa_name((pixel_isa)isa));
+                failures++;
+                continue;
+            }
+            Clock::time_point t0 = Clock::now();
+            for (unsigned it = 0; it < args.iters; ++it) {
+                for (unsigned y = 0; y < args.height; ++y) {
+                    fn(dst.data() + (size_t)y * args.width * 4,
+                       src.data() + (size_t)y * args.width * f.bpp, args.width);
+                }
+            }
+            double s = seconds_since(t0);
+            printf("%-9s %-7s %8.1f Mpix/s %8.3f ms/frame (%ux%u)\n", f.name,
+                   pixel_isa_name((pixel_isa)isa), pixels * args.iters / s / 1e6,
+                   s * 1e3 / args.iters, args.width, args.height);
+        }
+    }
+    return failures ? 1 : 0;
+}
+
+// ---------------------------
+// rewind
+// ---------------------------
+
+// Mutate a synthetic savestate the way a game frame does: scattered single-byte writes plus a
+// small contiguous block (sprite table, audio registers).
+static void step_state(std::vector<uint8_t>& st, unsigned dirty, std::mt19937& rng) {
+    for (unsigned i = 0; i < dirty; ++i) st[rng() % st.size()] = (uint8_t)rng();
+    size_t block = std::min<size_t>(256, st.size());
+    size_t at = rng() % (st.size() - block + 1);
+    for (size_t i = 0; i < block; ++i) st[at + i] += (uint8_t)(i + 1);
+}
+
+static int bench_rewind(const bench_args& args) {
+    const size_t size = (size_t)args.state_kb * 1024 + 24; // odd size exercises the word padding
+    const size_t budget = (size_t)args.budget_mb << 20;
+    const unsigned kVerify = 256; // newest states kept in full to check pops against
+
+    RewindBuffer rb;
+    rb.configure(size, budget);
+    std::vector<uint8_t> st(size, 0), out(size);
+    std::vector<std::vector<uint8_t>> recent(kVerify);
+    std::mt19937 rng(7);
+
+    double push_total = 0, push_max = 0;
+    for (unsigned f = 0; f < args.frames; ++f) {
+        step_state(st, args.dirty, rng);
+        Clock::time_point t0 = Clock::now();
+        rb.push(st.data());
+        double s = seconds_since(t0);
+        push_total += s;
+        if (s > push_max) push_max = s;
+        recent[f % kVerify] = st;
+    }
+    const size_t depth = rb.depth();
+    const size_t used = rb.bytes_used();
+
+    // Pop back through the newest states; each must match the state pushed before it.
+    unsigned checked = 0;
+    Clock::time_point t0 = Clock::now();
+    for (unsigned k = 1; k < kVerify && k < args.frames && rb.depth(); ++k) {
+        if (!rb.pop(out.data())) break;
+        if (out != recent[(args.frames - 1 - k) % kVerify]) {
+            printf("rewind MISMATCH at %u states back\n", k);
+            return 1;
+        }
+        checked++;
+    }
+    double pop_s = seconds_since(t0);
+
+    printf("state            %zu bytes, %u dirty bytes/frame\n", size, args.dirty);
+    printf("captures         %u (verified %u pops)\n", args.frames, checked);
+    printf("capture_us       avg %.2f max %.2f\n", push_total * 1e6 / args.frames, push_max * 1e6);
+    printf("restore_us       avg %.2f\n", checked ? pop_s * 1e6 / checked : 0.0);
+    printf("bytes_per_state  %.0f (%.2f%% of raw)\n", depth ? (double)used / depth : 0.0,
+           depth ? 100.0 * used / depth / size : 0.0);
+    printf("history          %zu states, %.1f s at 60 fps, %.1f/%u MB\n", depth, depth / 60.0,
+           used / 1048576.0, args.budget_mb);
+    return checked ? 0 : 1;
+}
+
+// ---------------------------
+// resampler
+// ---------------------------
+
+static const struct { unsigned in, out; } kRatePairs[] = {
+    {32040, 48000}, {44100, 48000}, {48000, 48000}, {48000, 44100},
+};
+
+// Signal-to-error ratio in dB of a resampled sine against the ideal one. Both kernels are zero
+// phase: output frame n lands on input position n * in_rate / out_rate.
+static double sine_snr(int quality, unsigned in_rate, unsigned out_rate, double freq) {
+    const size_t in_frames = in_rate / 4;
+    std::vector<int16_t> in(in_frames * 2);
+    for (size_t i = 0; i < in_frames; ++i) {
+        in[i * 2] = in[i * 2 + 1] = (int16_t)lrint(16384.0 * sin(2.0 * M_PI * freq * i / in_rate));
+    }
+    Resampler rs;
+    rs.init(quality, in_rate, out_rate);
+    rs.push(in.data(), in_frames);
+    std::vector<int16_t> out((size_t)out_rate * 2);
+    size_t n = rs.pull(out.data(), out_rate);
+    double sig = 0, err = 0;
+    for (size_t i = 64; i + 64 < n; ++i) {
+        double ideal = 16384.0 * sin(2.0 * M_PI * freq * i / out_rate);
+        for (int c = 0; c < 2; ++c) {
+            double e = out[i * 2 + c] - ideal;
+            sig += ideal * ideal;
+            err += e * e;
+        }
+    }
+    return err > 0 ? 10.0 * log10(sig / err) : 200.0;
+}
+
+struct drift_result {
+    size_t fill_min, fill_max;
+    double fill_avg;
+    uint64_t underruns, overruns;
+    double factor;
+};
+
+// An emulator and an audio device with independent clocks, in virtual time. The core delivers a
+// video frame's worth of audio at 60.0988 fps with up to 4 ms of scheduling jitter; the device
+// pulls 240-frame bursts at out_rate with its crystal off by ppm. The device side mirrors the
+// output thread in audio_output.cpp. Fill is sampled after the first minute, once the controller
+// has settled.
+static drift_result simulate_drift(unsigned in_rate, unsigned out_rate, double ppm, double seconds) {
+    const double fps = 60.0988;
+    const unsigned burst = 240;
+    const size_t target = (size_t)(in_rate * 0.04);
+    AudioRing ring;
+    ring.init((size_t)(in_rate * 0.1));
+    Resampler rs;
+    rs.init(RESAMPLER_LINEAR, in_rate, out_rate); // the controller does not depend on the kernel
+    RateController drc;
+    drc.init(target, 0.005);
+    std::vector<int16_t> frame((size_t)(in_rate / fps + 2) * 2, 0);
+    std::vector<int16_t> in((size_t)(burst * 2 + 64) * 2), out((size_t)burst * 2);
+    std::mt19937 rng(99);
+
+    drift_result r = {SIZE_MAX, 0, 0.0, 0, 0, 1.0};
+    double fill_sum = 0;
+    uint64_t fill_samples = 0;
+    const double core_period = 1.0 / fps;
+    const double dev_period = burst / (out_rate * (1.0 + ppm * 1e-6));
+    double core_t = 0, dev_t = 0, owed = 0;
+    uint64_t core_frames = 0, bursts = 0;
+    bool primed = false;
+    while (dev_t < seconds) {
+        double jitter = (rng() % 4000) * 1e-6;
+        if (core_frames * core_period + jitter <= dev_t) {
+            owed += in_rate / fps;
+            size_t n = (size_t)owed;
+            owed -= n;
+            if (ring.write(frame.data(), n) < n && core_t > 60.0) r.overruns++;
+            core_t = ++core_frames * core_period;
+            continue;
+        }
+        size_t produced = 0;
+        if (!primed && ring.fill() >= target) primed = true;
+        if (primed) {
+            size_t need = std::min(rs.input_needed(burst), in.size() / 2);
+            rs.push(in.data(), ring.read(in.data(), need));
+            produced = rs.pull(out.data(), burst);
+            if (produced < burst) {
+                if (dev_t > 60.0) r.underruns++;
+                primed = false;
+            }
+            rs.set_step_factor(drc.update(ring.fill()));
+        }
+        if (dev_t > 60.0) {
+            size_t f = ring.fill();
+            r.fill_min = std::min(r.fill_min, f);
+            r.fill_max = std::max(r.fill_max, f);
+            fill_sum += f;
+            fill_samples++;
+        }
+        dev_t = ++bursts * dev_period;
+    }
+    r.fill_avg = fill_samples ? fill_sum / fill_samples : 0.0;
+    r.factor = drc.factor();
+    return r;
+}
+
+static int bench_resampler(const bench_args& args) {
+    static const double kMinSnr[RESAMPLER_QUALITY_COUNT] = {30.0, 60.0, 70.0};
+    int failures = 0;
+
+    for (int q = 0; q < RESAMPLER_QUALITY_COUNT; ++q) {
+        double snr = sine_snr(q, 44100, 48000, 1000.0);
+        double snr_hi = sine_snr(q, 44100, 48000, 8000.0);
+        bool ok = snr >= kMinSnr[q];
+        printf("%-7s snr 1 kHz %6.1f dB, 8 kHz %6.1f dB%s\n", resampler_quality_name(q), snr, snr_hi,
+               ok ? "" : "  BELOW THRESHOLD");
+        if (!ok) failures++;
+    }
+
+    for (const auto& p : kRatePairs) {
+        std::vector<int16_t> in((size_t)p.in * 2), out(((size_t)p.out + 64) * 2);
+        std::mt19937 rng(3);
+        for (auto& v : in) v = (int16_t)(rng() >> 17);
+        for (int q = 0; q < RESAMPLER_QUALITY_COUNT; ++q) {
+            Resampler rs;
+            rs.init(q, p.in, p.out);
+            uint64_t produced = 0;
+            Clock::time_point t0 = Clock::now();
+            for (unsigned it = 0; it < args.iters; ++it) {
+                rs.push(in.data(), p.in);
+                produced += rs.pull(out.data(), p.out + 64);
+            }
+            double s = seconds_since(t0);
+            printf("%5u -> %5u %-7s %8.1f Mframes/s %7.0fx realtime\n", p.in, p.out, resampler_quality_name(q),
+                   produced / s / 1e6, produced / s / p.out);
+        }
+    }
+
+    for (int sign = -1; sign <= 1; sign += 2) {
+        double ppm = sign * (double)args.ppm;
+        drift_result r = simulate_drift(32040, 48000, ppm, args.seconds);
+        bool ok = !r.underruns && !r.overruns;
+        printf("drift %+5.0f ppm %u s: fill %zu..%zu avg %.0f (target %zu), factor %.6f, "
+               "underruns %llu, overruns %llu%s\n",
+               ppm, args.seconds, r.fill_min, r.fill_max, r.fill_avg, (size_t)(32040 * 0.04), r.factor,
+               (unsigned long long)r.underruns, (unsigned long long)r.overruns, ok ? "" : "  UNSTABLE");
+        if (!ok) failures++;
+    }
+    return failures ? 1 : 0;
+}
+
+// ---------------------------
+// input
+// ---------------------------
+
+// What the core sees in one frame: a poll, then queries the way a typical core makes them (each
+// button of two pads individually, plus a mask read). Returns a checksum so nothing is elided.
+template<typename Query>
+static unsigned core_frame_queries(Query query, bool* consistent) {
+    unsigned sum = 0;
+    for (unsigned port = 0; port < 2; ++port) {
+        unsigned bits = 0;
+        for (unsigned id = 0; id < 16; ++id) bits |= (unsigned)(query(port, RETRO_DEVICE_JOYPAD, 0, id) & 1) << id;
+        unsigned mask = (uint16_t)query(port, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_MASK);
+        if (mask != bits) *consistent = false;
+        sum += bits;
+    }
+    return sum;
+}
+
+// Every device kind through the batched event path, checked against what input_state reports.
+static bool verify_input_events() {
+    input_reset();
+    const int32_t ev[] = {
+        (int32_t)input_event_word(INPUT_EVENT_BUTTONS, 1, 0, 0), 0x0101,
+        (int32_t)input_event_word(INPUT_EVENT_BUTTON, 1, 0, RETRO_DEVICE_ID_JOYPAD_START), 1,
+        (int32_t)input_event_word(INPUT_EVENT_ANALOG, 2, RETRO_DEVICE_INDEX_ANALOG_RIGHT, 0), input_event_pair(-32768, 1234),
+        (int32_t)input_event_word(INPUT_EVENT_POINTER, 3, 2, 1), input_event_pair(-100, 200),
+        (int32_t)input_event_word(INPUT_EVENT_POINTER, 3, 0, 0), input_event_pair(5, 5),
+        (int32_t)input_event_word(INPUT_EVENT_MOUSE_MOVE, 4, 0, 0), input_event_pair(3, -7),
+        (int32_t)input_event_word(INPUT_EVENT_MOUSE_MOVE, 4, 0, 0), input_event_pair(4, -1),
+        (int32_t)input_event_word(INPUT_EVENT_MOUSE_BUTTON, 4, 0, RETRO_DEVICE_ID_MOUSE_RIGHT), 1,
+        (int32_t)input_event_word(INPUT_EVENT_MOUSE_BUTTON, 4, 0, RETRO_DEVICE_ID_MOUSE_WHEELDOWN), 2,
+    };
+    input_apply_events(ev, sizeof(ev) / sizeof(ev[0]) / 2);
+    input_begin_frame();
+    input_poll();
+    struct { unsigned port, device, index, id; int expect; } checks[] = {
+        {1, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_MASK, 0x0109},
+        {1, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_A, 1},
+        {1, RETRO_DEVICE_ANALOG, RETRO_DEVICE_INDEX_ANALOG_BUTTON, RETRO_DEVICE_ID_JOYPAD_B, 0x7FFF},
+        {0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_MASK, 0},
+        {2, RETRO_DEVICE_ANALOG, RETRO_DEVICE_INDEX_ANALOG_RIGHT, RETRO_DEVICE_ID_ANALOG_X, -32768},
+        {2, RETRO_DEVICE_SUBCLASS(RETRO_DEVICE_ANALOG, 0), RETRO_DEVICE_INDEX_ANALOG_RIGHT, RETRO_DEVICE_ID_ANALOG_Y, 1234},
+        {2, RETRO_DEVICE_ANALOG, RETRO_DEVICE_INDEX_ANALOG_LEFT, RETRO_DEVICE_ID_ANALOG_X, 0},
+        {3, RETRO_DEVICE_POINTER, 0, RETRO_DEVICE_ID_POINTER_COUNT, 1},   // touch 0 was released
+        {3, RETRO_DEVICE_POINTER, 0, RETRO_DEVICE_ID_POINTER_X, -100},    // touch 2 packed to the front
+        {3, RETRO_DEVICE_POINTER, 0, RETRO_DEVICE_ID_POINTER_Y, 200},
+        {3, RETRO_DEVICE_POINTER, 1, RETRO_DEVICE_ID_POINTER_PRESSED, 0},
+        {4, RETRO_DEVICE_MOUSE, 0, RETRO_DEVICE_ID_MOUSE_X, 7},
+        {4, RETRO_DEVICE_MOUSE, 0, RETRO_DEVICE_ID_MOUSE_Y, -8},
+        {4, RETRO_DEVICE_MOUSE, 0, RETRO_DEVICE_ID_MOUSE_RIGHT, 1},
+        {4, RETRO_DEVICE_MOUSE, 0, RETRO_DEVICE_ID_MOUSE_WHEELDOWN, 1},
+    };
+    bool ok = true;
+    for (const auto& c : checks) {
+        int got = input_state(c.port, c.device, c.index, c.id);
+        if (got != c.expect) {
+            printf("input MISMATCH port %u device 0x%x index %u id %u: %d, expected %d\n", c.port, c.device,
+                   c.index, c.id, got, c.expect);
+            ok = false;
+        }
+    }
+    // Relative motion and wheel clicks are consumed by the snapshot that saw them.
+    input_begin_frame();
+    if (input_state(4, RETRO_DEVICE_MOUSE, 0, RETRO_DEVICE_ID_MOUSE_X) != 0 ||
+        input_state(4, RETRO_DEVICE_MOUSE, 0, RETRO_DEVICE_ID_MOUSE_WHEELDOWN) != 0 ||
+        input_state(4, RETRO_DEVICE_MOUSE, 0, RETRO_DEVICE_ID_MOUSE_RIGHT) != 1) {
+        printf("input MISMATCH: mouse motion not consumed by the previous frame\n");
+        ok = false;
+    }
+    input_set_port_device(1, RETRO_DEVICE_NONE);
+    input_begin_frame();
+    if (input_state(1, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_A) != 0) {
+        printf("input MISMATCH: port with RETRO_DEVICE_NONE still reports buttons\n");
+        ok = false;
+    }
+    input_set_port_device(1, RETRO_DEVICE_JOYPAD);
+    input_reset();
+    return ok;
+}
+
+static int bench_input(const bench_args& args) {
+    const unsigned kQueriesPerFrame = 2 * 17;
+    if (!verify_input_events()) return 1;
+
+    // The loader's previous scheme, for comparison: one mutex around a flat button array.
+    std::mutex lock;
+    std::vector<int> buttons(512, 0);
+    auto locked_query = [&](unsigned port, unsigned device, unsigned index, unsigned id) -> int16_t {
+        (void)device; (void)index;
+        std::lock_guard<std::mutex> lk(lock);
+        unsigned slot = port * 32 + id;
+        if (id == RETRO_DEVICE_ID_JOYPAD_MASK) {
+            int16_t m = 0;
+            for (unsigned i = 0; i < 16; ++i) m |= (int16_t)(buttons[port * 32 + i] << i);
+            return m;
+        }
+        return slot < buttons.size() ? (int16_t)buttons[slot] : 0;
+    };
+
+    // A UI thread hammering button changes while the core runs.
+    std::atomic<bool> stop(false);
+    std::atomic<bool> use_lock(true);
+    std::thread ui([&] {
+        std::mt19937 rng(5);
+        while (!stop.load(std::memory_order_relaxed)) {
+            unsigned port = rng() & 1, id = rng() & 15;
+            bool down = rng() & 1;
+            if (use_lock.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lk(lock);
+                buttons[port * 32 + id] = down;
+            } else {
+                input_set_button(port, id, down);
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    bool locked_consistent = true, snap_consistent = true;
+    unsigned sink = 0;
+    Clock::time_point t0 = Clock::now();
+    for (unsigned f = 0; f < args.frames; ++f) sink += core_frame_queries(locked_query, &locked_consistent);
+    double locked_s = seconds_since(t0);
+
+    use_lock.store(false);
+    input_reset();
+    t0 = Clock::now();
+    for (unsigned f = 0; f < args.frames; ++f) {
+        input_begin_frame();
+        input_poll();
+        sink += core_frame_queries(input_state, &snap_consistent);
+    }
+    double snap_s = seconds_since(t0);
+    stop.store(true);
+    ui.join();
+
+    const double queries = (double)args.frames * kQueriesPerFrame;
+    printf("mutex     %7.1f ns/query, frames %s (checksum %u)\n", locked_s * 1e9 / queries,
+           locked_consistent ? "consistent" : "TORN", sink & 0xFF);
+    printf("snapshot  %7.1f ns/query, frames %s\n", snap_s * 1e9 / queries,
+           snap_consistent ? "consistent" : "TORN");
+
+    // A frame's worth of touch and stick updates submitted as one batch, as the JNI entry does.
+    std::vector<int32_t> batch;
+    for (unsigned k = 0; k < 8; ++k) {
+        batch.push_back((int32_t)input_event_word(INPUT_EVENT_POINTER, 0, k & 3, 1));
+        batch.push_back(input_event_pair(k * 100, -(int)k * 100));
+        batch.push_back((int32_t)input_event_word(INPUT_EVENT_ANALOG, 0, k & 1, 0));
+        batch.push_back(input_event_pair(k * 1000, k * 2000));
+    }
+    const size_t events = batch.size() / 2;
+    t0 = Clock::now();
+    for (unsigned f = 0; f < args.frames; ++f) input_apply_events(batch.data(), events);
+    double batch_s = seconds_since(t0);
+    printf("batch     %7.1f ns/event (%zu events per submit)\n", batch_s * 1e9 / ((double)args.frames * events),
+           events);
+    return snap_consistent ? 0 : 1;
+}
+
+// ---------------------------
+// scan
+// ---------------------------
+
+static std::string hex_digest(const uint8_t* d, size_t n) {
+    char out[41];
+    hash_to_hex(d, n, out);
+    return out;
+}
+
+// Known answers, then every kernel against the scalar one (and zlib) across lengths, offsets and
+// update splits that hit each tail path.
+static bool verify_hashes() {
+    static const struct { const char* msg; const char* sha1; } kVectors[] = {
+        {"", "da39a3ee5e6b4b0d3255bfef95601890afd80709"},
+        {"abc", "a9993e364706816aba3e25717850c26c9cd0d89d"},
+        {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "84983e441c3bd26ebaae4aa1f95129e5e54670f1"},
+    };
+    bool ok = true;
+    std::mt19937 rng(19);
+    std::vector<uint8_t> buf(1 << 20);
+    for (auto& b : buf) b = (uint8_t)rng();
+
+    for (int i = 0; i < HASH_ISA_COUNT; ++i) {
+        hash_isa isa = (hash_isa)i;
+        if (crc32_fn crc = content_crc32_kernel(isa)) {
+            for (unsigned t = 0; t < 2000 && ok; ++t) {
+                size_t len = t < 300 ? t : rng() % (t < 1500 ? 4096 : buf.size() - 64);
+                size_t off = rng() % 64;
+                uint32_t seed = t & 1 ? (uint32_t)rng() : 0;
+                uint32_t want = (uint32_t)crc32(seed, buf.data() + off, (uInt)len);
+                uint32_t got = crc(seed, buf.data() + off, len);
+                if (got != want) {
+                    printf("crc32 %-6s MISMATCH len %zu offset %zu: %08x, zlib %08x\n", hash_isa_name(isa), len,
+                           off, got, want);
+                    ok = false;
+                }
+            }
+        }
+        if (sha1_blocks_fn blocks = content_sha1_kernel(isa)) {
+            uint8_t d[20];
+            for (const auto& v : kVectors) {
+                Sha1 sha(blocks);
+                sha.update(v.msg, strlen(v.msg));
+                sha.final(d);
+                if (hex_digest(d, 20) != v.sha1) {
+                    printf("sha1 %-6s MISMATCH for \"%s\": %s\n", hash_isa_name(isa), v.msg, hex_digest(d, 20).c_str());
+                    ok = false;
+                }
+            }
+            for (unsigned t = 0; t < 300 && ok; ++t) {
+                size_t len = t < 200 ? t : rng() % buf.size();
+                Sha1 ref(content_sha1_kernel(HASH_ISA_SCALAR)), sha(blocks);
+                ref.update(buf.data(), len);
+                for (size_t pos = 0; pos < len;) {
+                    size_t n = std::min<size_t>(len - pos, 1 + rng() % 200);
+                    sha.update(buf.data() + pos, n);
+                    pos += n;
+                }
+                uint8_t a[20], b[20];
+                ref.final(a);
+                sha.final(b);
+                if (memcmp(a, b, 20)) {
+                    printf("sha1 %-6s MISMATCH len %zu\n", hash_isa_name(isa), len);
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+// Library of random files, log-uniform from 4 KB to 1 MB, plus a DAT naming every other one.
+// Kept between runs, one tree per file count.
+static bool make_library(const bench_args& args, std::vector<std::string>* paths, size_t* listed) {
+    const std::string roms = args.dir + "/roms_" + std::to_string(args.files), dats = args.dir + "/dat";
+    mkdir(args.dir.c_str(), 0755);
+    mkdir(roms.c_str(), 0755);
+    mkdir(dats.c_str(), 0755);
+    const std::string marker = args.dir + "/files_" + std::to_string(args.files);
+    const bool fresh = access(marker.c_str(), F_OK) != 0;
+    if (fresh) printf("generating %u files in %s\n", args.files, roms.c_str());
+
+    std::mt19937 rng(args.files);
+    std::vector<uint8_t> buf(1 << 20);
+    std::string dat = "<?xml version=\"1.0\"?>\n<datafile>\n<header>\n<name>Bench &amp; Test</name>\n</header>\n";
+    *listed = 0;
+    for (unsigned i = 0; i < args.files; ++i) {
+        char dir[32], name[32];
+        snprintf(dir, sizeof(dir), "/%02u", i % 64);
+        snprintf(name, sizeof(name), "/game_%05u.bin", i);
+        const std::string path = roms + dir + name;
+        if (i < 64) mkdir((roms + dir).c_str(), 0755);
+        size_t size = (size_t)(4096.0 * std::pow(256.0, std::uniform_real_distribution<double>(0, 1)(rng)));
+        for (size_t j = 0; j < size; j += 4) {
+            uint32_t v = rng();
+            memcpy(&buf[j], &v, std::min<size_t>(4, size - j));
+        }
+        if (fresh) {
+            FILE* f = fopen(path.c_str(), "wb");
+            bool written = f && fwrite(buf.data(), 1, size, f) == size;
+            if (f) fclose(f);
+            if (!written) {
+                printf("cannot write %s\n", path.c_str());
+                return false;
+            }
+        }
+        if (i % 2 == 0) {
+            uint8_t d[20];
+            Sha1 sha;
+            sha.update(buf.data(), size);
+            sha.final(d);
+            char line[256];
+            snprintf(line, sizeof(line), "<game name=\"Game %u\">\n\t<rom name=\"%s\" size=\"%zu\" crc=\"%08x\" sha1=\"%s\"/>\n</game>\n",
+                     i, name + 1, size, (unsigned)crc32(0, buf.data(), (uInt)size), hex_digest(d, 20).c_str());
+            dat += line;
+            ++*listed;
+        }
+        paths->push_back(path);
+    }
+    dat += "</datafile>\n";
+    FILE* f = fopen((dats + "/bench.dat").c_str(), "wb");
+    if (!f) return false;
+    fwrite(dat.data(), 1, dat.size(), f);
+    fclose(f);
+    if (fresh) {
+        sync();
+        if ((f = fopen(marker.c_str(), "wb"))) fclose(f);
+    }
+    return true;
+}
+
+// Drops the files from the page cache so the next pass has to read storage.
+static void evict(const std::vector<std::string>& paths) {
+    for (const std::string& p : paths) {
+        int fd = open(p.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+// Plain read() of every file on the same number of threads: the throughput hashing should reach.
+static uint64_t read_all(const std::vector<std::string>& paths, unsigned threads) {
+    std::atomic<size_t> next(0);
+    std::atomic<uint64_t> total(0);
+    auto worker = [&]() {
+        std::vector<uint8_t> buf(1 << 20);
+        uint64_t n = 0;
+        for (size_t i; (i = next.fetch_add(1)) < paths.size();) {
+            int fd = open(paths[i].c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) continue;
+            for (ssize_t r; (r = read(fd, buf.data(), buf.size())) > 0;) n += (uint64_t)r;
+            close(fd);
+        }
+        total += n;
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+    return total.load();
+}
+
+static int bench_scan(const bench_args& args) {
+    if (!verify_hashes()) return 1;
+    printf("cpu: %s; crc32 %s, sha1 %s\n", cpu_features_string(), hash_isa_name(content_crc32_selected_isa()),
+           hash_isa_name(content_sha1_selected_isa()));
+
+    // Kernel throughput on a buffer that stays in cache
+    std::vector<uint8_t> buf(256 << 10, 0x5A);
+    const unsigned reps = args.iters * 4;
+    const double bytes = (double)buf.size() * reps;
+    for (int i = 0; i < HASH_ISA_COUNT; ++i) {
+        hash_isa isa = (hash_isa)i;
+        crc32_fn crc = content_crc32_kernel(isa);
+        sha1_blocks_fn blocks = content_sha1_kernel(isa);
+        if (!crc && !blocks) continue;
+        uint32_t sink = 0;
+        printf("%-6s", hash_isa_name(isa));
+        if (crc) {
+            auto t0 = Clock::now();
+            for (unsigned k = 0; k < reps; ++k) sink = crc(sink, buf.data(), buf.size());
+            printf("  crc32 %7.0f MB/s", bytes / seconds_since(t0) / 1e6);
+        }
+        if (blocks) {
+            uint32_t st[5] = {};
+            auto t0 = Clock::now();
+            for (unsigned k = 0; k < reps; ++k) blocks(st, buf.data(), buf.size() / 64);
+            printf("  sha1 %7.0f MB/s", bytes / seconds_since(t0) / 1e6);
+            sink ^= st[0];
+        }
+        printf("  (%02x)\n", sink & 0xFF);
+    }
+
+    std::vector<std::string> paths;
+    size_t listed = 0;
+    if (!make_library(args, &paths, &listed)) return 1;
+    rom_scan_options opts;
+    opts.dirs.push_back(args.dir + "/roms_" + std::to_string(args.files));
+    opts.dat_dir = args.dir + "/dat";
+    opts.index_path = args.dir + "/library.idx";
+    const unsigned threads = std::min(8u, std::max(4u, std::thread::hardware_concurrency()));
+
+    evict(paths);
+    auto t0 = Clock::now();
+    const uint64_t total = read_all(paths, threads);
+    const double read_s = seconds_since(t0);
+    const double read_rate = total / read_s;
+    printf("library   %zu files, %.1f MB, %u threads\n", paths.size(), total / 1048576.0, threads);
+    printf("read      cold %8.1f ms  %7.1f MB/s (plain read, no hashing)\n", read_s * 1e3, read_rate / 1e6);
+
+    // Full scans: cold against the read baseline, warm for the hashing ceiling
+    std::vector<rom_entry> entries;
+    rom_scan_stats st;
+    bool ok = true;
+    for (int warm = 0; warm < 2; ++warm) {
+        unlink(opts.index_path.c_str());
+        if (!warm) evict(paths);
+        if (!rom_library_scan(opts, &entries, &st)) return 1;
+        const double rate = st.bytes_hashed / (st.hash_ns / 1e9);
+        printf("scan      %s %8.1f ms  %7.1f MB/s (walk %.1f ms, hash %.1f ms)", warm ? "warm" : "cold",
+               st.total_ns / 1e6, rate / 1e6, st.walk_ns / 1e6, st.hash_ns / 1e6);
+        if (!warm) printf(", %.0f%% of plain read", 100.0 * rate / read_rate);
+        printf("\n");
+        if (st.files != paths.size() || st.hashed != paths.size() || st.errors || st.matched != listed) {
+            printf("scan MISMATCH: %llu files, %llu hashed, %llu errors, %llu matched (expected %zu, %zu matched)\n",
+                   (unsigned long long)st.files, (unsigned long long)st.hashed, (unsigned long long)st.errors,
+                   (unsigned long long)st.matched, paths.size(), listed);
+            ok = false;
+        }
+    }
+
+    // Scanner results against zlib for a sample of files
+    std::mt19937 rng(7);
+    for (unsigned k = 0; k < 100 && ok && !entries.empty(); ++k) {
+        const rom_entry& e = entries[rng() % entries.size()];
+        std::vector<uint8_t> data(e.size);
+        FILE* f = fopen(e.path.c_str(), "rb");
+        bool read_ok = f && fread(data.data(), 1, data.size(), f) == data.size();
+        if (f) fclose(f);
+        if (!read_ok || e.crc32 != (uint32_t)crc32(0, data.data(), (uInt)data.size())) {
+            printf("scan MISMATCH: crc32 of %s\n", e.path.c_str());
+            ok = false;
+        }
+    }
+
+    // Incremental: nothing changed, then 1% of the files rewritten
+    if (!rom_library_scan(opts, &entries, &st)) return 1;
+    printf("rescan    %8.1f ms  (%llu reused, %llu hashed)\n", st.total_ns / 1e6, (unsigned long long)st.reused,
+           (unsigned long long)st.hashed);
+    if (st.hashed || st.reused != paths.size() || st.matched != listed) {
+        printf("scan MISMATCH: unchanged library rehashed or lost matches\n");
+        ok = false;
+    }
+    const size_t touched = std::max<size_t>(1, paths.size() / 100);
+    for (size_t i = 0; i < touched; ++i) {
+        FILE* f = fopen(paths[i * 100 % paths.size()].c_str(), "r+b");
+        if (!f) continue;
+        fputc((int)(rng() & 0xFF), f);
+        fclose(f);
+    }
+    if (!rom_library_scan(opts, &entries, &st)) return 1;
+    printf("rescan    %8.1f ms  (%llu reused, %llu hashed after touching %zu)\n", st.total_ns / 1e6,
+           (unsigned long long)st.reused, (unsigned long long)st.hashed, touched);
+    if (st.hashed != touched) {
+        printf("scan MISMATCH: %llu files rehashed, expected %zu\n", (unsigned long long)st.hashed, touched);
+        ok = false;
+    }
+    // The touched files no longer match the DAT; the next run regenerates the library
+    unlink((args.dir + "/files_" + std::to_string(args.files)).c_str());
+    return ok ? 0 : 1;
+}
+
+// ---------------------------
+// cores
+// ---------------------------
+
+static std::string exe_dir() {
+    char path[4096];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (n <= 0) return ".";
+    path[n] = 0;
+    char* slash = strrchr(path, '/');
+    if (slash) *slash = 0;
+    return path;
+}
+
+static bool copy_to(const std::string& src, const std::string& dst, size_t limit) {
+    FILE* in = fopen(src.c_str(), "rb");
+    FILE* out = fopen(dst.c_str(), "wb");
+    bool ok = in && out;
+    std::vector<char> buf(1 << 16);
+    size_t total = 0, n;
+    while (ok && total < limit && (n = fread(buf.data(), 1, std::min(buf.size(), limit - total), in)) > 0) {
+        ok = fwrite(buf.data(), 1, n, out) == n;
+        total += n;
+    }
+    if (in) fclose(in);
+    if (out) fclose(out);
+    return ok;
+}
+
+// The catalog against dlopen: same exports, same system info, and how long each answer takes.
+static int bench_cores(const bench_args& args) {
+    const std::string core = args.core.empty() ? exe_dir() + "/libsaasemu_synthcore.so" : args.core;
+    const std::string dir = args.dir + "/cores";
+    mkdir(args.dir.c_str(), 0755);
+    mkdir(dir.c_str(), 0755);
+    const std::string cache = args.dir + "/core_info.cache", copy = dir + "/synth_libretro.so";
+    unlink(cache.c_str());
+    unlink(copy.c_str());
+    core_catalog_set_cache_path(cache.c_str());
+    bool ok = true;
+
+    // Reference: what the loader would see in-process
+    void* h = dlopen(core.c_str(), RTLD_NOW | RTLD_LOCAL);
+    auto info_fn = h ? (void (*)(retro_system_info*))dlsym(h, "retro_get_system_info") : nullptr;
+    if (!info_fn) {
+        printf("cannot load %s: %s\n", core.c_str(), dlerror());
+        return 1;
+    }
+    retro_system_info si = {};
+    info_fn(&si);
+    // Copied: the strings live in the core, which is closed below
+    const std::string ref_name = si.library_name ? si.library_name : "", ref_version = si.library_version ? si.library_version : "",
+                      ref_ext = si.valid_extensions ? si.valid_extensions : "";
+
+    core_info ci;
+    auto t0 = Clock::now();
+    if (!core_catalog_get(core.c_str(), &ci)) return 1;
+    const double first_ms = seconds_since(t0) * 1e3;
+    printf("core      %s: %s %s [%s] api %u%s%s\n", core.c_str(), ci.name.c_str(), ci.version.c_str(),
+           ci.extensions.c_str(), ci.api_version, ci.flags & CORE_INFO_SAVESTATES ? " savestates" : "",
+           ci.flags & CORE_INFO_CONTROLLERS ? " controllers" : "");
+    if (!ci.loadable() || !(ci.flags & CORE_INFO_PROBED) || ci.name != ref_name || ci.version != ref_version ||
+        ci.extensions != ref_ext || ((ci.flags & CORE_INFO_NEED_FULLPATH) != 0) != si.need_fullpath) {
+        printf("cores MISMATCH: catalog (%s) differs from in-process retro_get_system_info\n", ci.error.c_str());
+        ok = false;
+    }
+    const bool savestates = dlsym(h, "retro_serialize_size") && dlsym(h, "retro_serialize") && dlsym(h, "retro_unserialize");
+    if (savestates != ((ci.flags & CORE_INFO_SAVESTATES) != 0)) {
+        printf("cores MISMATCH: savestate exports\n");
+        ok = false;
+    }
+    dlclose(h);
+
+    // Files that must be rejected without loading them: not ELF, truncated, a library without the
+    // retro_* interface
+    const struct { std::string path; const char* what; } kBad[] = {
+        {args.dir + "/cores/text.so", "text"},
+        {args.dir + "/cores/truncated.so", "truncated"},
+        {"", "zlib"},
+    };
+    FILE* f = fopen(kBad[0].path.c_str(), "wb");
+    if (f) {
+        fputs("not a core\n", f);
+        fclose(f);
+    }
+    copy_to(core, kBad[1].path, 4096);
+    Dl_info zinfo = {};
+    std::string zlib_path = dladdr((void*)&zlibVersion, &zinfo) && zinfo.dli_fname ? zinfo.dli_fname : "";
+    for (const auto& bad : kBad) {
+        const std::string& path = bad.path.empty() ? zlib_path : bad.path;
+        if (path.empty()) continue;
+        core_info b;
+        if (core_catalog_get(path.c_str(), &b) && b.loadable()) {
+            printf("cores MISMATCH: %s accepted as a core\n", bad.what);
+            ok = false;
+        } else {
+            printf("reject    %-9s %s\n", bad.what, b.error.c_str());
+        }
+    }
+    unlink(kBad[0].path.c_str());
+    unlink(kBad[1].path.c_str());
+
+    // Cached answers: by path, after reloading the cache file, and for a copy found by hash
+    const unsigned reps = args.iters * 100;
+    t0 = Clock::now();
+    for (unsigned i = 0; i < reps; ++i) core_catalog_get(core.c_str(), &ci);
+    const double cached_us = seconds_since(t0) * 1e6 / reps;
+    core_catalog_set_cache_path("");
+    core_catalog_set_cache_path(cache.c_str());
+    t0 = Clock::now();
+    core_catalog_get(core.c_str(), &ci);
+    const double reload_us = seconds_since(t0) * 1e6;
+    copy_to(core, copy, SIZE_MAX);
+    t0 = Clock::now();
+    core_catalog_get(copy.c_str(), &ci);
+    const double copy_ms = seconds_since(t0) * 1e3;
+    if (!ci.loadable() || ci.name != ref_name) {
+        printf("cores MISMATCH: copy not recognized by hash\n");
+        ok = false;
+    }
+
+    // What loadCoreCheck used to cost per core
+    t0 = Clock::now();
+    for (unsigned i = 0; i < args.iters; ++i) {
+        void* d = dlopen(core.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (d) dlclose(d);
+    }
+    const double dlopen_us = seconds_since(t0) * 1e6 / args.iters;
+
+    core_info pick;
+    const bool found = core_catalog_find_for_content(dir.c_str(), "/roms/game.bin", &pick) && pick.path == copy;
+    const bool none = !core_catalog_find_for_content(dir.c_str(), "/roms/game.iso", &pick);
+    if (!found || !none) {
+        printf("cores MISMATCH: content to core matching\n");
+        ok = false;
+    }
+
+    printf("first     %8.2f ms  (hash, ELF inspection, forked probe)\n", first_ms);
+    printf("cached    %8.2f us  per lookup\n", cached_us);
+    printf("reloaded  %8.2f us  (first lookup after reading the cache file)\n", reload_us);
+    printf("copy      %8.2f ms  (new path, recognized by hash, no probe)\n", copy_ms);
+    printf("dlopen    %8.2f us  per dlopen + dlclose, for comparison\n", dlopen_us);
+    unlink(copy.c_str());
+    return ok ? 0 : 1;
+}
+
+// ---------------------------
+// stats
+// ---------------------------
+
+// Every bucket holds the values that map to it, and neighbouring buckets meet.
+static bool verify_perf_buckets() {
+    for (size_t b = 0; b + 1 < PerfHistogram::kBuckets; ++b) {
+        const uint64_t lo = PerfHistogram::bucket_floor(b), hi = PerfHistogram::bucket_floor(b + 1);
+        if (hi <= lo || PerfHistogram::bucket_of(lo) != b || PerfHistogram::bucket_of(hi - 1) != b) {
+            fprintf(stderr, "perf bucket %zu [%llu, %llu) is inconsistent\n", b, (unsigned long long)lo,
+                    (unsigned long long)hi);
+            return false;
+        }
+    }
+    return PerfHistogram::bucket_of(UINT64_MAX) == PerfHistogram::kBuckets - 1;
+}
+
+static int bench_stats(const bench_args& args) {
+    if (!verify_perf_buckets()) return 1;
+    const double kFrameNs = 1e9 / 60;
+
+    // Percentiles against the exact ones, over log-uniform durations from 50 ns to 50 ms.
+    std::mt19937_64 rng(21);
+    std::uniform_real_distribution<double> exponent(std::log(50.0), std::log(50e6));
+    std::vector<int64_t> values(std::max(args.frames, 1000u) * 10);
+    PerfHistogram hist;
+    for (int64_t& v : values) {
+        v = (int64_t)std::exp(exponent(rng));
+        hist.record(v);
+    }
+    std::sort(values.begin(), values.end());
+    latency_summary sum;
+    hist.summarize(&sum);
+    double worst = 0;
+    const struct { double p; int64_t got; } kChecks[] = {{0.50, sum.p50_ns}, {0.90, sum.p90_ns}, {0.99, sum.p99_ns}};
+    for (const auto& c : kChecks) {
+        const int64_t exact = values[(size_t)(c.p * (values.size() - 1))];
+        worst = std::max(worst, std::fabs((double)(c.got - exact)) / exact);
+    }
+    const bool accurate = sum.count == values.size() && sum.max_ns == values.back() && worst <= 1.0 / (2 * PerfHistogram::kSub) + 1e-3;
+    printf("accuracy  %zu samples, worst percentile error %.2f%% %s\n", values.size(), worst * 100,
+           accurate ? "ok" : "OUT OF BOUND");
+
+    // The loader's probes: a scope (two clock reads and a record) per metric per frame, on the
+    // metrics a frame actually records.
+    const unsigned samples = args.frames * 100;
+    Clock::time_point t0 = Clock::now();
+    for (unsigned i = 0; i < samples; ++i) perf_record(PERF_INPUT_POLL, (int64_t)(i & 0xFFFFF));
+    const double record_ns = seconds_since(t0) * 1e9 / samples;
+    t0 = Clock::now();
+    for (unsigned i = 0; i < samples; ++i) {
+        PERF_SCOPE(PERF_INPUT_POLL);
+    }
+    const double scope_ns = seconds_since(t0) * 1e9 / samples;
+    perf_stats_reset();
+
+    const double frame_ns = scope_ns * PERF_METRIC_COUNT;
+    const bool cheap = frame_ns < 0.001 * kFrameNs;
+    printf("record    %7.1f ns/sample\n", record_ns);
+    printf("scope     %7.1f ns/sample (with its clock reads)\n", scope_ns);
+    printf("frame     %7.1f ns for %d metrics, %.4f%% of a 60 Hz frame %s\n", frame_ns, (int)PERF_METRIC_COUNT,
+           frame_ns * 100 / kFrameNs, cheap ? "ok" : "TOO SLOW");
+    return accurate && cheap ? 0 : 1;
+}
+
+// ---------------------------
+// trace
+// ---------------------------
+
+// Writers on every thread at once: each event must come back whole, in each thread's order.
+static bool verify_trace_ring(unsigned per_thread) {
+    static const char* const kNames[] = {"writer0", "writer1", "writer2", "writer3"};
+    const unsigned kThreads = 4;
+    trace_clear();
+    std::vector<std::thread> writers;
+    for (unsigned t = 0; t < kThreads; ++t) {
+        writers.emplace_back([t, per_thread] {
+            for (unsigned i = 0; i < per_thread; ++i) {
+                trace_emit(kNames[t], i, (int64_t)i * 3 + t, ((int64_t)t << 32) | i);
+            }
+        });
+    }
+    for (std::thread& w : writers) w.join();
+
+    std::vector<trace_event> events;
+    trace_snapshot(&events);
+    trace_stats st;
+    trace_get_stats(&st);
+    const uint64_t total = (uint64_t)kThreads * per_thread;
+    const uint64_t expected = std::min<uint64_t>(total, kTraceCapacity);
+    // A drop is counted and loses only its own event; anything else missing is a lost write.
+    bool ok = events.size() <= expected && events.size() + st.dropped >= expected;
+    int64_t last[kThreads] = {-1, -1, -1, -1};
+    for (const trace_event& e : events) {
+        const unsigned t = (unsigned)(e.arg >> 32);
+        const int64_t i = e.arg & 0xFFFFFFFF;
+        if (t >= kThreads || e.name != kNames[t] || e.ts_ns != i || e.dur_ns != i * 3 + t || i <= last[t]) {
+            ok = false;
+            break;
+        }
+        last[t] = i;
+    }
+    ok = ok && st.events == total && st.overwritten == (total > kTraceCapacity ? total - kTraceCapacity : 0);
+    printf("ring      %u writers x %u events, %zu kept, %llu dropped: %s\n", kThreads, per_thread, events.size(),
+           (unsigned long long)st.dropped, ok ? "ok" : "TORN OR LOST");
+    trace_clear();
+    return ok;
+}
+
+static int bench_trace(const bench_args& args) {
+    if (!verify_trace_ring(args.frames * 10) || !verify_trace_ring(1000)) return 1;
+    const double kFrameNs = 1e9 / 60;
+    const unsigned kMarkersPerFrame = 16;
+    const unsigned markers = args.frames * 100;
+
+    trace_set_enabled(false);
+    Clock::time_point t0 = Clock::now();
+    for (unsigned i = 0; i < markers; ++i) {
+        TRACE_SCOPE("bench");
+    }
+    const double off_ns = seconds_since(t0) * 1e9 / markers;
+
+    trace_set_enabled(true);
+    t0 = Clock::now();
+    for (unsigned i = 0; i < markers; ++i) {
+        TRACE_SCOPE_ARG("bench", i);
+    }
+    const double on_ns = seconds_since(t0) * 1e9 / markers;
+    trace_set_enabled(false);
+
+    const std::string path = "/tmp/saasemu_bench_trace.json";
+    const bool written = trace_write_json(path.c_str());
+    struct stat st;
+    const double mb = written && stat(path.c_str(), &st) == 0 ? st.st_size / 1048576.0 : 0.0;
+    unlink(path.c_str());
+    trace_clear();
+
+    printf("off       %7.2f ns/marker, %.5f%% of a 60 Hz frame at %u markers\n", off_ns,
+           off_ns * kMarkersPerFrame * 100 / kFrameNs, kMarkersPerFrame);
+    printf("on        %7.1f ns/marker, %.4f%% of a 60 Hz frame at %u markers\n", on_ns,
+           on_ns * kMarkersPerFrame * 100 / kFrameNs, kMarkersPerFrame);
+    printf("json      %s, %.1f MB for %zu events\n", written ? "ok" : "FAILED", mb,
+           std::min<size_t>(markers, kTraceCapacity));
+    return written ? 0 : 1;
+}
+
+// ---------------------------
+// coreperf
+// ---------------------------
+
+// Every detected feature reaches the core under its RETRO_SIMD_* name.
+static bool verify_simd_mapping(uint64_t simd) {
+    static const struct { uint32_t feature; uint64_t simd; } kMap[] = {
+        {CPU_FEATURE_SSE2, RETRO_SIMD_SSE | RETRO_SIMD_SSE2}, {CPU_FEATURE_SSE3, RETRO_SIMD_SSE3},
+        {CPU_FEATURE_SSSE3, RETRO_SIMD_SSSE3}, {CPU_FEATURE_SSE4_1, RETRO_SIMD_SSE4},
+        {CPU_FEATURE_SSE4_2, RETRO_SIMD_SSE42}, {CPU_FEATURE_AVX, RETRO_SIMD_AVX},
+        {CPU_FEATURE_AVX2, RETRO_SIMD_AVX2}, {CPU_FEATURE_NEON, RETRO_SIMD_NEON},
+        {CPU_FEATURE_POPCNT, RETRO_SIMD_POPCNT}, {CPU_FEATURE_AES, RETRO_SIMD_AES},
+    };
+    const uint32_t f = cpu_features_get();
+    for (const auto& m : kMap) {
+        if (!(f & m.feature) != !((simd & m.simd) == m.simd)) {
+            fprintf(stderr, "cpu feature 0x%x and RETRO_SIMD 0x%llx disagree\n", m.feature,
+                    (unsigned long long)m.simd);
+            return false;
+        }
+    }
+    return true;
+}
+
+static int bench_coreperf(const bench_args& args) {
+    retro_perf_callback perf;
+    core_perf_interface(&perf, true);
+    core_perf_reset();
+    const uint64_t simd = perf.get_cpu_features();
+    if (!verify_simd_mapping(simd)) return 1;
+    printf("features  %s -> RETRO_SIMD 0x%llx\n", cpu_features_string(), (unsigned long long)simd);
+
+    // Ticks over a known interval, converted with the runtime's rate, against the steady clock.
+    Clock::time_point t0 = Clock::now();
+    const retro_time_t us0 = perf.get_time_usec();
+    const uint64_t k0 = perf.get_perf_counter();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const uint64_t k1 = perf.get_perf_counter();
+    const retro_time_t us1 = perf.get_time_usec();
+    const double wall_ns = seconds_since(t0) * 1e9;
+    const double rate = core_perf_ticks_per_ns();
+    const double tick_err = std::fabs((k1 - k0) / rate - wall_ns) / wall_ns;
+    const double usec_err = std::fabs((us1 - us0) * 1e3 - wall_ns) / wall_ns;
+    const bool clocks_ok = tick_err < 0.02 && usec_err < 0.02;
+    printf("clocks    %.4f ticks/ns, 50 ms sleep off by %.2f%% (ticks) and %.2f%% (usec) %s\n", rate, tick_err * 100,
+           usec_err * 100, clocks_ok ? "ok" : "MISMATCH");
+
+    // A core's RETRO_PERFORMANCE_START / STOP pair around an empty section
+    static retro_perf_counter counter = {"bench_section", 0, 0, 0, false};
+    perf.perf_register(&counter);
+    const unsigned calls = args.iters * 10000;
+    t0 = Clock::now();
+    for (unsigned i = 0; i < calls; ++i) {
+        perf.perf_start(&counter);
+        perf.perf_stop(&counter);
+    }
+    const double pair_ns = seconds_since(t0) * 1e9 / calls;
+    t0 = Clock::now();
+    uint64_t sink = 0;
+    for (unsigned i = 0; i < calls; ++i) sink += (uint64_t)perf.get_time_usec();
+    const double usec_ns = seconds_since(t0) * 1e9 / calls;
+
+    std::vector<core_perf_counter> counters;
+    core_perf_snapshot(&counters);
+    const bool counted = counters.size() == 1 && counters[0].ident == "bench_section" && counters[0].calls == calls;
+    core_perf_unload("bench");
+    core_perf_snapshot(&counters);
+    const bool dropped = counters.empty();
+    printf("counter   %7.1f ns per start/stop pair, %u calls %s, %s after unload\n", pair_ns, calls,
+           counted ? "counted" : "MISCOUNTED", dropped ? "dropped" : "STILL HELD");
+    printf("usec      %7.1f ns per get_time_usec (checksum %llu)\n", usec_ns, (unsigned long long)(sink & 0xFF));
+    return clocks_ok && counted && dropped ? 0 : 1;
+}
+
+// ---------------------------
+// log
+// ---------------------------
+
+static std::mutex gLogLock;
+static std::vector<std::string> gLogLines;
+static std::atomic<uint64_t> gLogCount(0);
+
+static void capture_sink(int /*prio*/, const char* tag, const char* msg) {
+    if (!strcmp(tag, "Log")) return;   // the drain's own drop reports
+    std::lock_guard<std::mutex> lk(gLogLock);
+    gLogLines.push_back(msg);
+}
+
+static void count_sink(int, const char*, const char*) {
+    gLogCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Logged through the ring and formatted right away by snprintf; the drain must agree.
+template <typename... A>
+static void log_and_expect(std::vector<std::string>* expect, const char* fmt, A... a) {
+    char buf[1024];
+    snprintf(buf, sizeof(buf), fmt, a...);
+    log_write(LOG_LEVEL_INFO, "bench", fmt, a...);
+    std::string s = buf;
+    while (!s.empty() && s.back() == '\n') s.pop_back();
+    expect->push_back(s);
+}
+
+static bool verify_log_format() {
+    std::vector<std::string> expect;
+    log_and_expect(&expect, "ints %d %i %5d|%-5d|%05d %+d", -42, INT32_MIN, 7, 7, -7, 3);
+    log_and_expect(&expect, "unsigned %u %x %X %o %#x %#o", 4000000000u, 0xbeefu, 0xbeefu, 8u, 255u, 8u);
+    log_and_expect(&expect, "lengths %ld %lld %llu %zu %zd %jd %td %hd %hhu", -5L, -(1LL << 40), ~0ULL, (size_t)77,
+                   (ssize_t)-77, (intmax_t)-1, (ptrdiff_t)-9, (short)-300, (unsigned char)200);
+    log_and_expect(&expect, "floats %f %.3f %e %g %10.2f|%-10.1f| %Lf %a", 3.14159, 2.0 / 3, 12345.678, 1e-7, -1.5,
+                   2.25, (long double)1.5, 1.0);
+    log_and_expect(&expect, "strings %s|%.3s|%10s|%-10s|%s", "hello", "truncate", "right", "left", "");
+    log_and_expect(&expect, "stars %*d|%-*d|%.*f|%*.*s|%.*s|", 6, 42, 6, 42, 2, 3.14159, 8, 3, "abcdef", -1, "neg");
+    log_and_expect(&expect, "chars %c%c%c %5c|", 'a', 'b', 'c', 'd');
+    log_and_expect(&expect, "pointer %p", (void*)&expect);
+    log_and_expect(&expect, "100%% literal");
+    log_and_expect(&expect, "newline stripped %d\n", 1);
+
+    // A core's format may be gone (unloaded, or a stack buffer) by the time the drain runs.
+    retro_log_callback core;
+    log_core_interface(&core);
+    char fmt[64];
+    strcpy(fmt, "core format %s %d %.1f\n");
+    core.log(RETRO_LOG_INFO, fmt, "copied", 9, 0.5);
+    memset(fmt, 'x', sizeof(fmt) - 1);
+    expect.push_back("core format copied 9 0.5");
+
+    const std::string big(2000, 'z');
+    log_write(LOG_LEVEL_INFO, "bench", "big %s", big.c_str());
+    log_flush();
+
+    std::lock_guard<std::mutex> lk(gLogLock);
+    bool ok = gLogLines.size() == expect.size() + 1;
+    for (size_t i = 0; ok && i < expect.size(); ++i) {
+        if (gLogLines[i] != expect[i]) {
+            fprintf(stderr, "log: got \"%s\", want \"%s\"\n", gLogLines[i].c_str(), expect[i].c_str());
+            ok = false;
+        }
+    }
+    const std::string last = ok ? gLogLines.back() : std::string();
+    const bool truncated = ok && last.size() < 512 && !last.compare(0, 6, "big zz") &&
+                           !last.compare(last.size() - 6, 6, " [...]");
+    printf("format    %zu messages against snprintf: %s, long argument %s\n", expect.size(),
+           ok ? "ok" : "MISMATCH", truncated ? "truncated" : "NOT TRUNCATED");
+    gLogLines.clear();
+    return ok && truncated;
+}
+
+// Writers on every thread at once: every message arrives whole and in its thread's order, or is
+// counted as dropped.
+static bool verify_log_ring(unsigned per_thread) {
+    const unsigned kThreads = 4;
+    log_stats before;
+    log_get_stats(&before);
+    std::vector<std::thread> writers;
+    for (unsigned t = 0; t < kThreads; ++t) {
+        writers.emplace_back([t, per_thread] {
+            for (unsigned i = 0; i < per_thread; ++i) log_write(LOG_LEVEL_INFO, "bench", "writer %u %s %u", t, "message", i);
+        });
+    }
+    for (std::thread& w : writers) w.join();
+    log_flush();
+    log_stats after;
+    log_get_stats(&after);
+
+    std::lock_guard<std::mutex> lk(gLogLock);
+    bool ok = true;
+    long last[kThreads] = {-1, -1, -1, -1};
+    for (const std::string& line : gLogLines) {
+        unsigned t, i;
+        char word[16];
+        if (sscanf(line.c_str(), "writer %u %15s %u", &t, word, &i) != 3 || t >= kThreads || strcmp(word, "message") ||
+            (long)i <= last[t]) {
+            ok = false;
+            break;
+        }
+        last[t] = i;
+    }
+    const uint64_t total = (uint64_t)kThreads * per_thread;
+    const uint64_t dropped = after.dropped - before.dropped;
+    ok = ok && gLogLines.size() + dropped == total && after.written - before.written == gLogLines.size();
+    printf("ring      %u writers x %u messages, %zu delivered, %llu dropped: %s\n", kThreads, per_thread,
+           gLogLines.size(), (unsigned long long)dropped, ok ? "ok" : "TORN OR LOST");
+    gLogLines.clear();
+    return ok;
+}
+
+static int bench_log(const bench_args& args) {
+    const double kFrameNs = 1e9 / 60;
+    log_set_sink(capture_sink);
+    log_set_rate_limit(32, 0);
+    bool ok = verify_log_format();
+    ok &= verify_log_ring(args.frames * 10);
+
+    // One call site flooding: the burst gets through, the rest is counted.
+    log_set_rate_limit(32, 10);
+    log_stats before, after;
+    log_get_stats(&before);
+    for (unsigned i = 0; i < 1000; ++i) log_write(LOG_LEVEL_INFO, "bench", "flood %u", i);
+    log_flush();
+    log_get_stats(&after);
+    size_t passed;
+    {
+        std::lock_guard<std::mutex> lk(gLogLock);
+        passed = gLogLines.size();
+        gLogLines.clear();
+    }
+    const uint64_t limited = after.rate_limited - before.rate_limited;
+    const bool limited_ok = passed >= 32 && passed <= 34 && passed + limited == 1000;
+    printf("limit     1000 from one call site: %zu passed, %llu suppressed: %s\n", passed,
+           (unsigned long long)limited, limited_ok ? "ok" : "WRONG");
+    ok &= limited_ok;
+
+    // Cost on the calling thread, in batches the drain keeps up with
+    log_set_sink(count_sink);
+    log_set_rate_limit(32, 0);
+    const unsigned kBatch = 128;
+    const unsigned batches = args.frames / 4;
+    double total_ns = 0, worst_ns = 0;
+    for (unsigned b = 0; b < batches; ++b) {
+        Clock::time_point t0 = Clock::now();
+        for (unsigned i = 0; i < kBatch; ++i) {
+            log_write(LOG_LEVEL_INFO, "bench", "frame %u: %d samples, %.2f ms late, core %s", b, (int)i, i * 0.01,
+                      "synthetic");
+        }
+        const double ns = seconds_since(t0) * 1e9 / kBatch;
+        total_ns += ns;
+        worst_ns = std::max(worst_ns, ns);
+        log_flush();
+    }
+    const double call_ns = total_ns / batches;
+    Clock::time_point t0 = Clock::now();
+    const unsigned filtered = args.frames * 100;
+    for (unsigned i = 0; i < filtered; ++i) log_write(LOG_LEVEL_DEBUG, "bench", "filtered %u", i);
+    const double filtered_ns = seconds_since(t0) * 1e9 / filtered;
+    char line[256];
+    t0 = Clock::now();
+    for (unsigned i = 0; i < batches * kBatch; ++i) {
+        snprintf(line, sizeof(line), "frame %u: %d samples, %.2f ms late, core %s", i, (int)i, i * 0.01, "synthetic");
+    }
+    const double format_ns = seconds_since(t0) * 1e9 / (batches * kBatch);
+    log_set_sink(nullptr);
+
+    const bool cheap = call_ns < 1000;
+    printf("call      %7.1f ns per message (worst batch %.1f ns), %.4f%% of a 60 Hz frame at 10 per frame %s\n",
+           call_ns, worst_ns, call_ns * 10 * 100 / kFrameNs, cheap ? "ok" : "TOO SLOW");
+    printf("filtered  %7.2f ns per message below the level\n", filtered_ns);
+    printf("snprintf  %7.1f ns per message formatted in place, for comparison\n", format_ns);
+    return ok && cheap ? 0 : 1;
+}
+
+// ---------------------------
+// placement
+// ---------------------------
+
+static void write_text(const std::string& path, const std::string& text) {
+    if (FILE* f = fopen(path.c_str(), "w")) {
+        fputs(text.c_str(), f);
+        fclose(f);
+    }
+}
+
+// A /sys/devices/system/cpu lookalike: per CPU its max frequency and capacity (0: not reported).
+static std::string make_sysfs(const std::string& root, const char* online, const std::vector<uint32_t>& khz,
+                              const std::vector<uint32_t>& capacity) {
+    mkdir(root.c_str(), 0755);
+    write_text(root + "/online", std::string(online) + "\n");
+    for (size_t c = 0; c < khz.size(); ++c) {
+        const std::string cpu = root + "/cpu" + std::to_string(c);
+        mkdir(cpu.c_str(), 0755);
+        mkdir((cpu + "/cpufreq").c_str(), 0755);
+        unlink((cpu + "/cpufreq/cpuinfo_max_freq").c_str());
+        unlink((cpu + "/cpu_capacity").c_str());
+        if (khz[c]) write_text(cpu + "/cpufreq/cpuinfo_max_freq", std::to_string(khz[c]) + "\n");
+        if (capacity[c]) write_text(cpu + "/cpu_capacity", std::to_string(capacity[c]) + "\n");
+    }
+    return root;
+}
+
+static bool verify_placement_plans(const bench_args& args) {
+    struct plan_case {
+        const char* name;
+        const char* online;
+        std::vector<uint32_t> khz, capacity;
+        uint64_t allowed;
+        unsigned clusters;
+        uint64_t emu, others;   // expected masks, 0: left to the scheduler
+    };
+    const std::vector<plan_case> cases = {
+        {"big.LITTLE 4+4", "0-7", {1800000, 1800000, 1800000, 1800000, 2800000, 2800000, 2800000, 2800000},
+         {446, 446, 446, 446, 1024, 1024, 1024, 1024}, ~0ull, 2, 0xF0, 0x0F},
+        {"4+3+1 with a prime core", "0-7", {2000000, 2000000, 2000000, 2000000, 2800000, 2800000, 2800000, 3200000},
+         {300, 300, 300, 300, 850, 850, 850, 1024}, ~0ull, 3, 0x80, 0x7F},
+        {"homogeneous 8", "0-7", std::vector<uint32_t>(8, 2400000), std::vector<uint32_t>(8, 1024), ~0ull, 1, 0, 0},
+        {"capacity only", "0-3", {0, 0, 0, 0}, {512, 512, 1024, 1024}, ~0ull, 2, 0x0C, 0x03},
+        {"hybrid x86, frequency only", "0-15",
+         {5000000, 5000000, 5000000, 5000000, 5000000, 5000000, 5000000, 5000000,
+          3800000, 3800000, 3800000, 3800000, 3800000, 3800000, 3800000, 3800000},
+         std::vector<uint32_t>(16, 0), ~0ull, 2, 0x00FF, 0xFF00},
+        {"big cores offline", "0-5", {1800000, 1800000, 1800000, 1800000, 2400000, 2400000, 3000000, 3000000},
+         {446, 446, 446, 446, 800, 800, 1024, 1024}, ~0ull, 2, 0x30, 0x0F},
+        {"background cpuset", "0-7", {1800000, 1800000, 1800000, 1800000, 2800000, 2800000, 2800000, 2800000},
+         {446, 446, 446, 446, 1024, 1024, 1024, 1024}, 0x0F, 2, 0, 0},
+        {"restricted cpuset", "0-7", {1800000, 1800000, 1800000, 1800000, 2800000, 2800000, 2800000, 2800000},
+         {446, 446, 446, 446, 1024, 1024, 1024, 1024}, 0x3F, 2, 0x30, 0x0F},
+    };
+    mkdir(args.dir.c_str(), 0755);
+    bool ok = true;
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const plan_case& k = cases[i];
+        const std::string root = make_sysfs(args.dir + "/sysfs_cpu" + std::to_string(i), k.online, k.khz, k.capacity);
+        cpu_topology topo;
+        thread_placement_plan plan;
+        const bool read = cpu_topology_read(root.c_str(), &topo);
+        thread_placement_plan_for(topo, k.allowed, &plan);
+        const bool match = read && topo.clusters == k.clusters && plan.mask[THREAD_ROLE_EMU] == k.emu &&
+                           plan.mask[THREAD_ROLE_PRESENT] == k.others && plan.mask[THREAD_ROLE_AUDIO] == k.others;
+        printf("plan      %-27s %u %-9s emu %-5s others %-5s %s\n", k.name, topo.clusters,
+               topo.clusters == 1 ? "cluster," : "clusters,",
+               plan.mask[THREAD_ROLE_EMU] ? cpu_mask_string(plan.mask[THREAD_ROLE_EMU]).c_str() : "any",
+               plan.mask[THREAD_ROLE_PRESENT] ? cpu_mask_string(plan.mask[THREAD_ROLE_PRESENT]).c_str() : "any",
+               match ? "ok" : "WRONG");
+        ok &= match;
+    }
+    return ok;
+}
+
+static int bench_placement(const bench_args& args) {
+    bool ok = verify_placement_plans(args);
+
+    // This machine: place a thread as the emulation thread and sample it like the frame loop does.
+    cpu_topology topo;
+    cpu_topology_read("/sys/devices/system/cpu", &topo);
+    printf("host      %u cpus, %u cluster%s, fastest %s\n", topo.cpus, topo.clusters, topo.clusters == 1 ? "" : "s",
+           cpu_mask_string(topo.fast).c_str());
+    double sample_ns = 0;
+    thread_placement_stats st;
+    std::thread emu([&] {
+        thread_placement_apply(THREAD_ROLE_EMU);
+        const unsigned samples = args.frames * 100;
+        Clock::time_point t0 = Clock::now();
+        for (unsigned i = 0; i < samples; ++i) thread_placement_sample(THREAD_ROLE_EMU);
+        sample_ns = seconds_since(t0) * 1e9 / samples;
+        thread_placement_get_stats(THREAD_ROLE_EMU, &st);
+    });
+    emu.join();
+    const bool pinned_ok = !st.mask || (st.mask & ~topo.fast) == 0;
+    const bool counted = st.samples == args.frames * 100ull;
+    printf("apply     emu on cpus %s, nice %d%s%s: %s\n", st.mask ? cpu_mask_string(st.mask).c_str() : "any", st.nice,
+           st.nice_raised ? "" : " (not permitted)", st.boosted ? ", uclamp.min raised" : "",
+           pinned_ok ? "ok" : "OFF THE FAST CLUSTER");
+    printf("sample    %7.2f ns per sched_getcpu sample, %llu samples %s, %llu migrations\n", sample_ns,
+           (unsigned long long)st.samples, counted ? "counted" : "MISCOUNTED", (unsigned long long)st.migrations);
+    return ok && pinned_ok && counted ? 0 : 1;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s <benchmark> [options]\n"
+            "  convert   pixel format conversion kernels (--width N --height N --iters N)\n"
+            "  rewind    savestate delta ring (--state-kb N --dirty N --frames N --budget-mb N)\n"
+            "  resampler audio resampling kernels and rate control (--iters N --seconds N --ppm N)\n"
+            "  input     per-frame input snapshot against a UI writer thread (--frames N)\n"
+            "  scan      content hashes and the ROM library scanner (--files N --iters N --dir PATH)\n"
+            "  cores     core catalog: ELF inspection, probe and cache (--iters N --dir PATH --core PATH)\n"
+            "  stats     per-frame timing histograms: accuracy and recording cost (--frames N)\n"
+            "  trace     trace marker cost, ring integrity under concurrent writers (--frames N)\n"
+            "  coreperf  perf interface for cores: clocks, SIMD flags, counter cost (--iters N)\n"
+            "  log       asynchronous log: formatting, ring integrity, rate limit, call cost (--frames N)\n"
+            "  placement thread placement plans on sample topologies, this host's, sample cost (--frames N --dir PATH)\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    std::string which = argv[1];
+    bench_args args;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--dir") || !strcmp(argv[i], "--core")) {
+            (argv[i][2] == 'd' ? args.dir : args.core) = argv[i + 1];
+            continue;
+        }
+        unsigned v = (unsigned)strtoul(argv[i + 1], nullptr, 10);
+        if (!strcmp(argv[i], "--width")) args.width = v;
+        else if (!strcmp(argv[i], "--height")) args.height = v;
+        else if (!strcmp(argv[i], "--iters")) args.iters = v;
+        else if (!strcmp(argv[i], "--state-kb")) args.state_kb = v;
+        else if (!strcmp(argv[i], "--dirty")) args.dirty = v;
+        else if (!strcmp(argv[i], "--frames")) args.frames = v;
+        else if (!strcmp(argv[i], "--budget-mb")) args.budget_mb = v;
+        else if (!strcmp(argv[i], "--seconds")) args.seconds = v;
+        else if (!strcmp(argv[i], "--ppm")) args.ppm = v;
+        else if (!strcmp(argv[i], "--files")) args.files = v;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!args.width || !args.height || !args.iters || !args.frames || !args.budget_mb) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (which == "convert") return bench_convert(args);
+    if (which == "rewind") return bench_rewind(args);
+    if (which == "resampler") return bench_resampler(args);
+    if (which == "input") return bench_input(args);
+    if (which == "scan") return bench_scan(args);
+    if (which == "cores") return bench_cores(args);
+    if (which == "stats") return bench_stats(args);
+    if (which == "trace") return bench_trace(args);
+    if (which == "coreperf") return bench_coreperf(args);
+    if (which == "log") return bench_log(args);
+    if (which == "placement") return bench_placement(args);
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,550 @@
+// headless_main.cpp
+// saasemu_headless: runs the libretro loader on a Linux host against an in-memory window and
+// reports frame rate, frame-time percentiles and bytes copied. By default it loads the bundled
+// synthetic core (libsaasemu_synthcore.so next to the executable).
+//
+// --latency-test presses random buttons through the JNI entry point while the game runs and
+// watches for the synthetic core's input echo in posted frames. The latency measured that way,
+// entirely outside the runtime, must agree with the runtime's own input-to-photon histogram.
+
+#include "libretro_loader.h"
+#include "resampler.h"
+#include "thread_placement.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define LOG_TAG "Headless"
+
+typedef std::chrono::steady_clock Clock;
+
+struct run_options {
+    std::string core;
+    std::string content;
+    unsigned frames = 600;
+    bool quiet = false;
+    bool verbose = false;
+    bool placement = true;
+    bool paced = true;
+    bool fast_forward = false;
+    float ff_ratio = 0.0f;
+    unsigned rewind_interval = 0; // 0: rewind off
+    unsigned rewind_mb = 32;
+    unsigned rewind_back = 0;
+    std::string wav;
+    unsigned device_rate = 0;     // 0: the core's rate
+    double device_ppm = 0.0;
+    int audio_quality = -1;       // -1: default
+    unsigned run_ahead = 0;
+    bool run_ahead_secondary = false;
+    std::string save_dir;         // non-empty: save and reload a state after the run
+    bool latency_test = false;
+    bool prefetch = true;
+    std::string trace;            // non-empty: write a Chrome trace of the run here
+};
+
+// --latency-test: the press the driver thread is waiting to see, and what it measured.
+struct latency_probe {
+    std::atomic<uint32_t> expected{0};   // port 0 button mask after the press
+    std::atomic<int64_t> pressed_ns{0};  // latency_now_ns() before the JNI call; 0: answered
+    std::mutex lock;
+    std::vector<double> ms;
+    unsigned missed = 0;
+};
+
+struct frame_recorder {
+    std::mutex lock;
+    std::condition_variable done;
+    std::vector<Clock::time_point> stamps;
+    size_t target = 0;
+    latency_probe* probe = nullptr;
+};
+
+// Port 0's buttons as the synthetic core echoes them into the first 16 pixels of the top row.
+static uint32_t decode_echo(const ANativeWindow_Buffer* buf) {
+    uint32_t mask = 0;
+    for (int x = 0; x < 16 && x < buf->width; ++x) {
+        bool on = buf->format == WINDOW_FORMAT_RGB_565 ? (((const uint16_t*)buf->bits)[x] >> 11) >= 16
+                                                       : (((const uint32_t*)buf->bits)[x] & 0xFF) >= 128;
+        if (on) mask |= 1u << x;
+    }
+    return mask;
+}
+
+static void on_post(const ANativeWindow_Buffer* buf, void* user) {
+    frame_recorder* rec = (frame_recorder*)user;
+    Clock::time_point now = Clock::now();
+    if (latency_probe* probe = rec->probe) {
+        int64_t pressed = probe->pressed_ns.load(std::memory_order_acquire);
+        if (pressed && decode_echo(buf) == probe->expected.load(std::memory_order_relaxed)) {
+            int64_t ns = latency_now_ns() - pressed;
+            std::lock_guard<std::mutex> lk(probe->lock);
+            probe->ms.push_back(ns / 1e6);
+            probe->pressed_ns.store(0, std::memory_order_release);
+        }
+    }
+    std::lock_guard<std::mutex> lk(rec->lock);
+    if (rec->stamps.size() < rec->target) {
+        rec->stamps.push_back(now);
+        if (rec->stamps.size() == rec->target) rec->done.notify_one();
+    }
+}
+
+static std::string exe_dir() {
+    char path[4096];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (n <= 0) return ".";
+    path[n] = 0;
+    char* slash = strrchr(path, '/');
+    if (slash) *slash = 0;
+    return path;
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+// A "VmRSS:   1234 kB" style field of /proc/self/status, in bytes.
+static uint64_t status_bytes(const char* field) {
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f) return 0;
+    char line[256];
+    uint64_t kb = 0;
+    const size_t n = strlen(field);
+    while (fgets(line, sizeof(line), f)) {
+        if (!strncmp(line, field, n) && line[n] == ':') {
+            kb = strtoull(line + n + 1, nullptr, 10);
+            break;
+        }
+    }
+    fclose(f);
+    return kb * 1024;
+}
+
+// Flip a random button at a random point in the frame, wait for it to show, repeat.
+static void latency_driver(latency_probe* probe, const std::atomic<bool>* running) {
+    std::mt19937 rng(1234);
+    uint32_t mask = 0;
+    while (running->load()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(5000 + rng() % 25000));
+        const unsigned id = rng() % 16;
+        mask ^= 1u << id;
+        probe->expected.store(mask, std::memory_order_relaxed);
+        probe->pressed_ns.store(latency_now_ns(), std::memory_order_release);
+        set_button_state_internal((int)id, (mask >> id) & 1);
+        int waited = 0;
+        while (probe->pressed_ns.load(std::memory_order_acquire) && running->load() && waited++ < 500) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (probe->pressed_ns.exchange(0) && running->load()) {
+            std::lock_guard<std::mutex> lk(probe->lock);
+            probe->missed++;
+        }
+    }
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --core PATH          libretro core (default: bundled synthetic core)\n"
+            "  --content PATH       content passed to retro_load_game\n"
+            "  --frames N           frames to present before stopping (default 600)\n"
+            "  --width N --height N synthetic core frame size\n"
+            "  --format F           synthetic core pixel format: xrgb8888 | rgb565 | 0rgb1555\n"
+            "  --fps N              synthetic core reported frame rate\n"
+            "  --audio-rate N       synthetic core sample rate (0 disables audio)\n"
+            "  --cost N             synthetic core work per frame (thousands of iterations)\n"
+            "  --swfb 0|1           synthetic core renders into GET_CURRENT_SOFTWARE_FRAMEBUFFER\n"
+            "  --fast-forward R     fast-forward at R times the core's rate (0 = unlimited)\n"
+            "  --state-kb N         synthetic core savestate RAM size\n"
+            "  --state-dirty N      synthetic core RAM bytes written per frame\n"
+            "  --rewind N           capture a rewind state every N frames\n"
+            "  --rewind-mb N        rewind history budget (default 32)\n"
+            "  --rewind-back N      after the run, rewind N frames and measure playback\n"
+            "  --wav PATH           record the audio output to a WAV file\n"
+            "  --device-rate N      simulated audio device rate (default: the core's rate)\n"
+            "  --device-ppm N       simulated audio device clock error in ppm\n"
+            "  --audio-quality N    resampler: 0 linear, 1 sinc16, 2 sinc32\n"
+            "  --run-ahead N        run N frames ahead to hide input lag\n"
+            "  --run-ahead-secondary  run ahead on a second core instance\n"
+            "  --savestate DIR      after the run, save slot 0 into DIR and load it back\n"
+            "  --input-lag N        synthetic core shows input N frames late\n"
+            "  --fullpath 0|1       synthetic core asks for a path and reads the content itself\n"
+            "  --latency-test       press buttons during the run and check input-to-photon latency\n"
+            "  --no-prefetch        do not unpack archive content while the core loads\n"
+            "  --trace PATH         record trace markers and write them as Chrome trace JSON\n"
+            "  --no-placement       leave thread affinity and priority to the scheduler\n"
+            "  --unpaced            run frames back to back instead of at the core's frame rate\n"
+            "  -q                   only log errors\n"
+            "  -v                   also log debug messages, the core's included\n",
+            argv0);
+}
+
+static bool parse_args(int argc, char** argv, run_options& opt) {
+    static const struct { const char* flag; const char* env; } kSynthFlags[] = {
+        {"--width", "SAASEMU_SYNTH_WIDTH"},
+        {"--height", "SAASEMU_SYNTH_HEIGHT"},
+        {"--format", "SAASEMU_SYNTH_FORMAT"},
+        {"--fps", "SAASEMU_SYNTH_FPS"},
+        {"--audio-rate", "SAASEMU_SYNTH_AUDIO_RATE"},
+        {"--cost", "SAASEMU_SYNTH_COST"},
+        {"--swfb", "SAASEMU_SYNTH_SWFB"},
+        {"--state-kb", "SAASEMU_SYNTH_STATE_KB"},
+        {"--state-dirty", "SAASEMU_SYNTH_STATE_DIRTY"},
+        {"--input-lag", "SAASEMU_SYNTH_INPUT_LAG"},
+        {"--fullpath", "SAASEMU_SYNTH_FULLPATH"},
+    };
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "-q")) { opt.quiet = true; continue; }
+        if (!strcmp(a, "-v")) { opt.verbose = true; continue; }
+        if (!strcmp(a, "--unpaced")) { opt.paced = false; continue; }
+        if (!strcmp(a, "--run-ahead-secondary")) { opt.run_ahead_secondary = true; continue; }
+        if (!strcmp(a, "--latency-test")) { opt.latency_test = true; continue; }
+        if (!strcmp(a, "--no-prefetch")) { opt.prefetch = false; continue; }
+        if (!strcmp(a, "--no-placement")) { opt.placement = false; continue; }
+        if (!strcmp(a, "-h") || !strcmp(a, "--help")) return false;
+        if (!v) {
+            fprintf(stderr, "missing value for %s\n", a);
+            return false;
+        }
+        bool known = true;
+        if (!strcmp(a, "--core")) opt.core = v;
+        else if (!strcmp(a, "--content")) opt.content = v;
+        else if (!strcmp(a, "--frames")) opt.frames = (unsigned)strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--savestate")) opt.save_dir = v;
+        else if (!strcmp(a, "--wav")) opt.wav = v;
+        else if (!strcmp(a, "--trace")) opt.trace = v;
+        else if (!strcmp(a, "--device-rate")) opt.device_rate = (unsigned)strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--device-ppm")) opt.device_ppm = strtod(v, nullptr);
+        else if (!strcmp(a, "--audio-quality")) opt.audio_quality = atoi(v);
+        else if (!strcmp(a, "--run-ahead")) opt.run_ahead = (unsigned)strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--rewind")) opt.rewind_interval = (unsigned)strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--rewind-mb")) opt.rewind_mb = (unsigned)strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--rewind-back")) opt.rewind_back = (unsigned)strtoul(v, nullptr, 10);
+        else if (!strcmp(a, "--fast-forward")) {
+            opt.fast_forward = true;
+            opt.ff_ratio = strtof(v, nullptr);
+        }
+        else {
+            known = false;
+            for (const auto& f : kSynthFlags) {
+                if (!strcmp(a, f.flag)) {
+                    setenv(f.env, v, 1);
+                    known = true;
+                }
+            }
+        }
+        if (!known) {
+            fprintf(stderr, "unknown option %s\n", a);
+            return false;
+        }
+        ++i;
+    }
+    if (opt.core.empty()) opt.core = exe_dir() + "/libsaasemu_synthcore.so";
+    if (opt.content.empty()) opt.content = "synthetic.synth";
+    if (!opt.frames) opt.frames = 1;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    run_options opt;
+    if (!parse_args(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (opt.quiet || opt.verbose) {
+        log_set_min_level(opt.quiet ? LOG_LEVEL_ERROR : LOG_LEVEL_DEBUG);
+        log_set_core_min_level(opt.quiet ? LOG_LEVEL_ERROR : LOG_LEVEL_DEBUG);
+    }
+    if (!opt.trace.empty()) trace_set_enabled(true);
+    thread_placement_set_enabled(opt.placement);
+
+    // time to first frame: the app's order of calls, from picking the game to the first post
+    Clock::time_point launch = Clock::now();
+    if (opt.prefetch) prefetch_content_internal(opt.content.c_str());
+    if (!load_core_internal(opt.core.c_str())) {
+        LOGE("failed to load core %s", opt.core.c_str());
+        return 1;
+    }
+    Clock::time_point core_loaded = Clock::now();
+    if (!load_game_internal(opt.content.c_str())) {
+        LOGE("failed to load content %s", opt.content.c_str());
+        unload_core_internal();
+        return 1;
+    }
+    Clock::time_point game_loaded = Clock::now();
+
+    frame_recorder rec;
+    rec.target = (size_t)opt.frames + 1; // intervals need one extra timestamp
+    rec.stamps.reserve(rec.target);
+
+    ANativeWindow* win = host_window_create();
+    ANativeWindow_acquire(win); // keep our own reference for stats after the loader releases it
+    host_window_set_post_hook(win, on_post, &rec);
+    set_window_internal(win);
+
+    if (!opt.wav.empty()) host_audio_set_wav_path(opt.wav.c_str());
+    host_audio_set_device(opt.device_rate, opt.device_ppm);
+    if (opt.audio_quality >= 0) set_audio_quality_internal(opt.audio_quality);
+    if (opt.run_ahead) set_run_ahead_internal(opt.run_ahead, opt.run_ahead_secondary);
+    set_frame_pacing_internal(opt.paced);
+    set_fast_forward_ratio_internal(opt.ff_ratio);
+    set_fast_forward_internal(opt.fast_forward);
+    if (opt.rewind_interval) set_rewind_internal(true, opt.rewind_interval, (size_t)opt.rewind_mb << 20);
+    latency_probe probe;
+    if (opt.latency_test) rec.probe = &probe;
+    Clock::time_point start = Clock::now();
+    if (!start_emulation_internal()) {
+        LOGE("failed to start emulation");
+        unload_core_internal();
+        return 1;
+    }
+    std::atomic<bool> driving(true);
+    std::thread driver;
+    if (opt.latency_test) driver = std::thread(latency_driver, &probe, &driving);
+    {
+        std::unique_lock<std::mutex> lk(rec.lock);
+        rec.done.wait(lk, [&] { return rec.stamps.size() >= rec.target; });
+    }
+    if (driver.joinable()) {
+        driving.store(false);
+        driver.join();
+        usleep(100000); // let a frame answering the last press reach the presenter
+    }
+    emu_stats es;
+    get_emu_stats_internal(&es); // before stopping, so the speed window ends with the last frame
+    rewind_stats rs;
+    get_rewind_stats_internal(&rs);
+    audio_stats as;
+    get_audio_stats_internal(&as);
+    runahead_stats ras;
+    get_run_ahead_stats_internal(&ras);
+    content_stats cs;
+    get_content_stats_internal(&cs);
+    const uint64_t rss = status_bytes("VmRSS"), rss_anon = status_bytes("RssAnon"), rss_file = status_bytes("RssFile");
+
+    // Rewind phase: one restored state per presented frame
+    double rewind_fps = 0.0;
+    uint64_t rewind_steps = 0;
+    if (opt.rewind_interval && opt.rewind_back && rs.depth) {
+        unsigned steps = (opt.rewind_back + opt.rewind_interval - 1) / opt.rewind_interval;
+        if (steps > rs.depth) steps = (unsigned)rs.depth;
+        size_t first;
+        {
+            std::lock_guard<std::mutex> lk(rec.lock);
+            first = rec.stamps.size() - 1;
+            rec.target += steps;
+        }
+        rewind_frames_internal((int)(steps * opt.rewind_interval));
+        std::unique_lock<std::mutex> lk(rec.lock);
+        rec.done.wait(lk, [&] { return rec.stamps.size() >= rec.target; });
+        double span = std::chrono::duration<double>(rec.stamps.back() - rec.stamps[first]).count();
+        rewind_fps = span > 0 ? steps / span : 0.0;
+        rec.target = first + 1; // keep frame-time percentiles for the forward run only
+        rec.stamps.resize(rec.target);
+        lk.unlock();
+        rewind_stats after;
+        get_rewind_stats_internal(&after);
+        rewind_steps = after.steps;
+    }
+
+    // Savestate round trip while the core keeps running
+    savestate_stats ss;
+    memset(&ss, 0, sizeof(ss));
+    bool save_ok = false;
+    if (!opt.save_dir.empty()) {
+        set_save_dir_internal(opt.save_dir.c_str());
+        auto wait_for = [&](uint64_t savestate_stats::*field) {
+            for (int i = 0; i < 5000; ++i) {
+                get_savestate_stats_internal(&ss);
+                if (ss.*field || ss.failures) return ss.*field != 0;
+                usleep(1000);
+            }
+            return false;
+        };
+        save_ok = save_state_internal(0) && wait_for(&savestate_stats::saves) &&
+                  load_state_internal(0) && wait_for(&savestate_stats::loads);
+    }
+    stop_emulation_internal();
+    Clock::time_point end = Clock::now();
+    bool trace_ok = true;
+    trace_stats ts{};
+    if (!opt.trace.empty()) {
+        trace_set_enabled(false);
+        trace_get_stats(&ts);
+        trace_ok = trace_write_json(opt.trace.c_str());
+    }
+
+    presenter_stats vs;
+    get_video_stats_internal(&vs);
+    host_window_stats ws;
+    host_window_get_stats(win, &ws);
+    pacer_stats ps;
+    get_pacer_stats_internal(&ps);
+    latency_summary ls;
+    get_input_latency_internal(&ls);
+    core_perf_counter counters[64];   // the core's own, gone once it is unloaded
+    const size_t core_counters = std::min<size_t>(get_core_perf_counters_internal(counters, 64), 64);
+
+    clear_window_internal();
+    unload_core_internal();
+    ANativeWindow_release(win);
+    log_flush();   // the run's log ahead of the report
+    log_stats lg;
+    log_get_stats(&lg);
+
+    std::vector<double> ms;
+    for (size_t i = 1; i < rec.stamps.size(); ++i) {
+        ms.push_back(std::chrono::duration<double, std::milli>(rec.stamps[i] - rec.stamps[i - 1]).count());
+    }
+    std::sort(ms.begin(), ms.end());
+    double span = std::chrono::duration<double>(rec.stamps.back() - rec.stamps.front()).count();
+    double wall = std::chrono::duration<double>(end - start).count();
+
+    printf("frames           %zu\n", ms.size());
+    printf("wall_s           %.3f\n", wall);
+    printf("fps              %.1f\n", span > 0 ? ms.size() / span : 0.0);
+    printf("frame_ms_p50     %.3f\n", percentile(ms, 50));
+    printf("frame_ms_p90     %.3f\n", percentile(ms, 90));
+    printf("frame_ms_p99     %.3f\n", percentile(ms, 99));
+    printf("frame_ms_max     %.3f\n", ms.empty() ? 0.0 : ms.back());
+    uint64_t submitted = vs.frames_submitted ? vs.frames_submitted : 1;
+    uint64_t posted = vs.frames_posted ? vs.frames_posted : 1;
+    printf("frames_submitted %llu\n", (unsigned long long)vs.frames_submitted);
+    printf("frames_dropped   %llu\n", (unsigned long long)vs.frames_dropped);
+    printf("frames_dup       %llu\n", (unsigned long long)vs.frames_duplicated);
+    printf("frames_converted %llu\n", (unsigned long long)vs.frames_converted);
+    printf("frames_zero_copy %llu\n", (unsigned long long)vs.frames_zero_copy);
+    printf("bytes_per_frame  %llu (read %llu, staged %llu, written %llu)\n",
+           (unsigned long long)(vs.bytes_read / submitted + vs.bytes_staged / submitted + vs.bytes_written / posted),
+           (unsigned long long)(vs.bytes_read / submitted), (unsigned long long)(vs.bytes_staged / submitted),
+           (unsigned long long)(vs.bytes_written / posted));
+    printf("video_cb_us_avg  %.2f\n", vs.video_cb_ns_total / 1e3 / submitted);
+    printf("video_cb_us_max  %.2f\n", vs.video_cb_ns_max / 1e3);
+    printf("reconfigurations %llu\n", (unsigned long long)vs.reconfigurations);
+    printf("window_geometry  %llu\n", (unsigned long long)ws.geometry_calls);
+    printf("window_realloc   %llu\n", (unsigned long long)ws.reallocations);
+    auto ms_since = [&](Clock::time_point t) { return std::chrono::duration<double, std::milli>(t - launch).count(); };
+    printf("first_frame_ms   %.2f (core loaded %.2f, game loaded %.2f)\n", ms_since(rec.stamps.front()),
+           ms_since(core_loaded), ms_since(game_loaded));
+    printf("content          %s%s, %.1f MB, load %.3f ms (map %.3f ms), %.1f MB cached\n",
+           cs.in_memory ? "in memory" : "by path",
+           cs.from_archive ? (cs.prefetched ? " from archive (prefetched)" : " from archive") : "",
+           cs.size / 1048576.0, cs.load_ns / 1e6, cs.map_ns / 1e6, cs.cached_bytes / 1048576.0);
+    if (cs.from_archive) printf("content_extract  %.3f ms on the load path\n", cs.extract_ns / 1e6);
+    printf("memory_rss       %.1f MB (anon %.1f MB, file %.1f MB)\n", rss / 1048576.0, rss_anon / 1048576.0,
+           rss_file / 1048576.0);
+    printf("frames_run       %llu\n", (unsigned long long)es.frames_run);
+    printf("speed            %.2fx\n", es.speed);
+    if (opt.fast_forward) {
+        printf("ff_video_skipped %llu\n", (unsigned long long)es.frames_video_skipped);
+        printf("ff_audio_dropped %llu\n", (unsigned long long)es.audio_frames_dropped);
+    }
+    if (as.sample_rate) {
+        printf("audio_rate       %u Hz (device %u)\n", as.sample_rate, as.device_rate);
+        printf("audio_frames     queued %llu, played %llu\n", (unsigned long long)as.frames_queued,
+               (unsigned long long)as.frames_played);
+        printf("audio_underruns  %llu (%llu frames)\n", (unsigned long long)as.underruns,
+               (unsigned long long)as.underrun_frames);
+        printf("audio_overruns   %llu (%llu frames)\n", (unsigned long long)as.overruns,
+               (unsigned long long)as.overrun_frames);
+        printf("audio_fill       %llu / %llu frames (target %llu)\n", (unsigned long long)as.fill_frames,
+               (unsigned long long)as.capacity_frames, (unsigned long long)as.target_frames);
+        printf("audio_resampler  %s, rate factor %.5f\n", resampler_quality_name(as.quality), as.rate_factor);
+    }
+    if (opt.run_ahead) {
+        printf("run_ahead        %u frames%s, %s\n", ras.frames_ahead, ras.secondary_instance ? " (second instance)" : "",
+               ras.auto_disabled ? "DISABLED (over budget)" : ras.active ? "active" : "inactive");
+        printf("run_ahead_frames %llu\n", (unsigned long long)ras.frames);
+        printf("run_ahead_us     serialize avg %.1f max %.1f, unserialize avg %.1f max %.1f\n",
+               ras.serialize_ns_avg / 1e3, ras.serialize_ns_max / 1e3, ras.unserialize_ns_avg / 1e3,
+               ras.unserialize_ns_max / 1e3);
+        printf("run_ahead_cost   %.3f ms/frame overhead, %.3f of %.3f ms budget\n", ras.overhead_ns_avg / 1e6,
+               ras.work_ns / 1e6, ras.budget_ns / 1e6);
+    }
+    if (opt.rewind_interval) {
+        printf("rewind_state     %llu bytes every %u frames\n", (unsigned long long)rs.state_size, rs.interval);
+        printf("rewind_capture   avg %.2f us, max %.2f us\n",
+               rs.captures ? rs.capture_ns_total / 1e3 / rs.captures : 0.0, rs.capture_ns_max / 1e3);
+        printf("rewind_per_state %.0f bytes\n", rs.depth ? (double)rs.bytes_used / rs.depth : 0.0);
+        printf("rewind_history   %llu states, %.1f s, %.1f MB\n", (unsigned long long)rs.depth, rs.seconds,
+               rs.bytes_used / 1048576.0);
+        if (opt.rewind_back) printf("rewind_playback  %llu steps at %.1f fps\n", (unsigned long long)rewind_steps, rewind_fps);
+    }
+    if (!opt.save_dir.empty()) {
+        printf("savestate        %s, %llu -> %llu bytes\n", save_ok ? "ok" : "FAILED",
+               (unsigned long long)ss.last_state_bytes, (unsigned long long)ss.last_file_bytes);
+        printf("save_us          emu thread %.1f, worker %.1f\n", ss.last_serialize_ns / 1e3, ss.last_write_ns / 1e3);
+        printf("load_us          worker %.1f, emu thread %.1f\n", ss.last_read_ns / 1e3, ss.last_unserialize_ns / 1e3);
+    }
+    if (opt.paced) {
+        printf("pacer_fps        %.3f\n", ps.target_fps);
+        printf("pacer_late       %llu\n", (unsigned long long)ps.late_frames);
+        printf("pacer_resyncs    %llu\n", (unsigned long long)ps.resyncs);
+        printf("pacer_jitter_us  p50 %.1f p99 %.1f max %.1f\n",
+               ps.jitter_p50_ns / 1e3, ps.jitter_p99_ns / 1e3, ps.jitter_max_ns / 1e3);
+    } else {
+        printf("pacer            off\n");
+    }
+#if SAASEMU_PERF_STATS
+    printf("%s", perf_stats_dump().c_str());
+#endif
+    for (size_t i = 0; i < core_counters; ++i) {
+        printf("core_perf        %s: %llu calls, avg %.2f us, total %.3f ms\n", counters[i].ident.c_str(),
+               (unsigned long long)counters[i].calls,
+               counters[i].calls ? counters[i].total_ns / 1e3 / counters[i].calls : 0.0, counters[i].total_ns / 1e6);
+    }
+    printf("%s", thread_placement_dump().c_str());
+    printf("log              %llu messages, %llu dropped, %llu rate limited\n", (unsigned long long)lg.written,
+           (unsigned long long)lg.dropped, (unsigned long long)lg.rate_limited);
+    if (!opt.trace.empty()) {
+        printf("trace            %s, %llu events (%llu overwritten, %llu dropped) -> %s\n", trace_ok ? "ok" : "FAILED",
+               (unsigned long long)ts.events, (unsigned long long)ts.overwritten, (unsigned long long)ts.dropped,
+               opt.trace.c_str());
+    }
+    bool latency_ok = true;
+    if (opt.latency_test) {
+        // The runtime tags the first frame whose retro_run saw the input; the echo shows up
+        // input-lag frames later unless run-ahead hides them.
+        const char* lag_env = getenv("SAASEMU_SYNTH_INPUT_LAG");
+        const char* fps_env = getenv("SAASEMU_SYNTH_FPS");
+        unsigned lag = lag_env ? (unsigned)strtoul(lag_env, nullptr, 10) : 0;
+        double fps = fps_env ? strtod(fps_env, nullptr) : 60.0;
+        if (fps <= 0) fps = 60.0;
+        unsigned hidden = ras.auto_disabled ? 0 : std::min(lag, opt.run_ahead);
+        double core_ms = (lag - hidden) * 1000.0 / fps;
+
+        std::vector<double> ext = probe.ms;
+        std::sort(ext.begin(), ext.end());
+        double ext_p50 = percentile(ext, 50);
+        double int_p50 = ls.p50_ns / 1e6;
+        double diff = ext_p50 - int_p50 - core_ms;
+        latency_ok = !ext.empty() && !probe.missed && ls.count >= ext.size() &&
+                     ls.count <= ext.size() + 1 && diff > -1.0 && diff < 1.0;
+        printf("latency_runtime  %llu frames, ms mean %.2f p50 %.2f p90 %.2f p99 %.2f max %.2f\n",
+               (unsigned long long)ls.count, ls.mean_ns / 1e6, int_p50, ls.p90_ns / 1e6, ls.p99_ns / 1e6,
+               ls.max_ns / 1e6);
+        printf("latency_echo     %zu presses (%u missed), ms p50 %.2f p90 %.2f p99 %.2f max %.2f\n",
+               ext.size(), probe.missed, ext_p50, percentile(ext, 90), percentile(ext, 99),
+               ext.empty() ? 0.0 : ext.back());
+        printf("latency_check    %s (core lag %u frames, %u hidden by run-ahead, p50 difference %.2f ms)\n",
+               latency_ok ? "ok" : "MISMATCH", lag, hidden, diff);
+    }
+    return ((opt.save_dir.empty() || save_ok) && latency_ok && trace_ok) ? 0 : 1;
+}
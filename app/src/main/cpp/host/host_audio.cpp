@@ -0,0 +1,131 @@
+// host_audio.cpp
+// Default AudioSink for the host build. There is no sound device: writes block until the frames
+// would have been played at the stream rate, so the output thread, ring fill and underrun
+// counters behave as on a device. The device rate and a clock skew against the monotonic clock
+// can be simulated to exercise resampling and rate control. Optionally records what was played
+// to a WAV file.
+
+#include "audio_output.h"
+#include "platform.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+
+#define LOG_TAG "HostAudio"
+
+static const unsigned kBurstFrames = 240; // 5 ms at 48 kHz, a typical low-latency device burst
+
+static std::mutex gWavPathLock;
+static std::string gWavPath;
+static unsigned gDeviceRate = 0;     // 0: open at the source rate
+static double gDeviceSkewPpm = 0.0;
+
+static int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void put_le(FILE* f, uint32_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) fputc((int)((v >> (8 * i)) & 0xFF), f);
+}
+
+class HostSink : public AudioSink {
+public:
+    ~HostSink() override { close(); }
+
+    const char* name() const override { return wav_ ? "host-wav" : "host-null"; }
+
+    bool open(unsigned rate) override {
+        close();
+        start_ns_ = 0;
+        played_ = 0;
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lk(gWavPathLock);
+            path = gWavPath;
+            rate_ = gDeviceRate ? gDeviceRate : rate;
+            clock_rate_ = rate_ * (1.0 + gDeviceSkewPpm * 1e-6);
+        }
+        if (!path.empty()) {
+            wav_ = fopen(path.c_str(), "wb");
+            if (!wav_) {
+                LOGE("cannot open %s", path.c_str());
+            } else {
+                write_wav_header(0);
+            }
+        }
+        return true;
+    }
+
+    unsigned rate() const override { return rate_; }
+    unsigned burst_frames() const override { return kBurstFrames; }
+
+    bool write(const int16_t* frames, size_t count) override {
+        if (wav_) {
+            fwrite(frames, 4, count, wav_);
+            wav_frames_ += count;
+        }
+        // Block until the device clock reaches the end of what has been written so far.
+        if (!start_ns_) start_ns_ = now_ns();
+        played_ += count;
+        int64_t deadline = start_ns_ + (int64_t)(played_ * 1e9 / clock_rate_);
+        timespec ts;
+        ts.tv_sec = deadline / 1000000000LL;
+        ts.tv_nsec = deadline % 1000000000LL;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) != 0) {
+        }
+        return true;
+    }
+
+    void close() override {
+        if (!wav_) return;
+        write_wav_header((uint32_t)(wav_frames_ * 4));
+        fclose(wav_);
+        wav_ = nullptr;
+        wav_frames_ = 0;
+    }
+
+private:
+    void write_wav_header(uint32_t data_bytes) {
+        fseek(wav_, 0, SEEK_SET);
+        fwrite("RIFF", 1, 4, wav_);
+        put_le(wav_, 36 + data_bytes, 4);
+        fwrite("WAVEfmt ", 1, 8, wav_);
+        put_le(wav_, 16, 4);
+        put_le(wav_, 1, 2);             // PCM
+        put_le(wav_, 2, 2);             // channels
+        put_le(wav_, rate_, 4);
+        put_le(wav_, rate_ * 4, 4);     // byte rate
+        put_le(wav_, 4, 2);             // block align
+        put_le(wav_, 16, 2);            // bits per sample
+        fwrite("data", 1, 4, wav_);
+        put_le(wav_, data_bytes, 4);
+        fseek(wav_, 0, SEEK_END);
+    }
+
+    unsigned rate_ = 48000;
+    double clock_rate_ = 48000.0;   // frames per second the simulated crystal actually plays
+    int64_t start_ns_ = 0;
+    uint64_t played_ = 0;
+    FILE* wav_ = nullptr;
+    uint64_t wav_frames_ = 0;
+};
+
+AudioSink* audio_sink_create_default() {
+    return new HostSink();
+}
+
+extern "C" void host_audio_set_wav_path(const char* path) {
+    std::lock_guard<std::mutex> lk(gWavPathLock);
+    gWavPath = path ? path : "";
+}
+
+extern "C" void host_audio_set_device(unsigned rate, double skew_ppm) {
+    std::lock_guard<std::mutex> lk(gWavPathLock);
+    gDeviceRate = rate;
+    gDeviceSkewPpm = skew_ppm;
+}
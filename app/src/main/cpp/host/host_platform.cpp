@@ -0,0 +1,140 @@
+// host_platform.cpp
+// Linux host implementation of platform.h: a stderr log sink and an in-memory ANativeWindow.
+// The window mimics gralloc behaviour closely enough for benchmarking: strides are padded,
+// the backing store is only reallocated when geometry actually changes, and lock/post are counted.
+
+#include "platform.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+// Strides are rounded up to this many pixels, like most Android gralloc implementations.
+static const int32_t kStrideAlign = 16;
+
+struct ANativeWindow {
+    std::atomic<int> refs{1};
+    std::mutex lock;
+    int32_t width = 1;
+    int32_t height = 1;
+    int32_t format = WINDOW_FORMAT_RGBA_8888;
+    int32_t stride = 0;
+    bool locked = false;
+    std::vector<uint8_t> pixels;
+    host_window_post_fn post_fn = nullptr;
+    void* post_user = nullptr;
+    host_window_stats stats{};
+};
+
+static std::atomic<int> gMinLevel(HOST_LOG_DEBUG);   // async_log.h filters first
+
+static int bytes_per_pixel(int32_t format) {
+    return format == WINDOW_FORMAT_RGB_565 ? 2 : 4;
+}
+
+static void ensure_storage(ANativeWindow* w) {
+    int32_t stride = (w->width + kStrideAlign - 1) / kStrideAlign * kStrideAlign;
+    size_t need = (size_t)stride * w->height * bytes_per_pixel(w->format);
+    if (stride != w->stride || need != w->pixels.size()) {
+        w->stride = stride;
+        w->pixels.assign(need, 0);
+        w->stats.reallocations++;
+    }
+}
+
+extern "C" {
+
+void host_log_print(int prio, const char* tag, const char* fmt, ...) {
+    if (prio < gMinLevel.load(std::memory_order_relaxed)) return;
+    char line[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    const char level = prio >= HOST_LOG_ERROR ? 'E' : prio == HOST_LOG_WARN ? 'W' : prio <= HOST_LOG_DEBUG ? 'D' : 'I';
+    fprintf(stderr, "%c/%s: %s\n", level, tag, line);
+}
+
+void host_log_set_min_level(int prio) {
+    gMinLevel.store(prio, std::memory_order_relaxed);
+}
+
+int32_t ANativeWindow_setBuffersGeometry(ANativeWindow* window, int32_t width, int32_t height, int32_t format) {
+    if (!window || width < 0 || height < 0) return -1;
+    std::lock_guard<std::mutex> lk(window->lock);
+    window->stats.geometry_calls++;
+    window->width = width ? width : 1;
+    window->height = height ? height : 1;
+    if (format) window->format = format;
+    return 0;
+}
+
+int32_t ANativeWindow_lock(ANativeWindow* window, ANativeWindow_Buffer* outBuffer, ARect* inOutDirtyBounds) {
+    (void)inOutDirtyBounds;
+    if (!window || !outBuffer) return -1;
+    std::lock_guard<std::mutex> lk(window->lock);
+    if (window->locked) return -1;
+    ensure_storage(window);
+    window->locked = true;
+    window->stats.locks++;
+    memset(outBuffer, 0, sizeof(*outBuffer));
+    outBuffer->width = window->width;
+    outBuffer->height = window->height;
+    outBuffer->stride = window->stride;
+    outBuffer->format = window->format;
+    outBuffer->bits = window->pixels.data();
+    return 0;
+}
+
+int32_t ANativeWindow_unlockAndPost(ANativeWindow* window) {
+    if (!window) return -1;
+    ANativeWindow_Buffer buf;
+    host_window_post_fn fn;
+    void* user;
+    {
+        std::lock_guard<std::mutex> lk(window->lock);
+        if (!window->locked) return -1;
+        window->locked = false;
+        window->stats.posts++;
+        buf.width = window->width;
+        buf.height = window->height;
+        buf.stride = window->stride;
+        buf.format = window->format;
+        buf.bits = window->pixels.data();
+        fn = window->post_fn;
+        user = window->post_user;
+    }
+    if (fn) fn(&buf, user);
+    return 0;
+}
+
+void ANativeWindow_acquire(ANativeWindow* window) {
+    if (window) window->refs.fetch_add(1);
+}
+
+void ANativeWindow_release(ANativeWindow* window) {
+    if (window && window->refs.fetch_sub(1) == 1) delete window;
+}
+
+ANativeWindow* host_window_create() {
+    return new ANativeWindow();
+}
+
+void host_window_set_post_hook(ANativeWindow* window, host_window_post_fn fn, void* user) {
+    if (!window) return;
+    std::lock_guard<std::mutex> lk(window->lock);
+    window->post_fn = fn;
+    window->post_user = user;
+}
+
+void host_window_get_stats(ANativeWindow* window, host_window_stats* out) {
+    if (!window || !out) return;
+    std::lock_guard<std::mutex> lk(window->lock);
+    *out = window->stats;
+}
+
+} // extern "C"
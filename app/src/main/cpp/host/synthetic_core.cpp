@@ -0,0 +1,410 @@
+// synthetic_core.cpp
+// Deterministic libretro core for the host build. It renders a moving test pattern, emits a sine
+// tone and burns a fixed amount of CPU per frame, so the runtime can be measured without real cores.
+//
+// Configuration is read from the environment at retro_init (the headless runner sets these):
+//   SAASEMU_SYNTH_WIDTH / SAASEMU_SYNTH_HEIGHT   frame size (default 320x240)
+//   SAASEMU_SYNTH_FORMAT                          xrgb8888 | rgb565 | 0rgb1555 (default xrgb8888)
+//   SAASEMU_SYNTH_FPS                             reported frame rate (default 60)
+//   SAASEMU_SYNTH_AUDIO_RATE                      sample rate, 0 disables audio (default 48000)
+//   SAASEMU_SYNTH_COST                            work iterations per frame, in thousands (default 0)
+//   SAASEMU_SYNTH_SWFB                            1: render into GET_CURRENT_SOFTWARE_FRAMEBUFFER
+//   SAASEMU_SYNTH_STATE_KB                        emulated RAM included in savestates (default 0)
+//   SAASEMU_SYNTH_STATE_DIRTY                     RAM bytes rewritten per frame (default 256)
+//   SAASEMU_SYNTH_INPUT_LAG                       frames before input shows on screen (0-15, default 0)
+//   SAASEMU_SYNTH_FULLPATH                        1: report need_fullpath and read the content itself
+//
+// Content, when the file exists, is treated as a ROM: taken from retro_game_info.data if the
+// frontend provides it, otherwise read whole into a heap buffer at load the way most cores do.
+// Each frame reads a bank of it, so the two paths can be compared for load time and memory.
+//
+// With RETRO_ENVIRONMENT_GET_PERF_INTERFACE, the CPU burn and the render are timed with perf
+// counters the way real cores instrument their hot paths.
+//
+// Port 0's joypad buttons are echoed into the first 16 pixels of the top row (white: pressed),
+// INPUT_LAG frames late, so a frontend can see exactly which frame reflects an input.
+
+#include "libretro_defs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define SYNTH_EXPORT extern "C" __attribute__((visibility("default")))
+
+static retro_environment_t env_cb;
+static retro_video_refresh_t video_cb;
+static retro_audio_sample_t audio_cb;
+static retro_audio_sample_batch_t audio_batch_cb;
+static retro_input_poll_t input_poll_cb;
+static retro_input_state_t input_state_cb;
+
+static unsigned gWidth = 320;
+static unsigned gHeight = 240;
+static int gFormat = RETRO_PIXEL_FORMAT_XRGB8888;
+static double gFps = 60.0;
+static unsigned gAudioRate = 48000;
+static unsigned gCost = 0;
+static bool gUseSwFramebuffer = false;
+static unsigned gRamDirty = 256;
+static bool gInputBitmasks = false;
+static unsigned gPortDevice[2] = {RETRO_DEVICE_JOYPAD, RETRO_DEVICE_JOYPAD};
+static unsigned gInputLag = 0;
+static bool gNeedFullpath = false;
+
+static retro_log_printf_t log_cb;
+
+static retro_perf_callback gPerf;
+static bool gHavePerf = false;
+static retro_perf_counter gPerfBurn = {"synth_burn_cpu", 0, 0, 0, false};
+static retro_perf_counter gPerfRender = {"synth_render", 0, 0, 0, false};
+
+// Serialized state
+struct synth_state {
+    uint64_t frame;
+    uint64_t rng;
+    double audio_phase;
+    double audio_carry;
+    uint16_t buttons[16];   // port 0 joypad, by frame & 15
+};
+static synth_state gState;
+static std::vector<uint8_t> gRam; // serialized after gState
+
+static const uint8_t* gRom = nullptr;
+static size_t gRomSize = 0;
+static std::vector<uint8_t> gRomCopy;   // content read by path
+
+static std::vector<uint8_t> gFrame;
+static std::vector<int16_t> gAudio;
+static volatile uint64_t gSink;
+
+static unsigned env_uint(const char* name, unsigned def) {
+    const char* v = getenv(name);
+    return (v && *v) ? (unsigned)strtoul(v, nullptr, 10) : def;
+}
+
+static unsigned bytes_per_pixel() {
+    return gFormat == RETRO_PIXEL_FORMAT_XRGB8888 ? 4 : 2;
+}
+
+static uint64_t next_rand() {
+    // xorshift64*, deterministic across runs
+    gState.rng ^= gState.rng >> 12;
+    gState.rng ^= gState.rng << 25;
+    gState.rng ^= gState.rng >> 27;
+    return gState.rng * 2685821657736338717ULL;
+}
+
+// Scattered writes into RAM, roughly what a game loop does to work RAM each frame.
+static void touch_ram() {
+    if (gRam.empty()) return;
+    for (unsigned i = 0; i < gRamDirty; ++i) {
+        uint64_t r = next_rand();
+        gRam[(size_t)(r >> 8) % gRam.size()] = (uint8_t)r;
+    }
+}
+
+static void burn_cpu() {
+    uint64_t acc = 0;
+    for (unsigned i = 0; i < gCost * 1000u; ++i) acc += next_rand();
+    gSink = acc;
+}
+
+// One byte per cache line of a 256 KB bank, a different bank each frame.
+static void read_rom() {
+    if (!gRomSize) return;
+    const size_t bank = 256 * 1024;
+    const size_t banks = (gRomSize + bank - 1) / bank;
+    const size_t start = (size_t)(gState.frame % banks) * bank;
+    const size_t end = std::min(start + bank, gRomSize);
+    uint64_t acc = 0;
+    for (size_t i = start; i < end; i += 64) acc += gRom[i];
+    gSink ^= acc;
+}
+
+// Diagonal bars that scroll by one pixel per frame; every pixel changes each frame.
+// The input echo goes over the top left corner.
+static void render() {
+    const unsigned bpp = bytes_per_pixel();
+    uint8_t* dst = gFrame.data();
+    size_t pitch = (size_t)gWidth * bpp;
+
+    if (gUseSwFramebuffer) {
+        retro_framebuffer fb;
+        memset(&fb, 0, sizeof(fb));
+        fb.width = gWidth;
+        fb.height = gHeight;
+        fb.access_flags = RETRO_MEMORY_ACCESS_WRITE;
+        if (env_cb(RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER, &fb) &&
+            fb.format == gFormat && fb.pitch >= (size_t)gWidth * bpp) {
+            dst = (uint8_t*)fb.data;
+            pitch = fb.pitch;
+        }
+    }
+
+    const unsigned shift = (unsigned)gState.frame;
+    for (unsigned y = 0; y < gHeight; ++y) {
+        uint8_t* row = dst + y * pitch;
+        for (unsigned x = 0; x < gWidth; ++x) {
+            unsigned r = (x + shift) & 0xFF;
+            unsigned g = (y + shift * 2) & 0xFF;
+            unsigned b = (x + y) & 0xFF;
+            if (gFormat == RETRO_PIXEL_FORMAT_XRGB8888) {
+                ((uint32_t*)row)[x] = (r << 16) | (g << 8) | b;
+            } else if (gFormat == RETRO_PIXEL_FORMAT_RGB565) {
+                ((uint16_t*)row)[x] = (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+            } else {
+                ((uint16_t*)row)[x] = (uint16_t)(((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3));
+            }
+        }
+    }
+    const unsigned echo = gState.buttons[(gState.frame - gInputLag) & 15];
+    for (unsigned x = 0; x < 16 && x < gWidth; ++x) {
+        const bool on = (echo >> x) & 1;
+        if (gFormat == RETRO_PIXEL_FORMAT_XRGB8888) ((uint32_t*)dst)[x] = on ? 0xFFFFFF : 0;
+        else ((uint16_t*)dst)[x] = on ? (gFormat == RETRO_PIXEL_FORMAT_RGB565 ? 0xFFFF : 0x7FFF) : 0;
+    }
+    video_cb(dst, gWidth, gHeight, pitch);
+}
+
+static void emit_audio() {
+    if (!gAudioRate) return;
+    double exact = gAudioRate / gFps + gState.audio_carry;
+    size_t frames = (size_t)exact;
+    gState.audio_carry = exact - frames;
+    if (gAudio.size() < frames * 2) gAudio.resize(frames * 2);
+    const double step = 2.0 * M_PI * 440.0 / gAudioRate;
+    for (size_t i = 0; i < frames; ++i) {
+        int16_t s = (int16_t)(std::sin(gState.audio_phase) * 8000.0);
+        gAudio[i * 2] = s;
+        gAudio[i * 2 + 1] = s;
+        gState.audio_phase += step;
+    }
+    gState.audio_phase = std::fmod(gState.audio_phase, 2.0 * M_PI);
+    if (frames) audio_batch_cb(gAudio.data(), frames);
+}
+
+// Query input the way real cores do: every button (or the mask), then whatever the port's
+// device adds. Only port 0's buttons are shown (see render); the rest just feeds gSink.
+static void read_input() {
+    for (unsigned port = 0; port < 2; ++port) {
+        unsigned buttons = 0;
+        if (gInputBitmasks) {
+            buttons = (uint16_t)input_state_cb(port, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_MASK);
+        } else {
+            for (unsigned id = 0; id < 16; ++id) {
+                if (input_state_cb(port, RETRO_DEVICE_JOYPAD, 0, id)) buttons |= 1u << id;
+            }
+        }
+        if (port == 0) gState.buttons[gState.frame & 15] = (uint16_t)buttons;
+        uint64_t v = buttons;
+        switch (gPortDevice[port] & RETRO_DEVICE_MASK) {
+            case RETRO_DEVICE_ANALOG:
+                for (unsigned stick = 0; stick < 2; ++stick) {
+                    v = v * 31 + (uint16_t)input_state_cb(port, RETRO_DEVICE_ANALOG, stick, RETRO_DEVICE_ID_ANALOG_X);
+                    v = v * 31 + (uint16_t)input_state_cb(port, RETRO_DEVICE_ANALOG, stick, RETRO_DEVICE_ID_ANALOG_Y);
+                }
+                break;
+            case RETRO_DEVICE_POINTER: {
+                int n = input_state_cb(port, RETRO_DEVICE_POINTER, 0, RETRO_DEVICE_ID_POINTER_COUNT);
+                for (int i = 0; i < n; ++i) {
+                    v = v * 31 + (uint16_t)input_state_cb(port, RETRO_DEVICE_POINTER, i, RETRO_DEVICE_ID_POINTER_X);
+                    v = v * 31 + (uint16_t)input_state_cb(port, RETRO_DEVICE_POINTER, i, RETRO_DEVICE_ID_POINTER_Y);
+                }
+                break;
+            }
+            case RETRO_DEVICE_MOUSE:
+                v = v * 31 + (uint16_t)input_state_cb(port, RETRO_DEVICE_MOUSE, 0, RETRO_DEVICE_ID_MOUSE_X);
+                v = v * 31 + (uint16_t)input_state_cb(port, RETRO_DEVICE_MOUSE, 0, RETRO_DEVICE_ID_MOUSE_Y);
+                v = v * 31 + input_state_cb(port, RETRO_DEVICE_MOUSE, 0, RETRO_DEVICE_ID_MOUSE_LEFT);
+                break;
+            default:
+                break;
+        }
+        gSink ^= v;
+    }
+}
+
+SYNTH_EXPORT unsigned retro_api_version(void) { return RETRO_API_VERSION; }
+
+SYNTH_EXPORT void retro_set_environment(retro_environment_t cb) {
+    env_cb = cb;
+    static const retro_controller_description kTypes[] = {
+        {"Gamepad", RETRO_DEVICE_JOYPAD},
+        {"Analog gamepad", RETRO_DEVICE_SUBCLASS(RETRO_DEVICE_ANALOG, 0)},
+        {"Touchscreen", RETRO_DEVICE_POINTER},
+        {"Mouse", RETRO_DEVICE_MOUSE},
+    };
+    static const retro_controller_info kPorts[] = {
+        {kTypes, 4}, {kTypes, 4}, {nullptr, 0},
+    };
+    cb(RETRO_ENVIRONMENT_SET_CONTROLLER_INFO, (void*)kPorts);
+}
+SYNTH_EXPORT void retro_set_video_refresh(retro_video_refresh_t cb) { video_cb = cb; }
+SYNTH_EXPORT void retro_set_audio_sample(retro_audio_sample_t cb) { audio_cb = cb; }
+SYNTH_EXPORT void retro_set_audio_sample_batch(retro_audio_sample_batch_t cb) { audio_batch_cb = cb; }
+SYNTH_EXPORT void retro_set_input_poll(retro_input_poll_t cb) { input_poll_cb = cb; }
+SYNTH_EXPORT void retro_set_input_state(retro_input_state_t cb) { input_state_cb = cb; }
+
+SYNTH_EXPORT void retro_init(void) {
+    gWidth = env_uint("SAASEMU_SYNTH_WIDTH", 320);
+    gHeight = env_uint("SAASEMU_SYNTH_HEIGHT", 240);
+    gFps = env_uint("SAASEMU_SYNTH_FPS", 60);
+    gAudioRate = env_uint("SAASEMU_SYNTH_AUDIO_RATE", 48000);
+    gCost = env_uint("SAASEMU_SYNTH_COST", 0);
+    gUseSwFramebuffer = env_uint("SAASEMU_SYNTH_SWFB", 0) != 0;
+    gRam.assign((size_t)env_uint("SAASEMU_SYNTH_STATE_KB", 0) * 1024, 0);
+    gRamDirty = env_uint("SAASEMU_SYNTH_STATE_DIRTY", 256);
+    gInputLag = std::min(env_uint("SAASEMU_SYNTH_INPUT_LAG", 0), 15u);
+    gNeedFullpath = env_uint("SAASEMU_SYNTH_FULLPATH", 0) != 0;
+    gHavePerf = env_cb(RETRO_ENVIRONMENT_GET_PERF_INTERFACE, &gPerf) && gPerf.perf_register;
+    retro_log_callback log;
+    log_cb = env_cb(RETRO_ENVIRONMENT_GET_LOG_INTERFACE, &log) ? log.log : nullptr;
+    if (!gWidth) gWidth = 1;
+    if (!gHeight) gHeight = 1;
+    if (gFps <= 0) gFps = 60.0;
+
+    gFormat = RETRO_PIXEL_FORMAT_XRGB8888;
+    if (const char* f = getenv("SAASEMU_SYNTH_FORMAT")) {
+        if (!strcmp(f, "rgb565")) gFormat = RETRO_PIXEL_FORMAT_RGB565;
+        else if (!strcmp(f, "0rgb1555")) gFormat = RETRO_PIXEL_FORMAT_0RGB1555;
+    }
+}
+
+SYNTH_EXPORT void retro_deinit(void) {
+    gFrame.clear();
+    gAudio.clear();
+}
+
+SYNTH_EXPORT void retro_get_system_info(struct retro_system_info* info) {
+    memset(info, 0, sizeof(*info));
+    info->library_name = "saasemu synthetic";
+    info->library_version = "1.0";
+    info->valid_extensions = "synth|bin";
+    info->need_fullpath = env_uint("SAASEMU_SYNTH_FULLPATH", 0) != 0;   // may be asked before retro_init
+}
+
+SYNTH_EXPORT void retro_get_system_av_info(struct retro_system_av_info* info) {
+    memset(info, 0, sizeof(*info));
+    info->geometry.base_width = gWidth;
+    info->geometry.base_height = gHeight;
+    info->geometry.max_width = gWidth;
+    info->geometry.max_height = gHeight;
+    info->geometry.aspect_ratio = (float)gWidth / (float)gHeight;
+    info->timing.fps = gFps;
+    info->timing.sample_rate = gAudioRate;
+}
+
+SYNTH_EXPORT void retro_set_controller_port_device(unsigned port, unsigned device) {
+    if (port < 2) gPortDevice[port] = device;
+}
+
+SYNTH_EXPORT void retro_reset(void) {
+    memset(&gState, 0, sizeof(gState));
+    gState.rng = 0x9E3779B97F4A7C15ULL;
+    std::fill(gRam.begin(), gRam.end(), 0);
+}
+
+SYNTH_EXPORT bool retro_load_game(const struct retro_game_info* game) {
+    gRomCopy.clear();
+    gRom = nullptr;
+    gRomSize = 0;
+    if (game && game->data && game->size) {
+        gRom = (const uint8_t*)game->data;
+        gRomSize = game->size;
+    } else if (game && game->path) {
+        if (FILE* f = fopen(game->path, "rb")) {
+            fseek(f, 0, SEEK_END);
+            long size = ftell(f);
+            fseek(f, 0, SEEK_SET);
+            if (size > 0) {
+                gRomCopy.resize((size_t)size);
+                if (fread(gRomCopy.data(), 1, gRomCopy.size(), f) != gRomCopy.size()) gRomCopy.clear();
+            }
+            fclose(f);
+            gRom = gRomCopy.data();
+            gRomSize = gRomCopy.size();
+        }
+    }
+    int fmt = gFormat;
+    if (env_cb && !env_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt)) return false;
+    gInputBitmasks = env_cb && env_cb(RETRO_ENVIRONMENT_GET_INPUT_BITMASKS, nullptr);
+    gFrame.assign((size_t)gWidth * gHeight * bytes_per_pixel(), 0);
+    retro_reset();
+    if (log_cb) log_cb(RETRO_LOG_INFO, "synth: %ux%u at %.2f fps, %zu bytes of content%s\n", gWidth, gHeight, gFps,
+                       gRomSize, gNeedFullpath ? " (read by path)" : "");
+    return true;
+}
+
+SYNTH_EXPORT bool retro_load_game_special(unsigned type, const struct retro_game_info* info, size_t num) {
+    (void)type; (void)info; (void)num;
+    return false;
+}
+
+SYNTH_EXPORT void retro_unload_game(void) {
+    gFrame.clear();
+    gRomCopy.clear();
+    gRomCopy.shrink_to_fit();
+    gRom = nullptr;
+    gRomSize = 0;
+}
+
+SYNTH_EXPORT unsigned retro_get_region(void) { return 0; }
+
+// RETRO_PERFORMANCE_INIT / START / STOP from libretro's perf helpers
+static void perf_begin(retro_perf_counter* c) {
+    if (!gHavePerf) return;
+    if (!c->registered) gPerf.perf_register(c);
+    gPerf.perf_start(c);
+}
+
+static void perf_end(retro_perf_counter* c) {
+    if (gHavePerf) gPerf.perf_stop(c);
+}
+
+SYNTH_EXPORT void retro_run(void) {
+    input_poll_cb();
+    read_input();
+    read_rom();
+    perf_begin(&gPerfBurn);
+    burn_cpu();
+    perf_end(&gPerfBurn);
+    touch_ram();
+    int av = RETRO_AV_ENABLE_VIDEO | RETRO_AV_ENABLE_AUDIO;
+    if (!env_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av)) av = RETRO_AV_ENABLE_VIDEO | RETRO_AV_ENABLE_AUDIO;
+    if (av & RETRO_AV_ENABLE_VIDEO) {
+        perf_begin(&gPerfRender);
+        render();
+        perf_end(&gPerfRender);
+    } else video_cb(nullptr, gWidth, gHeight, 0); // frontend is skipping this frame
+    emit_audio();
+    if (log_cb && gState.frame % 60 == 0) log_cb(RETRO_LOG_DEBUG, "synth: frame %llu\n", (unsigned long long)gState.frame);
+    gState.frame++;
+}
+
+SYNTH_EXPORT size_t retro_serialize_size(void) { return sizeof(gState) + gRam.size(); }
+
+SYNTH_EXPORT bool retro_serialize(void* data, size_t size) {
+    if (size < retro_serialize_size()) return false;
+    memcpy(data, &gState, sizeof(gState));
+    if (!gRam.empty()) memcpy((uint8_t*)data + sizeof(gState), gRam.data(), gRam.size());
+    return true;
+}
+
+SYNTH_EXPORT bool retro_unserialize(const void* data, size_t size) {
+    if (size < retro_serialize_size()) return false;
+    memcpy(&gState, data, sizeof(gState));
+    if (!gRam.empty()) memcpy(gRam.data(), (const uint8_t*)data + sizeof(gState), gRam.size());
+    return true;
+}
+
+SYNTH_EXPORT void retro_cheat_reset(void) {}
+SYNTH_EXPORT void retro_cheat_set(unsigned index, bool enabled, const char* code) {
+    (void)index; (void)enabled; (void)code;
+}
+
+SYNTH_EXPORT void* retro_get_memory_data(unsigned id) { (void)id; return nullptr; }
+SYNTH_EXPORT size_t retro_get_memory_size(unsigned id) { (void)id; return 0; }
@@ -0,0 +1,245 @@
+// input_state.cpp
+// Lock-free controller state with a per-frame snapshot for the core.
+
+#include "input_state.h"
+#include "latency_histogram.h"
+#include "libretro_defs.h"
+
+#include <atomic>
+#include <mutex>
+
+// Written by the UI thread.
+struct port_live {
+    std::atomic<uint32_t> buttons{0};                       // bit per RETRO_DEVICE_ID_JOYPAD_*
+    std::atomic<uint32_t> sticks[2] = {};                   // x | y << 16
+    std::atomic<uint32_t> pointers[INPUT_MAX_POINTERS] = {}; // x | y << 16
+    std::atomic<uint32_t> pointers_down{0};                 // bit per pointer
+    std::atomic<int32_t> mouse_dx{0}, mouse_dy{0};          // accumulated since the last snapshot
+    std::atomic<uint32_t> mouse_buttons{0};                 // bit per RETRO_DEVICE_ID_MOUSE_*
+    std::atomic<int32_t> wheel[4] = {};                     // clicks: up, down, horizontal up, down
+    std::atomic<unsigned> device{RETRO_DEVICE_JOYPAD};
+};
+
+// Read by the core during a frame.
+struct port_snap {
+    unsigned device;
+    uint32_t buttons;
+    int16_t sticks[2][2];
+    unsigned pointer_count;                  // pressed touches, packed to the front
+    int16_t pointers[INPUT_MAX_POINTERS][2];
+    int16_t mouse_dx, mouse_dy;
+    uint32_t mouse_buttons;                  // wheel bits set when clicks arrived this frame
+};
+
+static port_live gLive[INPUT_MAX_PORTS];
+// latency_now_ns() of the oldest change no snapshot has seen yet, 0 if none.
+static std::atomic<int64_t> gPendingSince(0);
+
+// Emulation thread only.
+static port_snap gSnap[INPUT_MAX_PORTS];
+static bool gPolled = false;
+static bool gHeld = false;
+static int64_t gSnapSince = 0;
+
+static std::mutex gInfoLock;
+static std::vector<input_controller_type> gControllerTypes[INPUT_MAX_PORTS];
+
+static inline int16_t pair_x(uint32_t v) { return (int16_t)(v & 0xFFFF); }
+static inline int16_t pair_y(uint32_t v) { return (int16_t)(v >> 16); }
+
+static inline int16_t clamp16(int32_t v) {
+    return (int16_t)(v < -0x8000 ? -0x8000 : v > 0x7FFF ? 0x7FFF : v);
+}
+
+// Take an accumulator's value, skipping the locked exchange in the common idle case.
+static inline int32_t consume(std::atomic<int32_t>& acc) {
+    return acc.load(std::memory_order_relaxed) ? acc.exchange(0, std::memory_order_acq_rel) : 0;
+}
+
+// Keep the earliest timestamp: a frame answers the oldest input it picks up.
+static void note_change(int64_t now) {
+    int64_t expected = 0;
+    gPendingSince.compare_exchange_strong(expected, now, std::memory_order_relaxed);
+}
+
+static void set_bit(std::atomic<uint32_t>& word, unsigned bit, bool on) {
+    if (on) word.fetch_or(1u << bit, std::memory_order_release);
+    else word.fetch_and(~(1u << bit), std::memory_order_release);
+}
+
+void input_reset() {
+    for (auto& p : gLive) {
+        p.buttons.store(0, std::memory_order_relaxed);
+        for (auto& s : p.sticks) s.store(0, std::memory_order_relaxed);
+        for (auto& t : p.pointers) t.store(0, std::memory_order_relaxed);
+        p.pointers_down.store(0, std::memory_order_relaxed);
+        p.mouse_dx.store(0, std::memory_order_relaxed);
+        p.mouse_dy.store(0, std::memory_order_relaxed);
+        p.mouse_buttons.store(0, std::memory_order_relaxed);
+        for (auto& w : p.wheel) w.store(0, std::memory_order_relaxed);
+    }
+    gPendingSince.store(0, std::memory_order_relaxed);
+    gSnapSince = 0;
+}
+
+void input_unload() {
+    for (auto& p : gLive) p.device.store(RETRO_DEVICE_JOYPAD, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lk(gInfoLock);
+    for (auto& t : gControllerTypes) t.clear();
+}
+
+void input_set_button(unsigned port, unsigned id, bool pressed) {
+    if (port >= INPUT_MAX_PORTS || id >= 16) return;
+    note_change(latency_now_ns());
+    set_bit(gLive[port].buttons, id, pressed);
+}
+
+static void apply_event(uint32_t head, int32_t value) {
+    const unsigned kind = head >> 24, port = (head >> 16) & 0xFF, index = (head >> 8) & 0xFF, id = head & 0xFF;
+    if (port >= INPUT_MAX_PORTS) return;
+    port_live& p = gLive[port];
+    switch (kind) {
+        case INPUT_EVENT_BUTTON:
+            if (id < 16) set_bit(p.buttons, id, value != 0);
+            break;
+        case INPUT_EVENT_BUTTONS:
+            p.buttons.store((uint32_t)value & 0xFFFF, std::memory_order_release);
+            break;
+        case INPUT_EVENT_ANALOG:
+            if (index < 2) p.sticks[index].store((uint32_t)value, std::memory_order_release);
+            break;
+        case INPUT_EVENT_POINTER:
+            if (index >= INPUT_MAX_POINTERS) break;
+            p.pointers[index].store((uint32_t)value, std::memory_order_release);
+            set_bit(p.pointers_down, index, id != 0);
+            break;
+        case INPUT_EVENT_MOUSE_MOVE:
+            p.mouse_dx.fetch_add(pair_x((uint32_t)value), std::memory_order_relaxed);
+            p.mouse_dy.fetch_add(pair_y((uint32_t)value), std::memory_order_relaxed);
+            break;
+        case INPUT_EVENT_MOUSE_BUTTON:
+            if (id >= RETRO_DEVICE_ID_MOUSE_WHEELUP && id <= RETRO_DEVICE_ID_MOUSE_HORIZ_WHEELDOWN &&
+                id != RETRO_DEVICE_ID_MOUSE_MIDDLE) {
+                unsigned w = id <= RETRO_DEVICE_ID_MOUSE_WHEELDOWN ? id - RETRO_DEVICE_ID_MOUSE_WHEELUP
+                                                                  : id - RETRO_DEVICE_ID_MOUSE_HORIZ_WHEELUP + 2;
+                if (value > 0) p.wheel[w].fetch_add(value, std::memory_order_relaxed);
+            } else if (id < 32) {
+                set_bit(p.mouse_buttons, id, value != 0);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void input_apply_events(const int32_t* words, size_t count) {
+    if (count) note_change(latency_now_ns());
+    for (size_t i = 0; i < count; ++i) apply_event((uint32_t)words[i * 2], words[i * 2 + 1]);
+}
+
+void input_set_port_device(unsigned port, unsigned device) {
+    if (port < INPUT_MAX_PORTS) gLive[port].device.store(device, std::memory_order_release);
+}
+
+unsigned input_port_device(unsigned port) {
+    return port < INPUT_MAX_PORTS ? gLive[port].device.load(std::memory_order_acquire) : (unsigned)RETRO_DEVICE_NONE;
+}
+
+void input_set_controller_info(const retro_controller_info* info) {
+    std::lock_guard<std::mutex> lk(gInfoLock);
+    for (auto& t : gControllerTypes) t.clear();
+    for (unsigned port = 0; info && info[port].types && port < INPUT_MAX_PORTS; ++port) {
+        for (unsigned i = 0; i < info[port].num_types; ++i) {
+            const retro_controller_description& d = info[port].types[i];
+            gControllerTypes[port].push_back({d.id, d.desc ? d.desc : ""});
+        }
+    }
+}
+
+std::vector<input_controller_type> input_controller_types(unsigned port) {
+    std::lock_guard<std::mutex> lk(gInfoLock);
+    return port < INPUT_MAX_PORTS ? gControllerTypes[port] : std::vector<input_controller_type>();
+}
+
+void input_begin_frame() {
+    gPolled = false;
+}
+
+void input_hold(bool held) {
+    gHeld = held;
+}
+
+void input_poll() {
+    if (gHeld && gPolled) return;
+    // before the state loads: a change stamped after this exchange is left for the next snapshot
+    if (gPendingSince.load(std::memory_order_relaxed)) {
+        int64_t since = gPendingSince.exchange(0, std::memory_order_acquire);
+        if (since && (!gSnapSince || since < gSnapSince)) gSnapSince = since;
+    }
+    static const unsigned kWheelIds[4] = {RETRO_DEVICE_ID_MOUSE_WHEELUP, RETRO_DEVICE_ID_MOUSE_WHEELDOWN,
+                                          RETRO_DEVICE_ID_MOUSE_HORIZ_WHEELUP,
+                                          RETRO_DEVICE_ID_MOUSE_HORIZ_WHEELDOWN};
+    for (unsigned n = 0; n < INPUT_MAX_PORTS; ++n) {
+        port_live& p = gLive[n];
+        port_snap& s = gSnap[n];
+        s.device = p.device.load(std::memory_order_acquire);
+        s.buttons = p.buttons.load(std::memory_order_acquire);
+        for (unsigned k = 0; k < 2; ++k) {
+            uint32_t v = p.sticks[k].load(std::memory_order_acquire);
+            s.sticks[k][0] = pair_x(v);
+            s.sticks[k][1] = pair_y(v);
+        }
+        uint32_t down = p.pointers_down.load(std::memory_order_acquire);
+        s.pointer_count = 0;
+        for (unsigned k = 0; k < INPUT_MAX_POINTERS; ++k) {
+            if (!(down & (1u << k))) continue;
+            uint32_t v = p.pointers[k].load(std::memory_order_acquire);
+            s.pointers[s.pointer_count][0] = pair_x(v);
+            s.pointers[s.pointer_count][1] = pair_y(v);
+            s.pointer_count++;
+        }
+        s.mouse_dx = clamp16(consume(p.mouse_dx));
+        s.mouse_dy = clamp16(consume(p.mouse_dy));
+        s.mouse_buttons = p.mouse_buttons.load(std::memory_order_acquire);
+        for (unsigned w = 0; w < 4; ++w) {
+            if (consume(p.wheel[w]) > 0) s.mouse_buttons |= 1u << kWheelIds[w];
+        }
+    }
+    gPolled = true;
+}
+
+int64_t input_take_snapshot_time() {
+    int64_t since = gSnapSince;
+    gSnapSince = 0;
+    return since;
+}
+
+int16_t input_state(unsigned port, unsigned device, unsigned index, unsigned id) {
+    if (!gPolled) input_poll();
+    if (port >= INPUT_MAX_PORTS) return 0;
+    const port_snap& s = gSnap[port];
+    if (s.device == RETRO_DEVICE_NONE) return 0;
+
+    switch (device & RETRO_DEVICE_MASK) {
+        case RETRO_DEVICE_JOYPAD:
+            if (id == RETRO_DEVICE_ID_JOYPAD_MASK) return (int16_t)(s.buttons & 0xFFFF);
+            return id < 16 ? (int16_t)((s.buttons >> id) & 1) : 0;
+        case RETRO_DEVICE_ANALOG:
+            if (index == RETRO_DEVICE_INDEX_ANALOG_BUTTON) {
+                // digital buttons report full pressure
+                return id < 16 && (s.buttons >> id & 1) ? 0x7FFF : 0;
+            }
+            return index < 2 && id < 2 ? s.sticks[index][id] : 0;
+        case RETRO_DEVICE_POINTER:
+            if (id == RETRO_DEVICE_ID_POINTER_COUNT) return (int16_t)s.pointer_count;
+            if (index >= s.pointer_count) return 0;
+            if (id == RETRO_DEVICE_ID_POINTER_PRESSED) return 1;
+            return id < 2 ? s.pointers[index][id] : 0;
+        case RETRO_DEVICE_MOUSE:
+            if (id == RETRO_DEVICE_ID_MOUSE_X) return s.mouse_dx;
+            if (id == RETRO_DEVICE_ID_MOUSE_Y) return s.mouse_dy;
+            return id < 32 ? (int16_t)((s.mouse_buttons >> id) & 1) : 0;
+        default:
+            return 0;
+    }
+}
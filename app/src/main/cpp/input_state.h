@@ -0,0 +1,89 @@
+// input_state.h
+// Controller state shared between the UI thread and the core.
+//
+// The UI thread updates per-port atomic words (buttons, sticks, touches, mouse) without taking a
+// lock. Once per frame the core's input_poll callback copies them into a snapshot owned by the
+// emulation thread, and every input_state query that frame reads the snapshot with no
+// synchronization at all: cores query dozens of times per frame and all of them see the same,
+// consistent state. Cores that never poll get an implicit snapshot on their first query of the
+// frame. Relative mouse motion and wheel clicks accumulate until a snapshot consumes them.
+//
+// Every change is timestamped on arrival (latency_now_ns); the oldest one a snapshot picks up is
+// handed to the frame being produced, for input-to-photon latency measurement.
+//
+// Supported devices: RETRO_DEVICE_JOYPAD (including RETRO_DEVICE_ID_JOYPAD_MASK), ANALOG (both
+// sticks and per-button pressure), POINTER (multi-touch) and MOUSE, on INPUT_MAX_PORTS ports.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define INPUT_MAX_PORTS 8
+#define INPUT_MAX_POINTERS 4
+
+struct retro_controller_info;
+
+// Batched input, so a frame's worth of changes crosses JNI once. Each event is two 32-bit words:
+//   word 0: kind << 24 | port << 16 | index << 8 | id
+//   word 1: value
+// Paired axes travel together as value = (x & 0xFFFF) | y << 16, so they never update apart.
+enum input_event_kind {
+    INPUT_EVENT_BUTTON = 1,        // id: RETRO_DEVICE_ID_JOYPAD_*, value: 0/1
+    INPUT_EVENT_BUTTONS = 2,       // value: every joypad button as a bitmask
+    INPUT_EVENT_ANALOG = 3,        // index: RETRO_DEVICE_INDEX_ANALOG_LEFT/RIGHT, value: x | y << 16
+    INPUT_EVENT_POINTER = 4,       // index: touch, id: pressed 0/1, value: x | y << 16
+    INPUT_EVENT_MOUSE_MOVE = 5,    // value: dx | dy << 16
+    INPUT_EVENT_MOUSE_BUTTON = 6,  // id: RETRO_DEVICE_ID_MOUSE_*, value: 0/1, or clicks for wheels
+};
+
+static inline uint32_t input_event_word(unsigned kind, unsigned port, unsigned index, unsigned id) {
+    return (kind & 0xFF) << 24 | (port & 0xFF) << 16 | (index & 0xFF) << 8 | (id & 0xFF);
+}
+
+static inline int32_t input_event_pair(int x, int y) {
+    return (int32_t)(((uint32_t)(uint16_t)x) | ((uint32_t)(uint16_t)y << 16));
+}
+
+struct input_controller_type {
+    unsigned id;       // RETRO_DEVICE_* or subclass
+    std::string desc;
+};
+
+// Release everything on every port (new game).
+void input_reset();
+
+// Forget the core's controller info and plug a joypad back into every port (core unload).
+void input_unload();
+
+// UI thread: press or release a RETRO_DEVICE_ID_JOYPAD_* button on a port. Lock-free.
+void input_set_button(unsigned port, unsigned id, bool pressed);
+
+// UI thread: apply count events (2 * count words, see input_event_kind). Lock-free.
+void input_apply_events(const int32_t* words, size_t count);
+
+// Device plugged into a port (RETRO_DEVICE_*, subclasses allowed); NONE mutes the port.
+// Every port starts as RETRO_DEVICE_JOYPAD.
+void input_set_port_device(unsigned port, unsigned device);
+unsigned input_port_device(unsigned port);
+
+// RETRO_ENVIRONMENT_SET_CONTROLLER_INFO: keep a copy of the types the core offers per port.
+void input_set_controller_info(const retro_controller_info* info);
+std::vector<input_controller_type> input_controller_types(unsigned port);
+
+// Emulation thread, before retro_run: the next query or poll takes a fresh snapshot.
+void input_begin_frame();
+
+// Emulation thread: while held, polls keep the current snapshot, so run-ahead replays of a frame
+// see exactly the input the real frame saw.
+void input_hold(bool held);
+
+// Emulation thread: retro_input_poll_t and retro_input_state_t implementations.
+void input_poll();
+int16_t input_state(unsigned port, unsigned device, unsigned index, unsigned id);
+
+// Emulation thread: arrival time of the oldest input change that snapshots since the last call
+// picked up, or 0 if none did. Clears it, so each change is attributed to one frame.
+int64_t input_take_snapshot_time();
@@ -0,0 +1,84 @@
+// latency_histogram.h
+// Fixed-bucket histogram of durations, written by one thread and read by any.
+//
+// Buckets are kBucketNs wide up to kBuckets * kBucketNs; longer samples land in the last bucket
+// (the summary's max still reports them exactly). Recording is a couple of relaxed atomic adds, cheap
+// enough for the presenter thread on every frame.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Timestamps compared across threads (input, presentation) all come from this clock.
+static inline int64_t latency_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct latency_summary {
+    uint64_t count;
+    int64_t mean_ns;
+    int64_t p50_ns;
+    int64_t p90_ns;
+    int64_t p99_ns;
+    int64_t max_ns;
+};
+
+class LatencyHistogram {
+public:
+    static const size_t kBuckets = 256;
+    static const int64_t kBucketNs = 500000;   // 0.5 ms: 128 ms of range
+
+    void clear() {
+        for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+        total_ns_.store(0, std::memory_order_relaxed);
+        max_ns_.store(0, std::memory_order_relaxed);
+    }
+
+    // Single writer.
+    void record(int64_t ns) {
+        if (ns < 0) ns = 0;
+        size_t b = (size_t)(ns / kBucketNs);
+        if (b >= kBuckets) b = kBuckets - 1;
+        buckets_[b].fetch_add(1, std::memory_order_relaxed);
+        total_ns_.fetch_add((uint64_t)ns, std::memory_order_relaxed);
+        if (ns > max_ns_.load(std::memory_order_relaxed)) max_ns_.store(ns, std::memory_order_relaxed);
+    }
+
+    // Copy up to n bucket counts; returns the number of buckets.
+    size_t buckets(uint32_t* out, size_t n) const {
+        for (size_t i = 0; i < n && i < kBuckets; ++i) out[i] = (uint32_t)buckets_[i].load(std::memory_order_relaxed);
+        return kBuckets;
+    }
+
+    // Percentiles resolve to the middle of their bucket.
+    void summarize(latency_summary* out) const {
+        uint64_t counts[kBuckets];
+        uint64_t total = 0;
+        for (size_t i = 0; i < kBuckets; ++i) total += counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        out->count = total;
+        out->max_ns = max_ns_.load(std::memory_order_relaxed);
+        out->mean_ns = total ? (int64_t)(total_ns_.load(std::memory_order_relaxed) / total) : 0;
+        out->p50_ns = percentile(counts, total, 0.50);
+        out->p90_ns = percentile(counts, total, 0.90);
+        out->p99_ns = percentile(counts, total, 0.99);
+    }
+
+private:
+    static int64_t percentile(const uint64_t* counts, uint64_t total, double p) {
+        if (!total) return 0;
+        uint64_t rank = (uint64_t)(p * (total - 1)) + 1, seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return (int64_t)i * kBucketNs + kBucketNs / 2;
+        }
+        return (int64_t)kBuckets * kBucketNs;
+    }
+
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> total_ns_{0};
+    std::atomic<int64_t> max_ns_{0};
+};
@@ -4,7 +4,7 @@
 // - Lê BIOS por system dir
 // - Carrega ROM
 // - Conecta vídeo ao SurfaceView
-// - Reproduz áudio via AudioTrack (Java)
+// - Reproduz áudio via audio_output (ring lock-free + thread de saída)
 // - Input básico
 // - Emulação em thread separada
 
@@ -20,6 +20,9 @@
 #include <mutex>
 #include <condition_variable>
 
+#include "audio_output.h"
+#include "pixel_convert.h"
+
 #define LOG_TAG "LibretroGlue"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
@@ -49,6 +52,12 @@ typedef void (*retro_run_t)(void);
 
 typedef bool (*retro_environment_t)(unsigned cmd, void* data);
 
+typedef struct retro_system_av_info {
+    struct { unsigned base_width, base_height, max_width, max_height; float aspect_ratio; } geometry;
+    struct { double fps, sample_rate; } timing;
+} retro_system_av_info;
+typedef void (*retro_get_system_av_info_t)(struct retro_system_av_info *);
+
 enum {
     RETRO_ENVIRONMENT_SET_PIXEL_FORMAT = 10,
     RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY = 8
@@ -75,6 +84,7 @@ static retro_deinit_t g_deinit = nullptr;
 static retro_load_game_t g_loadGame = nullptr;
 static retro_unload_game_t g_unloadGame = nullptr;
 static retro_run_t g_run = nullptr;
+static retro_get_system_av_info_t g_getAvInfo = nullptr;
 
 static std::atomic<bool> gRunning(false);
 static std::thread gThread;
@@ -88,25 +98,12 @@ static std::mutex gInputMutex;
 static std::vector<int> gButtons(512, 0);
 
 static JavaVM* gJvm = nullptr;
-static jobject gAudioTrack = nullptr;
-static jmethodID gAudioWrite = nullptr;
 
 // ---------------------------------
-// Audio → AudioTrack (Java)
+// Audio → ring (sem JNI, sem alocação)
 // ---------------------------------
 static void sendAudio(const int16_t* samples, size_t frames) {
-    if (!gJvm || !gAudioTrack || !gAudioWrite) return;
-
-    JNIEnv* env = nullptr;
-    gJvm->AttachCurrentThread(&env, nullptr);
-
-    jshortArray arr = env->NewShortArray(frames * 2);
-    env->SetShortArrayRegion(arr, 0, frames * 2, samples);
-
-    env->CallVoidMethod(gAudioTrack, gAudioWrite, arr, 0, (jint)(frames * 2));
-
-    env->DeleteLocalRef(arr);
-    gJvm->DetachCurrentThread();
+    audio_output_write(samples, frames);
 }
 
 // ---------------------------------
@@ -140,27 +137,7 @@ static void video_cb(const void* data, unsigned w, unsigned h, size_t pitch) {
     ANativeWindow_Buffer buf;
     if (ANativeWindow_lock(gWindow, &buf, nullptr) != 0) return;
 
-    uint8_t* dst = (uint8_t*)buf.bits;
-
-    if (gPixelFormat == RETRO_PIXEL_FORMAT_XRGB8888) {
-        for (unsigned y=0; y<h; y++) {
-            memcpy(dst + y * buf.stride * 4, (uint8_t*)data + y * pitch, w * 4);
-        }
-
-    } else if (gPixelFormat == RETRO_PIXEL_FORMAT_RGB565) {
-        uint16_t* src = (uint16_t*)data;
-        uint32_t* out = (uint32_t*)buf.bits;
-
-        for (unsigned y=0; y<h; y++) {
-            for (unsigned x=0; x<w; x++) {
-                uint16_t p = src[y*(pitch/2)+x];
-                uint8_t r = ((p>>11)&0x1F)<<3;
-                uint8_t g = ((p>>5)&0x3F)<<2;
-                uint8_t b = (p&0x1F)<<3;
-                out[y*buf.stride+x] = (0xFF<<24)|(r<<16)|(g<<8)|b;
-            }
-        }
-    }
+    pixel_convert_frame(gPixelFormat, buf.bits, (size_t)buf.stride * 4, data, pitch, w, h);
 
     ANativeWindow_unlockAndPost(gWindow);
 }
@@ -214,6 +191,7 @@ Java_com_saasemu_app_core_NativeBridge_loadCore
         gCore = nullptr;
     }
 
+    pixel_convert_init();
     gCore = dlopen(p, RTLD_NOW);
     env->ReleaseStringUTFChars(path, p);
 
@@ -246,6 +224,8 @@ Java_com_saasemu_app_core_NativeBridge_loadCore
         return JNI_FALSE;
     }
 
+    load(g_getAvInfo, "retro_get_system_av_info"); // opcional: taxa de áudio do core
+
     g_setEnv(environment_cb);
     g_setVideo(video_cb);
     g_setAudio(audio_cb);
@@ -293,6 +273,10 @@ Java_com_saasemu_app_core_NativeBridge_startEmulation
 
     if (gRunning.load()) return JNI_TRUE;
 
+    retro_system_av_info av{};
+    if (g_getAvInfo) g_getAvInfo(&av);
+    if (av.timing.sample_rate > 0) audio_output_start((unsigned)(av.timing.sample_rate + 0.5));
+
     gRunning.store(true);
     gThread = std::thread(emuLoop);
     return JNI_TRUE;
@@ -305,6 +289,7 @@ Java_com_saasemu_app_core_NativeBridge_stopEmulation
 (JNIEnv*, jclass) {
     gRunning.store(false);
     if (gThread.joinable()) gThread.join();
+    audio_output_stop();
     return JNI_TRUE;
 }
 
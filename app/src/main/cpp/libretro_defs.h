@@ -0,0 +1,257 @@
+// libretro_defs.h
+// Minimal subset of the libretro API shared by the loader and the host synthetic core.
+// Values match upstream libretro.h; only what we actually use is declared here.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Callback typedefs
+typedef bool (*retro_environment_t)(unsigned, void*);
+typedef void (*retro_video_refresh_t)(const void*, unsigned, unsigned, size_t);
+typedef void (*retro_audio_sample_t)(int16_t, int16_t);
+typedef size_t (*retro_audio_sample_batch_t)(const int16_t*, size_t);
+typedef void (*retro_input_poll_t)(void);
+typedef int16_t (*retro_input_state_t)(unsigned, unsigned, unsigned, unsigned);
+
+struct retro_game_info {
+    const char *path;
+    const void *data;
+    size_t size;
+    const char *meta;
+};
+
+struct retro_system_info {
+    const char *library_name;
+    const char *library_version;
+    const char *valid_extensions;
+    bool need_fullpath;
+    bool block_extract;
+};
+
+struct retro_game_geometry {
+    unsigned base_width;
+    unsigned base_height;
+    unsigned max_width;
+    unsigned max_height;
+    float aspect_ratio;
+};
+
+struct retro_system_timing {
+    double fps;
+    double sample_rate;
+};
+
+struct retro_system_av_info {
+    struct retro_game_geometry geometry;
+    struct retro_system_timing timing;
+};
+
+enum {
+    RETRO_API_VERSION = 1
+};
+
+#define RETRO_ENVIRONMENT_EXPERIMENTAL 0x10000
+
+// RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER
+struct retro_framebuffer {
+    void *data;
+    unsigned width;
+    unsigned height;
+    size_t pitch;
+    int format;              // RETRO_PIXEL_FORMAT_*
+    unsigned access_flags;   // RETRO_MEMORY_ACCESS_*
+    unsigned memory_flags;   // RETRO_MEMORY_TYPE_*
+};
+
+// RETRO_ENVIRONMENT_SET_FRAME_TIME_CALLBACK
+typedef int64_t retro_usec_t;
+typedef void (*retro_frame_time_callback_t)(retro_usec_t usec);
+struct retro_frame_time_callback {
+    retro_frame_time_callback_t callback;
+    retro_usec_t reference;  // nominal frame time, passed when no measurement is meaningful
+};
+
+// RETRO_ENVIRONMENT_GET_LOG_INTERFACE
+enum retro_log_level {
+    RETRO_LOG_DEBUG = 0,
+    RETRO_LOG_INFO,
+    RETRO_LOG_WARN,
+    RETRO_LOG_ERROR,
+    RETRO_LOG_DUMMY = 0x7fffffff
+};
+
+typedef void (*retro_log_printf_t)(enum retro_log_level level, const char *fmt, ...);
+
+struct retro_log_callback {
+    retro_log_printf_t log;
+};
+
+// RETRO_ENVIRONMENT_GET_PERF_INTERFACE
+typedef int64_t retro_time_t;
+typedef uint64_t retro_perf_tick_t;
+
+// Owned by the core (usually static); the frontend keeps a pointer once it is registered.
+struct retro_perf_counter {
+    const char *ident;
+    retro_perf_tick_t start;
+    retro_perf_tick_t total;
+    retro_perf_tick_t call_cnt;
+    bool registered;
+};
+
+typedef retro_time_t (*retro_perf_get_time_usec_t)(void);
+typedef retro_perf_tick_t (*retro_perf_get_counter_t)(void);
+typedef uint64_t (*retro_get_cpu_features_t)(void);   // RETRO_SIMD_*
+typedef void (*retro_perf_log_t)(void);
+typedef void (*retro_perf_register_t)(struct retro_perf_counter *counter);
+typedef void (*retro_perf_start_t)(struct retro_perf_counter *counter);
+typedef void (*retro_perf_stop_t)(struct retro_perf_counter *counter);
+
+struct retro_perf_callback {
+    retro_perf_get_time_usec_t get_time_usec;
+    retro_get_cpu_features_t get_cpu_features;
+    retro_perf_get_counter_t get_perf_counter;
+    retro_perf_register_t perf_register;
+    retro_perf_start_t perf_start;
+    retro_perf_stop_t perf_stop;
+    retro_perf_log_t perf_log;
+};
+
+enum {
+    RETRO_SIMD_SSE    = 1 << 0,
+    RETRO_SIMD_SSE2   = 1 << 1,
+    RETRO_SIMD_VMX    = 1 << 2,
+    RETRO_SIMD_VMX128 = 1 << 3,
+    RETRO_SIMD_AVX    = 1 << 4,
+    RETRO_SIMD_NEON   = 1 << 5,
+    RETRO_SIMD_SSE3   = 1 << 6,
+    RETRO_SIMD_SSSE3  = 1 << 7,
+    RETRO_SIMD_MMX    = 1 << 8,
+    RETRO_SIMD_MMXEXT = 1 << 9,
+    RETRO_SIMD_SSE4   = 1 << 10,
+    RETRO_SIMD_SSE42  = 1 << 11,
+    RETRO_SIMD_AVX2   = 1 << 12,
+    RETRO_SIMD_VFPU   = 1 << 13,
+    RETRO_SIMD_PS     = 1 << 14,
+    RETRO_SIMD_AES    = 1 << 15,
+    RETRO_SIMD_VFPV3  = 1 << 16,
+    RETRO_SIMD_VFPV4  = 1 << 17,
+    RETRO_SIMD_POPCNT = 1 << 18,
+    RETRO_SIMD_MOVBE  = 1 << 19,
+    RETRO_SIMD_CMOV   = 1 << 20,
+    RETRO_SIMD_ASIMD  = 1 << 21
+};
+
+enum {
+    RETRO_MEMORY_ACCESS_WRITE = 1 << 0,
+    RETRO_MEMORY_ACCESS_READ = 1 << 1,
+    RETRO_MEMORY_TYPE_CACHED = 1 << 0
+};
+
+enum {
+    RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY = 8,
+    RETRO_ENVIRONMENT_SET_PIXEL_FORMAT = 10,
+    RETRO_ENVIRONMENT_SET_FRAME_TIME_CALLBACK = 21,
+    RETRO_ENVIRONMENT_GET_LOG_INTERFACE = 27,
+    RETRO_ENVIRONMENT_GET_PERF_INTERFACE = 28,
+    RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO = 32,
+    RETRO_ENVIRONMENT_SET_CONTROLLER_INFO = 35,
+    RETRO_ENVIRONMENT_SET_GEOMETRY = 37,
+    RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER = 40 | RETRO_ENVIRONMENT_EXPERIMENTAL,
+    RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE = 47 | RETRO_ENVIRONMENT_EXPERIMENTAL,
+    RETRO_ENVIRONMENT_GET_FASTFORWARDING = 49 | RETRO_ENVIRONMENT_EXPERIMENTAL,
+    RETRO_ENVIRONMENT_GET_INPUT_BITMASKS = 51 | RETRO_ENVIRONMENT_EXPERIMENTAL
+};
+
+// RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE bits
+enum {
+    RETRO_AV_ENABLE_VIDEO = 1 << 0,
+    RETRO_AV_ENABLE_AUDIO = 1 << 1
+};
+
+enum {
+    RETRO_PIXEL_FORMAT_0RGB1555 = 0,
+    RETRO_PIXEL_FORMAT_XRGB8888 = 1,
+    RETRO_PIXEL_FORMAT_RGB565 = 2
+};
+
+// The low byte of a device id is the base type; cores may pass subclasses built on top of it.
+#define RETRO_DEVICE_TYPE_SHIFT 8
+#define RETRO_DEVICE_MASK ((1 << RETRO_DEVICE_TYPE_SHIFT) - 1)
+
+#define RETRO_DEVICE_SUBCLASS(base, id) ((((id) + 1) << RETRO_DEVICE_TYPE_SHIFT) | (base))
+
+enum {
+    RETRO_DEVICE_NONE = 0,
+    RETRO_DEVICE_JOYPAD = 1,
+    RETRO_DEVICE_MOUSE = 2,
+    RETRO_DEVICE_KEYBOARD = 3,
+    RETRO_DEVICE_LIGHTGUN = 4,
+    RETRO_DEVICE_ANALOG = 5,
+    RETRO_DEVICE_POINTER = 6
+};
+
+// RETRO_DEVICE_ANALOG: index selects the stick (or per-button pressure), id the axis.
+enum {
+    RETRO_DEVICE_INDEX_ANALOG_LEFT = 0,
+    RETRO_DEVICE_INDEX_ANALOG_RIGHT = 1,
+    RETRO_DEVICE_INDEX_ANALOG_BUTTON = 2,
+    RETRO_DEVICE_ID_ANALOG_X = 0,
+    RETRO_DEVICE_ID_ANALOG_Y = 1
+};
+
+// RETRO_DEVICE_MOUSE: X/Y are deltas since the last poll.
+enum {
+    RETRO_DEVICE_ID_MOUSE_X = 0,
+    RETRO_DEVICE_ID_MOUSE_Y = 1,
+    RETRO_DEVICE_ID_MOUSE_LEFT = 2,
+    RETRO_DEVICE_ID_MOUSE_RIGHT = 3,
+    RETRO_DEVICE_ID_MOUSE_WHEELUP = 4,
+    RETRO_DEVICE_ID_MOUSE_WHEELDOWN = 5,
+    RETRO_DEVICE_ID_MOUSE_MIDDLE = 6,
+    RETRO_DEVICE_ID_MOUSE_HORIZ_WHEELUP = 7,
+    RETRO_DEVICE_ID_MOUSE_HORIZ_WHEELDOWN = 8,
+    RETRO_DEVICE_ID_MOUSE_BUTTON_4 = 9,
+    RETRO_DEVICE_ID_MOUSE_BUTTON_5 = 10
+};
+
+// RETRO_DEVICE_POINTER: absolute screen position in [-0x7fff, 0x7fff]; index selects the touch.
+enum {
+    RETRO_DEVICE_ID_POINTER_X = 0,
+    RETRO_DEVICE_ID_POINTER_Y = 1,
+    RETRO_DEVICE_ID_POINTER_PRESSED = 2,
+    RETRO_DEVICE_ID_POINTER_COUNT = 3
+};
+
+// RETRO_ENVIRONMENT_SET_CONTROLLER_INFO: one entry per port, terminated by types == NULL.
+struct retro_controller_description {
+    const char *desc;
+    unsigned id;             // RETRO_DEVICE_* or a RETRO_DEVICE_SUBCLASS
+};
+
+struct retro_controller_info {
+    const struct retro_controller_description *types;
+    unsigned num_types;
+};
+
+enum {
+    RETRO_DEVICE_ID_JOYPAD_B = 0,
+    RETRO_DEVICE_ID_JOYPAD_Y = 1,
+    RETRO_DEVICE_ID_JOYPAD_SELECT = 2,
+    RETRO_DEVICE_ID_JOYPAD_START = 3,
+    RETRO_DEVICE_ID_JOYPAD_UP = 4,
+    RETRO_DEVICE_ID_JOYPAD_DOWN = 5,
+    RETRO_DEVICE_ID_JOYPAD_LEFT = 6,
+    RETRO_DEVICE_ID_JOYPAD_RIGHT = 7,
+    RETRO_DEVICE_ID_JOYPAD_A = 8,
+    RETRO_DEVICE_ID_JOYPAD_X = 9,
+    RETRO_DEVICE_ID_JOYPAD_L = 10,
+    RETRO_DEVICE_ID_JOYPAD_R = 11,
+    RETRO_DEVICE_ID_JOYPAD_L2 = 12,
+    RETRO_DEVICE_ID_JOYPAD_R2 = 13,
+    RETRO_DEVICE_ID_JOYPAD_L3 = 14,
+    RETRO_DEVICE_ID_JOYPAD_R3 = 15,
+    RETRO_DEVICE_ID_JOYPAD_MASK = 256   // all buttons as a bitmask (GET_INPUT_BITMASKS)
+};
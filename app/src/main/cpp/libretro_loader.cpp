@@ -2,75 +2,216 @@
 // Responsible for dlopen core, resolving libretro symbols, callbacks, retro_run thread.
 // Exposes C-style functions that native_bridge.cpp will call.
 
+#include "libretro_loader.h"
+#include "libretro_defs.h"
+#include "audio_output.h"
+#include "content_map.h"
+#include "core_perf.h"
+#include "frame_pacer.h"
+#include "input_state.h"
+#include "perf_stats.h"
+#include "pixel_convert.h"
+#include "rewind_buffer.h"
+#include "savestate.h"
+#include "thread_placement.h"
+#include "trace.h"
+#include "video_presenter.h"
+#include "zip_archive.h"
+
+#include <dirent.h>
 #include <dlfcn.h>
-#include <android/log.h>
-#include <android/native_window.h>
-#include <android/native_window_jni.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <vector>
+#include <string>
 #include <cstring>
+#include <cerrno>
 
 #define LOG_TAG "LibRetroLoader"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 // Minimal libretro typedefs
-typedef bool (*retro_environment_t)(unsigned, void*);
 typedef void (*retro_set_environment_t)(retro_environment_t);
-typedef void (*retro_set_video_refresh_t)(void (*)(const void*, unsigned, unsigned, size_t));
-typedef void (*retro_set_audio_sample_t)(void (*)(int16_t, int16_t));
-typedef void (*retro_set_audio_sample_batch_t)(size_t (*)(const int16_t*, size_t));
-typedef void (*retro_set_input_poll_t)(void (*)(void));
-typedef void (*retro_set_input_state_t)(int16_t (*)(unsigned, unsigned, unsigned, unsigned));
+typedef void (*retro_set_video_refresh_t)(retro_video_refresh_t);
+typedef void (*retro_set_audio_sample_t)(retro_audio_sample_t);
+typedef void (*retro_set_audio_sample_batch_t)(retro_audio_sample_batch_t);
+typedef void (*retro_set_input_poll_t)(retro_input_poll_t);
+typedef void (*retro_set_input_state_t)(retro_input_state_t);
+typedef void (*retro_set_controller_port_device_t)(unsigned, unsigned);
 typedef void (*retro_init_t)(void);
 typedef void (*retro_deinit_t)(void);
-typedef int (*retro_api_version_t)(void);
+typedef unsigned (*retro_api_version_t)(void);
+typedef void (*retro_get_system_info_t)(struct retro_system_info *);
+typedef void (*retro_get_system_av_info_t)(struct retro_system_av_info *);
 typedef bool (*retro_load_game_t)(const struct retro_game_info *);
 typedef void (*retro_unload_game_t)(void);
 typedef void (*retro_run_t)(void);
-
-struct retro_game_info {
-    const char *path;
-    const void *data;
-    size_t size;
-    const char *meta;
-};
-
-enum {
-    RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY = 8,
-    RETRO_ENVIRONMENT_SET_PIXEL_FORMAT = 10
-};
-
-enum {
-    RETRO_PIXEL_FORMAT_XRGB8888 = 1,
-    RETRO_PIXEL_FORMAT_RGB565 = 2
-};
+typedef size_t (*retro_serialize_size_t)(void);
+typedef bool (*retro_serialize_t)(void *, size_t);
+typedef bool (*retro_unserialize_t)(const void *, size_t);
 
 // Internal state
 static void* gCoreHandle = nullptr;
+static std::string gCorePath;
 static retro_set_environment_t g_set_environment = nullptr;
 static retro_set_video_refresh_t g_set_video = nullptr;
 static retro_set_audio_sample_t g_set_audio = nullptr;
 static retro_set_audio_sample_batch_t g_set_audio_batch = nullptr;
 static retro_set_input_poll_t g_set_poll = nullptr;
 static retro_set_input_state_t g_set_input_state = nullptr;
+static retro_set_controller_port_device_t g_set_controller_port_device = nullptr;
 static retro_init_t g_retro_init = nullptr;
 static retro_deinit_t g_retro_deinit = nullptr;
 static retro_load_game_t g_retro_load_game = nullptr;
 static retro_unload_game_t g_retro_unload_game = nullptr;
 static retro_run_t g_retro_run = nullptr;
 static retro_api_version_t g_retro_api_version = nullptr;
+static retro_get_system_info_t g_retro_get_system_info = nullptr;
+static retro_get_system_av_info_t g_retro_get_system_av_info = nullptr;
+static retro_serialize_size_t g_retro_serialize_size = nullptr;
+static retro_serialize_t g_retro_serialize = nullptr;
+static retro_unserialize_t g_retro_unserialize = nullptr;
 
-static ANativeWindow* gWindow = nullptr;
-static std::mutex gWindowMutex;
+static retro_system_av_info gAvInfo;
+static retro_frame_time_callback gFrameTime;
 
 static std::atomic<bool> gRunning(false);
 static std::thread gEmuThread;
-static int gPixelFormat = RETRO_PIXEL_FORMAT_XRGB8888;
 
-static std::mutex gInputLock;
-static std::vector<int> gButtons(512, 0);
+static std::atomic<bool> gPacing(true);
+static std::atomic<bool> gFastForward(false);
+static std::atomic<float> gFastForwardRatio(0.0f); // <= 0: as fast as the core runs
+
+// Ports whose device changed since the core was last told (bit per port); applied between frames.
+static std::atomic<uint32_t> gPortDevicesPending(0);
+
+// Per-frame decisions, emulation thread only
+static bool gPresentThisFrame = true;
+static bool gAudioThisFrame = true;
+static bool gReplayFrame = false;      // run-ahead: suppressed output is expected, not counted as skipped
+static int64_t gFrameInputNs = 0;      // oldest input not yet shown on a presented frame (0: none)
+
+// Run-ahead: settings from the UI thread, everything else emulation thread only
+static std::atomic<unsigned> gRunAheadFrames(0);
+static std::atomic<bool> gRunAheadSecondary(false);
+static std::atomic<bool> gRunAheadAutoDisabled(false);
+static std::atomic<bool> gRunAheadReset(false);
+static std::atomic<bool> gRunAheadActive(false);
+static std::vector<uint8_t> gRunAheadState;
+static double gRunAheadWorkEma = 0.0;   // ns per frame spent in the core, run-ahead included
+static unsigned gRunAheadWarmup = 0;
+
+static std::atomic<uint64_t> gRunAheadFramesDone(0);
+static std::atomic<uint64_t> gRunAheadSerializeNsTotal(0);
+static std::atomic<uint64_t> gRunAheadSerializeNsMax(0);
+static std::atomic<uint64_t> gRunAheadUnserializeNsTotal(0);
+static std::atomic<uint64_t> gRunAheadUnserializeNsMax(0);
+static std::atomic<uint64_t> gRunAheadOverheadNsTotal(0);
+static std::atomic<uint64_t> gRunAheadWorkNs(0);
+static std::atomic<uint64_t> gRunAheadBudgetNs(0);
+
+// Second core instance for run-ahead: a private copy of the core library, so its globals are
+// separate. The primary then never rolls back, which keeps cores whose audio has side effects
+// (ring buffers not in the savestate, threaded audio) glitch-free.
+struct secondary_core {
+    void* handle = nullptr;
+    std::string path;                  // private copy, removed on destroy
+    retro_run_t run = nullptr;
+    retro_unserialize_t unserialize = nullptr;
+    retro_unload_game_t unload_game = nullptr;
+    retro_deinit_t deinit = nullptr;
+    retro_set_controller_port_device_t set_port_device = nullptr;
+    retro_frame_time_callback frame_time = {nullptr, 0};
+    bool failed = false;               // do not retry until settings change
+};
+static secondary_core gSecondary;                           // in use; emulation thread
+static thread_local secondary_core* gSecondaryCall = nullptr; // the instance inside a libretro call
+// The secondary is built on a worker thread and handed to the emulation thread between frames.
+enum { SECONDARY_IDLE, SECONDARY_BUILDING, SECONDARY_READY, SECONDARY_FAILED };
+static std::atomic<int> gSecondaryBuild(SECONDARY_IDLE);
+static secondary_core gSecondaryBuilt;                      // owned by the worker until READY
+static std::thread gSecondaryWorker;
+static std::mutex gDataDirLock;
+static std::string gDataDir;
+
+static std::atomic<uint64_t> gFramesRun(0);
+static std::atomic<uint64_t> gFramesVideoSkipped(0);
+static std::atomic<uint64_t> gAudioFramesDropped(0);
+
+// Single samples from audio_cb are gathered here and queued once per frame (or when full).
+static int16_t gSampleBatch[512 * 2];
+static size_t gSampleBatchFrames = 0;
+static int64_t gAudioNsThisFrame = 0;    // PERF_AUDIO_CB, recorded once per frame
+static std::atomic<double> gNominalFps(60.0);
+static std::atomic<int64_t> gSpeedStartNs(0);
+static std::atomic<uint64_t> gSpeedStartFrame(0);
+
+// Rewind: settings and requests come from the UI thread, the history itself is emulation thread only
+static std::atomic<bool> gRewindEnabled(false);
+static std::atomic<unsigned> gRewindInterval(1);
+static std::atomic<size_t> gRewindBudget(32u << 20);
+static std::atomic<bool> gRewindReset(true);
+static std::atomic<int> gRewindPending(0);
+static std::atomic<bool> gRewindHeld(false);
+static RewindBuffer gRewind;
+static std::vector<uint8_t> gStateScratch;
+static unsigned gFramesSinceCapture = 0;
+
+static std::atomic<uint64_t> gRewindCaptures(0);
+static std::atomic<uint64_t> gRewindSteps(0);
+static std::atomic<uint64_t> gRewindCaptureNsTotal(0);
+static std::atomic<uint64_t> gRewindCaptureNsMax(0);
+static std::atomic<uint64_t> gRewindDepth(0);
+static std::atomic<uint64_t> gRewindBytesUsed(0);
+static std::atomic<uint64_t> gRewindStateSize(0);
+
+// Savestates: slot requests come from the UI thread and are served between frames
+static std::mutex gPathLock;
+static std::string gSaveDir;
+static std::string gContentPath;
+static std::atomic<size_t> gStateSize(0);   // retro_serialize_size after load_game
+
+// Content handed to the core in memory; must outlive the game, so it is unmapped only after
+// retro_unload_game. UI thread, like load and unload.
+static ContentMapping gContent;
+static bool gGameLoaded = false;
+static std::string gGamePath;           // retro_game_info.path the core got (guarded by gPathLock)
+static std::atomic<bool> gContentInMemory(false);
+static std::atomic<bool> gContentFromArchive(false);
+static std::atomic<bool> gContentPrefetched(false);
+static std::atomic<uint64_t> gContentSize(0);
+static std::atomic<uint64_t> gContentMapNs(0);
+static std::atomic<uint64_t> gContentExtractNs(0);
+static std::atomic<uint64_t> gContentLoadNs(0);
+
+// Archive content: prefetch_content_internal extracts the likely entry on a worker thread while
+// the core is being loaded; load_game_internal takes it if it is the entry the core wants.
+// UI thread; the worker's results are read only after joining it.
+struct content_prefetch {
+    std::thread worker;
+    std::string path;        // archive
+    std::string entry;       // extracted entry
+    ContentMapping data;
+    bool ok = false;
+    uint64_t extract_ns = 0;
+};
+static content_prefetch gPrefetch;
+static const uint64_t kContentCacheMax = 1ull << 30;   // extracted files kept for need_fullpath cores
+static std::atomic<int> gSaveSlotPending(-1);
+static int gPixelFormat = RETRO_PIXEL_FORMAT_0RGB1555;
+
+// Last frame the core submitted, for savestate thumbnails. Emulation thread only.
+static const void* gLastFrameData = nullptr;
+static unsigned gLastFrameWidth = 0;
+static unsigned gLastFrameHeight = 0;
+static size_t gLastFramePitch = 0;
 
 // Forward callbacks
 static bool environment_cb(unsigned cmd, void* data);
@@ -90,53 +231,41 @@ static bool resolve_sym(void* handle, const char* name, T &out) {
         return false;
     }
     out = reinterpret_cast<T>(s);
-    LOGI("Resolved %s", name);
+    LOGD("Resolved %s", name);
     return true;
 }
 
-// Post frame to ANativeWindow
-static void post_frame_to_window(const void* data, unsigned width, unsigned height, size_t pitch) {
-    std::lock_guard<std::mutex> lk(gWindowMutex);
-    if (!gWindow || !data) return;
-
-    // set geometry to native size and RGBA_8888
-    ANativeWindow_setBuffersGeometry(gWindow, width, height, WINDOW_FORMAT_RGBA_8888);
-    ANativeWindow_Buffer buf;
-    if (ANativeWindow_lock(gWindow, &buf, nullptr) != 0) return;
-
-    if (gPixelFormat == RETRO_PIXEL_FORMAT_XRGB8888) {
-        // copy rows (assume 4 bytes/pixel)
-        for (unsigned y = 0; y < height; ++y) {
-            const void* src = (const uint8_t*)data + y * pitch;
-            void* dst = (uint8_t*)buf.bits + y * buf.stride * 4;
-            memcpy(dst, src, width * 4);
-        }
-    } else if (gPixelFormat == RETRO_PIXEL_FORMAT_RGB565) {
-        uint16_t* src = (uint16_t*)data;
-        uint32_t* dst = (uint32_t*)buf.bits;
-        for (unsigned y = 0; y < height; ++y) {
-            for (unsigned x = 0; x < width; ++x) {
-                uint16_t p = src[y * (pitch/2) + x];
-                uint8_t r = ((p >> 11) & 0x1F) << 3;
-                uint8_t g = ((p >> 5) & 0x3F) << 2;
-                uint8_t b = (p & 0x1F) << 3;
-                dst[y * buf.stride + x] = (0xFFu << 24) | (r << 16) | (g << 8) | b;
-            }
-        }
-    } else {
-        // fallback copy 32-bit
-        for (unsigned y = 0; y < height; ++y) {
-            const void* src = (const uint8_t*)data + y * pitch;
-            void* dst = (uint8_t*)buf.bits + y * buf.stride * 4;
-            memcpy(dst, src, width * 4);
-        }
+// Environment calls from the run-ahead secondary instance: anything that would reconfigure the
+// frontend is the primary's business. Returns false to fall through to the shared handling.
+static bool secondary_environment(unsigned cmd, void* data, bool* result) {
+    switch (cmd) {
+        case RETRO_ENVIRONMENT_SET_FRAME_TIME_CALLBACK:
+            if (data) gSecondaryCall->frame_time = *(const retro_frame_time_callback*)data;
+            *result = data != nullptr;
+            return true;
+        case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+            *result = data && *(int*)data == gPixelFormat;
+            return true;
+        case RETRO_ENVIRONMENT_SET_GEOMETRY:
+        case RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO:
+        case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
+            *result = true;
+            return true;
+        case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
+            // its counters would dangle once the copy is unloaded
+            if (data) core_perf_interface((retro_perf_callback*)data, false);
+            *result = data != nullptr;
+            return true;
+        default:
+            return false;
     }
-
-    ANativeWindow_unlockAndPost(gWindow);
 }
 
 // libretro callbacks
 static bool environment_cb(unsigned cmd, void* data) {
+    TRACE_SCOPE_ARG("environment", cmd);
+    bool result;
+    if (gSecondaryCall && secondary_environment(cmd, data, &result)) return result;
     switch (cmd) {
         case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
             if (!data) return false;
@@ -149,63 +278,841 @@ static bool environment_cb(unsigned cmd, void* data) {
             return true;
         case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
             if (!data) return false;
+            if (!pixel_convert_row(*(int*)data)) {
+                LOGE("env SET_PIXEL_FORMAT -> %d unsupported", *(int*)data);
+                return false;
+            }
             gPixelFormat = *(int*)data;
-            LOGI("env SET_PIXEL_FORMAT -> %d", gPixelFormat);
+            presenter_set_pixel_format(gPixelFormat);
+            LOGI("env SET_PIXEL_FORMAT -> %d", *(int*)data);
+            return true;
+        case RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER:
+            return presenter_get_software_framebuffer((retro_framebuffer*)data);
+        case RETRO_ENVIRONMENT_SET_GEOMETRY:
+            if (!data) return false;
+            gAvInfo.geometry = *(const retro_game_geometry*)data;
+            presenter_set_geometry(gAvInfo.geometry.base_width, gAvInfo.geometry.base_height, 0, 0);
+            return true;
+        case RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO:
+            if (!data) return false;
+            gAvInfo = *(const retro_system_av_info*)data;
+            LOGI("env SET_SYSTEM_AV_INFO -> %.3f fps, %.0f Hz", gAvInfo.timing.fps, gAvInfo.timing.sample_rate);
+            presenter_set_geometry(gAvInfo.geometry.base_width, gAvInfo.geometry.base_height,
+                                   gAvInfo.geometry.max_width, gAvInfo.geometry.max_height);
+            return true; // the emulation loop picks up the new rate before the next frame
+        case RETRO_ENVIRONMENT_SET_FRAME_TIME_CALLBACK:
+            if (!data) return false;
+            gFrameTime = *(const retro_frame_time_callback*)data;
+            LOGI("env SET_FRAME_TIME_CALLBACK -> reference %lld us", (long long)gFrameTime.reference);
             return true;
+        case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
+            if (!data) return false;
+            *(int*)data = (gPresentThisFrame ? RETRO_AV_ENABLE_VIDEO : 0) |
+                          (gAudioThisFrame ? RETRO_AV_ENABLE_AUDIO : 0);
+            return true;
+        case RETRO_ENVIRONMENT_GET_FASTFORWARDING:
+            if (!data) return false;
+            *(bool*)data = gFastForward.load(std::memory_order_relaxed);
+            return true;
+        case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
+            if (!data) return false;
+            input_set_controller_info((const retro_controller_info*)data);
+            return true;
+        case RETRO_ENVIRONMENT_GET_INPUT_BITMASKS:
+            return true; // RETRO_DEVICE_ID_JOYPAD_MASK is supported
+        case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+            if (!data) return false;
+            log_core_interface((retro_log_callback*)data);
+            return true;
+        case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
+            if (!data) return false;
+            core_perf_interface((retro_perf_callback*)data, true);
+            return true;
+
         default:
             return false;
     }
 }
 
 static void video_cb(const void* data, unsigned width, unsigned height, size_t pitch) {
-    post_frame_to_window(data, width, height, pitch);
+    // input first seen this frame, or by earlier frames that never reached the screen
+    const int64_t input_ns = input_take_snapshot_time();
+    if (input_ns && (!gFrameInputNs || input_ns < gFrameInputNs)) gFrameInputNs = input_ns;
+    if (data) {
+        gLastFrameData = data;
+        gLastFrameWidth = width;
+        gLastFrameHeight = height;
+        gLastFramePitch = pitch;
+    }
+    if (!gPresentThisFrame) {
+        // fast-forward and run-ahead: intermediate frames are never converted or presented
+        if (!gReplayFrame) gFramesVideoSkipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    {
+        PERF_SCOPE(PERF_VIDEO_CB);
+        presenter_submit_frame(data, width, height, pitch, gFrameInputNs);
+    }
+    if (data) gFrameInputNs = 0;
+}
+
+static void flush_sample_batch() {
+    if (!gSampleBatchFrames) return;
+    {
+        PERF_SUM(gAudioNsThisFrame);
+        audio_output_write(gSampleBatch, gSampleBatchFrames);
+    }
+    gSampleBatchFrames = 0;
 }
 
 static void audio_cb(int16_t left, int16_t right) {
-    (void)left; (void)right; // stub - audio handler not implemented here
+    if (!gAudioThisFrame) {
+        if (!gReplayFrame) gAudioFramesDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    gSampleBatch[gSampleBatchFrames * 2] = left;
+    gSampleBatch[gSampleBatchFrames * 2 + 1] = right;
+    if (++gSampleBatchFrames == sizeof(gSampleBatch) / sizeof(gSampleBatch[0]) / 2) flush_sample_batch();
 }
 
 static size_t audio_batch_cb(const int16_t* data, size_t frames) {
-    (void)data; (void)frames;
+    // fast-forward audio is dropped rather than queued behind real-time playback
+    if (!gAudioThisFrame) {
+        if (!gReplayFrame) gAudioFramesDropped.fetch_add(frames, std::memory_order_relaxed);
+        return frames;
+    }
+    flush_sample_batch(); // keep ordering with single samples
+    PERF_SUM(gAudioNsThisFrame);
+    audio_output_write(data, frames);
     return frames;
 }
 
 static void input_poll_cb(void) {
-    // no-op
+    PERF_SCOPE(PERF_INPUT_POLL);
+    input_poll();
 }
 
 static int16_t input_state_cb(unsigned port, unsigned device, unsigned index, unsigned id) {
-    std::lock_guard<std::mutex> lk(gInputLock);
-    if (id < gButtons.size()) return gButtons[id] ? 1 : 0;
-    return 0;
+    return input_state(port, device, index, id);
+}
+
+// Emulation thread (or while stopped): forward port device changes to the core.
+static void apply_port_devices() {
+    uint32_t pending = gPortDevicesPending.exchange(0);
+    if (!pending || !g_set_controller_port_device) return;
+    for (unsigned port = 0; port < INPUT_MAX_PORTS; ++port) {
+        if (!(pending & (1u << port))) continue;
+        unsigned device = input_port_device(port);
+        g_set_controller_port_device(port, device);
+        if (gSecondary.set_port_device) {
+            gSecondaryCall = &gSecondary;
+            gSecondary.set_port_device(port, device);
+            gSecondaryCall = nullptr;
+        }
+        LOGI("port %u -> device 0x%x", port, device);
+    }
+}
+
+static int64_t mono_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void reset_speed_window() {
+    gSpeedStartFrame.store(gFramesRun.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    gSpeedStartNs.store(mono_ns(), std::memory_order_relaxed);
+}
+
+// Make sure the rewind history matches the current settings and state size. Emulation thread.
+static bool rewind_ready() {
+    if (!gRewindEnabled.load(std::memory_order_relaxed) || !g_retro_serialize_size) return false;
+    size_t size = g_retro_serialize_size();
+    if (!size) return false;
+    size_t budget = gRewindBudget.load(std::memory_order_relaxed);
+    if (gRewindReset.exchange(false) || size != gRewind.state_size() || budget != gRewind.budget()) {
+        gRewind.configure(size, budget);
+        gStateScratch.assign(size, 0);
+        gFramesSinceCapture = 0;
+        gRewindStateSize.store(size, std::memory_order_relaxed);
+        LOGI("rewind: %zu byte states, %zu KB budget", size, budget >> 10);
+    }
+    return true;
+}
+
+// The primary core's retro_serialize / retro_unserialize, as the trace shows them.
+static bool core_serialize(void* data, size_t size) {
+    TRACE_SCOPE("retro_serialize");
+    return g_retro_serialize(data, size);
+}
+
+static bool core_unserialize(const void* data, size_t size) {
+    TRACE_SCOPE("retro_unserialize");
+    return g_retro_unserialize(data, size);
+}
+
+// Restore the previous captured state if a rewind step is due. Returns true if one was restored.
+static bool rewind_step() {
+    if (!gRewindHeld.load(std::memory_order_relaxed) && gRewindPending.load(std::memory_order_relaxed) <= 0) {
+        return false;
+    }
+    bool ok = gRewind.pop(gStateScratch.data()) && core_unserialize(gStateScratch.data(), gStateScratch.size());
+    if (ok) {
+        if (gRewindPending.fetch_sub(1, std::memory_order_relaxed) <= 0) gRewindPending.store(0);
+        gRewindSteps.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        gRewindPending.store(0); // history exhausted
+    }
+    gRewindDepth.store(gRewind.depth(), std::memory_order_relaxed);
+    gRewindBytesUsed.store(gRewind.bytes_used(), std::memory_order_relaxed);
+    return ok;
+}
+
+static void rewind_capture() {
+    if (++gFramesSinceCapture < gRewindInterval.load(std::memory_order_relaxed)) return;
+    gFramesSinceCapture = 0;
+    int64_t t0 = mono_ns();
+    if (!core_serialize(gStateScratch.data(), gStateScratch.size())) return;
+    gRewind.push(gStateScratch.data());
+    uint64_t ns = (uint64_t)(mono_ns() - t0);
+    gRewindCaptures.fetch_add(1, std::memory_order_relaxed);
+    gRewindCaptureNsTotal.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > gRewindCaptureNsMax.load(std::memory_order_relaxed)) gRewindCaptureNsMax.store(ns, std::memory_order_relaxed);
+    gRewindDepth.store(gRewind.depth(), std::memory_order_relaxed);
+    gRewindBytesUsed.store(gRewind.bytes_used(), std::memory_order_relaxed);
+}
+
+static std::string state_path(int slot) {
+    std::lock_guard<std::mutex> lk(gPathLock);
+    std::string dir = gSaveDir;
+    std::string name = gContentPath;
+    size_t slash = name.rfind('/');
+    if (dir.empty()) dir = slash == std::string::npos ? "." : name.substr(0, slash);
+    if (slash != std::string::npos) name = name.substr(slash + 1);
+    size_t dot = name.rfind('.');
+    if (dot != std::string::npos && dot > 0) name.resize(dot);
+    if (name.empty()) name = "content";
+    return dir + "/" + name + ".state" + std::to_string(slot);
+}
+
+// Serialize into a pooled buffer and hand it to the savestate worker. Emulation thread (or any
+// thread while it is stopped); this is the only part of a save that runs synchronously.
+static bool save_state_now(int slot) {
+    size_t size = g_retro_serialize_size ? g_retro_serialize_size() : 0;
+    if (!size) return false;
+    int64_t t0 = mono_ns();
+    savestate_buffer* buf = savestate_begin_save(size);
+    if (!buf) return false;
+    if (!core_serialize(buf->state.data(), size)) {
+        LOGE("retro_serialize failed");
+        savestate_release(buf);
+        return false;
+    }
+    savestate_attach_frame(buf, gLastFrameData, gLastFrameWidth, gLastFrameHeight, gLastFramePitch, gPixelFormat);
+    savestate_commit_save(buf, state_path(slot).c_str(), mono_ns() - t0);
+    return true;
+}
+
+static bool unserialize_loaded(savestate_buffer* buf) {
+    int64_t t0 = mono_ns();
+    bool ok = core_unserialize(buf->state.data(), buf->state_size);
+    savestate_note_unserialize(ok, mono_ns() - t0);
+    if (!ok) LOGE("retro_unserialize failed");
+    return ok;
+}
+
+// Serve savestate requests at a frame boundary.
+static void service_savestates() {
+    int slot = gSaveSlotPending.exchange(-1, std::memory_order_relaxed);
+    if (slot >= 0) save_state_now(slot);
+    if (savestate_buffer* loaded = savestate_poll_loaded()) {
+        unserialize_loaded(loaded);
+        savestate_release(loaded);
+    }
+}
+
+// ---------------------------
+// Run-ahead
+// ---------------------------
+//
+// Each frame the real frame runs with its video hidden, then the state is saved and the core
+// runs `ahead` more frames with the same input, audio muted, presenting only the last one; the
+// saved state is then restored. What the player sees is `ahead` frames into the future, which
+// hides that many frames of the game's own input lag. With the second instance the replays run on
+// a separate copy of the core that receives the saved state, and the primary never rolls back.
+
+static void store_max(std::atomic<uint64_t>& a, uint64_t v) {
+    if (v > a.load(std::memory_order_relaxed)) a.store(v, std::memory_order_relaxed);
+}
+
+static std::string data_dir() {
+    std::lock_guard<std::mutex> lk(gDataDirLock);
+    if (!gDataDir.empty()) return gDataDir;
+    const char* tmp = getenv("TMPDIR");
+    return tmp && *tmp ? tmp : "/tmp";
+}
+
+static bool copy_file(const std::string& src, const std::string& dst) {
+    int in = open(src.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return false;
+    int out = open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0700);
+    if (out < 0) {
+        close(in);
+        return false;
+    }
+    std::vector<char> buf(1 << 16);
+    bool ok = true;
+    ssize_t n;
+    while (ok && (n = read(in, buf.data(), buf.size())) > 0) ok = write(out, buf.data(), (size_t)n) == n;
+    if (n < 0) ok = false;
+    close(in);
+    return close(out) == 0 && ok;
+}
+
+static uint64_t fnv1a(uint64_t h, const void* data, size_t n) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < n; ++i) h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+}
+
+static bool extract_entry(ZipArchive& zip, const zip_entry& e, ContentMapping* out) {
+    void* dst = out->allocate((size_t)e.size);
+    if (!dst || !zip.extract(e, dst)) {
+        out->unmap();
+        return false;
+    }
+    out->seal();
+    return true;
+}
+
+static bool write_all(int fd, const void* data, size_t n) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w <= 0) return false;
+        p += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+// Keep the extraction cache under kContentCacheMax, dropping the least recently used files.
+static void trim_content_cache(const std::string& dir, const std::string& keep) {
+    struct cached { std::string path; uint64_t size; time_t used; };
+    std::vector<cached> files;
+    uint64_t total = 0;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* ent = readdir(d)) {
+            if (ent->d_name[0] == '.') continue;
+            std::string path = dir + "/" + ent->d_name;
+            struct stat st;
+            if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+            files.push_back({path, (uint64_t)st.st_size, st.st_mtime});
+            total += (uint64_t)st.st_size;
+        }
+        closedir(d);
+    }
+    std::sort(files.begin(), files.end(), [](const cached& a, const cached& b) { return a.used < b.used; });
+    for (const cached& f : files) {
+        if (total <= kContentCacheMax) break;
+        if (f.path == keep) continue;
+        if (unlink(f.path.c_str()) == 0) total -= f.size;
+    }
+}
+
+// Extracted copies of entries for cores that insist on a path, keyed by the archive's identity
+// (path, size, mtime) and the entry (name, CRC), so an unchanged archive is extracted only once.
+static std::string cache_path(const char* archive, const zip_entry& e) {
+    struct stat st;
+    if (stat(archive, &st) != 0) return std::string();
+    uint64_t key = 1469598103934665603ull;
+    key = fnv1a(key, archive, strlen(archive));
+    key = fnv1a(key, &st.st_size, sizeof(st.st_size));
+    key = fnv1a(key, &st.st_mtime, sizeof(st.st_mtime));
+    key = fnv1a(key, e.name.data(), e.name.size());
+    key = fnv1a(key, &e.crc32, sizeof(e.crc32));
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)key);
+    const size_t slash = e.name.rfind('/');
+    return data_dir() + "/content_cache/" + hex + "_" + e.name.substr(slash == std::string::npos ? 0 : slash + 1);
+}
+
+static bool cache_valid(const std::string& path, const zip_entry& e) {
+    struct stat st;
+    return !path.empty() && stat(path.c_str(), &st) == 0 && (uint64_t)st.st_size == e.size;
+}
+
+// Write the entry to its cache path. prefetched: the entry already in memory, or nullptr to
+// stream it from the archive.
+static bool cache_write(ZipArchive& zip, const zip_entry& e, const std::string& path,
+                        const ContentMapping* prefetched) {
+    const std::string dir = path.substr(0, path.rfind('/'));
+    mkdir(dir.c_str(), 0700);
+    const std::string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+    bool ok = prefetched ? write_all(fd, prefetched->data(), prefetched->size()) : zip.extract_to_fd(e, fd);
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    trim_content_cache(dir, path);
+    return true;
+}
+
+static void prefetch_join() {
+    if (gPrefetch.worker.joinable()) gPrefetch.worker.join();
+}
+
+// Whether a "sfc|smc"-style valid_extensions list names ext, as a whole entry, ignoring case.
+static bool extension_listed(const char* valid_extensions, const char* ext) {
+    if (!valid_extensions) return false;
+    const size_t n = strlen(ext);
+    for (const char* p = valid_extensions;; ++p) {
+        const char* end = strchr(p, '|');
+        const size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len == n && strncasecmp(p, ext, n) == 0) return true;
+        if (!end) return false;
+        p = end;
+    }
+}
+
+// Path to hand the core for archive content, with gContent filled when the entry goes in
+// memory. Returns the archive path unchanged when it cannot be opened.
+static std::string prepare_archive(const char* rompath, const retro_system_info& si) {
+    ZipArchive zip;
+    const int64_t t0 = mono_ns();
+    if (!zip.open(rompath)) return rompath;
+    const int i = zip.pick(si.valid_extensions);
+    if (i < 0) return rompath;
+    const zip_entry& e = zip.entries()[i];
+
+    const int64_t t_wait = mono_ns();
+    prefetch_join();
+    const bool prefetched = gPrefetch.ok && gPrefetch.path == rompath && gPrefetch.entry == e.name;
+    const std::string cached = cache_path(rompath, e);
+    const bool in_cache = cache_valid(cached, e);
+    std::string path;
+    if (!si.need_fullpath) {
+        // an earlier extraction for a path-only core maps for free
+        if (prefetched) gContent.swap(gPrefetch.data);
+        else if (in_cache) gContent.map(cached.c_str());
+        if (gContent.mapped() || extract_entry(zip, e, &gContent)) path = std::string(rompath) + "#" + e.name;
+    } else if (in_cache) {
+        utimensat(AT_FDCWD, cached.c_str(), nullptr, 0); // most recently used
+        path = cached;
+    } else if (cache_write(zip, e, cached, prefetched ? &gPrefetch.data : nullptr)) {
+        path = cached;
+    }
+    gPrefetch.data.unmap();
+    // only the part the core load did not hide counts when prefetched
+    gContentExtractNs.store((uint64_t)(mono_ns() - (prefetched ? t_wait : t0)));
+    gContentPrefetched.store(prefetched);
+    if (path.empty()) {
+        LOGE("%s: cannot extract %s", rompath, e.name.c_str());
+        return rompath;
+    }
+    gContentFromArchive.store(true);
+    LOGI("%s: %s (%llu bytes) %s%s", rompath, e.name.c_str(), (unsigned long long)e.size,
+         si.need_fullpath ? "extracted to " : "in memory", si.need_fullpath ? path.c_str() : "");
+    return path;
+}
+
+static void run_primary(retro_usec_t usec) {
+    TRACE_SCOPE("retro_run");
+    if (gFrameTime.callback) gFrameTime.callback(usec);
+    g_retro_run();
+}
+
+static void secondary_unload(secondary_core* c) {
+    if (c->handle) {
+        gSecondaryCall = c;
+        if (c->unload_game) c->unload_game();
+        if (c->deinit) c->deinit();
+        gSecondaryCall = nullptr;
+        dlclose(c->handle);
+        LOGI("run-ahead: secondary instance unloaded");
+    }
+    if (!c->path.empty()) unlink(c->path.c_str());
+    *c = secondary_core();
+}
+
+// Emulation thread, or while it is stopped. Waits for a build in progress.
+static void secondary_destroy() {
+    if (gSecondaryWorker.joinable()) gSecondaryWorker.join();
+    secondary_unload(&gSecondaryBuilt);
+    gSecondaryBuild.store(SECONDARY_IDLE);
+    secondary_unload(&gSecondary);
+}
+
+// Copies from dead processes: each run makes its own, and one that crashed never removed it.
+static void remove_stale_secondaries() {
+    const std::string dir = data_dir();
+    DIR* d = opendir(dir.c_str());
+    if (!d) return;
+    static const char kPrefix[] = "saasemu_runahead_";
+    while (dirent* de = readdir(d)) {
+        if (strncmp(de->d_name, kPrefix, sizeof(kPrefix) - 1) != 0) continue;
+        const long pid = strtol(de->d_name + sizeof(kPrefix) - 1, nullptr, 10);
+        if (pid == (long)getpid()) continue;
+        if (pid > 0 && (kill((pid_t)pid, 0) == 0 || errno != ESRCH)) continue;   // still running
+        if (unlink((dir + "/" + de->d_name).c_str()) == 0) LOGI("run-ahead: removed stale %s", de->d_name);
+    }
+    closedir(d);
+}
+
+// dlopen of the same path would return the primary's handle, so load a private copy.
+// Worker thread: the copy, dlopen, retro_init and retro_load_game take far longer than a frame.
+// content is read-only and stays mapped until secondary_destroy has joined this thread.
+static bool secondary_create(secondary_core* out, const std::string& core_path, const std::string& game_path,
+                             const void* content, size_t content_size) {
+    if (core_path.empty() || game_path.empty()) return false;
+    out->path = data_dir() + "/saasemu_runahead_" + std::to_string(getpid()) + ".so";
+    if (!copy_file(core_path, out->path)) {
+        LOGE("run-ahead: cannot copy core to %s", out->path.c_str());
+        secondary_unload(out);
+        return false;
+    }
+    void* h = dlopen(out->path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!h) {
+        LOGE("run-ahead: dlopen of the secondary failed: %s", dlerror());
+        secondary_unload(out);
+        return false;
+    }
+    out->handle = h;
+
+    retro_set_environment_t set_environment = nullptr;
+    retro_set_video_refresh_t set_video = nullptr;
+    retro_set_audio_sample_t set_audio = nullptr;
+    retro_set_audio_sample_batch_t set_audio_batch = nullptr;
+    retro_set_input_poll_t set_poll = nullptr;
+    retro_set_input_state_t set_input_state = nullptr;
+    retro_init_t init = nullptr;
+    retro_load_game_t load_game = nullptr;
+    retro_unload_game_t unload_game = nullptr;
+    retro_deinit_t deinit = nullptr;
+    bool ok = true;
+    ok &= resolve_sym(h, "retro_set_environment", set_environment);
+    ok &= resolve_sym(h, "retro_set_video_refresh", set_video);
+    ok &= resolve_sym(h, "retro_set_audio_sample", set_audio);
+    ok &= resolve_sym(h, "retro_set_audio_sample_batch", set_audio_batch);
+    ok &= resolve_sym(h, "retro_set_input_poll", set_poll);
+    ok &= resolve_sym(h, "retro_set_input_state", set_input_state);
+    ok &= resolve_sym(h, "retro_init", init);
+    ok &= resolve_sym(h, "retro_deinit", deinit);
+    ok &= resolve_sym(h, "retro_load_game", load_game);
+    ok &= resolve_sym(h, "retro_unload_game", unload_game);
+    ok &= resolve_sym(h, "retro_run", out->run);
+    ok &= resolve_sym(h, "retro_unserialize", out->unserialize);
+    if (!ok) {
+        secondary_unload(out);
+        return false;
+    }
+    resolve_sym(h, "retro_set_controller_port_device", out->set_port_device);
+
+    gSecondaryCall = out;
+    set_environment(environment_cb);
+    set_video(video_cb);
+    set_audio(audio_cb);
+    set_audio_batch(audio_batch_cb);
+    set_poll(input_poll_cb);
+    set_input_state(input_state_cb);
+    init();
+    out->deinit = deinit;
+    retro_game_info gi;
+    memset(&gi, 0, sizeof(gi));
+    gi.path = game_path.c_str();
+    gi.data = content;   // read-only, so both instances can share the mapping
+    gi.size = content_size;
+    bool loaded = load_game(&gi);
+    gSecondaryCall = nullptr;
+    if (!loaded) {
+        LOGE("run-ahead: secondary instance failed to load %s", game_path.c_str());
+        secondary_unload(out);
+        return false;
+    }
+    out->unload_game = unload_game;
+    LOGI("run-ahead: secondary instance loaded from %s", out->path.c_str());
+    return true;
+}
+
+// Emulation thread: start building the secondary, or take it over once built. True when it is
+// ready to use this frame.
+static bool secondary_poll() {
+    switch (gSecondaryBuild.load(std::memory_order_acquire)) {
+        case SECONDARY_IDLE: {
+            if (gSecondary.failed) return false;
+            if (gSecondaryWorker.joinable()) gSecondaryWorker.join();
+            std::string game_path;
+            {
+                std::lock_guard<std::mutex> lk(gPathLock);
+                game_path = gGamePath;
+            }
+            gSecondaryBuild.store(SECONDARY_BUILDING);
+            gSecondaryWorker = std::thread([core_path = gCorePath, game_path, content = gContent.data(),
+                                            size = gContent.size()] {
+                trace_set_thread_name("saasemu-runahead");
+                const bool ok = secondary_create(&gSecondaryBuilt, core_path, game_path, content, size);
+                gSecondaryBuild.store(ok ? SECONDARY_READY : SECONDARY_FAILED, std::memory_order_release);
+            });
+            return false;
+        }
+        case SECONDARY_READY:
+            gSecondaryWorker.join();
+            gSecondary = std::move(gSecondaryBuilt);
+            gSecondaryBuilt = secondary_core();
+            gSecondaryBuild.store(SECONDARY_IDLE);
+            if (gSecondary.set_port_device) {
+                gSecondaryCall = &gSecondary;
+                for (unsigned port = 0; port < INPUT_MAX_PORTS; ++port) {
+                    gSecondary.set_port_device(port, input_port_device(port));
+                }
+                gSecondaryCall = nullptr;
+            }
+            return true;
+        case SECONDARY_FAILED:
+            gSecondaryWorker.join();
+            gSecondaryBuild.store(SECONDARY_IDLE);
+            gSecondary.failed = true;
+            return false;
+        default:
+            return false;   // still building: run without run-ahead meanwhile
+    }
+}
+
+static void run_ahead_disable(const char* why) {
+    gRunAheadAutoDisabled.store(true);
+    LOGE("run-ahead disabled: %s", why);
+}
+
+// Frames to run ahead this frame (0: run normally). Emulation thread.
+static unsigned run_ahead_frames(bool ff, bool rewinding) {
+    if (gRunAheadReset.exchange(false)) {
+        gRunAheadWorkEma = 0.0;
+        gRunAheadWarmup = 0;
+        gSecondary.failed = false;   // new settings or content: worth another try
+    }
+    const unsigned ahead = gRunAheadFrames.load(std::memory_order_relaxed);
+    if (!ahead || !g_retro_serialize_size || gRunAheadAutoDisabled.load(std::memory_order_relaxed)) return 0;
+    if (ff || rewinding) return 0; // nothing to hide: input is not being responded to in real time
+    if (gRunAheadSecondary.load(std::memory_order_relaxed)) {
+        if (!gSecondary.handle && !secondary_poll()) return 0;
+    }
+    return ahead;
+}
+
+// budget_ns: the frame period when paced, 0 when running unpaced.
+static void run_ahead_frame(unsigned ahead, retro_usec_t usec, int64_t budget_ns) {
+    const bool present = gPresentThisFrame;
+    const bool audio = gAudioThisFrame;
+    const bool secondary = gSecondary.handle != nullptr;
+    gReplayFrame = true;
+
+    // the real frame: advances the emulated state and plays its audio, but shows nothing
+    const int64_t t0 = mono_ns();
+    gPresentThisFrame = false;
+    run_primary(usec);
+    flush_sample_batch();
+    const int64_t t_real = mono_ns();
+
+    const size_t size = g_retro_serialize_size();
+    if (gRunAheadState.size() != size) gRunAheadState.assign(size, 0);
+    bool ok = size && core_serialize(gRunAheadState.data(), size);
+    const int64_t t_saved = mono_ns();
+    int64_t unserialize_ns = 0;
+    if (ok && secondary) {
+        TRACE_SCOPE("retro_unserialize_secondary");
+        gSecondaryCall = &gSecondary;
+        ok = gSecondary.unserialize(gRunAheadState.data(), size);
+        gSecondaryCall = nullptr;
+        unserialize_ns = mono_ns() - t_saved;
+    }
+
+    if (ok) {
+        input_hold(true);
+        gAudioThisFrame = false;
+        for (unsigned k = 1; k <= ahead; ++k) {
+            gPresentThisFrame = present && k == ahead;
+            if (secondary) {
+                TRACE_SCOPE("retro_run_secondary");
+                gSecondaryCall = &gSecondary;
+                if (gSecondary.frame_time.callback) gSecondary.frame_time.callback(usec);
+                gSecondary.run();
+                gSecondaryCall = nullptr;
+            } else {
+                run_primary(usec);
+            }
+        }
+        input_hold(false);
+        if (!secondary) {
+            const int64_t t_load = mono_ns();
+            ok = core_unserialize(gRunAheadState.data(), size);
+            unserialize_ns = mono_ns() - t_load;
+        }
+    }
+    gReplayFrame = false;
+    gPresentThisFrame = present;
+    gAudioThisFrame = audio;
+    if (!ok) {
+        run_ahead_disable("the core failed to save or restore its state");
+        return;
+    }
+
+    const int64_t work = mono_ns() - t0;
+    gRunAheadFramesDone.fetch_add(1, std::memory_order_relaxed);
+    gRunAheadSerializeNsTotal.fetch_add((uint64_t)(t_saved - t_real), std::memory_order_relaxed);
+    store_max(gRunAheadSerializeNsMax, (uint64_t)(t_saved - t_real));
+    gRunAheadUnserializeNsTotal.fetch_add((uint64_t)unserialize_ns, std::memory_order_relaxed);
+    store_max(gRunAheadUnserializeNsMax, (uint64_t)unserialize_ns);
+    gRunAheadOverheadNsTotal.fetch_add((uint64_t)(work - (t_real - t0)), std::memory_order_relaxed);
+
+    // Switch off when the whole cycle no longer fits in a frame: run-ahead that makes the game
+    // drop frames adds more latency than it removes.
+    gRunAheadWorkEma = gRunAheadWorkEma > 0 ? gRunAheadWorkEma + (work - gRunAheadWorkEma) / 16 : work;
+    gRunAheadWorkNs.store((uint64_t)gRunAheadWorkEma, std::memory_order_relaxed);
+    gRunAheadBudgetNs.store((uint64_t)budget_ns, std::memory_order_relaxed);
+    if (budget_ns && ++gRunAheadWarmup > 30 && gRunAheadWorkEma > 0.9 * budget_ns) {
+        char why[96];
+        snprintf(why, sizeof(why), "%.2f ms of core time per %.2f ms frame", gRunAheadWorkEma / 1e6,
+                 budget_ns / 1e6);
+        run_ahead_disable(why);
+    }
 }
 
 // Emulation thread
 static void emu_thread_main() {
+    trace_set_thread_name("saasemu-emu");
+    thread_placement_apply(THREAD_ROLE_EMU);
     LOGI("Emu thread started");
+    double nominal_fps = gAvInfo.timing.fps > 0 ? gAvInfo.timing.fps : 60.0;
+    pacer_reset(nominal_fps);
+    double paced_fps = nominal_fps;
+    bool ff_applied = false;
+    float ratio_applied = 1.0f;
+    int64_t last_present = 0;
+    int64_t last_frame_start = 0;
+    unsigned audio_rate = (unsigned)(gAvInfo.timing.sample_rate + 0.5);
+    gNominalFps.store(nominal_fps, std::memory_order_relaxed);
+    reset_speed_window();
+
     while (gRunning.load()) {
-        if (g_retro_run) {
-            g_retro_run();
-        } else {
-            break;
+        if (!g_retro_run) break;
+
+        const bool ff = gFastForward.load(std::memory_order_relaxed);
+        const float ratio = ff ? gFastForwardRatio.load(std::memory_order_relaxed) : 1.0f;
+        if (gAvInfo.timing.fps > 0) nominal_fps = gAvInfo.timing.fps;
+        const double fps = ratio > 0 ? nominal_fps * ratio : nominal_fps;
+        const unsigned rate = (unsigned)(gAvInfo.timing.sample_rate + 0.5);
+        if (rate && rate != audio_rate) {
+            audio_output_start(rate); // SET_SYSTEM_AV_INFO changed the sample rate
+            audio_rate = rate;
+        }
+        if (fps != paced_fps || ff != ff_applied || ratio != ratio_applied) {
+            pacer_set_fps(fps);
+            gNominalFps.store(nominal_fps, std::memory_order_relaxed);
+            if (ff != ff_applied || ratio != ratio_applied) reset_speed_window();
+            paced_fps = fps;
+            ff_applied = ff;
+            ratio_applied = ratio;
+        }
+        pacer_set_enabled(gPacing.load(std::memory_order_relaxed) && ratio > 0);
+
+        const int64_t wait_start = perf_now_ns();
+        int64_t delta_ns;
+        {
+            TRACE_SCOPE("pacer_wait");
+            delta_ns = pacer_wait();
+        }
+        const int64_t frame_start = perf_now_ns();
+        perf_record(PERF_PACER_WAIT, frame_start - wait_start);
+        if (last_frame_start) perf_record(PERF_FRAME_INTERVAL, frame_start - last_frame_start);
+        last_frame_start = frame_start;
+        thread_placement_sample(THREAD_ROLE_EMU);
+        if (g_retro_serialize_size) service_savestates();
+
+        // Rewinding restores one captured state per frame and runs it, so it plays back at the
+        // frame rate (interval frames per step), with audio muted.
+        const bool can_rewind = rewind_ready();
+        const bool rewinding = can_rewind && rewind_step();
+
+        // In fast-forward several retro_run calls share one presented frame: only the first frame
+        // after a display period has elapsed reaches the presenter, and audio is dropped.
+        const int64_t now = mono_ns();
+        gPresentThisFrame = !ff || now - last_present >= (int64_t)(0.9e9 / nominal_fps);
+        if (gPresentThisFrame) last_present = now;
+        gAudioThisFrame = !ff && !rewinding;
+
+        // unpaced and fast-forwarded frames report the nominal delta so game time advances per frame
+        const retro_usec_t usec = (delta_ns && pacer_enabled() && !ff) ? delta_ns / 1000 : gFrameTime.reference;
+        const unsigned ahead = run_ahead_frames(ff, rewinding);
+        gRunAheadActive.store(ahead != 0, std::memory_order_relaxed);
+        apply_port_devices();
+        input_begin_frame();
+        {
+            PERF_SCOPE(PERF_RUN);
+            if (ahead) run_ahead_frame(ahead, usec, pacer_enabled() ? (int64_t)(1e9 / fps) : 0);
+            else run_primary(usec);
         }
+        flush_sample_batch();
+        if (gAudioThisFrame) perf_record(PERF_AUDIO_CB, gAudioNsThisFrame);
+        gAudioNsThisFrame = 0;
+        gFramesRun.fetch_add(1, std::memory_order_relaxed);
+        if (can_rewind && !rewinding) rewind_capture();
     }
+    gPresentThisFrame = true;
+    gAudioThisFrame = true;
+    gRunAheadActive.store(false);
     LOGI("Emu thread stopped");
 }
 
+// After dlclose: nothing may call into the unmapped library.
+static void clear_core_symbols() {
+    g_set_environment = nullptr;
+    g_set_video = nullptr;
+    g_set_audio = nullptr;
+    g_set_audio_batch = nullptr;
+    g_set_poll = nullptr;
+    g_set_input_state = nullptr;
+    g_set_controller_port_device = nullptr;
+    g_retro_init = nullptr;
+    g_retro_deinit = nullptr;
+    g_retro_load_game = nullptr;
+    g_retro_unload_game = nullptr;
+    g_retro_run = nullptr;
+    g_retro_api_version = nullptr;
+    g_retro_get_system_info = nullptr;
+    g_retro_get_system_av_info = nullptr;
+    g_retro_serialize_size = nullptr;
+    g_retro_serialize = nullptr;
+    g_retro_unserialize = nullptr;
+}
+
 // Public API for native_bridge.cpp
 extern "C" {
 
 // Load core .so and resolve symbols, register callbacks, call retro_init
 bool load_core_internal(const char* path) {
     if (!path) return false;
+    stop_emulation_internal(); // retro_run must not be inside the core being unloaded
+    secondary_destroy();
+    remove_stale_secondaries();
+    gPixelFormat = RETRO_PIXEL_FORMAT_0RGB1555; // until the new core sets one
+    presenter_set_pixel_format(gPixelFormat);
+    memset(&gFrameTime, 0, sizeof(gFrameTime));
     if (gCoreHandle) {
         // unload first
-        if (g_retro_unload_game) g_retro_unload_game();
+        if (gGameLoaded && g_retro_unload_game) g_retro_unload_game();
         if (g_retro_deinit) g_retro_deinit();
+        core_perf_unload(gCorePath.c_str());
         dlclose(gCoreHandle);
         gCoreHandle = nullptr;
+        clear_core_symbols();
     }
+    gContent.unmap();
+    gGameLoaded = false;
+
+    pixel_convert_init();
+    LOGI("pixel conversion: %s", pixel_isa_name(pixel_convert_selected_isa()));
 
     LOGI("dlopen core: %s", path);
     void* h = dlopen(path, RTLD_NOW | RTLD_LOCAL);
@@ -214,6 +1121,8 @@ bool load_core_internal(const char* path) {
         return false;
     }
     gCoreHandle = h;
+    gCorePath = path;
+    core_perf_reset();
 
     bool ok = true;
     ok &= resolve_sym(h, "retro_api_version", g_retro_api_version);
@@ -228,11 +1137,28 @@ bool load_core_internal(const char* path) {
     ok &= resolve_sym(h, "retro_load_game", g_retro_load_game);
     ok &= resolve_sym(h, "retro_unload_game", g_retro_unload_game);
     ok &= resolve_sym(h, "retro_run", g_retro_run);
+    ok &= resolve_sym(h, "retro_get_system_av_info", g_retro_get_system_av_info);
+    // optional here: without it content is passed by path, as the core then has to expect
+    if (!resolve_sym(h, "retro_get_system_info", g_retro_get_system_info)) g_retro_get_system_info = nullptr;
+
+    // optional: without savestate support rewind stays unavailable
+    if (!resolve_sym(h, "retro_serialize_size", g_retro_serialize_size) ||
+        !resolve_sym(h, "retro_serialize", g_retro_serialize) ||
+        !resolve_sym(h, "retro_unserialize", g_retro_unserialize)) {
+        g_retro_serialize_size = nullptr;
+        g_retro_serialize = nullptr;
+        g_retro_unserialize = nullptr;
+    }
+    // optional: cores with a single fixed controller type often omit it
+    if (!resolve_sym(h, "retro_set_controller_port_device", g_set_controller_port_device)) {
+        g_set_controller_port_device = nullptr;
+    }
 
     if (!ok) {
         LOGE("Failed to resolve required libretro symbols");
         dlclose(h);
         gCoreHandle = nullptr;
+        clear_core_symbols();
         return false;
     }
 
@@ -245,43 +1171,118 @@ bool load_core_internal(const char* path) {
     if (g_set_input_state) g_set_input_state(input_state_cb);
 
     if (g_retro_init) g_retro_init();
+    savestate_start();
 
     LOGI("Core initialized");
     return true;
 }
 
 bool unload_core_internal() {
-    // stop emulation thread if running
-    if (gRunning.load()) {
-        gRunning.store(false);
-        if (gEmuThread.joinable()) gEmuThread.join();
-    }
-    if (g_retro_unload_game) g_retro_unload_game();
-    if (g_retro_deinit) g_retro_deinit();
+    stop_emulation_internal();
+    savestate_stop(); // let queued saves reach the disk
+    secondary_destroy();
     if (gCoreHandle) {
+        if (gGameLoaded && g_retro_unload_game) g_retro_unload_game();
+        if (g_retro_deinit) g_retro_deinit();
+        core_perf_unload(gCorePath.c_str());
         dlclose(gCoreHandle);
         gCoreHandle = nullptr;
+        clear_core_symbols();
     }
+    gContent.unmap();
+    gGameLoaded = false;
+    prefetch_join();
+    gPrefetch.data.unmap();
+    gCorePath.clear();
+    memset(&gFrameTime, 0, sizeof(gFrameTime));
+    input_unload();
+    gPortDevicesPending.store(0);
     return true;
 }
 
 bool load_game_internal(const char* rompath) {
     if (!gCoreHandle || !g_retro_load_game) return false;
+    stop_emulation_internal(); // the emulation thread must not run the game being unloaded
+    // the previous game, and the secondary instance, may still point into the old mapping
+    secondary_destroy();
+    if (gGameLoaded && g_retro_unload_game) g_retro_unload_game();
+    gGameLoaded = false;
+    gContent.unmap();
+
+    retro_system_info si;
+    memset(&si, 0, sizeof(si));
+    si.need_fullpath = true;
+    if (g_retro_get_system_info) g_retro_get_system_info(&si);
+
+    const int64_t t0 = mono_ns();
+    std::string game_path = rompath ? rompath : "";
+    gContentFromArchive.store(false);
+    gContentPrefetched.store(false);
+    gContentExtractNs.store(0);
+    const bool core_reads_zip = extension_listed(si.valid_extensions, "zip");
+    if (rompath && archive_is_zip(rompath) && !core_reads_zip) {
+        game_path = prepare_archive(rompath, si);
+    } else if (rompath && archive_is_7z(rompath)) {
+        LOGE("%s: 7z archives are not supported, passing it to the core as is", rompath);
+    } else if (!si.need_fullpath && rompath && !gContent.map(rompath)) {
+        LOGI("%s cannot be mapped; passing the path only", rompath);
+    }
+    prefetch_join();
+    gPrefetch.data.unmap();
+    const int64_t t_mapped = mono_ns();
+
     retro_game_info gi;
     memset(&gi, 0, sizeof(gi));
-    gi.path = rompath;
-    gi.data = nullptr;
-    gi.size = 0;
+    gi.path = rompath ? game_path.c_str() : nullptr;
+    gi.data = gContent.data();
+    gi.size = gContent.size();
     gi.meta = nullptr;
+    presenter_begin_session();
+    gRewindReset.store(true);
+    gRunAheadReset.store(true); // the secondary instance has to load the new content
+    input_reset();
+    gFrameInputNs = 0;
     bool ok = g_retro_load_game(&gi);
-    LOGI("retro_load_game -> %d", ok ? 1 : 0);
-    return ok;
+    const int64_t t_loaded = mono_ns();
+    LOGI("retro_load_game -> %d (%s, %zu bytes, %.2f ms)", ok ? 1 : 0,
+         gContent.mapped() ? "mapped" : "by path", gContent.size(), (t_loaded - t0) / 1e6);
+    gContentInMemory.store(gContent.mapped());
+    gContentSize.store(gContent.size());
+    gContentMapNs.store((uint64_t)(t_mapped - t0));
+    gContentLoadNs.store((uint64_t)(t_loaded - t0));
+    if (!ok) {
+        gContent.unmap();
+        return false;
+    }
+    gGameLoaded = true;
+    {
+        std::lock_guard<std::mutex> lk(gPathLock);
+        gContentPath = rompath ? rompath : "";   // savestates are named after the archive
+        gGamePath = game_path;
+    }
+    gStateSize.store(g_retro_serialize_size ? g_retro_serialize_size() : 0);
+    gLastFrameData = nullptr;
+
+    // timing and geometry are only valid once a game is loaded
+    memset(&gAvInfo, 0, sizeof(gAvInfo));
+    g_retro_get_system_av_info(&gAvInfo);
+    LOGI("av info: %ux%u (max %ux%u), %.3f fps, %.0f Hz",
+         gAvInfo.geometry.base_width, gAvInfo.geometry.base_height,
+         gAvInfo.geometry.max_width, gAvInfo.geometry.max_height,
+         gAvInfo.timing.fps, gAvInfo.timing.sample_rate);
+    presenter_set_geometry(gAvInfo.geometry.base_width, gAvInfo.geometry.base_height,
+                           gAvInfo.geometry.max_width, gAvInfo.geometry.max_height);
+    apply_port_devices(); // choices made before the game was loaded
+    return true;
 }
 
 bool start_emulation_internal() {
     if (!gCoreHandle || !g_retro_run) return false;
     if (gRunning.load()) return true;
     gRunning.store(true);
+    perf_stats_reset();
+    presenter_start();
+    if (gAvInfo.timing.sample_rate > 0) audio_output_start((unsigned)(gAvInfo.timing.sample_rate + 0.5));
     gEmuThread = std::thread(emu_thread_main);
     return true;
 }
@@ -290,28 +1291,227 @@ void stop_emulation_internal() {
     if (!gRunning.load()) return;
     gRunning.store(false);
     if (gEmuThread.joinable()) gEmuThread.join();
+    presenter_stop();
+    audio_output_stop();
 }
 
 void set_window_internal(ANativeWindow* win) {
-    std::lock_guard<std::mutex> lk(gWindowMutex);
-    if (gWindow) {
-        ANativeWindow_release(gWindow);
-        gWindow = nullptr;
-    }
-    gWindow = win; // note: caller must ensure reference (ANativeWindow_fromSurface used)
+    // note: caller must ensure reference (ANativeWindow_fromSurface used)
+    presenter_set_window(win);
 }
 
 void clear_window_internal() {
-    std::lock_guard<std::mutex> lk(gWindowMutex);
-    if (gWindow) {
-        ANativeWindow_release(gWindow);
-        gWindow = nullptr;
-    }
+    presenter_set_window(nullptr);
 }
 
 void set_button_state_internal(int id, int pressed) {
-    std::lock_guard<std::mutex> lk(gInputLock);
-    if (id >= 0 && (size_t)id < gButtons.size()) gButtons[id] = pressed ? 1 : 0;
+    if (id >= 0) input_set_button(0, (unsigned)id, pressed != 0);
+}
+
+void submit_input_internal(const int32_t* events, size_t count) {
+    input_apply_events(events, count);
+}
+
+void set_controller_port_device_internal(unsigned port, unsigned device) {
+    if (port >= INPUT_MAX_PORTS) return;
+    input_set_port_device(port, device);
+    gPortDevicesPending.fetch_or(1u << port); // the core hears about it between frames
+}
+
+size_t get_controller_types_internal(unsigned port, input_controller_type* out, size_t max) {
+    std::vector<input_controller_type> types = input_controller_types(port);
+    size_t n = std::min(types.size(), max);
+    for (size_t i = 0; i < n; ++i) out[i] = types[i];
+    return types.size();
+}
+
+void get_video_stats_internal(presenter_stats* out) {
+    presenter_get_stats(out);
+}
+
+void prefetch_content_internal(const char* path) {
+    prefetch_join();
+    gPrefetch.data.unmap();
+    gPrefetch.ok = false;
+    gPrefetch.entry.clear();
+    gPrefetch.path = path ? path : "";
+    if (!path || !archive_is_zip(path)) return;
+    gPrefetch.worker = std::thread([] {
+        const int64_t t0 = mono_ns();
+        ZipArchive zip;
+        if (!zip.open(gPrefetch.path.c_str())) return;
+        const int i = zip.pick(nullptr);   // the core's extensions are not known yet
+        if (i < 0) return;
+        const zip_entry& e = zip.entries()[i];
+        if (cache_valid(cache_path(gPrefetch.path.c_str(), e), e)) return;   // extracted before
+        gPrefetch.entry = e.name;
+        gPrefetch.ok = extract_entry(zip, e, &gPrefetch.data);
+        gPrefetch.extract_ns = (uint64_t)(mono_ns() - t0);
+        LOGI("prefetched %s from %s in %.2f ms", gPrefetch.entry.c_str(), gPrefetch.path.c_str(),
+             gPrefetch.extract_ns / 1e6);
+    });
+}
+
+void get_content_stats_internal(content_stats* out) {
+    if (!out) return;
+    out->in_memory = gContentInMemory.load();
+    out->from_archive = gContentFromArchive.load();
+    out->prefetched = gContentPrefetched.load();
+    out->extract_ns = gContentExtractNs.load();
+    out->size = gContentSize.load();
+    out->map_ns = gContentMapNs.load();
+    out->load_ns = gContentLoadNs.load();
+    out->cached_bytes = gContent.cached_bytes();
+}
+
+void get_input_latency_internal(latency_summary* out) {
+    presenter_get_input_latency(out);
+}
+
+size_t get_input_latency_histogram_internal(uint32_t* out, size_t n) {
+    return presenter_get_input_latency_histogram(out, n);
+}
+
+size_t get_core_perf_counters_internal(core_perf_counter* out, size_t max) {
+    std::vector<core_perf_counter> counters;
+    core_perf_snapshot(&counters);
+    for (size_t i = 0; i < counters.size() && i < max; ++i) out[i] = counters[i];
+    return counters.size();
+}
+
+size_t get_perf_stats_internal(latency_summary* out, size_t n) {
+    for (size_t i = 0; i < n && i < PERF_METRIC_COUNT; ++i) perf_stats_get((perf_metric)i, &out[i]);
+    return PERF_METRIC_COUNT;
+}
+
+void set_frame_pacing_internal(bool enabled) {
+    gPacing.store(enabled, std::memory_order_relaxed);
+}
+
+void set_fast_forward_internal(bool enabled) {
+    gFastForward.store(enabled, std::memory_order_relaxed);
+    LOGI("fast-forward %s", enabled ? "on" : "off");
+}
+
+void set_fast_forward_ratio_internal(float ratio) {
+    gFastForwardRatio.store(ratio > 0 ? ratio : 0.0f, std::memory_order_relaxed);
+}
+
+void set_rewind_internal(bool enabled, unsigned interval, size_t budget_bytes) {
+    gRewindInterval.store(interval ? interval : 1, std::memory_order_relaxed);
+    gRewindBudget.store(budget_bytes, std::memory_order_relaxed);
+    gRewindEnabled.store(enabled, std::memory_order_relaxed);
+    gRewindReset.store(true);
+}
+
+void rewind_frames_internal(int frames) {
+    if (frames <= 0) return;
+    unsigned interval = gRewindInterval.load(std::memory_order_relaxed);
+    gRewindPending.fetch_add((int)((frames + interval - 1) / interval), std::memory_order_relaxed);
+}
+
+void set_rewinding_internal(bool held) {
+    gRewindHeld.store(held, std::memory_order_relaxed);
+}
+
+void get_rewind_stats_internal(rewind_stats* out) {
+    if (!out) return;
+    out->enabled = gRewindEnabled.load(std::memory_order_relaxed) && g_retro_serialize_size;
+    out->interval = gRewindInterval.load(std::memory_order_relaxed);
+    out->state_size = gRewindStateSize.load(std::memory_order_relaxed);
+    out->budget = gRewindBudget.load(std::memory_order_relaxed);
+    out->bytes_used = gRewindBytesUsed.load(std::memory_order_relaxed);
+    out->depth = gRewindDepth.load(std::memory_order_relaxed);
+    out->captures = gRewindCaptures.load(std::memory_order_relaxed);
+    out->steps = gRewindSteps.load(std::memory_order_relaxed);
+    out->capture_ns_total = gRewindCaptureNsTotal.load(std::memory_order_relaxed);
+    out->capture_ns_max = gRewindCaptureNsMax.load(std::memory_order_relaxed);
+    double fps = gNominalFps.load(std::memory_order_relaxed);
+    out->seconds = fps > 0 ? out->depth * out->interval / fps : 0.0;
+}
+
+void set_save_dir_internal(const char* dir) {
+    std::lock_guard<std::mutex> lk(gPathLock);
+    gSaveDir = dir ? dir : "";
+    while (gSaveDir.size() > 1 && gSaveDir.back() == '/') gSaveDir.pop_back();
+}
+
+bool save_state_internal(int slot) {
+    if (!gCoreHandle || !g_retro_serialize_size || slot < 0) return false;
+    if (gRunning.load()) {
+        gSaveSlotPending.store(slot); // served by the emulation thread before its next frame
+        return true;
+    }
+    return save_state_now(slot);
+}
+
+bool load_state_internal(int slot) {
+    size_t size = gStateSize.load();
+    if (!gCoreHandle || !g_retro_unserialize || !size || slot < 0) return false;
+    std::string path = state_path(slot);
+    if (gRunning.load()) return savestate_request_load(path.c_str(), size);
+    savestate_buffer buf;
+    return savestate_read_file(path.c_str(), &buf, size) && unserialize_loaded(&buf);
+}
+
+void get_savestate_stats_internal(savestate_stats* out) {
+    savestate_get_stats(out);
+}
+
+void set_audio_quality_internal(int quality) {
+    audio_output_set_quality(quality);
+}
+
+void get_audio_stats_internal(audio_stats* out) {
+    audio_output_get_stats(out);
+}
+
+void get_emu_stats_internal(emu_stats* out) {
+    if (!out) return;
+    out->frames_run = gFramesRun.load(std::memory_order_relaxed);
+    out->frames_video_skipped = gFramesVideoSkipped.load(std::memory_order_relaxed);
+    out->audio_frames_dropped = gAudioFramesDropped.load(std::memory_order_relaxed);
+    out->fast_forward = gFastForward.load(std::memory_order_relaxed);
+    uint64_t frames = out->frames_run - gSpeedStartFrame.load(std::memory_order_relaxed);
+    double secs = (mono_ns() - gSpeedStartNs.load(std::memory_order_relaxed)) / 1e9;
+    double fps = gNominalFps.load(std::memory_order_relaxed);
+    out->speed = (secs > 0 && fps > 0) ? frames / (secs * fps) : 0.0;
+}
+
+void set_run_ahead_internal(unsigned frames, bool second_instance) {
+    gRunAheadFrames.store(std::min(frames, 8u));
+    gRunAheadSecondary.store(second_instance);
+    gRunAheadAutoDisabled.store(false);
+    gRunAheadReset.store(true);
+}
+
+void get_run_ahead_stats_internal(runahead_stats* out) {
+    if (!out) return;
+    out->frames_ahead = gRunAheadFrames.load(std::memory_order_relaxed);
+    out->secondary_instance = gRunAheadSecondary.load(std::memory_order_relaxed);
+    out->active = gRunAheadActive.load(std::memory_order_relaxed);
+    out->auto_disabled = gRunAheadAutoDisabled.load(std::memory_order_relaxed);
+    out->frames = gRunAheadFramesDone.load(std::memory_order_relaxed);
+    const uint64_t n = out->frames ? out->frames : 1;
+    out->serialize_ns_avg = gRunAheadSerializeNsTotal.load(std::memory_order_relaxed) / n;
+    out->serialize_ns_max = gRunAheadSerializeNsMax.load(std::memory_order_relaxed);
+    out->unserialize_ns_avg = gRunAheadUnserializeNsTotal.load(std::memory_order_relaxed) / n;
+    out->unserialize_ns_max = gRunAheadUnserializeNsMax.load(std::memory_order_relaxed);
+    out->overhead_ns_avg = gRunAheadOverheadNsTotal.load(std::memory_order_relaxed) / n;
+    out->work_ns = gRunAheadWorkNs.load(std::memory_order_relaxed);
+    out->budget_ns = gRunAheadBudgetNs.load(std::memory_order_relaxed);
+}
+
+void set_data_dir_internal(const char* dir) {
+    {
+        std::lock_guard<std::mutex> lk(gDataDirLock);
+        gDataDir = dir ? dir : "";
+    }
+    remove_stale_secondaries();
+}
+
+void get_pacer_stats_internal(pacer_stats* out) {
+    pacer_get_stats(out);
 }
 
 } // extern "C"
\ No newline at end of file
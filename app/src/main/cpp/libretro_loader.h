@@ -0,0 +1,114 @@
+// libretro_loader.h
+// C-style API of libretro_loader.cpp, used by native_bridge.cpp and the host headless runner.
+
+#pragma once
+
+#include <cstdint>
+
+#include "audio_output.h"
+#include "core_perf.h"
+#include "frame_pacer.h"
+#include "input_state.h"
+#include "latency_histogram.h"
+#include "perf_stats.h"
+#include "platform.h"
+#include "savestate.h"
+#include "video_presenter.h"
+
+struct emu_stats {
+    uint64_t frames_run;            // retro_run calls
+    uint64_t frames_video_skipped;  // frames not presented during fast-forward
+    uint64_t audio_frames_dropped;  // audio frames discarded during fast-forward
+    bool fast_forward;
+    double speed;                   // achieved rate as a multiple of the core's fps, since the last mode change
+};
+
+struct content_stats {
+    bool in_memory;              // passed as retro_game_info.data (mapped), else by path only
+    bool from_archive;           // an entry of a .zip the core cannot read itself
+    bool prefetched;             // extracted while the core was loading
+    uint64_t size;               // mapped bytes
+    uint64_t extract_ns;         // archive work left on the load path (waiting for the prefetch)
+    uint64_t map_ns;             // open + mmap + madvise, or archive extraction
+    uint64_t load_ns;            // mapping plus retro_load_game
+    uint64_t cached_bytes;       // mapped bytes in the page cache right now
+};
+
+struct rewind_stats {
+    bool enabled;
+    unsigned interval;           // frames between captures
+    uint64_t state_size;         // retro_serialize_size
+    uint64_t budget;             // bytes reserved for deltas
+    uint64_t bytes_used;
+    uint64_t depth;              // states available to step back through
+    uint64_t captures;
+    uint64_t steps;              // states restored
+    uint64_t capture_ns_total;   // serialize + delta encode
+    uint64_t capture_ns_max;
+    double seconds;              // history length at the core's frame rate
+};
+
+struct runahead_stats {
+    unsigned frames_ahead;       // requested; 0 = off
+    bool secondary_instance;
+    bool active;                 // running ahead right now (off during fast-forward and rewind)
+    bool auto_disabled;          // switched itself off: the core could not keep up
+    uint64_t frames;             // frames run ahead
+    uint64_t serialize_ns_avg;
+    uint64_t serialize_ns_max;
+    uint64_t unserialize_ns_avg;
+    uint64_t unserialize_ns_max;
+    uint64_t overhead_ns_avg;    // per frame, beyond the real frame's retro_run
+    uint64_t work_ns;            // smoothed core time per frame, run-ahead included
+    uint64_t budget_ns;          // frame period work_ns is held against (0 = unpaced)
+};
+
+extern "C" {
+    bool load_core_internal(const char* path);
+    bool unload_core_internal();
+    // Cores that report need_fullpath = false get the file mmapped as retro_game_info.data.
+    // .zip content is unpacked for cores that do not list zip among their extensions: into memory
+    // ("archive.zip#entry") or, for need_fullpath cores, into a cache under the data dir.
+    bool load_game_internal(const char* rompath);
+    // Start unpacking an archive before load_core_internal, so the two overlap.
+    void prefetch_content_internal(const char* path);
+    void get_content_stats_internal(content_stats* out);
+    bool start_emulation_internal();
+    void stop_emulation_internal();
+    void set_window_internal(ANativeWindow* win);
+    void clear_window_internal();
+    void set_button_state_internal(int id, int pressed);   // port 0 joypad
+    void submit_input_internal(const int32_t* events, size_t count);   // see input_event_kind
+    void set_controller_port_device_internal(unsigned port, unsigned device);
+    // Fills up to max types the core offers for port; returns how many there are.
+    size_t get_controller_types_internal(unsigned port, input_controller_type* out, size_t max);
+    void get_video_stats_internal(presenter_stats* out);
+    // Input-to-photon latency this session, from the JNI input call to ANativeWindow_unlockAndPost.
+    void get_input_latency_internal(latency_summary* out);
+    size_t get_input_latency_histogram_internal(uint32_t* out, size_t n);   // returns bucket count
+    // Per-frame timings this session (perf_stats.h); summaries for metrics [0, n), returns PERF_METRIC_COUNT.
+    size_t get_perf_stats_internal(latency_summary* out, size_t n);
+    // Counters the core registered through RETRO_ENVIRONMENT_GET_PERF_INTERFACE; fills up to max,
+    // returns how many there are.
+    size_t get_core_perf_counters_internal(core_perf_counter* out, size_t max);
+    void set_frame_pacing_internal(bool enabled);
+    void get_pacer_stats_internal(pacer_stats* out);
+    void set_fast_forward_internal(bool enabled);
+    void set_fast_forward_ratio_internal(float ratio); // <= 0: unlimited
+    void get_emu_stats_internal(emu_stats* out);
+    void set_rewind_internal(bool enabled, unsigned interval, size_t budget_bytes);
+    void rewind_frames_internal(int frames);
+    void set_rewinding_internal(bool held);
+    void get_rewind_stats_internal(rewind_stats* out);
+    void set_save_dir_internal(const char* dir);
+    bool save_state_internal(int slot);   // asynchronous while running
+    bool load_state_internal(int slot);   // asynchronous while running
+    void get_savestate_stats_internal(savestate_stats* out);
+    void set_audio_quality_internal(int quality);   // resampler_quality
+    void get_audio_stats_internal(audio_stats* out);
+    // Run frames ahead to hide the game's input lag (0 = off, at most 8). second_instance runs
+    // the look-ahead on a private copy of the core; it needs a writable data dir.
+    void set_run_ahead_internal(unsigned frames, bool second_instance);
+    void get_run_ahead_stats_internal(runahead_stats* out);
+    void set_data_dir_internal(const char* dir);   // app-private scratch space (initNative)
+}
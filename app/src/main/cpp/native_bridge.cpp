@@ -2,25 +2,21 @@
 // JNI bridge that connects Android / Kotlin to libretro loader functions.
 
 #include <jni.h>
-#include <android/log.h>
 #include <android/native_window_jni.h>
+#include <algorithm>
+#include <cstdio>
 #include <string>
+#include <vector>
 
 #define LOG_TAG "SaaSEmuNative"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// forward declarations of loader functions (defined in libretro_loader.cpp)
-extern "C" {
-    bool load_core_internal(const char* path);
-    bool unload_core_internal();
-    bool load_game_internal(const char* rompath);
-    bool start_emulation_internal();
-    void stop_emulation_internal();
-    void set_window_internal(ANativeWindow* win);
-    void clear_window_internal();
-    void set_button_state_internal(int id, int pressed);
-}
+// loader functions (defined in libretro_loader.cpp)
+#include "libretro_loader.h"
+#include "rom_library.h"
+#include "content_hash.h"
+#include "core_catalog.h"
+#include "thread_placement.h"
+#include "trace.h"
 
 // Cache JavaVM for potential future use
 static JavaVM* gJvm = nullptr;
@@ -33,12 +29,14 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
     return JNI_VERSION_1_6;
 }
 
-// initNative(datapath) - optional: we keep for compatibility
+// initNative(datapath) - app-private writable directory for native scratch files
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_saasemu_app_core_NativeBridge_initNative(JNIEnv* env, jobject /*clazz*/, jstring datapath) {
     const char* p = env->GetStringUTFChars(datapath, nullptr);
     if (p) {
         LOGI("initNative datapath: %s", p);
+        set_data_dir_internal(p);
+        core_catalog_set_cache_path((std::string(p) + "/core_info.cache").c_str());
         env->ReleaseStringUTFChars(datapath, p);
     }
     return JNI_TRUE;
@@ -84,6 +82,15 @@ Java_com_saasemu_app_core_NativeBridge_loadCore(JNIEnv* env, jobject /*clazz*/,
     return ok ? JNI_TRUE : JNI_FALSE;
 }
 
+// prefetchContent(romPath) - start unpacking an archive before loadCore, overlapping the two
+extern "C" JNIEXPORT void JNICALL
+Java_com_saasemu_app_core_NativeBridge_prefetchContent(JNIEnv* env, jobject /*clazz*/, jstring romPath) {
+    const char* p = env->GetStringUTFChars(romPath, nullptr);
+    if (!p) return;
+    prefetch_content_internal(p);
+    env->ReleaseStringUTFChars(romPath, p);
+}
+
 // loadGame(romPath)
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_saasemu_app_core_NativeBridge_loadGame(JNIEnv* env, jobject /*clazz*/, jstring romPath) {
@@ -124,395 +131,316 @@ Java_com_saasemu_app_core_NativeBridge_setButtonState(JNIEnv* env, jobject /*cla
     set_button_state_internal((int)id, (int)pressed);
 }
 
-// setFastForward (stub)
-extern "C" JNIEXPORT void JNICALL
-Java_com_saasemu_app_core_NativeBridge_setFastForward(JNIEnv* env, jobject /*clazz*/, jboolean enabled) {
-    (void)enabled;
-    LOGI("setFastForward called (stub)");
-}
-
-// rewindFrames (stub)
+// submitInput(events, count) - count packed input events (two ints each, see input_state.h)
 extern "C" JNIEXPORT void JNICALL
-Java_com_saasemu_app_core_NativeBridge_rewindFrames(JNIEnv* env, jobject /*clazz*/, jint frames) {
-    (void)frames;
-    LOGI("rewindFrames called (stub)");
+Java_com_saasemu_app_core_NativeBridge_submitInput(JNIEnv* env, jobject /*clazz*/, jintArray events, jint count) {
+    if (!events || count <= 0) return;
+    jsize available = env->GetArrayLength(events) / 2;
+    if (count > available) count = available;
+    // copy in small chunks onto the stack: no allocation and no pinning of the Java array
+    jint buf[64 * 2];
+    for (jint at = 0; at < count; at += 64) {
+        jint n = count - at < 64 ? count - at : 64;
+        env->GetIntArrayRegion(events, at * 2, n * 2, buf);
+        submit_input_internal((const int32_t*)buf, (size_t)n);
+    }
 }
 
-// setSystemDir (optional helper)
+// setControllerPortDevice(port, device) - RETRO_DEVICE_* (or a core subclass) for a port
 extern "C" JNIEXPORT void JNICALL
-Java_com_saasemu_app_core_NativeBridge_setSystemDir(JNIEnv* env, jobject /*clazz*/, jstring dir) {
-    const char* p = env->GetStringUTFChars(dir, nullptr);
-    if (p) {
-        LOGI("setSystemDir: %s", p);
-        env->ReleaseStringUTFChars(dir, p);
-    }
-}  void* sym = dlsym(handle, name);
-    const char* err = dlerror();
-    if (err) {
-        LOGE("dlsym(%s) error: %s", name, err);
-        return false;
-    }
-    out = reinterpret_cast<T>(sym);
-    LOGI("Resolved %s", name);
-    return true;
-}
-
-// ---------------------------
-// Libretro callbacks
-// ---------------------------
-static bool environment_cb(unsigned cmd, void* data) {
-    switch (cmd) {
-        case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
-            if (!data) return false;
-            {
-                const char** out = (const char**)data;
-                if (gSystemDir.empty()) {
-                    *out = nullptr;
-                    LOGI("env GET_SYSTEM_DIRECTORY -> (null)");
-                } else {
-                    *out = gSystemDir.c_str();
-                    LOGI("env GET_SYSTEM_DIRECTORY -> %s", gSystemDir.c_str());
-                }
-                return true;
-            }
-            break;
-        case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
-            if (!data) return false;
-            {
-                int fmt = *(int*)data;
-                gPixelFormat = fmt;
-                LOGI("env SET_PIXEL_FORMAT -> %d", fmt);
-                return true;
-            }
-            break;
-        default:
-            // Not handled
-            return false;
+Java_com_saasemu_app_core_NativeBridge_setControllerPortDevice(JNIEnv* env, jobject /*clazz*/, jint port,
+                                                               jint device) {
+    if (port >= 0 && device >= 0) set_controller_port_device_internal((unsigned)port, (unsigned)device);
+}
+
+// getControllerTypeIds(port) / getControllerTypeNames(port) - types from SET_CONTROLLER_INFO
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_saasemu_app_core_NativeBridge_getControllerTypeIds(JNIEnv* env, jobject /*clazz*/, jint port) {
+    input_controller_type types[32];
+    size_t n = port >= 0 ? std::min<size_t>(get_controller_types_internal((unsigned)port, types, 32), 32) : 0;
+    jintArray out = env->NewIntArray((jsize)n);
+    if (!out) return nullptr;
+    jint ids[32];
+    for (size_t i = 0; i < n; ++i) ids[i] = (jint)types[i].id;
+    env->SetIntArrayRegion(out, 0, (jsize)n, ids);
+    return out;
+}
+
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_saasemu_app_core_NativeBridge_getControllerTypeNames(JNIEnv* env, jobject /*clazz*/, jint port) {
+    input_controller_type types[32];
+    size_t n = port >= 0 ? std::min<size_t>(get_controller_types_internal((unsigned)port, types, 32), 32) : 0;
+    jclass string_class = env->FindClass("java/lang/String");
+    jobjectArray out = env->NewObjectArray((jsize)n, string_class, nullptr);
+    if (!out) return nullptr;
+    for (size_t i = 0; i < n; ++i) {
+        jstring name = env->NewStringUTF(types[i].desc.c_str());
+        env->SetObjectArrayElement(out, (jsize)i, name);
+        env->DeleteLocalRef(name);
     }
-}
-
-static void retro_video_cb(const void* data, unsigned width, unsigned height, size_t pitch) {
-    if (!gWindow || !data) return;
-
-    ANativeWindow_setBuffersGeometry(gWindow, width, height, WINDOW_FORMAT_RGBA_8888);
-    ANativeWindow_Buffer buf;
-    if (ANativeWindow_lock(gWindow, &buf, nullptr) != 0) return;
-
-    // handle known pixel formats
-    if (gPixelFormat == RETRO_PIXEL_FORMAT_XRGB8888) {
-        // copy rows (assume 4 bytes per pixel)
-        for (unsigned y = 0; y < height; y++) {
-            const void* src = (const uint8_t*)data + y * pitch;
-            void* dst = (uint8_t*)buf.bits + y * buf.stride * 4;
-            memcpy(dst, src, width * 4);
-        }
-    } else if (gPixelFormat == RETRO_PIXEL_FORMAT_RGB565) {
-        // convert RGB565 -> RGBA_8888
-        uint16_t* src = (uint16_t*)data;
-        uint32_t* dst = (uint32_t*)buf.bits;
-        for (unsigned y = 0; y < height; y++) {
-            for (unsigned x = 0; x < width; x++) {
-                uint16_t p = src[y * (pitch/2) + x];
-                uint8_t r = ((p >> 11) & 0x1F) << 3;
-                uint8_t g = ((p >> 5) & 0x3F) << 2;
-                uint8_t b = (p & 0x1F) << 3;
-                dst[y * buf.stride + x] = (0xFFu << 24) | (r << 16) | (g << 8) | b;
-            }
-        }
-    } else {
-        // fallback copy as 32-bit
-        for (unsigned y = 0; y < height; y++) {
-            const void* src = (const uint8_t*)data + y * pitch;
-            void* dst = (uint8_t*)buf.bits + y * buf.stride * 4;
-            memcpy(dst, src, width * 4);
-        }
+    return out;
+}
+
+// getInputLatency() - [count, mean, p50, p90, p99, max] input-to-photon nanoseconds this session
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_saasemu_app_core_NativeBridge_getInputLatency(JNIEnv* env, jobject /*clazz*/) {
+    latency_summary st;
+    get_input_latency_internal(&st);
+    const jlong values[6] = {(jlong)st.count, st.mean_ns, st.p50_ns, st.p90_ns, st.p99_ns, st.max_ns};
+    jlongArray out = env->NewLongArray(6);
+    if (!out) return nullptr;
+    env->SetLongArrayRegion(out, 0, 6, values);
+    return out;
+}
+
+// getCoreCounters() - "ident\tcalls\ttotal_ns" per counter the core registered through the
+// perf interface, in registration order
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_saasemu_app_core_NativeBridge_getCoreCounters(JNIEnv* env, jobject /*clazz*/) {
+    core_perf_counter counters[64];
+    const size_t n = std::min<size_t>(get_core_perf_counters_internal(counters, 64), 64);
+    jclass string_class = env->FindClass("java/lang/String");
+    jobjectArray out = env->NewObjectArray((jsize)n, string_class, nullptr);
+    if (!out) return nullptr;
+    for (size_t i = 0; i < n; ++i) {
+        const std::string row = counters[i].ident + "\t" + std::to_string(counters[i].calls) + "\t" +
+                                std::to_string(counters[i].total_ns);
+        jstring s = env->NewStringUTF(row.c_str());
+        env->SetObjectArrayElement(out, (jsize)i, s);
+        env->DeleteLocalRef(s);
     }
-
-    ANativeWindow_unlockAndPost(gWindow);
-}
-
-static void retro_audio_cb(int16_t left, int16_t right) {
-    // stub: log or later forward to AudioTrack via JNI
-    (void)left; (void)right;
-    // For performance don't log every sample; consider batching in audio_batch callback.
-}
-
-static size_t retro_audio_batch_cb(const int16_t* data, size_t frames) {
-    // stub: we don't output audio here. If you want, implement AudioTrack write via JNI.
-    (void)data; (void)frames;
-    return frames;
+    return out;
 }
 
-static void retro_input_poll_cb(void) {
-    // no-op; input_state will be called to retrieve individual buttons
+// setTracing(enabled) - ATrace sections around retro_run, conversion, window posts, audio writes,
+// serialize and environment calls; visible in systrace / Perfetto captures of the app
+extern "C" JNIEXPORT void JNICALL
+Java_com_saasemu_app_core_NativeBridge_setTracing(JNIEnv* /*env*/, jobject /*clazz*/, jboolean enabled) {
+    trace_set_enabled(enabled == JNI_TRUE);
 }
 
-static int16_t retro_input_state_cb(unsigned port, unsigned device, unsigned index, unsigned id) {
-    std::lock_guard<std::mutex> lk(gInputLock);
-    if (id < gButtonStates.size()) return gButtonStates[id] ? 1 : 0;
-    return 0;
+// setLogLevel(runtime, core) - minimum android.util.Log priority of runtime and core messages;
+// both INFO by default, DEBUG adds per-symbol and per-frame detail
+extern "C" JNIEXPORT void JNICALL
+Java_com_saasemu_app_core_NativeBridge_setLogLevel(JNIEnv* /*env*/, jobject /*clazz*/, jint runtime, jint core) {
+    log_set_min_level(runtime);
+    log_set_core_min_level(core);
 }
 
-// ---------------------------
-// Emulation thread loop
-// ---------------------------
-static void emu_loop() {
-    LOGI("Emu thread started");
-    while (gEmulating.load()) {
-        if (g_retro_run) {
-            g_retro_run();
-        } else {
-            // no run symbol, break
-            break;
-        }
-        // allow scheduler breathing
-        std::this_thread::sleep_for(std::chrono::microseconds(1));
+// setThreadPlacement(enabled) - pin the emulation thread to the fastest cluster and the presenter
+// and audio threads to the other cores, with raised priorities; applies from the next start
+extern "C" JNIEXPORT void JNICALL
+Java_com_saasemu_app_core_NativeBridge_setThreadPlacement(JNIEnv* /*env*/, jobject /*clazz*/, jboolean enabled) {
+    thread_placement_set_enabled(enabled == JNI_TRUE);
+}
+
+// getThreadPlacement() - the CPU topology, each thread's affinity and priority, and migrations seen
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_saasemu_app_core_NativeBridge_getThreadPlacement(JNIEnv* env, jobject /*clazz*/) {
+    return env->NewStringUTF(thread_placement_dump().c_str());
+}
+
+// getStats() - [metrics, 6, then per metric count, mean, p50, p90, p99, max] in nanoseconds, metrics
+// in perf_metric order: retro_run, video_cb, video_convert, video_post, audio_cb, input_poll,
+// frame_interval, pacer_wait
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_saasemu_app_core_NativeBridge_getStats(JNIEnv* env, jobject /*clazz*/) {
+    latency_summary st[PERF_METRIC_COUNT];
+    const size_t n = get_perf_stats_internal(st, PERF_METRIC_COUNT);
+    jlong values[2 + PERF_METRIC_COUNT * 6] = {(jlong)n, 6};
+    for (size_t i = 0; i < n; ++i) {
+        jlong* v = values + 2 + i * 6;
+        v[0] = (jlong)st[i].count;
+        v[1] = st[i].mean_ns;
+        v[2] = st[i].p50_ns;
+        v[3] = st[i].p90_ns;
+        v[4] = st[i].p99_ns;
+        v[5] = st[i].max_ns;
     }
-    LOGI("Emu thread exiting");
+    const jsize len = (jsize)(sizeof(values) / sizeof(values[0]));
+    jlongArray out = env->NewLongArray(len);
+    if (!out) return nullptr;
+    env->SetLongArrayRegion(out, 0, len, values);
+    return out;
 }
 
-// ---------------------------
-// JNI lifecycle
-// ---------------------------
-
-extern "C"
-JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
-    (void)reserved;
-    gJvm = vm;
-    LOGI("JNI_OnLoad");
-    return JNI_VERSION_1_6;
+// getInputLatencyHistogram() - frames per 0.5 ms bucket; the last bucket holds everything longer
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_saasemu_app_core_NativeBridge_getInputLatencyHistogram(JNIEnv* env, jobject /*clazz*/) {
+    uint32_t counts[LatencyHistogram::kBuckets];
+    get_input_latency_histogram_internal(counts, LatencyHistogram::kBuckets);
+    jintArray out = env->NewIntArray((jsize)LatencyHistogram::kBuckets);
+    if (!out) return nullptr;
+    env->SetIntArrayRegion(out, 0, (jsize)LatencyHistogram::kBuckets, (const jint*)counts);
+    return out;
 }
 
-// initNative(datapath) - we use datapath as system dir if provided
-extern "C" JNIEXPORT jboolean JNICALL
-Java_com_saasemu_app_core_NativeBridge_initNative(JNIEnv* env, jobject /*clazz*/, jstring datapath) {
-    const char* p = env->GetStringUTFChars(datapath, nullptr);
-    if (p) {
-        gSystemDir = std::string(p);
-        LOGI("initNative: systemDir set to %s", gSystemDir.c_str());
-        env->ReleaseStringUTFChars(datapath, p);
-    } else {
-        LOGI("initNative: datapath null");
-    }
-    return JNI_TRUE;
+// setFastForward(enabled)
+extern "C" JNIEXPORT void JNICALL
+Java_com_saasemu_app_core_NativeBridge_setFastForward(JNIEnv* env, jobject /*clazz*/, jboolean enabled) {
+    set_fast_forward_internal(enabled == JNI_TRUE);
 }
 
-// attachSurface(surface)
-extern "C" JNIEXPORT jboolean JNICALL
-Java_com_saasemu_app_core_NativeBridge_attachSurface(JNIEnv* env, jobject /*clazz*/, jobject surface) {
-    if (gWindow) {
-        ANativeWindow_release(gWindow);
-        gWindow = nullptr;
-    }
-    if (surface == nullptr) {
-        LOGE("attachSurface: surface == null");
-        return JNI_FALSE;
-    }
-    gWindow = ANativeWindow_fromSurface(env, surface);
-    if (!gWindow) {
-        LOGE("ANativeWindow_fromSurface failed");
-        return JNI_FALSE;
-    }
-    LOGI("Surface attached");
-    return JNI_TRUE;
+// setFastForwardRatio(ratio) - speed multiplier while fast-forwarding, <= 0 for unlimited
+extern "C" JNIEXPORT void JNICALL
+Java_com_saasemu_app_core_NativeBridge_setFastForwardRatio(JNIEnv* env, jobject /*clazz*/, jfloat ratio) {
+    set_fast_forward_ratio_internal((float)ratio);
 }
 
-// detachSurface()
-extern "C" JNIEXPORT jboolean JNICALL
-Java_com_saasemu_app_core_NativeBridge_detachSurface(JNIEnv* env, jobject /*clazz*/) {
-    // stop emulation first if running so callbacks stop using window
-    if (gEmulating.load()) {
-        gEmulating.store(false);
-        if (gEmuThread.joinable()) gEmuThread.join();
-    }
-    if (gWindow) {
-        ANativeWindow_release(gWindow);
-        gWindow = nullptr;
-    }
-    LOGI("Surface detached");
-    return JNI_TRUE;
+// getSpeedMultiplier() - achieved emulation speed relative to the core's frame rate
+extern "C" JNIEXPORT jfloat JNICALL
+Java_com_saasemu_app_core_NativeBridge_getSpeedMultiplier(JNIEnv* env, jobject /*clazz*/) {
+    emu_stats st;
+    get_emu_stats_internal(&st);
+    return (jfloat)st.speed;
 }
 
-// loadCore(corePath) - dlopen and resolve symbols, call retro_init
-extern "C" JNIEXPORT jboolean JNICALL
-Java_com_saasemu_app_core_NativeBridge_loadCore(JNIEnv* env, jobject /*clazz*/, jstring corePath) {
-    const char* path = env->GetStringUTFChars(corePath, nullptr);
-    if (!path) {
-        LOGE("loadCore: path null");
-        return JNI_FALSE;
-    }
-
-    // If already loaded, unload first
-    if (gCoreHandle) {
-        if (g_retro_unload_game) g_retro_unload_game();
-        if (g_retro_deinit) g_retro_deinit();
-        dlclose(gCoreHandle);
-        gCoreHandle = nullptr;
-    }
-
-    LOGI("Attempt dlopen: %s", path);
-    void* h = dlopen(path, RTLD_NOW | RTLD_LOCAL);
-    env->ReleaseStringUTFChars(corePath, path);
-
-    if (!h) {
-        LOGE("dlopen failed: %s", dlerror());
-        return JNI_FALSE;
-    }
-    gCoreHandle = h;
-
-    // Resolve the commonly required symbols
-    bool ok = true;
-    ok &= resolve_sym<void*>(h, "retro_api_version", (void*&)g_retro_api_version);
-    ok &= resolve_sym<void*>(h, "retro_set_environment", (void*&)g_retro_set_environment);
-    ok &= resolve_sym<void*>(h, "retro_set_video_refresh", (void*&)g_retro_set_video_refresh);
-    ok &= resolve_sym<void*>(h, "retro_set_audio_sample", (void*&)g_retro_set_audio_sample);
-    ok &= resolve_sym<void*>(h, "retro_set_audio_sample_batch", (void*&)g_retro_set_audio_sample_batch);
-    ok &= resolve_sym<void*>(h, "retro_set_input_poll", (void*&)g_retro_set_input_poll);
-    ok &= resolve_sym<void*>(h, "retro_set_input_state", (void*&)g_retro_set_input_state);
-    ok &= resolve_sym<void*>(h, "retro_init", (void*&)g_retro_init);
-    ok &= resolve_sym<void*>(h, "retro_deinit", (void*&)g_retro_deinit);
-    ok &= resolve_sym<void*>(h, "retro_load_game", (void*&)g_retro_load_game);
-    ok &= resolve_sym<void*>(h, "retro_unload_game", (void*&)g_retro_unload_game);
-    ok &= resolve_sym<void*>(h, "retro_run", (void*&)g_retro_run);
-
-    if (!ok) {
-        LOGE("Failed to resolve required libretro symbols");
-        dlclose(h);
-        gCoreHandle = nullptr;
-        return JNI_FALSE;
-    }
-
-    // Wire callbacks
-    if (g_retro_set_environment) g_retro_set_environment(environment_cb);
-    if (g_retro_set_video_refresh) g_retro_set_video_refresh(retro_video_cb);
-    if (g_retro_set_audio_sample) g_retro_set_audio_sample(retro_audio_cb);
-    if (g_retro_set_audio_sample_batch) g_retro_set_audio_sample_batch(retro_audio_batch_cb);
-    if (g_retro_set_input_poll) g_retro_set_input_poll(retro_input_poll_cb);
-    if (g_retro_set_input_state) g_retro_set_input_state(retro_input_state_cb);
-
-    // Initialize core
-    if (g_retro_init) g_retro_init();
+// setRewind(enabled, interval, budgetBytes) - capture a state every interval frames
+extern "C" JNIEXPORT void JNICALL
+Java_com_saasemu_app_core_NativeBridge_setRewind(JNIEnv* env, jobject /*clazz*/, jboolean enabled,
+                                                 jint interval, jlong budgetBytes) {
+    set_rewind_internal(enabled == JNI_TRUE, interval > 0 ? (unsigned)interval : 1u,
+                        budgetBytes > 0 ? (size_t)budgetBytes : 0);
+}
 
-    LOGI("Core loaded and initialized");
-    return JNI_TRUE;
+// rewindFrames(frames) - step back, one captured state per presented frame
+extern "C" JNIEXPORT void JNICALL
+Java_com_saasemu_app_core_NativeBridge_rewindFrames(JNIEnv* env, jobject /*clazz*/, jint frames) {
+    rewind_frames_internal((int)frames);
 }
 
-// loadGame(romPath) - uses retro_game_info.path (many cores accept)
-extern "C" JNIEXPORT jboolean JNICALL
-Java_com_saasemu_app_core_NativeBridge_loadGame(JNIEnv* env, jobject /*clazz*/, jstring romPath) {
-    if (!gCoreHandle || !g_retro_load_game) {
-        LOGE("loadGame: core not loaded or retro_load_game missing");
-        return JNI_FALSE;
-    }
-    const char* rpath = env->GetStringUTFChars(romPath, nullptr);
-    if (!rpath) {
-        LOGE("loadGame: romPath null");
-        return JNI_FALSE;
-    }
-    retro_game_info gi;
-    memset(&gi, 0, sizeof(gi));
-    gi.path = rpath;
-    gi.data = nullptr;
-    gi.size = 0;
-    gi.meta = nullptr;
-
-    bool ok = g_retro_load_game(&gi);
-    env->ReleaseStringUTFChars(romPath, rpath);
-    LOGI("retro_load_game returned %d", ok ? 1 : 0);
-    return ok ? JNI_TRUE : JNI_FALSE;
+// setRewinding(held) - keep rewinding while the rewind button is held
+extern "C" JNIEXPORT void JNICALL
+Java_com_saasemu_app_core_NativeBridge_setRewinding(JNIEnv* env, jobject /*clazz*/, jboolean held) {
+    set_rewinding_internal(held == JNI_TRUE);
 }
 
-// startEmulation()
-extern "C" JNIEXPORT jboolean JNICALL
-Java_com_saasemu_app_core_NativeBridge_startEmulation(JNIEnv* env, jobject /*clazz*/) {
-    if (!gCoreHandle || !g_retro_run) {
-        LOGE("startEmulation: core not loaded or retro_run missing");
-        return JNI_FALSE;
-    }
-    if (gEmulating.load()) return JNI_TRUE;
-    gEmulating.store(true);
-    gEmuThread = std::thread(emu_loop);
-    LOGI("Emulation started");
-    return JNI_TRUE;
+// setSaveDir(path) - directory for savestate files (default: next to the content)
+extern "C" JNIEXPORT void JNICALL
+Java_com_saasemu_app_core_NativeBridge_setSaveDir(JNIEnv* env, jobject /*clazz*/, jstring dir) {
+    const char* p = env->GetStringUTFChars(dir, nullptr);
+    if (!p) return;
+    set_save_dir_internal(p);
+    env->ReleaseStringUTFChars(dir, p);
 }
 
-// stopEmulation()
+// saveState(slot) - serializes at the next frame boundary; the file is written in the background
 extern "C" JNIEXPORT jboolean JNICALL
-Java_com_saasemu_app_core_NativeBridge_stopEmulation(JNIEnv* env, jobject /*clazz*/) {
-    if (!gEmulating.load()) return JNI_TRUE;
-    gEmulating.store(false);
-    if (gEmuThread.joinable()) gEmuThread.join();
-    LOGI("Emulation stopped");
-    return JNI_TRUE;
+Java_com_saasemu_app_core_NativeBridge_saveState(JNIEnv* env, jobject /*clazz*/, jint slot) {
+    return save_state_internal((int)slot) ? JNI_TRUE : JNI_FALSE;
 }
 
-// unload core and cleanup
+// loadState(slot)
 extern "C" JNIEXPORT jboolean JNICALL
-Java_com_saasemu_app_core_NativeBridge_unloadCore(JNIEnv* env, jobject /*clazz*/) {
-    // stop emulation
-    if (gEmulating.load()) {
-        gEmulating.store(false);
-        if (gEmuThread.joinable()) gEmuThread.join();
-    }
-    if (g_retro_unload_game) g_retro_unload_game();
-    if (g_retro_deinit) g_retro_deinit();
-    if (gCoreHandle) {
-        dlclose(gCoreHandle);
-        gCoreHandle = nullptr;
-    }
-    LOGI("Core unloaded");
-    return JNI_TRUE;
+Java_com_saasemu_app_core_NativeBridge_loadState(JNIEnv* env, jobject /*clazz*/, jint slot) {
+    return load_state_internal((int)slot) ? JNI_TRUE : JNI_FALSE;
 }
 
-// setFastForward(enabled) - stub (core-specific speed handling can be optimized)
+// setRunAhead(frames, secondInstance) - 0 frames turns run-ahead off
 extern "C" JNIEXPORT void JNICALL
-Java_com_saasemu_app_core_NativeBridge_setFastForward(JNIEnv* env, jobject /*clazz*/, jboolean enabled) {
-    (void)env;
-    (void)enabled;
-    LOGI("setFastForward called (%d) - not implemented natively", enabled ? 1 : 0);
+Java_com_saasemu_app_core_NativeBridge_setRunAhead(JNIEnv* env, jobject /*clazz*/, jint frames,
+                                                   jboolean secondInstance) {
+    set_run_ahead_internal(frames > 0 ? (unsigned)frames : 0, secondInstance == JNI_TRUE);
 }
 
-// rewindFrames(frames) - stub: requires savestate stack implementation
+// setAudioQuality(level) - resampler: 0 linear, 1 16-tap sinc (default), 2 32-tap sinc
 extern "C" JNIEXPORT void JNICALL
-Java_com_saasemu_app_core_NativeBridge_rewindFrames(JNIEnv* env, jobject /*clazz*/, jint frames) {
-    (void)env;
-    (void)frames;
-    LOGI("rewindFrames called (%d) - not implemented (needs savestate system)", frames);
+Java_com_saasemu_app_core_NativeBridge_setAudioQuality(JNIEnv* env, jobject /*clazz*/, jint level) {
+    set_audio_quality_internal((int)level);
 }
 
-// setButtonState(id, pressed) - helper to let Kotlin toggle inputs
+// setSystemDir (optional helper)
 extern "C" JNIEXPORT void JNICALL
-Java_com_saasemu_app_core_NativeBridge_setButtonState(JNIEnv* env, jobject /*clazz*/, jint id, jint pressed) {
-    std::lock_guard<std::mutex> lk(gInputLock);
-    if (id >= 0 && (size_t)id < gButtonStates.size()) {
-        gButtonStates[id] = pressed ? 1 : 0;
+Java_com_saasemu_app_core_NativeBridge_setSystemDir(JNIEnv* env, jobject /*clazz*/, jstring dir) {
+    const char* p = env->GetStringUTFChars(dir, nullptr);
+    if (p) {
+        LOGI("setSystemDir: %s", p);
+        env->ReleaseStringUTFChars(dir, p);
     }
 }
 
-// Optional: setSystemDir from Java (if you prefer to set system dir separately)
-extern "C" JNIEXPORT void JNICALL
-Java_com_saasemu_app_core_NativeBridge_setSystemDir(JNIEnv* env, jobject /*clazz*/, jstring dir) {
-    const char* d = env->GetStringUTFChars(dir, nullptr);
-    if (d) {
-        gSystemDir = std::string(d);
-        env->ReleaseStringUTFChars(dir, d);
-        LOGI("setSystemDir -> %s", gSystemDir.c_str());
+static std::string jstring_to_string(JNIEnv* env, jstring s) {
+    if (!s) return std::string();
+    const char* p = env->GetStringUTFChars(s, nullptr);
+    std::string out = p ? p : "";
+    if (p) env->ReleaseStringUTFChars(s, p);
+    return out;
+}
+
+// scanRomLibrary(dirs, indexPath, datDir) - blocking; one tab-separated row per file:
+// path, size, crc32 (hex), sha1 (hex, empty for archives), system, title
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_saasemu_app_core_NativeBridge_scanRomLibrary(JNIEnv* env, jobject /*clazz*/, jobjectArray dirs,
+                                                      jstring indexPath, jstring datDir) {
+    rom_scan_options opts;
+    const jsize ndirs = dirs ? env->GetArrayLength(dirs) : 0;
+    for (jsize i = 0; i < ndirs; ++i) {
+        jstring d = (jstring)env->GetObjectArrayElement(dirs, i);
+        std::string dir = jstring_to_string(env, d);
+        if (!dir.empty()) opts.dirs.push_back(dir);
+        env->DeleteLocalRef(d);
     }
+    opts.index_path = jstring_to_string(env, indexPath);
+    opts.dat_dir = jstring_to_string(env, datDir);
+
+    std::vector<rom_entry> entries;
+    rom_library_scan(opts, &entries, nullptr);
+
+    jclass string_class = env->FindClass("java/lang/String");
+    jobjectArray out = env->NewObjectArray((jsize)entries.size(), string_class, nullptr);
+    if (!out) return nullptr;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const rom_entry& e = entries[i];
+        char crc[9], sha1[41] = "";
+        snprintf(crc, sizeof(crc), "%08x", e.crc32);
+        if (e.flags & ROM_FLAG_SHA1) hash_to_hex(e.sha1, 20, sha1);
+        std::string row = e.path + "\t" + std::to_string(e.size) + "\t" + crc + "\t" + sha1 + "\t" + e.system +
+                          "\t" + e.title;
+        jstring s = env->NewStringUTF(row.c_str());
+        env->SetObjectArrayElement(out, (jsize)i, s);
+        env->DeleteLocalRef(s);
+    }
+    return out;
 }
 
-// Keep a simple dlopen-only loader for compatibility
+// loadCoreCheck(corePath) - whether the core can be loaded, from the core catalog: ELF inspection and
+// a system-info probe in a child process the first time, a cache hit afterwards. No dlopen here.
 extern "C" JNIEXPORT jboolean JNICALL
 Java_com_saasemu_app_core_NativeBridge_loadCoreCheck(JNIEnv* env, jobject /*clazz*/, jstring corePath) {
-    // legacy helper (simply dlopen and close to check viability)
-    const char* p = env->GetStringUTFChars(corePath, nullptr);
-    void* h = dlopen(p, RTLD_NOW | RTLD_LOCAL);
-    if (!h) {
-        LOGE("dlopen failed: %s", dlerror());
-        env->ReleaseStringUTFChars(corePath, p);
+    core_info info;
+    const std::string path = jstring_to_string(env, corePath);
+    if (!core_catalog_get(path.c_str(), &info) || !info.loadable()) {
+        LOGE("core check failed: %s: %s", path.c_str(), info.error.empty() ? "cannot read" : info.error.c_str());
         return JNI_FALSE;
     }
-    LOGI("dlopen success: %s", p);
-    dlclose(h);
-    env->ReleaseStringUTFChars(corePath, p);
     return JNI_TRUE;
-}
\ No newline at end of file
+}
+
+// getCoreInfo(corePath) - [name, version, extensions, needFullpath ("1"/"0"), error], null if unreadable
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_saasemu_app_core_NativeBridge_getCoreInfo(JNIEnv* env, jobject /*clazz*/, jstring corePath) {
+    core_info info;
+    if (!core_catalog_get(jstring_to_string(env, corePath).c_str(), &info)) return nullptr;
+    const std::string fields[5] = {info.name, info.version, info.extensions,
+                                   info.flags & CORE_INFO_NEED_FULLPATH ? "1" : "0", info.error};
+    jclass string_class = env->FindClass("java/lang/String");
+    jobjectArray out = env->NewObjectArray(5, string_class, nullptr);
+    if (!out) return nullptr;
+    for (jsize i = 0; i < 5; ++i) {
+        jstring s = env->NewStringUTF(fields[i].c_str());
+        env->SetObjectArrayElement(out, i, s);
+        env->DeleteLocalRef(s);
+    }
+    return out;
+}
+
+// findCoreForContent(coresDir, romPath) - path of the first loadable core taking the ROM, or null
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_saasemu_app_core_NativeBridge_findCoreForContent(JNIEnv* env, jobject /*clazz*/, jstring coresDir,
+                                                          jstring romPath) {
+    core_info info;
+    if (!core_catalog_find_for_content(jstring_to_string(env, coresDir).c_str(),
+                                       jstring_to_string(env, romPath).c_str(), &info))
+        return nullptr;
+    return env->NewStringUTF(info.path.c_str());
+}
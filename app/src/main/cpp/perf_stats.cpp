@@ -0,0 +1,65 @@
+// perf_stats.cpp
+// The per-metric histograms behind perf_stats.h and their text dump.
+
+#include "perf_stats.h"
+
+#include <cstdio>
+
+// One cache line apart at least, so the presenter's metric never shares a line with the emulation thread's.
+struct alignas(64) perf_slot {
+    PerfHistogram hist;
+};
+
+static perf_slot gMetrics[PERF_METRIC_COUNT];
+
+const char* perf_metric_name(perf_metric m) {
+    switch (m) {
+        case PERF_RUN: return "retro_run";
+        case PERF_VIDEO_CB: return "video_cb";
+        case PERF_VIDEO_CONVERT: return "video_convert";
+        case PERF_VIDEO_POST: return "video_post";
+        case PERF_AUDIO_CB: return "audio_cb";
+        case PERF_INPUT_POLL: return "input_poll";
+        case PERF_FRAME_INTERVAL: return "frame_interval";
+        case PERF_PACER_WAIT: return "pacer_wait";
+        default: return "unknown";
+    }
+}
+
+void perf_stats_reset() {
+    for (perf_slot& s : gMetrics) s.hist.clear();
+}
+
+void perf_stats_get(perf_metric m, latency_summary* out) {
+    if (!out) return;
+    if (m < 0 || m >= PERF_METRIC_COUNT) {
+        *out = latency_summary();
+        return;
+    }
+    gMetrics[m].hist.summarize(out);
+}
+
+std::string perf_stats_dump() {
+    std::string out;
+    char line[160];
+    snprintf(line, sizeof(line), "%-15s %8s %9s %9s %9s %9s %9s\n", "metric_us", "count", "mean", "p50", "p90",
+             "p99", "max");
+    out += line;
+    for (int i = 0; i < PERF_METRIC_COUNT; ++i) {
+        latency_summary s;
+        perf_stats_get((perf_metric)i, &s);
+        snprintf(line, sizeof(line), "%-15s %8llu %9.2f %9.2f %9.2f %9.2f %9.2f\n", perf_metric_name((perf_metric)i),
+                 (unsigned long long)s.count, s.mean_ns / 1e3, s.p50_ns / 1e3, s.p90_ns / 1e3, s.p99_ns / 1e3,
+                 s.max_ns / 1e3);
+        out += line;
+    }
+    return out;
+}
+
+#if SAASEMU_PERF_STATS
+
+void perf_record(perf_metric m, int64_t ns) {
+    gMetrics[m].hist.record(ns);
+}
+
+#endif
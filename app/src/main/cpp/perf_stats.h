@@ -0,0 +1,163 @@
+// perf_stats.h
+// Per-frame timing of the emulation loop, always on: how long each frame spends in retro_run, the
+// video, audio and input callbacks, the pacer and between frames.
+//
+// Each metric has one histogram with exactly one writing thread (the emulation thread, or the
+// presenter thread for PERF_VIDEO_POST), so recording is a relaxed load and store with no locked
+// instruction, and any thread may read a snapshot at any time. Buckets are log-linear: exact below
+// 16 ns, then 16 per power of two up to ~34 s, so a percentile is within 1/32 of its true value
+// whatever the scale. Recording is two clock reads and a few instructions per sample, about a
+// dozen samples per frame.
+//
+// Build with SAASEMU_PERF_STATS=0 (cmake -DSAASEMU_PERF_STATS=OFF) to compile every probe out.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "latency_histogram.h"
+
+#ifndef SAASEMU_PERF_STATS
+#define SAASEMU_PERF_STATS 1
+#endif
+
+enum perf_metric {
+    PERF_RUN,              // the frame's retro_run with the callbacks it makes, run-ahead replays included
+    PERF_VIDEO_CB,         // video callback of a frame that is presented
+    PERF_VIDEO_CONVERT,    // staging in the video callback: pixel conversion or copy into a slot
+    PERF_VIDEO_POST,       // presenter thread: ANativeWindow_lock, copy and unlockAndPost
+    PERF_AUDIO_CB,         // handing the frame's samples to the audio output, summed over the frame
+    PERF_INPUT_POLL,       // each input poll callback
+    PERF_FRAME_INTERVAL,   // start of one frame to the start of the next
+    PERF_PACER_WAIT,       // sleeping for the frame's deadline
+    PERF_METRIC_COUNT
+};
+
+class PerfHistogram {
+public:
+    static const int kSubBits = 4;                          // 16 buckets per power of two
+    static const size_t kSub = (size_t)1 << kSubBits;
+    static const size_t kBuckets = 512;                     // up to 2^35 ns; longer lands in the last
+
+    void clear() {
+        for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+        total_ns_.store(0, std::memory_order_relaxed);
+        max_ns_.store(0, std::memory_order_relaxed);
+    }
+
+    // Single writer: a plain load and store, never a read-modify-write.
+    void record(int64_t ns) {
+        if (ns < 0) ns = 0;
+        std::atomic<uint64_t>& b = buckets_[bucket_of((uint64_t)ns)];
+        b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total_ns_.store(total_ns_.load(std::memory_order_relaxed) + (uint64_t)ns, std::memory_order_relaxed);
+        if (ns > max_ns_.load(std::memory_order_relaxed)) max_ns_.store(ns, std::memory_order_relaxed);
+    }
+
+    static size_t bucket_of(uint64_t ns) {
+        if (ns < kSub) return (size_t)ns;
+        const int e = 63 - __builtin_clzll(ns);   // >= kSubBits
+        const size_t b = kSub + (size_t)(e - kSubBits) * kSub + (size_t)((ns >> (e - kSubBits)) & (kSub - 1));
+        return b < kBuckets ? b : kBuckets - 1;
+    }
+
+    // Smallest value of bucket b; the bucket ends where b + 1 starts.
+    static uint64_t bucket_floor(size_t b) {
+        if (b < kSub) return b;
+        const int e = kSubBits + (int)((b - kSub) / kSub);
+        return (uint64_t)(kSub + (b - kSub) % kSub) << (e - kSubBits);
+    }
+
+    // Percentiles resolve to the middle of their bucket, never above the maximum.
+    void summarize(latency_summary* out) const {
+        uint64_t counts[kBuckets];
+        uint64_t total = 0;
+        for (size_t i = 0; i < kBuckets; ++i) total += counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        out->count = total;
+        out->max_ns = max_ns_.load(std::memory_order_relaxed);
+        out->mean_ns = total ? (int64_t)(total_ns_.load(std::memory_order_relaxed) / total) : 0;
+        out->p50_ns = percentile(counts, total, 0.50, out->max_ns);
+        out->p90_ns = percentile(counts, total, 0.90, out->max_ns);
+        out->p99_ns = percentile(counts, total, 0.99, out->max_ns);
+    }
+
+private:
+    static int64_t percentile(const uint64_t* counts, uint64_t total, double p, int64_t max_ns) {
+        if (!total) return 0;
+        uint64_t rank = (uint64_t)(p * (total - 1)) + 1, seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += counts[i];
+            if (seen < rank) continue;
+            const uint64_t lo = bucket_floor(i);
+            const uint64_t mid = i + 1 < kBuckets ? lo + (bucket_floor(i + 1) - lo) / 2 : lo;
+            return (int64_t)mid < max_ns ? (int64_t)mid : max_ns;
+        }
+        return max_ns;
+    }
+
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> total_ns_{0};
+    std::atomic<int64_t> max_ns_{0};
+};
+
+const char* perf_metric_name(perf_metric m);
+
+// Clears every metric. Only while the emulation and presenter threads are stopped.
+void perf_stats_reset();
+
+void perf_stats_get(perf_metric m, latency_summary* out);
+
+// One line per metric: count, then mean, p50, p90, p99 and max in microseconds.
+std::string perf_stats_dump();
+
+#if SAASEMU_PERF_STATS
+
+void perf_record(perf_metric m, int64_t ns);
+
+static inline int64_t perf_now_ns() {
+    return latency_now_ns();
+}
+
+// Records the time until the end of the enclosing scope.
+class PerfScope {
+public:
+    explicit PerfScope(perf_metric m) : metric_(m), t0_(perf_now_ns()) {}
+    ~PerfScope() { perf_record(metric_, perf_now_ns() - t0_); }
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+    perf_metric metric_;
+    int64_t t0_;
+};
+
+// Adds the time until the end of the enclosing scope to sum, for metrics recorded once per frame.
+class PerfSum {
+public:
+    explicit PerfSum(int64_t& sum) : sum_(sum), t0_(perf_now_ns()) {}
+    ~PerfSum() { sum_ += perf_now_ns() - t0_; }
+    PerfSum(const PerfSum&) = delete;
+    PerfSum& operator=(const PerfSum&) = delete;
+
+private:
+    int64_t& sum_;
+    int64_t t0_;
+};
+
+#define PERF_CONCAT2(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT2(a, b)
+#define PERF_SCOPE(metric) PerfScope PERF_CONCAT(perf_scope_, __LINE__)(metric)
+#define PERF_SUM(sum) PerfSum PERF_CONCAT(perf_sum_, __LINE__)(sum)
+
+#else
+
+static inline void perf_record(perf_metric, int64_t) {}
+static inline int64_t perf_now_ns() { return 0; }
+
+#define PERF_SCOPE(metric) ((void)0)
+#define PERF_SUM(sum) ((void)0)
+
+#endif
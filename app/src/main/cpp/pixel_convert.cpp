@@ -0,0 +1,125 @@
+// pixel_convert.cpp
+// Scalar reference kernels and the runtime dispatch table.
+
+#include "pixel_convert.h"
+#include "pixel_convert_kernels.h"
+#include "cpu_features.h"
+#include "libretro_defs.h"
+
+#include <atomic>
+#include <cstring>
+
+void rgb565_to_rgba_scalar(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    for (unsigned i = 0; i < pixels; ++i) {
+        uint16_t p;
+        memcpy(&p, s + i * 2, 2);
+        uint32_t o = rgb565_to_rgba_pixel(p);
+        memcpy(d + i * 4, &o, 4);
+    }
+}
+
+void argb1555_to_rgba_scalar(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    for (unsigned i = 0; i < pixels; ++i) {
+        uint16_t p;
+        memcpy(&p, s + i * 2, 2);
+        uint32_t o = argb1555_to_rgba_pixel(p);
+        memcpy(d + i * 4, &o, 4);
+    }
+}
+
+void xrgb8888_to_rgba_scalar(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    for (unsigned i = 0; i < pixels; ++i) {
+        uint32_t p;
+        memcpy(&p, s + i * 4, 4);
+        uint32_t o = xrgb8888_to_rgba_pixel(p);
+        memcpy(d + i * 4, &o, 4);
+    }
+}
+
+// Indexed by RETRO_PIXEL_FORMAT_* (0RGB1555, XRGB8888, RGB565)
+struct kernel_set {
+    pixel_row_fn fn[3];
+};
+
+static const kernel_set kKernels[PIXEL_ISA_COUNT] = {
+    {{argb1555_to_rgba_scalar, xrgb8888_to_rgba_scalar, rgb565_to_rgba_scalar}},
+#ifdef PIXEL_CONVERT_HAVE_X86
+    {{argb1555_to_rgba_sse2, xrgb8888_to_rgba_sse2, rgb565_to_rgba_sse2}},
+    {{argb1555_to_rgba_avx2, xrgb8888_to_rgba_avx2, rgb565_to_rgba_avx2}},
+#else
+    {{nullptr, nullptr, nullptr}},
+    {{nullptr, nullptr, nullptr}},
+#endif
+#ifdef PIXEL_CONVERT_HAVE_NEON
+    {{argb1555_to_rgba_neon, xrgb8888_to_rgba_neon, rgb565_to_rgba_neon}},
+#else
+    {{nullptr, nullptr, nullptr}},
+#endif
+};
+
+static std::atomic<int> gSelected(PIXEL_ISA_SCALAR);
+
+static bool isa_supported(pixel_isa isa) {
+    uint32_t f = cpu_features_get();
+    switch (isa) {
+        case PIXEL_ISA_SCALAR: return true;
+        case PIXEL_ISA_SSE2: return (f & CPU_FEATURE_SSE2) != 0;
+        case PIXEL_ISA_AVX2: return (f & CPU_FEATURE_AVX2) != 0;
+        case PIXEL_ISA_NEON: return (f & CPU_FEATURE_NEON) != 0;
+        default: return false;
+    }
+}
+
+void pixel_convert_init() {
+    static const pixel_isa kPreference[] = {PIXEL_ISA_NEON, PIXEL_ISA_AVX2, PIXEL_ISA_SSE2};
+    for (pixel_isa isa : kPreference) {
+        if (kKernels[isa].fn[0] && isa_supported(isa)) {
+            gSelected.store(isa, std::memory_order_relaxed);
+            return;
+        }
+    }
+    gSelected.store(PIXEL_ISA_SCALAR, std::memory_order_relaxed);
+}
+
+pixel_row_fn pixel_convert_kernel(pixel_isa isa, int retro_format) {
+    if (isa < 0 || isa >= PIXEL_ISA_COUNT || retro_format < 0 || retro_format > 2) return nullptr;
+    if (!isa_supported(isa)) return nullptr;
+    return kKernels[isa].fn[retro_format];
+}
+
+pixel_row_fn pixel_convert_row(int retro_format) {
+    if (retro_format < 0 || retro_format > 2) return nullptr;
+    return kKernels[gSelected.load(std::memory_order_relaxed)].fn[retro_format];
+}
+
+pixel_isa pixel_convert_selected_isa() {
+    return (pixel_isa)gSelected.load(std::memory_order_relaxed);
+}
+
+const char* pixel_isa_name(pixel_isa isa) {
+    switch (isa) {
+        case PIXEL_ISA_SCALAR: return "scalar";
+        case PIXEL_ISA_SSE2: return "sse2";
+        case PIXEL_ISA_AVX2: return "avx2";
+        case PIXEL_ISA_NEON: return "neon";
+        default: return "unknown";
+    }
+}
+
+bool pixel_convert_frame(int retro_format, void* dst, size_t dst_pitch,
+                         const void* src, size_t src_pitch, unsigned width, unsigned height) {
+    pixel_row_fn fn = pixel_convert_row(retro_format);
+    if (!fn) return false;
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    for (unsigned y = 0; y < height; ++y) {
+        fn(d + y * dst_pitch, s + y * src_pitch, width);
+    }
+    return true;
+}
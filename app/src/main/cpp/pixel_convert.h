@@ -0,0 +1,39 @@
+// pixel_convert.h
+// Conversion of libretro pixel formats (0RGB1555, XRGB8888, RGB565) to RGBA8888 as expected by
+// WINDOW_FORMAT_RGBA_8888 (bytes R, G, B, A in memory). Scalar, SSE2, AVX2 and NEON kernels exist;
+// the best one the CPU supports is picked once by pixel_convert_init().
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum pixel_isa {
+    PIXEL_ISA_SCALAR = 0,
+    PIXEL_ISA_SSE2,
+    PIXEL_ISA_AVX2,
+    PIXEL_ISA_NEON,
+    PIXEL_ISA_COUNT
+};
+
+// Converts one row of `pixels` pixels. dst and src need no particular alignment.
+typedef void (*pixel_row_fn)(void* dst, const void* src, unsigned pixels);
+
+// Select kernels for this CPU. Cheap and idempotent; until called the scalar kernels are used.
+void pixel_convert_init();
+
+// Kernel currently selected for a RETRO_PIXEL_FORMAT_*, or nullptr for unknown formats.
+pixel_row_fn pixel_convert_row(int retro_format);
+
+// Kernel of a given ISA, or nullptr if it was not compiled in or the CPU lacks support.
+// Used by the benchmark to check every kernel against the scalar reference.
+pixel_row_fn pixel_convert_kernel(pixel_isa isa, int retro_format);
+
+const char* pixel_isa_name(pixel_isa isa);
+
+// ISA of the selected kernels.
+pixel_isa pixel_convert_selected_isa();
+
+// Convert a whole frame row by row. Returns false for unknown formats.
+bool pixel_convert_frame(int retro_format, void* dst, size_t dst_pitch,
+                         const void* src, size_t src_pitch, unsigned width, unsigned height);
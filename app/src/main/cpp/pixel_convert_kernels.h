@@ -0,0 +1,49 @@
+// pixel_convert_kernels.h
+// Per-ISA row kernels behind pixel_convert.h. Only pixel_convert*.cpp include this.
+//
+// Channel expansion replicates the top bits (x5 -> x5 << 3 | x5 >> 2, x6 -> x6 << 2 | x6 >> 4), so
+// full intensity maps to 0xFF. Every SIMD kernel must be bit-exact with the scalar one.
+
+#pragma once
+
+#include <cstdint>
+
+void rgb565_to_rgba_scalar(void* dst, const void* src, unsigned pixels);
+void argb1555_to_rgba_scalar(void* dst, const void* src, unsigned pixels);
+void xrgb8888_to_rgba_scalar(void* dst, const void* src, unsigned pixels);
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXEL_CONVERT_HAVE_X86 1
+void rgb565_to_rgba_sse2(void* dst, const void* src, unsigned pixels);
+void argb1555_to_rgba_sse2(void* dst, const void* src, unsigned pixels);
+void xrgb8888_to_rgba_sse2(void* dst, const void* src, unsigned pixels);
+void rgb565_to_rgba_avx2(void* dst, const void* src, unsigned pixels);
+void argb1555_to_rgba_avx2(void* dst, const void* src, unsigned pixels);
+void xrgb8888_to_rgba_avx2(void* dst, const void* src, unsigned pixels);
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PIXEL_CONVERT_HAVE_NEON 1
+void rgb565_to_rgba_neon(void* dst, const void* src, unsigned pixels);
+void argb1555_to_rgba_neon(void* dst, const void* src, unsigned pixels);
+void xrgb8888_to_rgba_neon(void* dst, const void* src, unsigned pixels);
+#endif
+
+static inline uint32_t pack_rgba(uint32_t r, uint32_t g, uint32_t b) {
+    // little endian: bytes R, G, B, A
+    return r | (g << 8) | (b << 16) | 0xFF000000u;
+}
+
+static inline uint32_t rgb565_to_rgba_pixel(uint16_t p) {
+    uint32_t r = p >> 11, g = (p >> 5) & 0x3F, b = p & 0x1F;
+    return pack_rgba((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+static inline uint32_t argb1555_to_rgba_pixel(uint16_t p) {
+    uint32_t r = (p >> 10) & 0x1F, g = (p >> 5) & 0x1F, b = p & 0x1F;
+    return pack_rgba((r << 3) | (r >> 2), (g << 3) | (g >> 2), (b << 3) | (b >> 2));
+}
+
+static inline uint32_t xrgb8888_to_rgba_pixel(uint32_t p) {
+    return pack_rgba((p >> 16) & 0xFF, (p >> 8) & 0xFF, p & 0xFF);
+}
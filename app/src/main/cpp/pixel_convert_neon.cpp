@@ -0,0 +1,70 @@
+// pixel_convert_neon.cpp
+// NEON row kernels (arm64-v8a, and armeabi-v7a builds with NEON enabled, the NDK default).
+// The 16-bit formats use narrowing shifts to pull each channel into its own 8-bit lane, then
+// an interleaving vst4 writes R, G, B, A.
+
+#include "pixel_convert_kernels.h"
+
+#ifdef PIXEL_CONVERT_HAVE_NEON
+
+#include <arm_neon.h>
+
+void rgb565_to_rgba_neon(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    const uint8x8_t alpha = vdup_n_u8(0xFF);
+    unsigned i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        uint16x8_t p = vreinterpretq_u16_u8(vld1q_u8(s + i * 2));
+        uint8x8_t r = vand_u8(vshrn_n_u16(p, 8), vdup_n_u8(0xF8));
+        uint8x8_t g = vand_u8(vshrn_n_u16(p, 3), vdup_n_u8(0xFC));
+        uint8x8_t b = vmovn_u16(vshlq_n_u16(p, 3));
+        uint8x8x4_t o;
+        o.val[0] = vorr_u8(r, vshr_n_u8(r, 5));
+        o.val[1] = vorr_u8(g, vshr_n_u8(g, 6));
+        o.val[2] = vorr_u8(b, vshr_n_u8(b, 5));
+        o.val[3] = alpha;
+        vst4_u8(d + i * 4, o);
+    }
+    rgb565_to_rgba_scalar(d + i * 4, s + i * 2, pixels - i);
+}
+
+void argb1555_to_rgba_neon(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    const uint8x8_t alpha = vdup_n_u8(0xFF);
+    const uint8x8_t m5 = vdup_n_u8(0xF8);
+    unsigned i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        uint16x8_t p = vreinterpretq_u16_u8(vld1q_u8(s + i * 2));
+        uint8x8_t r = vand_u8(vshrn_n_u16(p, 7), m5);
+        uint8x8_t g = vand_u8(vshrn_n_u16(p, 2), m5);
+        uint8x8_t b = vmovn_u16(vshlq_n_u16(p, 3));
+        uint8x8x4_t o;
+        o.val[0] = vorr_u8(r, vshr_n_u8(r, 5));
+        o.val[1] = vorr_u8(g, vshr_n_u8(g, 5));
+        o.val[2] = vorr_u8(b, vshr_n_u8(b, 5));
+        o.val[3] = alpha;
+        vst4_u8(d + i * 4, o);
+    }
+    argb1555_to_rgba_scalar(d + i * 4, s + i * 2, pixels - i);
+}
+
+void xrgb8888_to_rgba_neon(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    const uint8x16_t alpha = vdupq_n_u8(0xFF);
+    unsigned i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x4_t p = vld4q_u8(s + i * 4); // B, G, R, X
+        uint8x16x4_t o;
+        o.val[0] = p.val[2];
+        o.val[1] = p.val[1];
+        o.val[2] = p.val[0];
+        o.val[3] = alpha;
+        vst4q_u8(d + i * 4, o);
+    }
+    xrgb8888_to_rgba_scalar(d + i * 4, s + i * 4, pixels - i);
+}
+
+#endif // PIXEL_CONVERT_HAVE_NEON
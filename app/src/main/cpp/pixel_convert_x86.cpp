@@ -0,0 +1,147 @@
+// pixel_convert_x86.cpp
+// SSE2 and AVX2 row kernels. AVX2 is compiled with a function-level target attribute so the rest
+// of the build keeps the baseline ISA; pixel_convert_init() only selects it after detection.
+
+#include "pixel_convert_kernels.h"
+
+#ifdef PIXEL_CONVERT_HAVE_X86
+
+#include <immintrin.h>
+
+#define SSE2_FN __attribute__((target("sse2")))
+#define AVX2_FN __attribute__((target("avx2")))
+
+// ---------------------------
+// SSE2
+// ---------------------------
+
+// r, g, b hold one expanded 8-bit channel per 16-bit lane; writes 8 RGBA pixels.
+SSE2_FN static inline void store_rgba_sse2(uint8_t* d, __m128i r, __m128i g, __m128i b) {
+    __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+    __m128i ba = _mm_or_si128(b, _mm_set1_epi16((short)0xFF00));
+    _mm_storeu_si128((__m128i*)d, _mm_unpacklo_epi16(rg, ba));
+    _mm_storeu_si128((__m128i*)(d + 16), _mm_unpackhi_epi16(rg, ba));
+}
+
+SSE2_FN static inline __m128i expand5_sse2(__m128i x) {
+    return _mm_or_si128(_mm_slli_epi16(x, 3), _mm_srli_epi16(x, 2));
+}
+
+SSE2_FN void rgb565_to_rgba_sse2(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    const __m128i m5 = _mm_set1_epi16(0x1F);
+    const __m128i m6 = _mm_set1_epi16(0x3F);
+    unsigned i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(s + i * 2));
+        __m128i r = _mm_srli_epi16(p, 11);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), m6);
+        __m128i b = _mm_and_si128(p, m5);
+        g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+        store_rgba_sse2(d + i * 4, expand5_sse2(r), g, expand5_sse2(b));
+    }
+    rgb565_to_rgba_scalar(d + i * 4, s + i * 2, pixels - i);
+}
+
+SSE2_FN void argb1555_to_rgba_sse2(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    const __m128i m5 = _mm_set1_epi16(0x1F);
+    unsigned i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(s + i * 2));
+        __m128i r = _mm_and_si128(_mm_srli_epi16(p, 10), m5);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), m5);
+        __m128i b = _mm_and_si128(p, m5);
+        store_rgba_sse2(d + i * 4, expand5_sse2(r), expand5_sse2(g), expand5_sse2(b));
+    }
+    argb1555_to_rgba_scalar(d + i * 4, s + i * 2, pixels - i);
+}
+
+SSE2_FN void xrgb8888_to_rgba_sse2(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    const __m128i mrb = _mm_set1_epi32(0x00FF00FF);
+    const __m128i mg = _mm_set1_epi32(0x0000FF00);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    unsigned i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(s + i * 4));
+        __m128i rb = _mm_and_si128(p, mrb);
+        __m128i br = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+        __m128i o = _mm_or_si128(_mm_or_si128(br, _mm_and_si128(p, mg)), alpha);
+        _mm_storeu_si128((__m128i*)(d + i * 4), o);
+    }
+    xrgb8888_to_rgba_scalar(d + i * 4, s + i * 4, pixels - i);
+}
+
+// ---------------------------
+// AVX2
+// ---------------------------
+
+// Same as store_rgba_sse2 for 16 pixels. unpack works per 128-bit lane, so the halves are
+// re-ordered with permute2x128 before storing.
+AVX2_FN static inline void store_rgba_avx2(uint8_t* d, __m256i r, __m256i g, __m256i b) {
+    __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+    __m256i ba = _mm256_or_si256(b, _mm256_set1_epi16((short)0xFF00));
+    __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+    __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+    _mm256_storeu_si256((__m256i*)d, _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i*)(d + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+AVX2_FN static inline __m256i expand5_avx2(__m256i x) {
+    return _mm256_or_si256(_mm256_slli_epi16(x, 3), _mm256_srli_epi16(x, 2));
+}
+
+AVX2_FN void rgb565_to_rgba_avx2(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    const __m256i m5 = _mm256_set1_epi16(0x1F);
+    const __m256i m6 = _mm256_set1_epi16(0x3F);
+    unsigned i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(s + i * 2));
+        __m256i r = _mm256_srli_epi16(p, 11);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi16(p, 5), m6);
+        __m256i b = _mm256_and_si256(p, m5);
+        g = _mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4));
+        store_rgba_avx2(d + i * 4, expand5_avx2(r), g, expand5_avx2(b));
+    }
+    rgb565_to_rgba_sse2(d + i * 4, s + i * 2, pixels - i);
+}
+
+AVX2_FN void argb1555_to_rgba_avx2(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    const __m256i m5 = _mm256_set1_epi16(0x1F);
+    unsigned i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(s + i * 2));
+        __m256i r = _mm256_and_si256(_mm256_srli_epi16(p, 10), m5);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi16(p, 5), m5);
+        __m256i b = _mm256_and_si256(p, m5);
+        store_rgba_avx2(d + i * 4, expand5_avx2(r), expand5_avx2(g), expand5_avx2(b));
+    }
+    argb1555_to_rgba_sse2(d + i * 4, s + i * 2, pixels - i);
+}
+
+AVX2_FN void xrgb8888_to_rgba_avx2(void* dst, const void* src, unsigned pixels) {
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    // BGRX -> RGB_, alpha OR'ed in afterwards
+    const __m256i shuf = _mm256_setr_epi8(
+        2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1,
+        2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1);
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+    unsigned i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(s + i * 4));
+        __m256i o = _mm256_or_si256(_mm256_shuffle_epi8(p, shuf), alpha);
+        _mm256_storeu_si256((__m256i*)(d + i * 4), o);
+    }
+    xrgb8888_to_rgba_sse2(d + i * 4, s + i * 4, pixels - i);
+}
+
+#endif // PIXEL_CONVERT_HAVE_X86
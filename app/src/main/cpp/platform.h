@@ -0,0 +1,92 @@
+// platform.h
+// Thin platform layer used by the runtime: logging and the ANativeWindow surface.
+// On Android this is the NDK itself. On the Linux host build the same API is backed by
+// host/host_platform.cpp (stderr log sink, in-memory window) so the loader can run headless.
+// LOG* go through the asynchronous log (async_log.h) on both; LOGD is filtered out by default.
+
+#pragma once
+
+#include <cstdint>
+
+#include "async_log.h"
+
+#define LOGD(...) log_write(LOG_LEVEL_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) log_write(LOG_LEVEL_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) log_write(LOG_LEVEL_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) log_write(LOG_LEVEL_ERROR, LOG_TAG, __VA_ARGS__)
+
+#ifdef __ANDROID__
+
+#include <android/log.h>
+#include <android/native_window.h>
+
+#else
+
+enum {
+    HOST_LOG_DEBUG = 3,
+    HOST_LOG_INFO = 4,
+    HOST_LOG_WARN = 5,
+    HOST_LOG_ERROR = 6
+};
+
+// Same layout and values as <android/native_window.h>
+enum {
+    WINDOW_FORMAT_RGBA_8888 = 1,
+    WINDOW_FORMAT_RGBX_8888 = 2,
+    WINDOW_FORMAT_RGB_565 = 4
+};
+
+typedef struct ARect {
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+} ARect;
+
+typedef struct ANativeWindow_Buffer {
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+    int32_t format;
+    void* bits;
+    uint32_t reserved[6];
+} ANativeWindow_Buffer;
+
+typedef struct ANativeWindow ANativeWindow;
+
+// Called from ANativeWindow_unlockAndPost with the buffer that is being posted.
+typedef void (*host_window_post_fn)(const ANativeWindow_Buffer* buf, void* user);
+
+struct host_window_stats {
+    uint64_t geometry_calls;   // ANativeWindow_setBuffersGeometry calls
+    uint64_t reallocations;    // backing store reallocations
+    uint64_t locks;
+    uint64_t posts;
+};
+
+extern "C" {
+
+void host_log_print(int prio, const char* tag, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+void host_log_set_min_level(int prio);
+
+int32_t ANativeWindow_setBuffersGeometry(ANativeWindow* window, int32_t width, int32_t height, int32_t format);
+int32_t ANativeWindow_lock(ANativeWindow* window, ANativeWindow_Buffer* outBuffer, ARect* inOutDirtyBounds);
+int32_t ANativeWindow_unlockAndPost(ANativeWindow* window);
+void ANativeWindow_acquire(ANativeWindow* window);
+void ANativeWindow_release(ANativeWindow* window);
+
+// Host-only helpers. A new window starts with one reference, like ANativeWindow_fromSurface.
+ANativeWindow* host_window_create();
+void host_window_set_post_hook(ANativeWindow* window, host_window_post_fn fn, void* user);
+void host_window_get_stats(ANativeWindow* window, host_window_stats* out);
+
+// Host audio sink (host/host_audio.cpp): consumes audio in real time like a device would and,
+// if a path is set before the sink opens, records it to a WAV file.
+void host_audio_set_wav_path(const char* path);
+// Simulated device: open at rate Hz (0: the source rate) with the clock running skew_ppm fast.
+void host_audio_set_device(unsigned rate, double skew_ppm);
+
+} // extern "C"
+
+#endif
@@ -0,0 +1,214 @@
+// resampler.cpp
+// Linear and windowed-sinc stereo resampling kernels and the dynamic rate controller.
+
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define RESAMPLER_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RESAMPLER_NEON 1
+#endif
+
+static const unsigned kPhaseBits = 8;
+static const unsigned kPhases = 1u << kPhaseBits;
+static const double kKaiserBeta = 7.0;
+// Passband edge relative to the lower Nyquist frequency; the rest is the transition band.
+static const double kSincCutoff = 0.92;
+
+const char* resampler_quality_name(int quality) {
+    switch (quality) {
+        case RESAMPLER_LINEAR: return "linear";
+        case RESAMPLER_SINC16: return "sinc16";
+        case RESAMPLER_SINC32: return "sinc32";
+        default: return "?";
+    }
+}
+
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 64; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+static inline int16_t to_s16(float v) {
+    float s = v * 32768.0f;
+    if (s > 32767.0f) s = 32767.0f;
+    if (s < -32768.0f) s = -32768.0f;
+    return (int16_t)lrintf(s);
+}
+
+// out[0..1] = a + (b - a) * f, where a and b are the adjacent stereo frames at in
+static inline void linear_frame(const float* in, float f, float* out) {
+#if RESAMPLER_SSE
+    __m128 v = _mm_loadu_ps(in);                 // L0 R0 L1 R1
+    __m128 hi = _mm_movehl_ps(v, v);             // L1 R1
+    __m128 r = _mm_add_ps(v, _mm_mul_ps(_mm_sub_ps(hi, v), _mm_set1_ps(f)));
+    _mm_storel_pi((__m64*)out, r);
+#elif RESAMPLER_NEON
+    float32x2_t a = vld1_f32(in), b = vld1_f32(in + 2);
+    vst1_f32(out, vmla_n_f32(a, vsub_f32(b, a), f));
+#else
+    out[0] = in[0] + (in[2] - in[0]) * f;
+    out[1] = in[1] + (in[3] - in[1]) * f;
+#endif
+}
+
+// Stereo dot product of taps frames at in with the phase rows r0/r1 blended by pf.
+static inline void sinc_frame(const float* in, const float* r0, const float* r1, float pf, unsigned taps,
+                              float* out) {
+    const unsigned n = taps * 2;
+#if RESAMPLER_SSE
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    const __m128 vf = _mm_set1_ps(pf);
+    for (unsigned k = 0; k < n; k += 8) {
+        __m128 c0 = _mm_loadu_ps(r0 + k), d0 = _mm_loadu_ps(r1 + k);
+        __m128 c1 = _mm_loadu_ps(r0 + k + 4), d1 = _mm_loadu_ps(r1 + k + 4);
+        c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_sub_ps(d0, c0), vf));
+        c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_sub_ps(d1, c1), vf));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(in + k), c0));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(in + k + 4), c1));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);                     // L R L R
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    _mm_storel_pi((__m64*)out, acc);
+#elif RESAMPLER_NEON
+    float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+    for (unsigned k = 0; k < n; k += 8) {
+        float32x4_t c0 = vld1q_f32(r0 + k), d0 = vld1q_f32(r1 + k);
+        float32x4_t c1 = vld1q_f32(r0 + k + 4), d1 = vld1q_f32(r1 + k + 4);
+        c0 = vmlaq_n_f32(c0, vsubq_f32(d0, c0), pf);
+        c1 = vmlaq_n_f32(c1, vsubq_f32(d1, c1), pf);
+        acc0 = vmlaq_f32(acc0, vld1q_f32(in + k), c0);
+        acc1 = vmlaq_f32(acc1, vld1q_f32(in + k + 4), c1);
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+    vst1_f32(out, vadd_f32(vget_low_f32(acc), vget_high_f32(acc)));
+#else
+    float l = 0.0f, r = 0.0f;
+    for (unsigned k = 0; k < n; k += 2) {
+        float c = r0[k] + (r1[k] - r0[k]) * pf;
+        l += in[k] * c;
+        r += in[k + 1] * c;
+    }
+    out[0] = l;
+    out[1] = r;
+#endif
+}
+
+void Resampler::build_table(double cutoff) {
+    const unsigned half = taps_ / 2;
+    table_.assign((size_t)(kPhases + 1) * taps_ * 2, 0.0f);
+    const double i0b = bessel_i0(kKaiserBeta);
+    std::vector<double> row(taps_);
+    for (unsigned p = 0; p <= kPhases; ++p) {
+        const double frac = (double)p / kPhases;
+        double sum = 0.0;
+        for (unsigned k = 0; k < taps_; ++k) {
+            double x = (double)k - (half - 1) - frac;   // input position minus output position
+            double sinc = x == 0.0 ? 1.0 : std::sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+            double w = x / half;
+            double win = std::fabs(w) >= 1.0 ? 0.0 : bessel_i0(kKaiserBeta * std::sqrt(1.0 - w * w)) / i0b;
+            row[k] = sinc * win;
+            sum += row[k];
+        }
+        float* dst = &table_[(size_t)p * taps_ * 2];
+        for (unsigned k = 0; k < taps_; ++k) {
+            dst[k * 2] = dst[k * 2 + 1] = (float)(row[k] / sum); // unity DC gain per phase
+        }
+    }
+}
+
+void Resampler::init(int quality, double in_rate, double out_rate) {
+    quality_ = (quality >= 0 && quality < RESAMPLER_QUALITY_COUNT) ? quality : RESAMPLER_LINEAR;
+    taps_ = quality_ == RESAMPLER_SINC32 ? 32 : quality_ == RESAMPLER_SINC16 ? 16 : 2;
+    nominal_step_ = (in_rate > 0 && out_rate > 0) ? in_rate / out_rate : 1.0;
+    if (quality_ != RESAMPLER_LINEAR) build_table(kSincCutoff * std::min(1.0, 1.0 / nominal_step_));
+    set_step_factor(1.0);
+    reset();
+}
+
+void Resampler::reset() {
+    const size_t pad = taps_ / 2 - 1;
+    hist_.assign(pad * 2, 0.0f);
+    hist_frames_ = pad;
+    pos_ = (uint64_t)pad << 32;
+}
+
+void Resampler::set_step_factor(double factor) {
+    step_ = (uint64_t)(nominal_step_ * factor * 4294967296.0 + 0.5);
+}
+
+size_t Resampler::input_needed(size_t out_frames) const {
+    if (!out_frames) return 0;
+    uint64_t last = pos_ + (uint64_t)(out_frames - 1) * step_;
+    size_t need = (size_t)(last >> 32) + taps_ / 2 + 1;
+    return need > hist_frames_ ? need - hist_frames_ : 0;
+}
+
+void Resampler::push(const int16_t* in, size_t frames) {
+    size_t at = hist_frames_ * 2;
+    if (hist_.size() < at + frames * 2) hist_.resize(at + frames * 2);
+    const float scale = 1.0f / 32768.0f;
+    for (size_t i = 0; i < frames * 2; ++i) hist_[at + i] = in[i] * scale;
+    hist_frames_ += frames;
+}
+
+size_t Resampler::pull(int16_t* out, size_t frames) {
+    const unsigned half = taps_ / 2;
+    size_t produced = 0;
+    float pair[2];
+    while (produced < frames) {
+        size_t i = (size_t)(pos_ >> 32);
+        if (i + half >= hist_frames_) break;
+        uint32_t frac = (uint32_t)pos_;
+        if (quality_ == RESAMPLER_LINEAR) {
+            linear_frame(&hist_[i * 2], (float)(frac * (1.0 / 4294967296.0)), pair);
+        } else {
+            unsigned ph = frac >> (32 - kPhaseBits);
+            float pf = (float)((frac & ((1u << (32 - kPhaseBits)) - 1)) * (1.0 / (1u << (32 - kPhaseBits))));
+            const float* r0 = &table_[(size_t)ph * taps_ * 2];
+            sinc_frame(&hist_[(i + 1 - half) * 2], r0, r0 + taps_ * 2, pf, taps_, pair);
+        }
+        out[produced * 2] = to_s16(pair[0]);
+        out[produced * 2 + 1] = to_s16(pair[1]);
+        ++produced;
+        pos_ += step_;
+    }
+
+    // Drop input no future output can reach.
+    size_t keep_from = (size_t)(pos_ >> 32) + 1 - half;
+    if (keep_from > hist_frames_) keep_from = hist_frames_;
+    if (keep_from) {
+        memmove(hist_.data(), hist_.data() + keep_from * 2, (hist_frames_ - keep_from) * 2 * sizeof(float));
+        hist_frames_ -= keep_from;
+        pos_ -= (uint64_t)keep_from << 32;
+    }
+    return produced;
+}
+
+void RateController::init(size_t target, double max_delta) {
+    target_ = target ? (double)target : 1.0;
+    max_delta_ = max_delta;
+    fill_ = -1.0;
+    factor_ = 1.0;
+}
+
+double RateController::update(size_t fill) {
+    // The core delivers audio a whole video frame at a time; smoothing over a few frames keeps
+    // that sawtooth out of the pitch.
+    fill_ = fill_ < 0 ? (double)fill : fill_ + ((double)fill - fill_) * 0.02;
+    double direction = (fill_ - target_) / target_;
+    direction = std::max(-1.0, std::min(1.0, direction));
+    factor_ = 1.0 + max_delta_ * direction;
+    return factor_;
+}
@@ -0,0 +1,79 @@
+// resampler.h
+// Audio resampling from the core's sample rate to the device rate, with dynamic rate control.
+//
+// The core's audio clock is slaved to the video frame rate, the device's to its own crystal, so
+// even with nominally equal rates the ring between them slowly fills or drains. RateController
+// nudges the resampling step by at most a fraction of a percent based on ring fill (inaudible as
+// pitch), which keeps the fill near its target indefinitely.
+//
+// Kernels, by quality level:
+//   RESAMPLER_LINEAR   two-tap linear interpolation
+//   RESAMPLER_SINC16   16-tap Kaiser-windowed sinc, polyphase with interpolated phases
+//   RESAMPLER_SINC32   32-tap Kaiser-windowed sinc
+// Samples are processed as float stereo pairs, two frames or two taps per 128-bit vector (SSE on
+// x86, NEON on ARM, both baseline for the targets we build).
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum resampler_quality {
+    RESAMPLER_LINEAR = 0,
+    RESAMPLER_SINC16 = 1,
+    RESAMPLER_SINC32 = 2,
+    RESAMPLER_QUALITY_COUNT
+};
+
+const char* resampler_quality_name(int quality);
+
+class Resampler {
+public:
+    void init(int quality, double in_rate, double out_rate);
+    void reset();   // drop buffered input, keep configuration
+
+    int quality() const { return quality_; }
+
+    // Multiply the nominal step (input frames per output frame) by factor; from RateController.
+    void set_step_factor(double factor);
+
+    // Additional input frames push() needs before pull() can produce out_frames.
+    size_t input_needed(size_t out_frames) const;
+
+    void push(const int16_t* in, size_t frames);
+
+    // Produce up to frames frames of interleaved stereo output. Returns the number produced.
+    size_t pull(int16_t* out, size_t frames);
+
+private:
+    void build_table(double cutoff);
+
+    int quality_ = RESAMPLER_LINEAR;
+    unsigned taps_ = 2;
+    double nominal_step_ = 1.0;
+    uint64_t step_ = 1ull << 32;       // 32.32 fixed point, input frames per output frame
+    uint64_t pos_ = 0;                 // 32.32 fixed point position in hist_
+    std::vector<float> hist_;          // interleaved stereo input, left-padded by taps_/2 - 1
+    size_t hist_frames_ = 0;
+    std::vector<float> table_;         // (kPhases + 1) rows of taps_ * 2 (coefficient per channel)
+};
+
+// Proportional controller on a smoothed fill level.
+class RateController {
+public:
+    // target: desired ring fill in frames; max_delta: largest step adjustment (e.g. 0.005).
+    void init(size_t target, double max_delta);
+
+    // Feed the current fill once per output burst; returns the step factor for the resampler.
+    double update(size_t fill);
+
+    double factor() const { return factor_; }
+    double smoothed_fill() const { return fill_; }
+
+private:
+    double target_ = 1.0;
+    double max_delta_ = 0.005;
+    double fill_ = -1.0;
+    double factor_ = 1.0;
+};
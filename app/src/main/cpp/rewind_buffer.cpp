@@ -0,0 +1,149 @@
+// rewind_buffer.cpp
+// XOR-delta + zero-run encoding of savestates and the byte ring that holds them.
+//
+// Encoded delta: a sequence of (varint zero_words, varint literal_words, literal_words * 8 bytes)
+// tokens covering the whole state. Literal words are the XOR of the two states.
+
+#include "rewind_buffer.h"
+
+#include <cstring>
+
+static inline uint8_t* put_varint(uint8_t* p, size_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static inline bool get_varint(const uint8_t*& p, const uint8_t* end, size_t& v) {
+    v = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t b = *p++;
+        v |= (size_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+size_t rewind_delta_bound(size_t state_size) {
+    size_t words = (state_size + 7) / 8;
+    // alternating single zero / single literal words is the worst case: 2 one-byte varints per literal
+    return words * 8 + (words / 2 + 1) * 2 * 10;
+}
+
+size_t rewind_delta_encode(uint8_t* out, const uint64_t* a, const uint64_t* b, size_t words) {
+    uint8_t* p = out;
+    size_t i = 0;
+    while (i < words) {
+        size_t z = i;
+        while (z < words && a[z] == b[z]) ++z;
+        size_t l = z;
+        while (l < words && a[l] != b[l]) ++l;
+        p = put_varint(p, z - i);
+        p = put_varint(p, l - z);
+        for (size_t k = z; k < l; ++k) {
+            uint64_t x = a[k] ^ b[k];
+            memcpy(p, &x, 8);
+            p += 8;
+        }
+        i = l;
+    }
+    return (size_t)(p - out);
+}
+
+bool rewind_delta_apply(uint64_t* state, size_t words, const uint8_t* in, size_t size) {
+    const uint8_t* p = in;
+    const uint8_t* end = in + size;
+    size_t i = 0;
+    while (p < end) {
+        size_t zeros, lits;
+        if (!get_varint(p, end, zeros) || !get_varint(p, end, lits)) return false;
+        if (zeros > words - i || lits > words - i - zeros || lits * 8 > (size_t)(end - p)) return false;
+        i += zeros;
+        for (size_t k = 0; k < lits; ++k, ++i, p += 8) {
+            uint64_t x;
+            memcpy(&x, p, 8);
+            state[i] ^= x;
+        }
+    }
+    return i == words;
+}
+
+void RewindBuffer::configure(size_t state_size, size_t budget) {
+    state_size_ = state_size;
+    words_ = (state_size + 7) / 8;
+    current_.assign(words_, 0);
+    incoming_.assign(words_, 0);
+    scratch_.resize(rewind_delta_bound(state_size));
+    ring_.assign(budget, 0); // touch the pages now rather than on the emulation thread later
+    clear();
+}
+
+void RewindBuffer::clear() {
+    have_current_ = false;
+    entries_.clear();
+    head_ = 0;
+    used_ = 0;
+}
+
+// Reserve n contiguous bytes at the head of the ring, evicting the oldest entries in the way.
+size_t RewindBuffer::place(size_t n) {
+    size_t pos = head_;
+    if (pos + n > ring_.size()) {
+        // wrap: entries in the unused tail are the oldest ones, drop them first
+        while (!entries_.empty() && entries_.front().offset >= head_) {
+            used_ -= entries_.front().size;
+            entries_.pop_front();
+        }
+        pos = 0;
+    }
+    while (!entries_.empty()) {
+        const entry& e = entries_.front();
+        if (e.offset >= pos + n || e.offset + e.size <= pos) break;
+        used_ -= e.size;
+        entries_.pop_front();
+    }
+    return pos;
+}
+
+void RewindBuffer::push(const void* state) {
+    if (!words_) return;
+    incoming_[words_ - 1] = 0; // padding bytes past state_size_ stay zero
+    memcpy(incoming_.data(), state, state_size_);
+    if (!have_current_) {
+        current_.swap(incoming_);
+        have_current_ = true;
+        return;
+    }
+
+    size_t n = rewind_delta_encode(scratch_.data(), incoming_.data(), current_.data(), words_);
+    if (n > ring_.size()) {
+        // a single delta larger than the budget: history cannot be kept across this jump
+        entries_.clear();
+        head_ = 0;
+        used_ = 0;
+    } else if (n) {
+        size_t pos = place(n);
+        memcpy(ring_.data() + pos, scratch_.data(), n);
+        entries_.push_back({pos, n});
+        head_ = pos + n;
+        used_ += n;
+    }
+    current_.swap(incoming_);
+}
+
+bool RewindBuffer::pop(void* out) {
+    if (entries_.empty()) return false;
+    entry e = entries_.back();
+    entries_.pop_back();
+    used_ -= e.size;
+    head_ = e.offset;
+    if (!rewind_delta_apply(current_.data(), words_, ring_.data() + e.offset, e.size)) {
+        clear();
+        return false;
+    }
+    memcpy(out, current_.data(), state_size_);
+    return true;
+}
@@ -0,0 +1,62 @@
+// rewind_buffer.h
+// History of retro_serialize snapshots for rewind, kept within a fixed memory budget.
+//
+// Only the newest state is held in full. Each push stores the XOR of the new state against the
+// previous one, run-length encoded over 64-bit words: consecutive emulator states differ in a few
+// bytes, so a delta is mostly zero words and compresses to a small fraction of the state size.
+// Deltas live in one preallocated byte ring; when it is full the oldest history is evicted. Popping
+// applies the newest delta to the current state, which yields the state captured before it.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class RewindBuffer {
+public:
+    // Reset the history for states of state_size bytes, keeping at most budget bytes of deltas.
+    void configure(size_t state_size, size_t budget);
+    void clear();
+
+    size_t state_size() const { return state_size_; }
+    size_t budget() const { return ring_.size(); }
+
+    // Record a new state (state_size bytes). The first push after clear() only sets the baseline.
+    void push(const void* state);
+
+    // Step back to the previously pushed state and copy it to out. False when no history is left.
+    bool pop(void* out);
+
+    size_t depth() const { return entries_.size(); }  // states that pop() can still return
+    size_t bytes_used() const { return used_; }        // compressed deltas currently held
+
+private:
+    struct entry {
+        size_t offset;
+        size_t size;
+    };
+
+    size_t place(size_t n);
+
+    size_t state_size_ = 0;
+    size_t words_ = 0;
+    bool have_current_ = false;
+    std::vector<uint64_t> current_;  // newest state, zero padded to whole words
+    std::vector<uint64_t> incoming_;
+    std::vector<uint8_t> scratch_;   // worst-case sized encode buffer
+    std::vector<uint8_t> ring_;
+    std::deque<entry> entries_;      // oldest first
+    size_t head_ = 0;                // next write offset in ring_
+    size_t used_ = 0;
+};
+
+// Worst-case encoded size of a delta between two states of state_size bytes.
+size_t rewind_delta_bound(size_t state_size);
+
+// Encode a ^ b over words 64-bit words into out; returns the encoded size.
+size_t rewind_delta_encode(uint8_t* out, const uint64_t* a, const uint64_t* b, size_t words);
+
+// XOR an encoded delta into state (words 64-bit words). False if the data is malformed.
+bool rewind_delta_apply(uint64_t* state, size_t words, const uint8_t* in, size_t size);
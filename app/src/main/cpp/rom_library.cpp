@@ -0,0 +1,518 @@
+// rom_library.cpp
+// Directory walk, parallel hashing, DAT matching and the on-disk index (see rom_library.h).
+
+#include "rom_library.h"
+#include "content_hash.h"
+#include "content_map.h"
+#include "platform.h"
+#include "zip_archive.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+
+#define LOG_TAG "RomLibrary"
+
+static const size_t kWindow = 64u << 20;      // mapped at a time; keeps 32-bit address space free
+static const size_t kChunk = 256u << 10;      // both hashes per chunk while it is in L2
+static const size_t kSmallFile = 64u << 10;   // below this one pread beats mmap + faults + munmap
+static const char kIndexMagic[8] = {'S', 'R', 'O', 'M', 'I', 'D', 'X', '1'};
+
+static uint64_t now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string lower_extension(const std::string& name) {
+    size_t dot = name.rfind('.');
+    size_t slash = name.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return "";
+    std::string ext = name.substr(dot + 1);
+    for (char& c : ext) c = (char)tolower((unsigned char)c);
+    return ext;
+}
+
+static std::string stem(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+    size_t dot = name.rfind('.');
+    return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+// Frontend and metadata files that live next to content
+static bool is_content_file(const std::string& name) {
+    static const char* const kSkip[] = {"dat", "xml", "txt", "nfo", "md", "pdf", "srm", "sav", "rtc",
+                                        "png", "jpg", "jpeg", "cfg", "so", "idx", "tmp"};
+    std::string ext = lower_extension(name);
+    if (ext.compare(0, 5, "state") == 0) return false;
+    for (const char* s : kSkip)
+        if (ext == s) return false;
+    return true;
+}
+
+// ---------------------------
+// Hashing
+// ---------------------------
+
+static void hash_bytes(const uint8_t* p, size_t n, uint32_t* crc, Sha1* sha) {
+    for (size_t off = 0; off < n; off += kChunk) {
+        size_t len = std::min(kChunk, n - off);
+        *crc = content_crc32(*crc, p + off, len);
+        sha->update(p + off, len);
+    }
+}
+
+static bool hash_plain(int fd, uint64_t size, rom_entry* e) {
+    uint32_t crc = 0;
+    Sha1 sha;
+    if (size < kSmallFile) {
+        uint8_t buf[kSmallFile];
+        size_t got = 0;
+        while (got < size) {
+            ssize_t r = pread(fd, buf + got, (size_t)size - got, (off_t)got);
+            if (r <= 0) return false;
+            got += (size_t)r;
+        }
+        hash_bytes(buf, got, &crc, &sha);
+    } else {
+        for (uint64_t off = 0; off < size; off += kWindow) {
+            size_t len = (size_t)std::min<uint64_t>(kWindow, size - off);
+            void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, (off_t)off);
+            if (p == MAP_FAILED) return false;
+            madvise(p, len, MADV_SEQUENTIAL);
+            hash_bytes((const uint8_t*)p, len, &crc, &sha);
+            munmap(p, len);
+        }
+    }
+    e->crc32 = crc;
+    sha.final(e->sha1);
+    e->content_size = size;
+    e->flags |= ROM_FLAG_SHA1;
+    return true;
+}
+
+static bool hash_zip(const char* path, rom_entry* e) {
+    ZipArchive zip;
+    if (!zip.open(path)) return false;
+    int idx = zip.pick(nullptr);
+    if (idx < 0) return false;
+    const zip_entry& z = zip.entries()[(size_t)idx];
+    e->crc32 = z.crc32;
+    e->content_size = z.size;
+    memset(e->sha1, 0, sizeof(e->sha1));
+    e->flags |= ROM_FLAG_ARCHIVE;
+    return true;
+}
+
+bool rom_hash_file(const char* path, rom_entry* e) {
+    e->flags = 0;
+    e->crc32 = 0;
+    e->content_size = 0;
+    memset(e->sha1, 0, sizeof(e->sha1));
+    e->system.clear();
+    e->title = stem(path);
+    if (lower_extension(path) == "zip" && archive_is_zip(path)) return hash_zip(path, e);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && hash_plain(fd, (uint64_t)st.st_size, e);
+    close(fd);
+    return ok;
+}
+
+// ---------------------------
+// DAT files
+// ---------------------------
+
+struct crc_key {
+    uint32_t crc;
+    uint64_t size;
+    bool operator==(const crc_key& o) const { return crc == o.crc && size == o.size; }
+};
+
+struct crc_key_hash {
+    size_t operator()(const crc_key& k) const { return (size_t)(k.size * 0x9E3779B97F4A7C15ull ^ k.crc); }
+};
+
+struct dat_record {
+    uint32_t system;
+    std::string title;
+};
+
+struct rom_database {
+    std::vector<std::string> systems;
+    std::vector<dat_record> records;
+    std::unordered_map<std::string, uint32_t> by_sha1;   // 20 raw bytes
+    std::unordered_map<crc_key, uint32_t, crc_key_hash> by_crc;
+};
+
+static std::string decode_entities(const char* p, const char* end) {
+    static const struct { const char* name; char c; } kEntities[] = {
+        {"&amp;", '&'}, {"&quot;", '"'}, {"&apos;", '\''}, {"&lt;", '<'}, {"&gt;", '>'}};
+    std::string out;
+    out.reserve((size_t)(end - p));
+    while (p < end) {
+        bool replaced = false;
+        if (*p == '&') {
+            for (const auto& e : kEntities) {
+                size_t n = strlen(e.name);
+                if ((size_t)(end - p) >= n && !memcmp(p, e.name, n)) {
+                    out += e.c;
+                    p += n;
+                    replaced = true;
+                    break;
+                }
+            }
+        }
+        if (!replaced) out += *p++;
+    }
+    return out;
+}
+
+// Value of attribute key inside a tag body [p, end), or false.
+static bool tag_attr(const char* p, const char* end, const char* key, std::string* out) {
+    const size_t klen = strlen(key);
+    while (p < end) {
+        while (p < end && isspace((unsigned char)*p)) ++p;
+        const char* k = p;
+        while (p < end && *p != '=' && !isspace((unsigned char)*p) && *p != '>') ++p;
+        const char* kend = p;
+        while (p < end && isspace((unsigned char)*p)) ++p;
+        if (p >= end || *p != '=') {
+            if (p == kend) ++p;
+            continue;
+        }
+        ++p;
+        while (p < end && isspace((unsigned char)*p)) ++p;
+        if (p >= end || (*p != '"' && *p != '\'')) return false;
+        const char quote = *p++;
+        const char* v = p;
+        while (p < end && *p != quote) ++p;
+        if ((size_t)(kend - k) == klen && !memcmp(k, key, klen)) {
+            *out = decode_entities(v, p);
+            return true;
+        }
+        ++p;
+    }
+    return false;
+}
+
+static bool parse_hex(const std::string& s, uint8_t* out, size_t n) {
+    if (s.size() != n * 2) return false;
+    for (size_t i = 0; i < n * 2; ++i) {
+        int c = tolower((unsigned char)s[i]);
+        int v = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+        if (v < 0) return false;
+        out[i / 2] = (uint8_t)(i & 1 ? out[i / 2] | v : v << 4);
+    }
+    return true;
+}
+
+// Logiqx XML: <header><name>System</name>...</header>, then <game name="..."> (or <machine>)
+// holding <rom name size crc sha1/> records. A hand-rolled tag scanner: DATs for large sets run to
+// tens of megabytes and only these few tags matter.
+static size_t load_dat(const char* path, rom_database* db) {
+    ContentMapping map;
+    if (!map.map(path)) return 0;
+    const char* p = (const char*)map.data();
+    const char* end = p + map.size();
+
+    const uint32_t system = (uint32_t)db->systems.size();
+    db->systems.push_back(stem(path));
+    bool in_header = false;
+    std::string title, value;
+    size_t added = 0;
+
+    while ((p = (const char*)memchr(p, '<', (size_t)(end - p))) != nullptr) {
+        ++p;
+        const char* name = p;
+        while (p < end && !isspace((unsigned char)*p) && *p != '>' && *p != '/') ++p;
+        const std::string tag(name, p);
+        const char* close = (const char*)memchr(p, '>', (size_t)(end - p));
+        if (!close) break;
+
+        if (tag == "header") {
+            in_header = true;
+        } else if (tag == "/header") {
+            in_header = false;
+        } else if (tag == "name" && in_header) {
+            const char* text = close + 1;
+            const char* text_end = (const char*)memchr(text, '<', (size_t)(end - text));
+            if (text_end && text_end > text) db->systems[system] = decode_entities(text, text_end);
+        } else if (tag == "game" || tag == "machine") {
+            if (!tag_attr(p, close, "name", &title)) title.clear();
+        } else if (tag == "rom" && !title.empty()) {
+            crc_key key = {0, 0};
+            uint8_t sha1[20];
+            bool has_crc = false, has_sha1 = false;
+            if (tag_attr(p, close, "size", &value)) key.size = strtoull(value.c_str(), nullptr, 10);
+            if (tag_attr(p, close, "crc", &value)) {
+                uint8_t c[4];
+                if ((has_crc = parse_hex(value, c, 4)))
+                    key.crc = (uint32_t)c[0] << 24 | (uint32_t)c[1] << 16 | (uint32_t)c[2] << 8 | c[3];
+            }
+            if (tag_attr(p, close, "sha1", &value)) has_sha1 = parse_hex(value, sha1, 20);
+            if (has_crc || has_sha1) {
+                const uint32_t idx = (uint32_t)db->records.size();
+                db->records.push_back({system, title});
+                if (has_sha1) db->by_sha1.emplace(std::string((const char*)sha1, 20), idx);
+                if (has_crc) db->by_crc.emplace(key, idx);
+                ++added;
+            }
+        }
+        p = close + 1;
+    }
+    return added;
+}
+
+static size_t load_dat_dir(const std::string& dir, rom_database* db) {
+    DIR* d = opendir(dir.c_str());
+    if (!d) return 0;
+    std::vector<std::string> files;
+    while (dirent* de = readdir(d)) {
+        std::string name = de->d_name;
+        std::string ext = lower_extension(name);
+        if (name[0] != '.' && (ext == "dat" || ext == "xml")) files.push_back(dir + "/" + name);
+    }
+    closedir(d);
+    std::sort(files.begin(), files.end());
+    size_t total = 0;
+    for (const std::string& f : files) {
+        size_t n = load_dat(f.c_str(), db);
+        LOGI("DAT %s: %zu records (%s)", f.c_str(), n, n ? db->systems.back().c_str() : "-");
+        total += n;
+    }
+    return total;
+}
+
+static bool match_entry(const rom_database& db, rom_entry* e) {
+    const dat_record* rec = nullptr;
+    if (e->flags & ROM_FLAG_SHA1) {
+        auto it = db.by_sha1.find(std::string((const char*)e->sha1, 20));
+        if (it != db.by_sha1.end()) rec = &db.records[it->second];
+    }
+    if (!rec) {
+        auto it = db.by_crc.find(crc_key{e->crc32, e->content_size});
+        if (it != db.by_crc.end()) rec = &db.records[it->second];
+    }
+    if (!rec) return false;
+    e->system = db.systems[rec->system];
+    e->title = rec->title;
+    e->flags |= ROM_FLAG_MATCHED;
+    return true;
+}
+
+// ---------------------------
+// Index
+// ---------------------------
+
+static void put(std::string& out, const void* p, size_t n) { out.append((const char*)p, n); }
+
+static void put_str(std::string& out, const std::string& s) {
+    uint16_t n = (uint16_t)std::min<size_t>(s.size(), 0xFFFF);
+    put(out, &n, 2);
+    out.append(s, 0, n);
+}
+
+bool rom_index_save(const char* path, const std::vector<rom_entry>& entries) {
+    std::string out;
+    out.reserve(64 + entries.size() * 160);
+    put(out, kIndexMagic, sizeof(kIndexMagic));
+    uint32_t count = (uint32_t)entries.size();
+    put(out, &count, 4);
+    for (const rom_entry& e : entries) {
+        put_str(out, e.path);
+        put(out, &e.size, 8);
+        put(out, &e.mtime_ns, 8);
+        put(out, &e.content_size, 8);
+        put(out, &e.crc32, 4);
+        put(out, e.sha1, 20);
+        put(out, &e.flags, 4);
+        put_str(out, e.system);
+        put_str(out, e.title);
+    }
+
+    // Written beside the index and renamed over it, so a crash never leaves a torn index
+    std::string tmp = std::string(path) + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOGE("Cannot write index %s", tmp.c_str());
+        return false;
+    }
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t w = write(fd, out.data() + done, out.size() - done);
+        if (w <= 0) break;
+        done += (size_t)w;
+    }
+    close(fd);
+    if (done != out.size() || rename(tmp.c_str(), path) != 0) {
+        unlink(tmp.c_str());
+        LOGE("Cannot write index %s", path);
+        return false;
+    }
+    return true;
+}
+
+bool rom_index_load(const char* path, std::vector<rom_entry>* out) {
+    out->clear();
+    ContentMapping map;
+    if (!map.map(path)) return false;
+    const uint8_t* p = (const uint8_t*)map.data();
+    const uint8_t* end = p + map.size();
+    auto get = [&](void* dst, size_t n) {
+        if ((size_t)(end - p) < n) return false;
+        memcpy(dst, p, n);
+        p += n;
+        return true;
+    };
+    auto get_str = [&](std::string* s) {
+        uint16_t n;
+        if (!get(&n, 2) || (size_t)(end - p) < n) return false;
+        s->assign((const char*)p, n);
+        p += n;
+        return true;
+    };
+
+    char magic[8];
+    uint32_t count;
+    if (!get(magic, 8) || memcmp(magic, kIndexMagic, 8) || !get(&count, 4)) return false;
+    out->resize(count);
+    for (rom_entry& e : *out) {
+        if (!get_str(&e.path) || !get(&e.size, 8) || !get(&e.mtime_ns, 8) || !get(&e.content_size, 8) ||
+            !get(&e.crc32, 4) || !get(e.sha1, 20) || !get(&e.flags, 4) || !get_str(&e.system) ||
+            !get_str(&e.title)) {
+            LOGE("Index %s is truncated, rescanning everything", path);
+            out->clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------
+// Scan
+// ---------------------------
+
+static void walk(const std::string& dir, std::vector<rom_entry>* out, unsigned depth) {
+    if (depth > 16) return;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return;
+    while (dirent* de = readdir(d)) {
+        if (de->d_name[0] == '.') continue;
+        std::string path = dir + "/" + de->d_name;
+        struct stat st;
+        if (fstatat(dirfd(d), de->d_name, &st, 0) != 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            walk(path, out, depth + 1);
+        } else if (S_ISREG(st.st_mode) && st.st_size > 0 && is_content_file(path)) {
+            rom_entry e = {};
+            e.path = std::move(path);
+            e.size = (uint64_t)st.st_size;
+            e.mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+            out->push_back(std::move(e));
+        }
+    }
+    closedir(d);
+}
+
+bool rom_library_scan(const rom_scan_options& opts, std::vector<rom_entry>* out, rom_scan_stats* stats) {
+    rom_scan_stats s = {};
+    const uint64_t t0 = now_ns();
+
+    std::vector<rom_entry> found;
+    for (const std::string& dir : opts.dirs) {
+        std::string d = dir;
+        while (d.size() > 1 && d.back() == '/') d.pop_back();
+        walk(d, &found, 0);
+    }
+    std::sort(found.begin(), found.end(), [](const rom_entry& a, const rom_entry& b) { return a.path < b.path; });
+    found.erase(std::unique(found.begin(), found.end(),
+                            [](const rom_entry& a, const rom_entry& b) { return a.path == b.path; }),
+                found.end());
+    s.files = found.size();
+    s.walk_ns = now_ns() - t0;
+
+    // Unchanged files keep their hashes
+    std::vector<rom_entry> previous;
+    if (!opts.index_path.empty()) rom_index_load(opts.index_path.c_str(), &previous);
+    std::unordered_map<std::string, const rom_entry*> by_path;
+    by_path.reserve(previous.size());
+    for (const rom_entry& e : previous) by_path.emplace(e.path, &e);
+
+    std::vector<size_t> work;
+    for (size_t i = 0; i < found.size(); ++i) {
+        auto it = by_path.find(found[i].path);
+        const rom_entry* old = it == by_path.end() ? nullptr : it->second;
+        if (old && old->size == found[i].size && old->mtime_ns == found[i].mtime_ns && !(old->flags & ROM_FLAG_ERROR)) {
+            found[i] = *old;
+            ++s.reused;
+        } else {
+            work.push_back(i);
+        }
+    }
+
+    // Hash the rest: workers pull files off a shared counter, so one large image does not hold up
+    // a queue of small ones behind it
+    const uint64_t th = now_ns();
+    unsigned threads = opts.threads ? opts.threads : std::max(4u, std::thread::hardware_concurrency());
+    threads = std::max(1u, std::min({threads, 8u, (unsigned)std::max<size_t>(work.size(), 1)}));
+    std::atomic<size_t> next(0);
+    std::atomic<uint64_t> bytes(0), errors(0);
+    auto worker = [&]() {
+        for (size_t w; (w = next.fetch_add(1, std::memory_order_relaxed)) < work.size();) {
+            rom_entry& e = found[work[w]];
+            if (rom_hash_file(e.path.c_str(), &e)) {
+                bytes.fetch_add(e.flags & ROM_FLAG_ARCHIVE ? 0 : e.content_size, std::memory_order_relaxed);
+            } else {
+                e.flags = ROM_FLAG_ERROR;
+                errors.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+    s.hashed = work.size();
+    s.bytes_hashed = bytes.load();
+    s.errors = errors.load();
+    s.hash_ns = now_ns() - th;
+
+    // DATs may have changed since the index was written, so every entry is matched again
+    if (!opts.dat_dir.empty()) {
+        rom_database db;
+        s.dat_entries = load_dat_dir(opts.dat_dir, &db);
+        for (rom_entry& e : found) {
+            if (e.flags & ROM_FLAG_ERROR) continue;
+            if (e.flags & ROM_FLAG_MATCHED) {
+                e.flags &= ~ROM_FLAG_MATCHED;
+                e.system.clear();
+                e.title = stem(e.path);
+            }
+            if (match_entry(db, &e)) ++s.matched;
+        }
+    } else {
+        for (const rom_entry& e : found) s.matched += (e.flags & ROM_FLAG_MATCHED) != 0;
+    }
+
+    bool ok = opts.index_path.empty() || rom_index_save(opts.index_path.c_str(), found);
+    s.total_ns = now_ns() - t0;
+    LOGI("Scanned %llu files: %llu hashed (%.1f MB), %llu reused, %llu matched, %llu errors in %.1f ms",
+         (unsigned long long)s.files, (unsigned long long)s.hashed, s.bytes_hashed / 1048576.0,
+         (unsigned long long)s.reused, (unsigned long long)s.matched, (unsigned long long)s.errors,
+         s.total_ns / 1e6);
+    if (stats) *stats = s;
+    out->swap(found);
+    return ok;
+}
@@ -0,0 +1,65 @@
+// rom_library.h
+// ROM library scanner: walks content directories, identifies every file by CRC32 and SHA-1, matches
+// them against Logiqx XML DAT files (No-Intro, Redump and friends) and keeps the results in a
+// compact on-disk index.
+//
+// Files are hashed on a small thread pool, read through mmap in sequential windows with both hashes
+// computed in one pass over each chunk while it is in cache. A rescan only hashes files whose size
+// or mtime differ from the index; everything else is reused, so an unchanged library costs one
+// directory walk. For .zip archives the CRC of the entry a core would get comes from the central
+// directory and no SHA-1 is computed, so matching falls back to CRC + size.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum {
+    ROM_FLAG_ARCHIVE = 1u << 0,   // .zip: crc32/size describe the picked entry
+    ROM_FLAG_SHA1    = 1u << 1,   // sha1 is valid
+    ROM_FLAG_MATCHED = 1u << 2,   // system/title come from a DAT
+    ROM_FLAG_ERROR   = 1u << 3    // could not be read; retried on the next scan
+};
+
+struct rom_entry {
+    std::string path;
+    uint64_t size;          // file size (the index key, with mtime_ns)
+    int64_t mtime_ns;
+    uint64_t content_size;  // bytes the hashes cover: the file, or the archive entry
+    uint32_t crc32;
+    uint8_t sha1[20];
+    uint32_t flags;         // ROM_FLAG_*
+    std::string system;     // DAT header name, empty when unmatched
+    std::string title;      // DAT game name, else the file name without extension
+};
+
+struct rom_scan_options {
+    std::vector<std::string> dirs;   // walked recursively
+    std::string index_path;          // empty: nothing loaded or saved
+    std::string dat_dir;             // *.dat files; empty: no matching
+    unsigned threads = 0;            // 0: one per core, at most 8
+};
+
+struct rom_scan_stats {
+    uint64_t files;          // content files found
+    uint64_t hashed;         // new or changed, hashed this scan
+    uint64_t reused;         // taken from the index
+    uint64_t matched;        // identified by a DAT
+    uint64_t errors;
+    uint64_t bytes_hashed;
+    uint64_t dat_entries;    // ROM records loaded from DAT files
+    uint64_t walk_ns;
+    uint64_t hash_ns;        // wall time of the parallel hashing phase
+    uint64_t total_ns;
+};
+
+// Scan, match and (when index_path is set) rewrite the index. Entries are sorted by path.
+bool rom_library_scan(const rom_scan_options& opts, std::vector<rom_entry>* out, rom_scan_stats* stats);
+
+// Hash one file the way the scanner does; false if it cannot be read.
+bool rom_hash_file(const char* path, rom_entry* e);
+
+bool rom_index_load(const char* path, std::vector<rom_entry>* out);
+bool rom_index_save(const char* path, const std::vector<rom_entry>& entries);
@@ -0,0 +1,345 @@
+// savestate.cpp
+// Background savestate worker: pooled buffers, zlib payloads, atomic file replacement.
+
+#include "savestate.h"
+#include "libretro_defs.h"
+#include "pixel_convert.h"
+#include "platform.h"
+#include "trace.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <zlib.h>
+
+#define LOG_TAG "SaveState"
+
+static const unsigned kPoolSize = 3;
+static const unsigned kThumbMaxWidth = 160;
+
+static savestate_buffer gPool[kPoolSize];
+static std::mutex gLock;                  // pool ownership and the job queue
+static std::condition_variable gWake;
+static std::deque<savestate_buffer*> gJobs;
+static std::thread gWorker;
+static bool gStopping = false;
+static std::atomic<savestate_buffer*> gLoaded(nullptr);
+
+static std::atomic<uint64_t> gSaves(0);
+static std::atomic<uint64_t> gLoads(0);
+static std::atomic<uint64_t> gFailures(0);
+static std::atomic<uint64_t> gLastSerializeNs(0);
+static std::atomic<uint64_t> gLastWriteNs(0);
+static std::atomic<uint64_t> gLastReadNs(0);
+static std::atomic<uint64_t> gLastUnserializeNs(0);
+static std::atomic<uint64_t> gLastStateBytes(0);
+static std::atomic<uint64_t> gLastFileBytes(0);
+
+static int64_t mono_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static savestate_buffer* acquire_buffer() {
+    std::lock_guard<std::mutex> lk(gLock);
+    for (auto& b : gPool) {
+        if (!b.in_use) {
+            b.in_use = true;
+            b.ok = false;
+            b.load = false;
+            b.frame_width = b.frame_height = 0;
+            return &b;
+        }
+    }
+    return nullptr;
+}
+
+// Nearest-neighbour downscale to at most kThumbMaxWidth wide, RGBA output.
+static void make_thumbnail(savestate_buffer* b, uint32_t* tw, uint32_t* th) {
+    *tw = *th = 0;
+    b->thumb.clear();
+    pixel_row_fn row_fn = pixel_convert_row(b->frame_format);
+    if (!row_fn || !b->frame_width || !b->frame_height) return;
+    unsigned step = (b->frame_width + kThumbMaxWidth - 1) / kThumbMaxWidth;
+    unsigned w = b->frame_width / step, h = b->frame_height / step;
+    if (!w || !h) return;
+    std::vector<uint32_t> row(b->frame_width);
+    b->thumb.resize((size_t)w * h * 4);
+    uint32_t* out = (uint32_t*)b->thumb.data();
+    for (unsigned y = 0; y < h; ++y) {
+        row_fn(row.data(), b->frame.data() + (size_t)y * step * b->frame_pitch, b->frame_width);
+        for (unsigned x = 0; x < w; ++x) out[(size_t)y * w + x] = row[(size_t)x * step];
+    }
+    *tw = w;
+    *th = h;
+}
+
+static bool write_all(int fd, const void* data, size_t n) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+// Write to path.tmp, fsync, rename over path, fsync the directory: a crash leaves either the old
+// file or the new one, never a torn state.
+static bool write_file_atomic(const std::string& path, const savestate_header& hdr,
+                              const std::vector<uint8_t>& thumb, const uint8_t* payload, size_t payload_size) {
+    std::string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOGE("open %s failed: %s", tmp.c_str(), strerror(errno));
+        return false;
+    }
+    bool ok = write_all(fd, &hdr, sizeof(hdr)) && write_all(fd, thumb.data(), thumb.size()) &&
+              write_all(fd, payload, payload_size) && fsync(fd) == 0;
+    ok = (close(fd) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        LOGE("write %s failed: %s", path.c_str(), strerror(errno));
+        unlink(tmp.c_str());
+        return false;
+    }
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : path.substr(0, slash ? slash : 1);
+    int dfd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dfd >= 0) {
+        fsync(dfd);
+        close(dfd);
+    }
+    return true;
+}
+
+static bool do_save(savestate_buffer* b) {
+    int64_t t0 = mono_ns();
+    uLongf packed = compressBound((uLong)b->state_size);
+    if (b->packed.size() < packed) b->packed.resize(packed);
+    if (compress2(b->packed.data(), &packed, b->state.data(), (uLong)b->state_size, Z_BEST_SPEED) != Z_OK) {
+        LOGE("compress failed");
+        return false;
+    }
+
+    savestate_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SAVESTATE_MAGIC, sizeof(hdr.magic));
+    hdr.version = SAVESTATE_VERSION;
+    hdr.header_size = sizeof(hdr);
+    hdr.state_size = b->state_size;
+    hdr.payload_size = packed;
+    hdr.state_crc32 = (uint32_t)crc32(0L, b->state.data(), (uInt)b->state_size);
+    make_thumbnail(b, &hdr.thumb_width, &hdr.thumb_height);
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    hdr.saved_unix_ms = (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+
+    if (!write_file_atomic(b->path, hdr, b->thumb, b->packed.data(), packed)) return false;
+    gLastWriteNs.store((uint64_t)(mono_ns() - t0), std::memory_order_relaxed);
+    gLastStateBytes.store(b->state_size, std::memory_order_relaxed);
+    gLastFileBytes.store(sizeof(hdr) + b->thumb.size() + packed, std::memory_order_relaxed);
+    LOGI("saved %s: %zu -> %lu bytes", b->path.c_str(), b->state_size, (unsigned long)packed);
+    return true;
+}
+
+bool savestate_read_file(const char* path, savestate_buffer* b, size_t state_size) {
+    int64_t t0 = mono_ns();
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("open %s failed: %s", path, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(savestate_header)) {
+        close(fd);
+        LOGE("%s: not a savestate", path);
+        return false;
+    }
+    size_t file_size = (size_t)st.st_size;
+    void* map = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        LOGE("mmap %s failed: %s", path, strerror(errno));
+        return false;
+    }
+    madvise(map, file_size, MADV_SEQUENTIAL);
+
+    bool ok = false;
+    const uint8_t* base = (const uint8_t*)map;
+    savestate_header hdr;
+    memcpy(&hdr, base, sizeof(hdr));
+    size_t thumb_bytes = (size_t)hdr.thumb_width * hdr.thumb_height * 4;
+    if (memcmp(hdr.magic, SAVESTATE_MAGIC, sizeof(hdr.magic)) != 0 || hdr.version != SAVESTATE_VERSION ||
+        hdr.header_size < sizeof(hdr) || hdr.header_size > file_size ||
+        thumb_bytes > file_size - hdr.header_size ||
+        hdr.payload_size > file_size - hdr.header_size - thumb_bytes) {
+        LOGE("%s: bad header", path);
+    } else if (hdr.state_size != state_size) {
+        LOGE("%s: state is %llu bytes, core expects %zu", path, (unsigned long long)hdr.state_size, state_size);
+    } else {
+        if (b->state.size() < state_size) b->state.resize(state_size);
+        uLongf len = (uLongf)state_size;
+        const uint8_t* payload = base + hdr.header_size + thumb_bytes;
+        if (uncompress(b->state.data(), &len, payload, (uLong)hdr.payload_size) != Z_OK || len != state_size) {
+            LOGE("%s: corrupt payload", path);
+        } else if ((uint32_t)crc32(0L, b->state.data(), (uInt)state_size) != hdr.state_crc32) {
+            LOGE("%s: checksum mismatch", path);
+        } else {
+            b->state_size = state_size;
+            ok = true;
+        }
+    }
+    munmap(map, file_size);
+    if (ok) gLastReadNs.store((uint64_t)(mono_ns() - t0), std::memory_order_relaxed);
+    return ok;
+}
+
+static void worker_main() {
+    trace_set_thread_name("saasemu-state");
+    for (;;) {
+        savestate_buffer* b;
+        {
+            std::unique_lock<std::mutex> lk(gLock);
+            gWake.wait(lk, [] { return gStopping || !gJobs.empty(); });
+            if (gJobs.empty()) return; // stopping and drained
+            b = gJobs.front();
+            gJobs.pop_front();
+        }
+        TRACE_SCOPE(b->load ? "savestate_read" : "savestate_write");
+        if (b->load) {
+            b->ok = savestate_read_file(b->path.c_str(), b, b->state_size);
+            if (b->ok) {
+                // a newer load replaces one the emulation thread has not picked up yet
+                savestate_buffer* prev = gLoaded.exchange(b);
+                if (prev) savestate_release(prev);
+                continue;
+            }
+        } else {
+            b->ok = do_save(b);
+            if (b->ok) gSaves.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (!b->ok) gFailures.fetch_add(1, std::memory_order_relaxed);
+        savestate_release(b);
+    }
+}
+
+void savestate_start() {
+    std::lock_guard<std::mutex> lk(gLock);
+    if (gWorker.joinable()) return;
+    gStopping = false;
+    gWorker = std::thread(worker_main);
+}
+
+void savestate_stop() {
+    {
+        std::lock_guard<std::mutex> lk(gLock);
+        if (!gWorker.joinable()) return;
+        gStopping = true;
+    }
+    gWake.notify_one();
+    gWorker.join();
+    if (savestate_buffer* b = gLoaded.exchange(nullptr)) savestate_release(b);
+}
+
+savestate_buffer* savestate_begin_save(size_t state_size) {
+    savestate_buffer* b = acquire_buffer();
+    if (!b) {
+        LOGE("save skipped: all %u buffers in flight", kPoolSize);
+        gFailures.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    if (b->state.size() < state_size) b->state.resize(state_size);
+    b->state_size = state_size;
+    return b;
+}
+
+void savestate_attach_frame(savestate_buffer* b, const void* data, unsigned width, unsigned height,
+                            size_t pitch, int format) {
+    if (!b || !data || !width || !height) return;
+    const size_t row = (size_t)width * (format == RETRO_PIXEL_FORMAT_XRGB8888 ? 4 : 2);
+    b->frame_pitch = row;
+    b->frame.resize(row * height);
+    for (unsigned y = 0; y < height; ++y) {
+        memcpy(b->frame.data() + y * row, (const uint8_t*)data + y * pitch, row);
+    }
+    b->frame_width = width;
+    b->frame_height = height;
+    b->frame_format = format;
+}
+
+void savestate_commit_save(savestate_buffer* b, const char* path, int64_t serialize_ns) {
+    if (!b) return;
+    b->path = path;
+    b->load = false;
+    b->serialize_ns = serialize_ns;
+    gLastSerializeNs.store((uint64_t)serialize_ns, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lk(gLock);
+        gJobs.push_back(b);
+    }
+    gWake.notify_one();
+}
+
+bool savestate_request_load(const char* path, size_t state_size) {
+    savestate_buffer* b = acquire_buffer();
+    if (!b) {
+        LOGE("load skipped: all %u buffers in flight", kPoolSize);
+        return false;
+    }
+    b->path = path;
+    b->load = true;
+    b->state_size = state_size;
+    {
+        std::lock_guard<std::mutex> lk(gLock);
+        gJobs.push_back(b);
+    }
+    gWake.notify_one();
+    return true;
+}
+
+savestate_buffer* savestate_poll_loaded() {
+    if (!gLoaded.load(std::memory_order_relaxed)) return nullptr;
+    return gLoaded.exchange(nullptr);
+}
+
+void savestate_release(savestate_buffer* b) {
+    if (!b) return;
+    std::lock_guard<std::mutex> lk(gLock);
+    b->in_use = false;
+}
+
+void savestate_note_unserialize(bool ok, int64_t ns) {
+    if (ok) {
+        gLoads.fetch_add(1, std::memory_order_relaxed);
+        gLastUnserializeNs.store((uint64_t)ns, std::memory_order_relaxed);
+    } else {
+        gFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void savestate_get_stats(savestate_stats* out) {
+    if (!out) return;
+    out->saves = gSaves.load(std::memory_order_relaxed);
+    out->loads = gLoads.load(std::memory_order_relaxed);
+    out->failures = gFailures.load(std::memory_order_relaxed);
+    out->last_serialize_ns = gLastSerializeNs.load(std::memory_order_relaxed);
+    out->last_write_ns = gLastWriteNs.load(std::memory_order_relaxed);
+    out->last_read_ns = gLastReadNs.load(std::memory_order_relaxed);
+    out->last_unserialize_ns = gLastUnserializeNs.load(std::memory_order_relaxed);
+    out->last_state_bytes = gLastStateBytes.load(std::memory_order_relaxed);
+    out->last_file_bytes = gLastFileBytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,90 @@
+// savestate.h
+// Savestate files written and read by a background worker.
+//
+// The emulation thread only runs retro_serialize into a pooled buffer (plus a copy of the last
+// frame for the thumbnail) and hands it over; deflate, thumbnail scaling and the atomic write
+// (temp file, fsync, rename) happen on the worker, so saving never stalls a frame. Loading maps the
+// file and inflates the payload straight into a pooled buffer that the emulation thread then
+// passes to retro_unserialize.
+//
+// File layout (little endian):
+//   savestate_header
+//   thumbnail: thumb_width * thumb_height RGBA bytes
+//   payload:   zlib stream of state_size bytes
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define SAVESTATE_MAGIC "SAASTATE"
+#define SAVESTATE_VERSION 1
+
+struct savestate_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t state_size;      // retro_serialize_size at save time
+    uint64_t payload_size;    // compressed bytes
+    uint32_t state_crc32;     // of the uncompressed state
+    uint32_t thumb_width;
+    uint32_t thumb_height;
+    uint32_t reserved;
+    int64_t saved_unix_ms;
+};
+
+struct savestate_buffer {
+    std::vector<uint8_t> state;   // serialized state, state_size bytes used
+    size_t state_size = 0;
+    // last frame as submitted by the core, converted and scaled on the worker
+    std::vector<uint8_t> frame;
+    unsigned frame_width = 0;
+    unsigned frame_height = 0;
+    size_t frame_pitch = 0;
+    int frame_format = 0;
+    // worker side
+    bool load = false;
+    std::string path;
+    std::vector<uint8_t> packed;  // compressed payload
+    std::vector<uint8_t> thumb;
+    int64_t serialize_ns = 0;
+    bool ok = false;
+    bool in_use = false;
+};
+
+struct savestate_stats {
+    uint64_t saves;
+    uint64_t loads;
+    uint64_t failures;
+    uint64_t last_serialize_ns;   // emulation thread: retro_serialize + frame copy
+    uint64_t last_write_ns;       // worker: compress + thumbnail + write + rename
+    uint64_t last_read_ns;        // worker: mmap + inflate + crc
+    uint64_t last_unserialize_ns; // emulation thread
+    uint64_t last_state_bytes;
+    uint64_t last_file_bytes;
+};
+
+// Worker lifecycle. savestate_stop waits for queued writes to reach the disk.
+void savestate_start();
+void savestate_stop();
+
+// Save, emulation thread: take a pooled buffer with room for state_size bytes (nullptr if every
+// buffer is still in flight), fill buf->state, optionally attach the last frame, then commit.
+savestate_buffer* savestate_begin_save(size_t state_size);
+void savestate_attach_frame(savestate_buffer* buf, const void* data, unsigned width, unsigned height,
+                            size_t pitch, int format);
+void savestate_commit_save(savestate_buffer* buf, const char* path, int64_t serialize_ns);
+
+// Load: the worker reads and inflates path into a pooled buffer. The emulation thread picks it up
+// with savestate_poll_loaded, unserializes, and releases it.
+bool savestate_request_load(const char* path, size_t state_size);
+savestate_buffer* savestate_poll_loaded();
+void savestate_release(savestate_buffer* buf);
+void savestate_note_unserialize(bool ok, int64_t ns);
+
+// Synchronous read for when the emulation thread is not running.
+bool savestate_read_file(const char* path, savestate_buffer* buf, size_t state_size);
+
+void savestate_get_stats(savestate_stats* out);
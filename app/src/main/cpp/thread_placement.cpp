@@ -0,0 +1,302 @@
+// thread_placement.cpp
+// CPU topology from sysfs, the placement plan and its application per thread (see thread_placement.h).
+
+#include "thread_placement.h"
+#include "platform.h"
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#define LOG_TAG "ThreadPlacement"
+
+static const char* kSysCpu = "/sys/devices/system/cpu";
+
+// android.os.Process THREAD_PRIORITY_URGENT_DISPLAY, _DISPLAY and _AUDIO
+static const int kNice[THREAD_ROLE_COUNT] = {-8, -4, -16};
+
+// uclamp minimum of the emulation thread (of 1024): asks schedutil for at least half speed
+// as soon as a frame starts instead of after the load tracking has caught up.
+static const uint32_t kEmuUtilMin = 512;
+
+struct role_state {
+    std::atomic<bool> applied{false};
+    std::atomic<uint64_t> mask{0};
+    std::atomic<int> nice{0};
+    std::atomic<bool> nice_raised{false};
+    std::atomic<bool> boosted{false};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> migrations{0};
+    std::atomic<int> cpu{-1};
+};
+
+static role_state gRoles[THREAD_ROLE_COUNT];
+static std::atomic<bool> gEnabled(true);
+
+// Last topology read by a starting thread, for the dump
+static std::mutex gTopoLock;
+static cpu_topology gTopo;
+static uint64_t gAllowed = 0;
+static bool gHaveTopo = false;
+
+const char* thread_role_name(thread_role role) {
+    static const char* const kNames[THREAD_ROLE_COUNT] = {"emu", "present", "audio"};
+    return role < THREAD_ROLE_COUNT ? kNames[role] : "?";
+}
+
+// ---------------------------
+// Topology
+// ---------------------------
+
+static bool read_line(const std::string& path, char* buf, size_t size) {
+    FILE* f = fopen(path.c_str(), "re");
+    if (!f) return false;
+    const bool ok = fgets(buf, (int)size, f) != nullptr;
+    fclose(f);
+    return ok;
+}
+
+static uint32_t read_u32(const std::string& path) {
+    char buf[32];
+    return read_line(path, buf, sizeof(buf)) ? (uint32_t)strtoul(buf, nullptr, 10) : 0;
+}
+
+// "0-3,5" as written in sysfs cpu lists
+static uint64_t parse_cpu_list(const char* s) {
+    uint64_t mask = 0;
+    while (*s >= '0' && *s <= '9') {
+        char* end;
+        const unsigned long first = strtoul(s, &end, 10);
+        unsigned long last = first;
+        if (*end == '-') last = strtoul(end + 1, &end, 10);
+        for (unsigned long c = first; c <= last && c < 64; ++c) mask |= 1ull << c;
+        s = *end == ',' ? end + 1 : end;
+    }
+    return mask;
+}
+
+std::string cpu_mask_string(uint64_t mask) {
+    std::string out;
+    for (int c = 0; c < 64; ++c) {
+        if (!(mask >> c & 1)) continue;
+        int last = c;
+        while (last < 63 && (mask >> (last + 1) & 1)) ++last;
+        if (!out.empty()) out += ',';
+        out += std::to_string(c);
+        if (last > c) out += (last == c + 1 ? "," : "-") + std::to_string(last);
+        c = last;
+    }
+    return out.empty() ? "none" : out;
+}
+
+bool cpu_topology_read(const char* root, cpu_topology* out) {
+    memset(out, 0, sizeof(*out));
+    const std::string dir = root;
+    char buf[256];
+    if (read_line(dir + "/online", buf, sizeof(buf))) out->online = parse_cpu_list(buf);
+    if (!out->online) {
+        const long n = sysconf(_SC_NPROCESSORS_ONLN);
+        out->online = n >= 64 ? ~0ull : n > 0 ? (1ull << n) - 1 : 1;
+    }
+    // Capacity (the kernel's relative performance, 1024 for the biggest core) orders cores of
+    // different microarchitectures correctly; the max frequency breaks ties within it.
+    uint64_t best = 0, levels[64];
+    unsigned nlevels = 0;
+    for (int c = 0; c < 64; ++c) {
+        if (!(out->online >> c & 1)) continue;
+        const std::string cpu = dir + "/cpu" + std::to_string(c);
+        out->max_khz[c] = read_u32(cpu + "/cpufreq/cpuinfo_max_freq");
+        out->capacity[c] = read_u32(cpu + "/cpu_capacity");
+        out->cpus++;
+        const uint64_t key = (uint64_t)out->capacity[c] << 32 | out->max_khz[c];
+        if (std::find(levels, levels + nlevels, key) == levels + nlevels) levels[nlevels++] = key;
+        if (key > best) {
+            best = key;
+            out->fast = 0;
+        }
+        if (key == best) out->fast |= 1ull << c;
+    }
+    out->clusters = nlevels;
+    out->fast_khz = (uint32_t)best;
+    return out->cpus > 0;
+}
+
+void thread_placement_plan_for(const cpu_topology& topo, uint64_t allowed, thread_placement_plan* out) {
+    memset(out, 0, sizeof(*out));
+    // Homogeneous CPUs: any core is as good as another and the scheduler balances better than a pin.
+    if (topo.clusters < 2) return;
+    const uint64_t fast = topo.fast & allowed;
+    const uint64_t rest = topo.online & allowed & ~topo.fast;
+    // Nothing to separate, e.g. a background cpuset that only has the little cores
+    if (!fast || !rest) return;
+    out->mask[THREAD_ROLE_EMU] = fast;
+    out->mask[THREAD_ROLE_PRESENT] = rest;
+    out->mask[THREAD_ROLE_AUDIO] = rest;
+}
+
+// ---------------------------
+// Per thread
+// ---------------------------
+
+// struct sched_attr (SCHED_ATTR_SIZE_VER1), absent from older libc headers
+struct sched_attr_v1 {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+    uint32_t sched_util_min;
+    uint32_t sched_util_max;
+};
+
+static bool raise_util_min(pid_t tid, uint32_t util_min) {
+#ifdef SYS_sched_setattr
+    static const uint64_t kKeepPolicy = 0x08, kKeepParams = 0x10, kUtilClampMin = 0x20;
+    sched_attr_v1 attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.sched_flags = kKeepPolicy | kKeepParams | kUtilClampMin;
+    attr.sched_util_min = util_min;
+    return syscall(SYS_sched_setattr, tid, &attr, 0) == 0;
+#else
+    (void)tid;
+    (void)util_min;
+    errno = ENOSYS;
+    return false;
+#endif
+}
+
+static uint64_t process_affinity() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    // the main thread's mask: the one the cpuset gives the app, whatever this thread inherited
+    if (sched_getaffinity(getpid(), sizeof(set), &set) != 0) return ~0ull;
+    uint64_t mask = 0;
+    for (int c = 0; c < 64; ++c) {
+        if (CPU_ISSET(c, &set)) mask |= 1ull << c;
+    }
+    return mask;
+}
+
+void thread_placement_set_enabled(bool enabled) {
+    gEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void thread_placement_apply(thread_role role) {
+    role_state& st = gRoles[role];
+    st.samples.store(0, std::memory_order_relaxed);
+    st.migrations.store(0, std::memory_order_relaxed);
+    st.mask.store(0, std::memory_order_relaxed);
+    st.nice_raised.store(false, std::memory_order_relaxed);
+    st.boosted.store(false, std::memory_order_relaxed);
+    const pid_t tid = (pid_t)syscall(SYS_gettid);
+    st.applied.store(gEnabled.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    if (!st.applied.load(std::memory_order_relaxed)) {
+        st.nice.store(getpriority(PRIO_PROCESS, (id_t)tid), std::memory_order_relaxed);
+        st.cpu.store(sched_getcpu(), std::memory_order_relaxed);
+        return;
+    }
+
+    // Cores come and go (hotplug, cpusets), so every thread start looks again.
+    cpu_topology topo;
+    cpu_topology_read(kSysCpu, &topo);
+    const uint64_t allowed = process_affinity();
+    thread_placement_plan plan;
+    thread_placement_plan_for(topo, allowed, &plan);
+    {
+        std::lock_guard<std::mutex> lk(gTopoLock);
+        gTopo = topo;
+        gAllowed = allowed;
+        gHaveTopo = true;
+    }
+
+    uint64_t mask = plan.mask[role];
+    if (mask) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c = 0; c < 64; ++c) {
+            if (mask >> c & 1) CPU_SET(c, &set);
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            LOGE("%s: cannot pin to cpus %s: %s", thread_role_name(role), cpu_mask_string(mask).c_str(),
+                 strerror(errno));
+            mask = 0;
+        }
+    }
+    st.mask.store(mask, std::memory_order_relaxed);
+    st.cpu.store(sched_getcpu(), std::memory_order_relaxed);   // pinning itself is not a migration
+
+    const bool nice_raised = setpriority(PRIO_PROCESS, (id_t)tid, kNice[role]) == 0;
+    const char* boost = "";
+    if (role == THREAD_ROLE_EMU) {
+        const bool boosted = raise_util_min(tid, kEmuUtilMin);
+        st.boosted.store(boosted, std::memory_order_relaxed);
+        boost = boosted ? ", uclamp.min raised" : errno == EPERM ? ", uclamp.min not permitted" : ", no uclamp";
+    }
+    const int nice = getpriority(PRIO_PROCESS, (id_t)tid);
+    st.nice_raised.store(nice_raised, std::memory_order_relaxed);
+    st.nice.store(nice, std::memory_order_relaxed);
+    LOGI("%s: cpus %s, nice %d%s%s", thread_role_name(role), mask ? cpu_mask_string(mask).c_str() : "any", nice,
+         nice_raised ? "" : " (not permitted)", boost);
+}
+
+void thread_placement_sample(thread_role role) {
+    role_state& st = gRoles[role];
+    const int cpu = sched_getcpu();
+    // written by the thread itself only
+    st.samples.store(st.samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    const int last = st.cpu.load(std::memory_order_relaxed);
+    if (cpu == last) return;
+    if (last >= 0) st.migrations.store(st.migrations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    st.cpu.store(cpu, std::memory_order_relaxed);
+}
+
+void thread_placement_get_stats(thread_role role, thread_placement_stats* out) {
+    if (!out || role >= THREAD_ROLE_COUNT) return;
+    const role_state& st = gRoles[role];
+    out->applied = st.applied.load(std::memory_order_relaxed);
+    out->mask = st.mask.load(std::memory_order_relaxed);
+    out->nice = st.nice.load(std::memory_order_relaxed);
+    out->nice_raised = st.nice_raised.load(std::memory_order_relaxed);
+    out->boosted = st.boosted.load(std::memory_order_relaxed);
+    out->samples = st.samples.load(std::memory_order_relaxed);
+    out->migrations = st.migrations.load(std::memory_order_relaxed);
+    out->cpu = st.cpu.load(std::memory_order_relaxed);
+}
+
+std::string thread_placement_dump() {
+    std::string out;
+    char line[256];
+    {
+        std::lock_guard<std::mutex> lk(gTopoLock);
+        if (gHaveTopo) {
+            char freq[32] = "";
+            if (gTopo.fast_khz) snprintf(freq, sizeof(freq), " at %.2f GHz", gTopo.fast_khz / 1e6);
+            snprintf(line, sizeof(line), "placement        %u cpus in %u cluster%s, fastest %s%s, allowed %s\n",
+                     gTopo.cpus, gTopo.clusters, gTopo.clusters == 1 ? "" : "s", cpu_mask_string(gTopo.fast).c_str(),
+                     freq, cpu_mask_string(gAllowed).c_str());
+            out += line;
+        }
+    }
+    for (int r = 0; r < THREAD_ROLE_COUNT; ++r) {
+        thread_placement_stats s;
+        thread_placement_get_stats((thread_role)r, &s);
+        if (!s.applied && !s.samples) continue;
+        snprintf(line, sizeof(line), "placement        %-8s cpus %s, nice %d%s, %llu samples, %llu migrations\n",
+                 thread_role_name((thread_role)r), s.mask ? cpu_mask_string(s.mask).c_str() : "any", s.nice,
+                 s.boosted ? " +uclamp" : "", (unsigned long long)s.samples, (unsigned long long)s.migrations);
+        out += line;
+    }
+    return out;
+}
@@ -0,0 +1,74 @@
+// thread_placement.h
+// Which CPUs the runtime's threads run on, and at what priority.
+//
+// The topology comes from /sys/devices/system/cpu: online CPUs are grouped into clusters by
+// cpu_capacity and cpufreq/cpuinfo_max_freq. On a heterogeneous SoC the emulation thread is pinned
+// to the fastest cluster and the presenter and audio threads to the other CPUs, so the scheduler
+// cannot bounce retro_run between big and little cores mid-game. Homogeneous CPUs are left to the
+// scheduler. Each thread also raises its own nice value, and the emulation thread its uclamp
+// minimum through sched_setattr, where the process is allowed to; a refusal is reported, never
+// fatal.
+//
+// Threads apply their placement themselves when they start and then sample sched_getcpu() once per
+// iteration (frame, present, audio burst) to count migrations.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+enum thread_role {
+    THREAD_ROLE_EMU,
+    THREAD_ROLE_PRESENT,
+    THREAD_ROLE_AUDIO,
+    THREAD_ROLE_COUNT
+};
+
+const char* thread_role_name(thread_role role);
+
+// CPUs are bit positions; ids of 64 and above are ignored.
+struct cpu_topology {
+    uint64_t online;
+    uint64_t fast;            // the fastest cluster
+    unsigned cpus;
+    unsigned clusters;        // distinct (capacity, max frequency) levels
+    uint32_t fast_khz;        // max frequency of the fastest cluster, 0: not reported
+    uint32_t max_khz[64];     // 0: not reported
+    uint32_t capacity[64];    // 0: not reported
+};
+
+// root is normally "/sys/devices/system/cpu". False when no CPU could be found.
+bool cpu_topology_read(const char* root, cpu_topology* out);
+
+// Affinity per role for CPUs the process may use; 0 leaves the role to the scheduler.
+struct thread_placement_plan {
+    uint64_t mask[THREAD_ROLE_COUNT];
+};
+
+void thread_placement_plan_for(const cpu_topology& topo, uint64_t allowed, thread_placement_plan* out);
+
+// On by default; applies to threads started afterwards.
+void thread_placement_set_enabled(bool enabled);
+
+// On the thread itself: first thing when it starts, then once per iteration.
+void thread_placement_apply(thread_role role);
+void thread_placement_sample(thread_role role);
+
+struct thread_placement_stats {
+    bool applied;             // the thread started with placement enabled
+    uint64_t mask;            // affinity set, 0: none
+    int nice;                 // after apply
+    bool nice_raised;         // setpriority succeeded
+    bool boosted;             // sched_setattr raised the uclamp minimum
+    uint64_t samples;
+    uint64_t migrations;      // CPU changes between consecutive samples
+    int cpu;                  // last sample, -1 before the first
+};
+
+void thread_placement_get_stats(thread_role role, thread_placement_stats* out);
+
+// The topology, the decision and per-role counters, one "placement" line each.
+std::string thread_placement_dump();
+
+// "0-3,6" for a mask
+std::string cpu_mask_string(uint64_t mask);
@@ -0,0 +1,199 @@
+// trace.cpp
+// ATrace sections on Android; on the host, a multi-producer ring of complete events and its
+// Chrome trace-event JSON export.
+
+#include "trace.h"
+#include "latency_histogram.h"
+#include "platform.h"
+
+#include <pthread.h>
+
+#ifdef __ANDROID__
+#include <android/trace.h>
+#else
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#endif
+
+#define LOG_TAG "Trace"
+
+std::atomic<bool> gTraceEnabled(false);
+
+void trace_set_enabled(bool enabled) {
+    if (gTraceEnabled.exchange(enabled) != enabled) LOGI("tracing %s", enabled ? "on" : "off");
+}
+
+#ifdef __ANDROID__
+
+void trace_set_thread_name(const char* name) {
+    pthread_setname_np(pthread_self(), name);
+}
+
+void TraceScope::begin(const char* name, int64_t /*arg*/) {
+    name_ = name;
+    ATrace_beginSection(name);
+}
+
+void TraceScope::end() {
+    ATrace_endSection();
+}
+
+#else
+
+// Each slot is a small seqlock: the writer marks it odd while filling it and stores the even
+// sequence of the event last, so a reader can tell a finished event from one being overwritten.
+// A writer claims its slot with a CAS from an earlier lap's even sequence; when the slot is still
+// being written one lap behind (a writer preempted mid-event), the newer event is dropped instead
+// of both writers tearing it.
+struct alignas(64) trace_slot {
+    std::atomic<uint64_t> seq{0};   // 2 * index + 1 while writing, 2 * index + 2 when done
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> ts_ns{0};
+    std::atomic<int64_t> dur_ns{0};
+    std::atomic<int64_t> arg{0};
+    std::atomic<uint32_t> tid{0};
+};
+
+static trace_slot gRing[kTraceCapacity];
+static std::atomic<uint64_t> gHead(0);     // events ever claimed
+static std::atomic<uint64_t> gCleared(0);  // gHead at the last trace_clear
+static std::atomic<uint64_t> gDropped(0);  // since the last trace_clear
+
+// Thread names for the JSON metadata; set once per thread start.
+static std::mutex gNamesLock;
+static std::vector<std::pair<uint32_t, std::string>> gThreadNames;
+
+static uint32_t current_tid() {
+    static thread_local uint32_t tid = (uint32_t)syscall(SYS_gettid);
+    return tid;
+}
+
+void trace_set_thread_name(const char* name) {
+    pthread_setname_np(pthread_self(), name);
+    const uint32_t tid = current_tid();
+    std::lock_guard<std::mutex> lk(gNamesLock);
+    for (auto& t : gThreadNames) {
+        if (t.first == tid) {
+            t.second = name;
+            return;
+        }
+    }
+    gThreadNames.emplace_back(tid, name);
+}
+
+void TraceScope::begin(const char* name, int64_t arg) {
+    name_ = name;
+    arg_ = arg;
+    t0_ = latency_now_ns();
+}
+
+void TraceScope::end() {
+    trace_emit(name_, t0_, latency_now_ns() - t0_, arg_);
+}
+
+void trace_emit(const char* name, int64_t ts_ns, int64_t dur_ns, int64_t arg) {
+    const uint64_t i = gHead.fetch_add(1, std::memory_order_relaxed);
+    trace_slot& s = gRing[i & (kTraceCapacity - 1)];
+    uint64_t seq = s.seq.load(std::memory_order_relaxed);
+    if ((seq & 1) || seq > 2 * i ||
+        !s.seq.compare_exchange_strong(seq, 2 * i + 1, std::memory_order_relaxed)) {
+        gDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    s.name.store(name, std::memory_order_relaxed);
+    s.ts_ns.store(ts_ns, std::memory_order_relaxed);
+    s.dur_ns.store(dur_ns, std::memory_order_relaxed);
+    s.arg.store(arg, std::memory_order_relaxed);
+    s.tid.store(current_tid(), std::memory_order_relaxed);
+    s.seq.store(2 * i + 2, std::memory_order_release);
+}
+
+size_t trace_snapshot(std::vector<trace_event>* out) {
+    out->clear();
+    const uint64_t head = gHead.load(std::memory_order_acquire);
+    uint64_t first = gCleared.load(std::memory_order_relaxed);
+    if (head - first > kTraceCapacity) first = head - kTraceCapacity;
+    out->reserve((size_t)(head - first));
+    for (uint64_t i = first; i < head; ++i) {
+        const trace_slot& s = gRing[i & (kTraceCapacity - 1)];
+        const uint64_t seq = s.seq.load(std::memory_order_acquire);
+        trace_event e;
+        e.name = s.name.load(std::memory_order_relaxed);
+        e.ts_ns = s.ts_ns.load(std::memory_order_relaxed);
+        e.dur_ns = s.dur_ns.load(std::memory_order_relaxed);
+        e.arg = s.arg.load(std::memory_order_relaxed);
+        e.tid = s.tid.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq != 2 * i + 2 || s.seq.load(std::memory_order_relaxed) != seq) continue;
+        out->push_back(e);
+    }
+    return out->size();
+}
+
+void trace_clear() {
+    gCleared.store(gHead.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    gDropped.store(0, std::memory_order_relaxed);
+}
+
+void trace_get_stats(trace_stats* out) {
+    if (!out) return;
+    const uint64_t events = gHead.load(std::memory_order_relaxed) - gCleared.load(std::memory_order_relaxed);
+    out->events = events;
+    out->overwritten = events > kTraceCapacity ? events - kTraceCapacity : 0;
+    out->dropped = gDropped.load(std::memory_order_relaxed);
+}
+
+static void json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s >= 0x20) fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+bool trace_write_json(const char* path) {
+    std::vector<trace_event> events;
+    trace_snapshot(&events);
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        LOGE("cannot write trace %s", path);
+        return false;
+    }
+    const int pid = (int)getpid();
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"saasemu\"}}", pid,
+            pid);
+    {
+        std::lock_guard<std::mutex> lk(gNamesLock);
+        for (const auto& t : gThreadNames) {
+            fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":", pid,
+                    t.first);
+            json_string(f, t.second.c_str());
+            fprintf(f, "}}");
+        }
+    }
+    for (const trace_event& e : events) {
+        fprintf(f, ",\n{\"name\":");
+        json_string(f, e.name ? e.name : "?");
+        fprintf(f, ",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f", pid, e.tid, e.ts_ns / 1e3,
+                e.dur_ns / 1e3);
+        if (e.arg != TRACE_NO_ARG) fprintf(f, ",\"args\":{\"value\":%lld}", (long long)e.arg);
+        fprintf(f, "}");
+    }
+    fprintf(f, "\n]}\n");
+    const bool ok = !ferror(f);
+    if (fclose(f) != 0 || !ok) {
+        LOGE("cannot write trace %s", path);
+        return false;
+    }
+    LOGI("trace: %zu events written to %s", events.size(), path);
+    return true;
+}
+
+#endif
@@ -0,0 +1,88 @@
+// trace.h
+// Timeline markers for finding out why one particular frame hitched.
+//
+// TRACE_SCOPE("name") marks the enclosing scope. On a device it becomes an
+// ATrace_beginSection / ATrace_endSection pair and shows up in systrace and Perfetto captures. On the
+// Linux host build each scope is one complete event in a lock-free ring that keeps the most recent
+// kTraceCapacity events; trace_write_json() exports it as Chrome trace-event JSON, which Perfetto
+// (ui.perfetto.dev) and chrome://tracing open directly.
+//
+// Tracing is off until trace_set_enabled(true). While it is off, a marker is one relaxed load and a
+// predicted branch. Names must be string literals: only the pointer is stored.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+extern std::atomic<bool> gTraceEnabled;
+
+void trace_set_enabled(bool enabled);
+
+static inline bool trace_enabled() {
+    return __builtin_expect(gTraceEnabled.load(std::memory_order_relaxed), 0);
+}
+
+// Names the calling thread, for the OS (pthread_setname_np, at most 15 characters) and the trace.
+void trace_set_thread_name(const char* name);
+
+static const int64_t TRACE_NO_ARG = INT64_MIN;
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, int64_t arg = TRACE_NO_ARG) {
+        if (trace_enabled()) begin(name, arg);
+    }
+    ~TraceScope() {
+        if (name_) end();
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    void begin(const char* name, int64_t arg);
+    void end();
+
+    const char* name_ = nullptr;   // set only when this scope was traced
+    int64_t t0_ = 0;
+    int64_t arg_ = 0;
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+// arg is shown as args.value of the event (host only).
+#define TRACE_SCOPE_ARG(name, arg) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name, (int64_t)(arg))
+
+#ifndef __ANDROID__
+
+static const size_t kTraceCapacity = 1u << 16;   // ~70 s of a typical frame loop
+
+struct trace_event {
+    const char* name;
+    int64_t ts_ns;     // latency_now_ns() at the start of the scope
+    int64_t dur_ns;
+    int64_t arg;       // TRACE_NO_ARG when the scope has none
+    uint32_t tid;
+};
+
+struct trace_stats {
+    uint64_t events;         // recorded since the last clear
+    uint64_t overwritten;    // older events the ring no longer holds
+    uint64_t dropped;        // the slot was still being written a lap behind
+};
+
+// Record one complete event; what TraceScope does on the host.
+void trace_emit(const char* name, int64_t ts_ns, int64_t dur_ns, int64_t arg);
+
+// Events still in the ring, oldest first. Events being written at that moment are skipped.
+size_t trace_snapshot(std::vector<trace_event>* out);
+void trace_clear();
+void trace_get_stats(trace_stats* out);
+
+// The ring as {"traceEvents": [...]}, with thread names as metadata events.
+bool trace_write_json(const char* path);
+
+#endif
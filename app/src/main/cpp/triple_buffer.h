@@ -0,0 +1,52 @@
+// triple_buffer.h
+// Single-producer / single-consumer triple buffer over three slot indices.
+//
+// The producer always owns the back slot and the consumer the front slot; the middle slot is
+// swapped atomically. Publishing never blocks, and the consumer always gets the most recent
+// completed slot. A publish that replaces a slot the consumer never took reports it as dropped.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+class TripleBuffer {
+public:
+    // Slot the producer may write into.
+    unsigned back() const { return back_; }
+
+    // Slot the consumer may read from (valid after the first successful acquire()).
+    unsigned front() const { return front_; }
+
+    // Producer: hand the back slot over and take a new one. Returns true if the slot being
+    // replaced held a frame that was never acquired (i.e. a frame was dropped).
+    bool publish() {
+        uint8_t prev = middle_.exchange((uint8_t)(back_ | kFresh), std::memory_order_acq_rel);
+        back_ = prev & kIndexMask;
+        return (prev & kFresh) != 0;
+    }
+
+    // Consumer: take the latest published slot as front. False if nothing new was published.
+    bool acquire() {
+        if (!(middle_.load(std::memory_order_relaxed) & kFresh)) return false;
+        uint8_t prev = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = prev & kIndexMask;
+        return true;
+    }
+
+    // Forget any published frame. Only call while neither side is active.
+    void reset() {
+        back_ = 0;
+        front_ = 1;
+        middle_.store(2, std::memory_order_relaxed);
+    }
+
+private:
+    static const uint8_t kIndexMask = 0x3;
+    static const uint8_t kFresh = 0x4;
+
+    // separate cache lines: back_ is producer-only, front_ consumer-only
+    alignas(64) uint8_t back_ = 0;
+    alignas(64) uint8_t front_ = 1;
+    alignas(64) std::atomic<uint8_t> middle_{2};
+};
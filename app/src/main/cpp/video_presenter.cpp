@@ -0,0 +1,372 @@
+// video_presenter.cpp
+// Frame presentation to the ANativeWindow (see video_presenter.h).
+//
+// video_cb runs on the emulation thread and only stages the frame into the back slot of a triple
+// buffer, already in the window's format. The presenter thread takes the newest staged frame and
+// does ANativeWindow_lock / copy / unlockAndPost, so compositor back-pressure never reaches retro_run.
+//
+// Frames carry the time of the oldest input they are the first to reflect; the presenter records
+// input-to-post latency right after unlockAndPost. A dropped frame hands its tag to the next one.
+
+#include "video_presenter.h"
+#include "latency_histogram.h"
+#include "libretro_defs.h"
+#include "perf_stats.h"
+#include "pixel_convert.h"
+#include "thread_placement.h"
+#include "trace.h"
+#include "triple_buffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define LOG_TAG "VideoPresenter"
+
+static ANativeWindow* gWindow = nullptr;
+static std::mutex gWindowMutex;
+static std::atomic<int> gPixelFormat(RETRO_PIXEL_FORMAT_0RGB1555);
+
+// Geometry the window is currently configured with (width 0: unknown), guarded by gWindowMutex.
+struct window_geometry {
+    unsigned width;
+    unsigned height;
+    int format;
+};
+static window_geometry gApplied = {0, 0, 0};
+
+// What the core announced, width << 32 | height. Published by the emulation thread without
+// taking gWindowMutex, which the presenter holds across lock and post; the presenter thread
+// reconfigures the window when gGeometryPending is set.
+static std::atomic<uint64_t> gBaseGeometry(0);
+static std::atomic<uint64_t> gMaxGeometry(0);
+static std::atomic<bool> gGeometryPending(false);
+
+static uint64_t pack_geometry(unsigned width, unsigned height) {
+    return (uint64_t)width << 32 | height;
+}
+
+// A staged frame, tightly packed in its window format.
+struct frame_slot {
+    std::vector<uint8_t> pixels;
+    unsigned width = 0;
+    unsigned height = 0;
+    size_t pitch = 0;
+    int window_format = 0;
+    int64_t input_ns = 0;    // latency_now_ns() of the input this frame answers, 0 if none
+};
+static frame_slot gSlots[3];
+static TripleBuffer gFrames;
+
+static std::thread gPresenterThread;
+static std::atomic<bool> gPresenting(false);
+static std::mutex gWakeMutex;
+static std::condition_variable gWakeCv;
+static bool gWakePending = false;
+
+static std::atomic<uint64_t> gFramesSubmitted(0);
+static std::atomic<uint64_t> gFramesPosted(0);
+static std::atomic<uint64_t> gFramesConverted(0);
+static std::atomic<uint64_t> gFramesZeroCopy(0);
+static std::atomic<uint64_t> gFramesDropped(0);
+static std::atomic<uint64_t> gFramesDuplicated(0);
+static std::atomic<uint64_t> gBytesRead(0);
+static std::atomic<uint64_t> gBytesStaged(0);
+static std::atomic<uint64_t> gBytesWritten(0);
+static std::atomic<uint64_t> gReconfigurations(0);
+static std::atomic<uint64_t> gVideoCbNsTotal(0);
+static std::atomic<uint64_t> gVideoCbNsMax(0);
+
+static LatencyHistogram gInputLatency;
+static int64_t gCarriedInputNs = 0;   // emulation thread: tag of a dropped frame
+
+static unsigned bytes_per_pixel(int retro_format) {
+    return retro_format == RETRO_PIXEL_FORMAT_XRGB8888 ? 4 : 2;
+}
+
+static unsigned window_bytes_per_pixel(int window_format) {
+    return window_format == WINDOW_FORMAT_RGB_565 ? 2 : 4;
+}
+
+// Copy rows of equal format; a single memcpy when both sides are laid out identically.
+static void copy_rows(void* dst, size_t dst_pitch, const void* src, size_t src_pitch,
+                      size_t row_bytes, unsigned height) {
+    if (!height) return;
+    if (dst_pitch == src_pitch) {
+        memcpy(dst, src, src_pitch * (height - 1) + row_bytes);
+        return;
+    }
+    const uint8_t* s = (const uint8_t*)src;
+    uint8_t* d = (uint8_t*)dst;
+    for (unsigned y = 0; y < height; ++y) {
+        memcpy(d + y * dst_pitch, s + y * src_pitch, row_bytes);
+    }
+}
+
+// Caller holds gWindowMutex.
+static bool apply_geometry(unsigned width, unsigned height, int window_format) {
+    if (!gWindow) return false;
+    if (gApplied.width == width && gApplied.height == height && gApplied.format == window_format) {
+        return true;
+    }
+    if (ANativeWindow_setBuffersGeometry(gWindow, width, height, window_format) != 0) {
+        LOGE("setBuffersGeometry(%u, %u, %d) failed", width, height, window_format);
+        gApplied = {0, 0, 0};
+        return false;
+    }
+    gApplied = {width, height, window_format};
+    gReconfigurations.fetch_add(1, std::memory_order_relaxed);
+    LOGI("window geometry %ux%u format %d", width, height, window_format);
+    return true;
+}
+
+// Caller holds gWindowMutex.
+static void apply_base_geometry() {
+    const uint64_t base = gBaseGeometry.load(std::memory_order_relaxed);
+    const unsigned width = (unsigned)(base >> 32), height = (unsigned)base;
+    if (width && height) {
+        apply_geometry(width, height, presenter_window_format(gPixelFormat.load(std::memory_order_relaxed)));
+    }
+}
+
+// Presenter thread
+static void apply_pending_geometry() {
+    if (!gGeometryPending.exchange(false, std::memory_order_acquire)) return;
+    std::lock_guard<std::mutex> lk(gWindowMutex);
+    apply_base_geometry();
+}
+
+// Size all slots for the largest frame the core may send, so staging never allocates.
+// Only while the presenter is stopped: slots are owned by the two threads while running.
+static void reserve_slots(unsigned max_width, unsigned max_height) {
+    if (gPresenting.load() || !max_width || !max_height) return;
+    size_t need = (size_t)max_width * max_height * 4;
+    for (frame_slot& s : gSlots) {
+        if (s.pixels.size() < need) s.pixels.resize(need);
+    }
+}
+
+static void present_slot(const frame_slot& s) {
+    std::lock_guard<std::mutex> lk(gWindowMutex);
+    if (!gWindow || !s.width || !s.height) return;
+    if (!apply_geometry(s.width, s.height, s.window_format)) return;
+    PERF_SCOPE(PERF_VIDEO_POST);
+    ANativeWindow_Buffer buf;
+    {
+        TRACE_SCOPE("window_lock");
+        if (ANativeWindow_lock(gWindow, &buf, nullptr) != 0) return;
+    }
+
+    // never write outside the buffer we were handed, whatever geometry the window settled on
+    unsigned w = s.width < (unsigned)buf.width ? s.width : (unsigned)buf.width;
+    unsigned h = s.height < (unsigned)buf.height ? s.height : (unsigned)buf.height;
+    unsigned bpp = window_bytes_per_pixel(buf.format);
+    if (bpp == window_bytes_per_pixel(s.window_format)) {
+        TRACE_SCOPE("window_copy");
+        copy_rows(buf.bits, (size_t)buf.stride * bpp, s.pixels.data(), s.pitch, (size_t)w * bpp, h);
+        gBytesWritten.fetch_add((uint64_t)w * h * bpp, std::memory_order_relaxed);
+    } else {
+        LOGE("window format %d cannot show staged format %d", buf.format, s.window_format);
+    }
+
+    {
+        TRACE_SCOPE("window_post");
+        ANativeWindow_unlockAndPost(gWindow);
+    }
+    if (s.input_ns) gInputLatency.record(latency_now_ns() - s.input_ns);
+    gFramesPosted.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void presenter_thread_main() {
+    trace_set_thread_name("saasemu-present");
+    thread_placement_apply(THREAD_ROLE_PRESENT);
+    LOGI("Presenter thread started");
+    apply_pending_geometry();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(gWakeMutex);
+            gWakeCv.wait(lk, [] { return gWakePending || !gPresenting.load(); });
+            gWakePending = false;
+        }
+        if (!gPresenting.load()) break;
+        thread_placement_sample(THREAD_ROLE_PRESENT);
+        apply_pending_geometry();
+        if (gFrames.acquire()) present_slot(gSlots[gFrames.front()]);
+    }
+    LOGI("Presenter thread stopped");
+}
+
+void presenter_set_window(ANativeWindow* win) {
+    std::lock_guard<std::mutex> lk(gWindowMutex);
+    if (gWindow) ANativeWindow_release(gWindow);
+    gWindow = win;
+    gApplied = {0, 0, 0};
+    apply_base_geometry();
+}
+
+void presenter_set_pixel_format(int retro_format) {
+    gPixelFormat.store(retro_format, std::memory_order_relaxed);
+}
+
+void presenter_set_geometry(unsigned base_width, unsigned base_height,
+                            unsigned max_width, unsigned max_height) {
+    uint64_t max = gMaxGeometry.load(std::memory_order_relaxed);
+    const unsigned max_w = max_width ? max_width : (unsigned)(max >> 32);
+    const unsigned max_h = max_height ? max_height : (unsigned)max;
+    gMaxGeometry.store(pack_geometry(max_w, max_h), std::memory_order_relaxed);
+    gBaseGeometry.store(pack_geometry(base_width, base_height), std::memory_order_relaxed);
+    gGeometryPending.store(true, std::memory_order_release);
+    LOGI("core geometry %ux%u (max %ux%u)", base_width, base_height, max_w, max_h);
+    reserve_slots(max_w, max_h);
+}
+
+void presenter_begin_session() {
+    std::lock_guard<std::mutex> lk(gWindowMutex);
+    gApplied = {0, 0, 0};
+    gBaseGeometry.store(0, std::memory_order_relaxed);
+    gMaxGeometry.store(0, std::memory_order_relaxed);
+    gGeometryPending.store(false, std::memory_order_relaxed);
+    if (!gPresenting.load()) gFrames.reset();
+    for (frame_slot& s : gSlots) s.input_ns = 0;
+    gCarriedInputNs = 0;
+    gInputLatency.clear();
+    gFramesSubmitted.store(0, std::memory_order_relaxed);
+    gFramesPosted.store(0, std::memory_order_relaxed);
+    gFramesConverted.store(0, std::memory_order_relaxed);
+    gFramesZeroCopy.store(0, std::memory_order_relaxed);
+    gFramesDropped.store(0, std::memory_order_relaxed);
+    gFramesDuplicated.store(0, std::memory_order_relaxed);
+    gBytesRead.store(0, std::memory_order_relaxed);
+    gBytesStaged.store(0, std::memory_order_relaxed);
+    gBytesWritten.store(0, std::memory_order_relaxed);
+    gReconfigurations.store(0, std::memory_order_relaxed);
+    gVideoCbNsTotal.store(0, std::memory_order_relaxed);
+    gVideoCbNsMax.store(0, std::memory_order_relaxed);
+}
+
+int presenter_window_format(int retro_format) {
+    return retro_format == RETRO_PIXEL_FORMAT_RGB565 ? WINDOW_FORMAT_RGB_565 : WINDOW_FORMAT_RGBA_8888;
+}
+
+void presenter_start() {
+    if (gPresenting.exchange(true)) return;
+    gPresenterThread = std::thread(presenter_thread_main);
+}
+
+void presenter_stop() {
+    if (!gPresenting.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lk(gWakeMutex);
+        gWakePending = true;
+    }
+    gWakeCv.notify_one();
+    if (gPresenterThread.joinable()) gPresenterThread.join();
+}
+
+bool presenter_get_software_framebuffer(retro_framebuffer* fb) {
+    if (!fb || !fb->width || !fb->height) return false;
+    const int fmt = gPixelFormat.load(std::memory_order_relaxed);
+    const int wfmt = presenter_window_format(fmt);
+    // only when the slot can hold the core's format as-is; otherwise the core keeps its own
+    // buffer and video_cb converts as usual
+    if (wfmt != WINDOW_FORMAT_RGB_565 || fmt != RETRO_PIXEL_FORMAT_RGB565) return false;
+    // the back slot holds the frame from two presents ago, not the core's last one, so a core
+    // that reads back to redraw only what changed needs its own buffer
+    if (fb->access_flags & RETRO_MEMORY_ACCESS_READ) return false;
+
+    frame_slot& s = gSlots[gFrames.back()];
+    size_t pitch = (size_t)fb->width * window_bytes_per_pixel(wfmt);
+    if (s.pixels.size() < pitch * fb->height) s.pixels.resize(pitch * fb->height);
+    fb->data = s.pixels.data();
+    fb->pitch = pitch;
+    fb->format = fmt;
+    fb->memory_flags = RETRO_MEMORY_TYPE_CACHED;
+    return true;
+}
+
+void presenter_submit_frame(const void* data, unsigned width, unsigned height, size_t pitch, int64_t input_ns) {
+    auto t0 = std::chrono::steady_clock::now();
+    gFramesSubmitted.fetch_add(1, std::memory_order_relaxed);
+
+    if (!data) {
+        // frame dupe: the previous frame stays on screen
+        gFramesDuplicated.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        const int fmt = gPixelFormat.load(std::memory_order_relaxed);
+        const int wfmt = presenter_window_format(fmt);
+        const unsigned bpp = window_bytes_per_pixel(wfmt);
+        frame_slot& s = gSlots[gFrames.back()];
+        const bool in_slot = data == s.pixels.data() && wfmt == WINDOW_FORMAT_RGB_565 &&
+                             pitch == (size_t)width * bpp && pitch * height <= s.pixels.size();
+        s.pitch = (size_t)width * bpp;
+        if (s.pixels.size() < s.pitch * height) s.pixels.resize(s.pitch * height);
+        if (in_slot) {
+            // rendered into the slot through GET_CURRENT_SOFTWARE_FRAMEBUFFER
+            gFramesZeroCopy.fetch_add(1, std::memory_order_relaxed);
+        } else if (wfmt == WINDOW_FORMAT_RGB_565) {
+            PERF_SCOPE(PERF_VIDEO_CONVERT);
+            TRACE_SCOPE("stage_copy");
+            copy_rows(s.pixels.data(), s.pitch, data, pitch, s.pitch, height);
+        } else {
+            PERF_SCOPE(PERF_VIDEO_CONVERT);
+            TRACE_SCOPE("pixel_convert");
+            pixel_convert_frame(fmt, s.pixels.data(), s.pitch, data, pitch, width, height);
+            gFramesConverted.fetch_add(1, std::memory_order_relaxed);
+        }
+        s.width = width;
+        s.height = height;
+        s.window_format = wfmt;
+        if (gCarriedInputNs && (!input_ns || gCarriedInputNs < input_ns)) input_ns = gCarriedInputNs;
+        s.input_ns = input_ns;
+        gCarriedInputNs = 0;
+        if (!in_slot) {
+            gBytesRead.fetch_add((uint64_t)width * height * bytes_per_pixel(fmt), std::memory_order_relaxed);
+            gBytesStaged.fetch_add((uint64_t)s.pitch * height, std::memory_order_relaxed);
+        }
+
+        if (gFrames.publish()) {
+            gFramesDropped.fetch_add(1, std::memory_order_relaxed);
+            gCarriedInputNs = gSlots[gFrames.back()].input_ns;
+        }
+        {
+            std::lock_guard<std::mutex> lk(gWakeMutex);
+            gWakePending = true;
+        }
+        gWakeCv.notify_one();
+    }
+
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+    gVideoCbNsTotal.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > gVideoCbNsMax.load(std::memory_order_relaxed)) {
+        gVideoCbNsMax.store(ns, std::memory_order_relaxed); // single writer: the emulation thread
+    }
+}
+
+void presenter_get_stats(presenter_stats* out) {
+    if (!out) return;
+    out->frames_submitted = gFramesSubmitted.load(std::memory_order_relaxed);
+    out->frames_posted = gFramesPosted.load(std::memory_order_relaxed);
+    out->frames_converted = gFramesConverted.load(std::memory_order_relaxed);
+    out->frames_zero_copy = gFramesZeroCopy.load(std::memory_order_relaxed);
+    out->frames_dropped = gFramesDropped.load(std::memory_order_relaxed);
+    out->frames_duplicated = gFramesDuplicated.load(std::memory_order_relaxed);
+    out->bytes_read = gBytesRead.load(std::memory_order_relaxed);
+    out->bytes_staged = gBytesStaged.load(std::memory_order_relaxed);
+    out->bytes_written = gBytesWritten.load(std::memory_order_relaxed);
+    out->reconfigurations = gReconfigurations.load(std::memory_order_relaxed);
+    out->video_cb_ns_total = gVideoCbNsTotal.load(std::memory_order_relaxed);
+    out->video_cb_ns_max = gVideoCbNsMax.load(std::memory_order_relaxed);
+}
+
+void presenter_get_input_latency(latency_summary* out) {
+    if (out) gInputLatency.summarize(out);
+}
+
+size_t presenter_get_input_latency_histogram(uint32_t* out, size_t n) {
+    return gInputLatency.buckets(out, n);
+}
@@ -0,0 +1,84 @@
+// video_presenter.h
+// Owns the ANativeWindow and puts core frames on it. The window format is negotiated with the
+// core's pixel format: RGB565 frames go to an RGB_565 window untouched, other formats are
+// converted to RGBA_8888 through pixel_convert.
+//
+// Window geometry is cached: ANativeWindow_setBuffersGeometry is only called when the frame size or
+// format actually changes, when the window is replaced, or when the core announces new geometry.
+//
+// Frames are handed from the emulation thread to a presenter thread through a triple buffer;
+// the emulation thread never waits on the window. Stale frames are dropped, only the newest
+// completed frame is shown.
+//
+// Cores that support RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER render straight into the
+// back slot when their pixel format is the window format (RGB565); the frame then reaches the
+// presenter without any copy on the emulation thread.
+//
+// Input-to-photon latency: each frame can carry the timestamp (latency_now_ns) of the oldest input
+// it is the first to reflect. When such a frame reaches ANativeWindow_unlockAndPost the elapsed
+// time goes into a per-session histogram.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "platform.h"
+
+struct latency_summary;
+
+struct presenter_stats {
+    uint64_t frames_submitted;    // video_cb calls
+    uint64_t frames_posted;       // frames that reached ANativeWindow_unlockAndPost
+    uint64_t frames_converted;    // frames that went through pixel conversion
+    uint64_t frames_zero_copy;    // frames rendered directly into a slot by the core
+    uint64_t frames_dropped;      // staged frames replaced before the presenter took them
+    uint64_t frames_duplicated;   // video_cb with NULL data (previous frame kept on screen)
+    uint64_t bytes_read;          // bytes read from core frames
+    uint64_t bytes_staged;        // bytes written into triple buffer slots
+    uint64_t bytes_written;       // bytes written into window buffers
+    uint64_t reconfigurations;    // ANativeWindow_setBuffersGeometry calls this session
+    uint64_t video_cb_ns_total;   // emulation thread time spent in video_cb
+    uint64_t video_cb_ns_max;
+};
+
+// Takes over the caller's window reference; nullptr releases the current window.
+void presenter_set_window(ANativeWindow* win);
+
+// RETRO_PIXEL_FORMAT_* the core renders in.
+void presenter_set_pixel_format(int retro_format);
+
+struct retro_framebuffer;
+
+// RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER, emulation thread only. On input fb holds the
+// size and access flags the core wants; returns false when a slot cannot be handed out for it.
+bool presenter_get_software_framebuffer(retro_framebuffer* fb);
+
+// Geometry from retro_get_system_av_info (at game load) or RETRO_ENVIRONMENT_SET_GEOMETRY /
+// SET_SYSTEM_AV_INFO. The window is sized for the base geometry before the first frame so that
+// frame does not reconfigure it. Never waits for the presenter, which reconfigures the window
+// itself; 0 max keeps the previous max.
+void presenter_set_geometry(unsigned base_width, unsigned base_height,
+                            unsigned max_width, unsigned max_height);
+
+// Start of a new game: clears statistics and cached geometry.
+void presenter_begin_session();
+
+// Window format used for a core pixel format.
+int presenter_window_format(int retro_format);
+
+// Presenter thread lifetime, tied to the emulation thread.
+void presenter_start();
+void presenter_stop();
+
+// Called from video_cb on the emulation thread. input_ns tags the frame with the input it answers
+// (0: none); a NULL (dupe) frame ignores it, so the caller keeps it for the next real frame.
+void presenter_submit_frame(const void* data, unsigned width, unsigned height, size_t pitch,
+                            int64_t input_ns);
+
+void presenter_get_stats(presenter_stats* out);
+
+// Input-to-post latency this session; the histogram has LatencyHistogram::kBuckets buckets of
+// kBucketNs each (see latency_histogram.h). Returns the bucket count.
+void presenter_get_input_latency(latency_summary* out);
+size_t presenter_get_input_latency_histogram(uint32_t* out, size_t n);
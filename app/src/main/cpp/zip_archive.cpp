@@ -0,0 +1,242 @@
+// zip_archive.cpp
+// Central directory parsing and streaming inflate for .zip content (see zip_archive.h).
+
+#include "zip_archive.h"
+#include "platform.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#define LOG_TAG "ZipArchive"
+
+static const size_t kChunk = 256 * 1024;
+static const uint32_t kEndOfDirectory = 0x06054b50;
+static const uint32_t kDirectoryEntry = 0x02014b50;
+static const uint32_t kLocalHeader = 0x04034b50;
+
+static inline uint16_t le16(const uint8_t* p) { return (uint16_t)(p[0] | p[1] << 8); }
+static inline uint32_t le32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static bool read_at(int fd, void* dst, size_t n, uint64_t offset) {
+    uint8_t* d = (uint8_t*)dst;
+    while (n) {
+        ssize_t r = pread(fd, d, n, (off_t)offset);
+        if (r <= 0) return false;
+        d += r;
+        n -= (size_t)r;
+        offset += (uint64_t)r;
+    }
+    return true;
+}
+
+static bool has_magic(const char* path, const uint8_t* magic, size_t n) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    uint8_t head[8];
+    bool ok = read_at(fd, head, n, 0) && !memcmp(head, magic, n);
+    ::close(fd);
+    return ok;
+}
+
+bool archive_is_zip(const char* path) {
+    static const uint8_t kMagic[4] = {'P', 'K', 3, 4};
+    return path && has_magic(path, kMagic, sizeof(kMagic));
+}
+
+bool archive_is_7z(const char* path) {
+    static const uint8_t kMagic[6] = {'7', 'z', 0xBC, 0xAF, 0x27, 0x1C};
+    return path && has_magic(path, kMagic, sizeof(kMagic));
+}
+
+bool ZipArchive::open(const char* path) {
+    close();
+    fd_ = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) return false;
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || st.st_size < 22) {
+        close();
+        return false;
+    }
+
+    // The end-of-directory record sits in the last 22 + up to 65535 (comment) bytes.
+    const uint64_t file_size = (uint64_t)st.st_size;
+    const size_t tail_size = (size_t)std::min<uint64_t>(file_size, 22 + 65535);
+    std::vector<uint8_t> tail(tail_size);
+    if (!read_at(fd_, tail.data(), tail_size, file_size - tail_size)) {
+        close();
+        return false;
+    }
+    const uint8_t* eocd = nullptr;
+    for (size_t i = tail_size - 22 + 1; i-- > 0;) {
+        if (le32(&tail[i]) == kEndOfDirectory) {
+            eocd = &tail[i];
+            break;
+        }
+    }
+    if (!eocd) {
+        close();
+        return false;
+    }
+    const unsigned count = le16(eocd + 10);
+    const uint32_t dir_size = le32(eocd + 12), dir_offset = le32(eocd + 16);
+    if (count == 0xFFFF || dir_offset == 0xFFFFFFFFu || (uint64_t)dir_offset + dir_size > file_size) {
+        LOGE("%s: ZIP64 archives are not supported", path);
+        close();
+        return false;
+    }
+
+    std::vector<uint8_t> dir(dir_size);
+    if (!read_at(fd_, dir.data(), dir_size, dir_offset)) {
+        close();
+        return false;
+    }
+    size_t at = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        if (at + 46 > dir.size() || le32(&dir[at]) != kDirectoryEntry) break;
+        const uint8_t* h = &dir[at];
+        const uint16_t flags = le16(h + 8);
+        const size_t name_len = le16(h + 28), extra_len = le16(h + 30), comment_len = le16(h + 32);
+        if (at + 46 + name_len > dir.size()) break;
+        zip_entry e;
+        e.method = le16(h + 10);
+        e.crc32 = le32(h + 16);
+        e.compressed = le32(h + 20);
+        e.size = le32(h + 24);
+        e.header_offset = le32(h + 42);
+        e.name.assign((const char*)h + 46, name_len);
+        at += 46 + name_len + extra_len + comment_len;
+        if (e.name.empty() || e.name.back() == '/') continue;   // directory
+        if (flags & 1) continue;                                // encrypted
+        if (e.size == 0xFFFFFFFFu || e.compressed == 0xFFFFFFFFu || e.header_offset == 0xFFFFFFFFu) continue;
+        entries_.push_back(std::move(e));
+    }
+    return true;
+}
+
+void ZipArchive::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    entries_.clear();
+}
+
+static std::string lower_extension(const std::string& name) {
+    size_t dot = name.rfind('.');
+    size_t slash = name.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return std::string();
+    std::string ext = name.substr(dot + 1);
+    for (char& c : ext) c = (char)tolower((unsigned char)c);
+    return ext;
+}
+
+int ZipArchive::pick(const char* valid_extensions) const {
+    if (valid_extensions && *valid_extensions) {
+        std::string list = valid_extensions;
+        for (char& c : list) c = (char)tolower((unsigned char)c);
+        list = "|" + list + "|";
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            std::string ext = lower_extension(entries_[i].name);
+            if (!ext.empty() && list.find("|" + ext + "|") != std::string::npos) return (int)i;
+        }
+    }
+    int best = -1;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (best < 0 || entries_[i].size > entries_[best].size) best = (int)i;
+    }
+    return best;
+}
+
+bool ZipArchive::data_offset(const zip_entry& entry, uint64_t* out) {
+    uint8_t h[30];
+    if (!read_at(fd_, h, sizeof(h), entry.header_offset) || le32(h) != kLocalHeader) return false;
+    *out = entry.header_offset + 30 + le16(h + 26) + le16(h + 28);
+    return true;
+}
+
+template <typename Sink>
+bool ZipArchive::inflate_entry(const zip_entry& entry, Sink sink) {
+    uint64_t offset;
+    if (fd_ < 0 || !data_offset(entry, &offset)) return false;
+    if (entry.method != 0 && entry.method != 8) {
+        LOGE("%s: compression method %u is not supported", entry.name.c_str(), entry.method);
+        return false;
+    }
+
+    std::vector<uint8_t> in(kChunk), out(kChunk);
+    uLong crc = crc32(0L, Z_NULL, 0);
+    uint64_t produced = 0, remaining = entry.compressed;
+
+    if (entry.method == 0) {
+        while (remaining) {
+            size_t n = (size_t)std::min<uint64_t>(remaining, kChunk);
+            if (!read_at(fd_, in.data(), n, offset)) return false;
+            crc = crc32(crc, in.data(), (uInt)n);
+            if (!sink(in.data(), n)) return false;
+            offset += n;
+            remaining -= n;
+            produced += n;
+        }
+    } else {
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) return false;
+        int rc = Z_OK;
+        while (rc != Z_STREAM_END) {
+            if (zs.avail_in == 0) {
+                if (!remaining) break;
+                size_t n = (size_t)std::min<uint64_t>(remaining, kChunk);
+                if (!read_at(fd_, in.data(), n, offset)) break;
+                offset += n;
+                remaining -= n;
+                zs.next_in = in.data();
+                zs.avail_in = (uInt)n;
+            }
+            zs.next_out = out.data();
+            zs.avail_out = (uInt)out.size();
+            rc = inflate(&zs, Z_NO_FLUSH);
+            if (rc != Z_OK && rc != Z_STREAM_END) break;
+            size_t n = out.size() - zs.avail_out;
+            if (produced + n > entry.size) break;
+            crc = crc32(crc, out.data(), (uInt)n);
+            if (n && !sink(out.data(), n)) break;
+            produced += n;
+        }
+        inflateEnd(&zs);
+        if (rc != Z_STREAM_END) {
+            LOGE("%s: corrupt deflate stream", entry.name.c_str());
+            return false;
+        }
+    }
+    if (produced != entry.size || (uint32_t)crc != entry.crc32) {
+        LOGE("%s: size or CRC mismatch", entry.name.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ZipArchive::extract(const zip_entry& entry, void* dst) {
+    uint8_t* d = (uint8_t*)dst;
+    return inflate_entry(entry, [&](const uint8_t* data, size_t n) {
+        memcpy(d, data, n);
+        d += n;
+        return true;
+    });
+}
+
+bool ZipArchive::extract_to_fd(const zip_entry& entry, int fd) {
+    return inflate_entry(entry, [&](const uint8_t* data, size_t n) {
+        while (n) {
+            ssize_t w = write(fd, data, n);
+            if (w <= 0) return false;
+            data += w;
+            n -= (size_t)w;
+        }
+        return true;
+    });
+}
@@ -0,0 +1,58 @@
+// zip_archive.h
+// Minimal reader for .zip content: the central directory, and streaming extraction of one entry
+// (stored or deflate, through zlib) into memory or a file descriptor. The archive is read in
+// fixed-size chunks, so extracting a large ROM never holds the compressed data in memory.
+//
+// Not supported: ZIP64, encryption, and methods other than stored/deflate. 7z is only
+// recognized, so the caller can say why the content cannot be opened.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct zip_entry {
+    std::string name;
+    uint64_t size;          // uncompressed
+    uint64_t compressed;
+    uint32_t crc32;
+    uint16_t method;        // 0 stored, 8 deflate
+    uint64_t header_offset; // local file header
+};
+
+class ZipArchive {
+public:
+    ZipArchive() = default;
+    ~ZipArchive() { close(); }
+    ZipArchive(const ZipArchive&) = delete;
+    ZipArchive& operator=(const ZipArchive&) = delete;
+
+    // Read the central directory. False if path is not a zip archive this reader can handle.
+    bool open(const char* path);
+    void close();
+
+    const std::vector<zip_entry>& entries() const { return entries_; }
+
+    // Entry to hand to a core: the first one whose extension is in valid_extensions
+    // ("sfc|smc", case-insensitive), else the largest file. -1 if the archive holds no files.
+    int pick(const char* valid_extensions) const;
+
+    // Decompress entry into dst (entry.size bytes) and check its CRC.
+    bool extract(const zip_entry& entry, void* dst);
+    // Same, written to fd.
+    bool extract_to_fd(const zip_entry& entry, int fd);
+
+private:
+    // Calls sink(data, n) for each decompressed chunk; false from sink aborts.
+    template <typename Sink> bool inflate_entry(const zip_entry& entry, Sink sink);
+    bool data_offset(const zip_entry& entry, uint64_t* out);
+
+    int fd_ = -1;
+    std::vector<zip_entry> entries_;
+};
+
+// Archive formats by magic number, regardless of the file name.
+bool archive_is_zip(const char* path);
+bool archive_is_7z(const char* path);
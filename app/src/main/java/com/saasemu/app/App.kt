@@ -2,6 +2,7 @@ package emu.saasemu.app
 
 import android.app.Application
 import com.google.android.material.color.DynamicColors
+import emu.saasemu.app.core.NativeBridge
 
 class App : Application() {
     override fun onCreate() {
@@ -9,5 +10,9 @@ class App : Application() {
 
         // Ativa Material You quando disponível (Android 12+)
         DynamicColors.applyToActivitiesIfAvailable(this)
+
+        // Native scratch files (run-ahead core copy, unpacked archives, core info cache) go here
+        // instead of the shared temp directory
+        NativeBridge.initNative(filesDir.absolutePath)
     }
 }
\ No newline at end of file
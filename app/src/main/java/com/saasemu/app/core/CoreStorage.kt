@@ -8,6 +8,15 @@ import java.io.File
 import java.io.FileOutputStream
 import java.io.InputStream
 
+data class RomInfo(
+    val path: String,
+    val size: Long,
+    val crc32: String,
+    val sha1: String,   // empty for archives
+    val system: String, // empty when no DAT matched
+    val title: String
+)
+
 object CoreStorage {
 
     fun coresDir(context: Context): File {
@@ -28,6 +37,26 @@ object CoreStorage {
         return f
     }
 
+    fun datDir(context: Context): File {
+        val f = File(context.filesDir, "dat")
+        if (!f.exists()) f.mkdirs()
+        return f
+    }
+
+    /**
+     * Scan romsDir (and any extra directories) natively. Files already in the index with the same
+     * size and mtime are not read again, so rescans are cheap. Blocking: call off the UI thread.
+     */
+    fun scanLibrary(context: Context, extraDirs: List<File> = emptyList()): List<RomInfo> {
+        val dirs = (listOf(romsDir(context)) + extraDirs.filter { it.isDirectory })
+            .map { it.absolutePath }.toTypedArray()
+        val index = File(context.filesDir, "library.idx").absolutePath
+        return NativeBridge.scanRomLibrary(dirs, index, datDir(context).absolutePath).mapNotNull { row ->
+            val f = row.split('\t')
+            if (f.size < 6) null else RomInfo(f[0], f[1].toLongOrNull() ?: 0L, f[2], f[3], f[4], f[5])
+        }
+    }
+
     /**
      * Copy a content Uri (from SAF or other providers) into the destination directory.
      * Returns the File object on success, or null on failure.
@@ -63,11 +92,18 @@ object CoreStorage {
     }
 
     /**
-     * Utility: find the first core file (.so) present in coresDir, or null.
+     * Utility: find the first loadable core file (.so) present in coresDir, or null.
      */
     fun findFirstCore(context: Context): File? {
-        val files = coresDir(context).listFiles()?.filter { it.isFile && it.name.endsWith(".so") }
-        return files?.firstOrNull()
+        val files = coresDir(context).listFiles()?.filter { it.isFile && it.name.endsWith(".so") }?.sortedBy { it.name }
+        return files?.firstOrNull { NativeBridge.loadCoreCheck(it.absolutePath) }
+    }
+
+    /**
+     * The first loadable core in coresDir whose supported extensions cover the ROM, or null.
+     */
+    fun findCoreFor(context: Context, romPath: String): File? {
+        return NativeBridge.findCoreForContent(coresDir(context).absolutePath, romPath)?.let { File(it) }
     }
 
     /**
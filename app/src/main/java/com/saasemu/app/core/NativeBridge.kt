@@ -11,13 +11,19 @@ object NativeBridge {
     // Initialization / directories
     external fun initNative(datapath: String): Boolean
     external fun setSystemDir(path: String)
+    external fun setSaveDir(path: String)
 
     // Core handling
     external fun loadCore(corePath: String): Boolean
+    // Core catalog: answered from ELF inspection and a cached probe, without loading the core here
     external fun loadCoreCheck(corePath: String): Boolean
+    external fun getCoreInfo(corePath: String): Array<String>? // [name, version, extensions, needFullpath, error]
+    external fun findCoreForContent(coresDir: String, romPath: String): String?
     external fun unloadCore(): Boolean
 
-    // Game handling
+    // Game handling. .zip content is unpacked natively; prefetchContent before loadCore lets
+    // the extraction run while the core loads.
+    external fun prefetchContent(path: String)
     external fun loadGame(path: String): Boolean
 
     // Emulation control
@@ -30,8 +36,51 @@ object NativeBridge {
 
     // Input
     external fun setButtonState(id: Int, pressed: Int)
+    // Packed events, two ints each: (kind shl 24 or port shl 16 or index shl 8 or id), value.
+    // Kinds and value packing are documented in cpp/input_state.h. Send a frame's changes at once.
+    external fun submitInput(events: IntArray, count: Int)
+    external fun setControllerPortDevice(port: Int, device: Int)
+    external fun getControllerTypeIds(port: Int): IntArray
+    external fun getControllerTypeNames(port: Int): Array<String>
 
     // Optional controls
     external fun setFastForward(enabled: Boolean)
+    external fun setFastForwardRatio(ratio: Float) // <= 0: unlimited
+    external fun getSpeedMultiplier(): Float
+    external fun setRewind(enabled: Boolean, interval: Int, budgetBytes: Long)
     external fun rewindFrames(frames: Int)
+    external fun setRewinding(held: Boolean)
+    external fun setRunAhead(frames: Int, secondInstance: Boolean) // 0 = off
+    external fun setAudioQuality(level: Int) // 0 linear, 1 sinc16 (default), 2 sinc32
+
+    // Input-to-photon latency this session: [count, mean, p50, p90, p99, max] in nanoseconds,
+    // and frame counts per 0.5 ms bucket (the last bucket collects everything longer)
+    external fun getInputLatency(): LongArray
+    external fun getInputLatencyHistogram(): IntArray
+
+    // Per-frame timings this session: [metrics, 6, then per metric count, mean, p50, p90, p99, max]
+    // in nanoseconds. Metrics: retro_run, video_cb, video_convert, video_post, audio_cb, input_poll,
+    // frame_interval, pacer_wait (cpp/perf_stats.h). Cheap enough to poll once a second.
+    external fun getStats(): LongArray
+    // Perf counters the core registered (RETRO_ENVIRONMENT_GET_PERF_INTERFACE): "ident\tcalls\ttotalNs"
+    external fun getCoreCounters(): Array<String>
+
+    // Trace sections for systrace / Perfetto (off by default; near free while off)
+    external fun setTracing(enabled: Boolean)
+
+    // Emulation thread on the fastest cores, presenter and audio elsewhere (on by default)
+    external fun setThreadPlacement(enabled: Boolean)
+    // Topology, per-thread affinity and nice value, and migrations seen, one line each
+    external fun getThreadPlacement(): String
+
+    // Minimum android.util.Log priority (Log.DEBUG .. Log.ERROR) for runtime and core messages
+    external fun setLogLevel(runtime: Int, core: Int)
+
+    // ROM library: walks dirs, hashes new or changed files and matches them against the DATs in
+    // datDir. Blocking. Rows are "path\tsize\tcrc32\tsha1\tsystem\ttitle" (see CoreStorage.scanLibrary)
+    external fun scanRomLibrary(dirs: Array<String>, indexPath: String, datDir: String): Array<String>
+
+    // Savestates (asynchronous while emulation runs)
+    external fun saveState(slot: Int): Boolean
+    external fun loadState(slot: Int): Boolean
 }
\ No newline at end of file
@@ -7,6 +7,7 @@ import android.widget.Button
 import androidx.appcompat.app.AppCompatActivity
 import emu.saasemu.app.R
 import emu.saasemu.app.core.CoreStorage
+import emu.saasemu.app.core.RomInfo
 import java.io.File
 
 class CatalogActivity : AppCompatActivity() {
@@ -23,7 +24,14 @@ class CatalogActivity : AppCompatActivity() {
 
     private fun showRoms() {
         val romDir = CoreStorage.romsDir(this)
-        val files = romDir.listFiles()?.filter { it.isFile }?.map { it.name }?.toTypedArray() ?: arrayOf()
+        Thread {
+            val roms = CoreStorage.scanLibrary(this).sortedWith(compareBy({ it.system }, { it.title }))
+            runOnUiThread { if (!isFinishing) showRoms(romDir, roms) }
+        }.start()
+    }
+
+    private fun showRoms(romDir: File, roms: List<RomInfo>) {
+        val files = roms.map { if (it.system.isEmpty()) it.title else "${it.title} (${it.system})" }.toTypedArray()
         if (files.isEmpty()) {
             AlertDialog.Builder(this)
                 .setTitle("ROMs")
@@ -36,10 +44,8 @@ class CatalogActivity : AppCompatActivity() {
         AlertDialog.Builder(this)
             .setTitle("Escolha ROM")
             .setItems(files) { _, which ->
-                val name = files[which]
-                val f = File(romDir, name)
                 val i = Intent(this, EmulationActivity::class.java)
-                i.putExtra("rom_path", f.absolutePath)
+                i.putExtra("rom_path", roms[which].path)
                 startActivity(i)
             }.show()
     }
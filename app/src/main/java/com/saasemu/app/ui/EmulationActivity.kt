@@ -45,42 +45,59 @@ class EmulationActivity : AppCompatActivity(), SurfaceHolder.Callback {
             intent.getStringExtra("rom_path")?.let {
                 loadedRomPath = it
             }
-            if (loadedCorePath == null) {
-                // try to pick first core
-                CoreStorage.findFirstCore(this)?.let { f -> loadedCorePath = f.absolutePath }
-            }
-            if (loadedCorePath == null || loadedRomPath == null) {
-                toast("Core e ROM necessários. Importe-os primeiro.")
+            if (loadedCorePath != null) {
+                startEmulation()
                 return@setOnClickListener
             }
+            // pick a core that takes this ROM, else the first loadable one; the lookup may have to
+            // probe cores, so it runs off the UI thread
+            val romPath = loadedRomPath
+            btnStart.isEnabled = false
+            Thread {
+                val core = romPath?.let { CoreStorage.findCoreFor(this, it) } ?: CoreStorage.findFirstCore(this)
+                runOnUiThread {
+                    btnStart.isEnabled = true
+                    if (isFinishing) return@runOnUiThread
+                    core?.let { f -> loadedCorePath = f.absolutePath }
+                    startEmulation()
+                }
+            }.start()
+        }
 
-            NativeBridge.setSystemDir(CoreStorage.biosDir(this).absolutePath)
+        // If incoming intent gives rom_path, set it
+        intent.getStringExtra("rom_path")?.let {
+            loadedRomPath = it
+        }
+    }
 
-            if (!NativeBridge.loadCore(loadedCorePath!!)) {
-                toast("Falha ao carregar core")
-                return@setOnClickListener
-            }
+    private fun startEmulation() {
+        if (loadedCorePath == null || loadedRomPath == null) {
+            toast("Core e ROM necessários. Importe-os primeiro.")
+            return
+        }
 
-            if (!NativeBridge.attachSurface(surfaceView.holder.surface)) {
-                toast("Falha ao anexar Surface")
-                return@setOnClickListener
-            }
+        NativeBridge.setSystemDir(CoreStorage.biosDir(this).absolutePath)
+        NativeBridge.prefetchContent(loadedRomPath!!)
 
-            if (!NativeBridge.loadGame(loadedRomPath!!)) {
-                toast("Falha ao carregar ROM")
-                return@setOnClickListener
-            }
+        if (!NativeBridge.loadCore(loadedCorePath!!)) {
+            toast("Falha ao carregar core")
+            return
+        }
 
-            if (!NativeBridge.startEmulation()) {
-                toast("Falha ao iniciar emulação")
-            } else {
-                toast("Emulação iniciada")
-            }
+        if (!NativeBridge.attachSurface(surfaceView.holder.surface)) {
+            toast("Falha ao anexar Surface")
+            return
         }
 
-        // If incoming intent gives rom_path, set it
-        intent.getStringExtra("rom_path")?.let {
-            loadedRomPath = it
+        if (!NativeBridge.loadGame(loadedRomPath!!)) {
+            toast("Falha ao carregar ROM")
+            return
+        }
+
+        if (!NativeBridge.startEmulation()) {
+            toast("Falha ao iniciar emulação")
+        } else {
+            toast("Emulação iniciada")
         }
     }
 